@@ -140,7 +140,7 @@ cfg_init(void)
 	cfg.ignore_case = 0;
 	cfg.smart_case = 0;
 	cfg.hl_search = 1;
-	cfg.vifm_info = VINFO_MARKS | VINFO_BOOKMARKS;
+	cfg.vifm_info = VINFO_MARKS | VINFO_BOOKMARKS | VINFO_CACHES;
 	cfg.session_options = VINFO_TUI | VINFO_STATE | VINFO_TABS | VINFO_SAVEDIRS
 	                    | VINFO_DHISTORY;
 	cfg.scroll_off = 0;
@@ -157,7 +157,11 @@ cfg_init(void)
 	cfg.tab_line = strdup("");
 
 	cfg.lines = INT_MIN;
+	cfg.list_cache = 64;
+	cfg.size_cache = 200000;
+	cfg.size_watch = 0;
 	cfg.columns = INT_MIN;
+	cfg.compare_cache = 0;
 
 	cfg.dot_dirs = DD_NONROOT_PARENT | DD_TREE_LEAFS_PARENT;
 
@@ -233,6 +237,7 @@ cfg_init(void)
 
 	cfg.fast_file_cloning = 0;
 	cfg.data_sync = 1;
+	cfg.sparse_files = 1;
 
 	cfg.cvoptions = 0;
 
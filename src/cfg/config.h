@@ -144,7 +144,8 @@ enum
 	VINFO_MCHISTORY = 1 << 16, /* Command-line history of menus. */
 	VINFO_SAVEDIRS  = 1 << 17, /* Restore last used directories on startup. */
 	VINFO_TABS      = 1 << 18, /* Restore global or pane tabs. */
-	NUM_VINFO       = 19,      /* Number of VINFO_* constants. */
+	VINFO_CACHES    = 1 << 19, /* Directory sizes and file fingerprints. */
+	NUM_VINFO       = 20,      /* Number of VINFO_* constants. */
 
 	EMPTY_VINFO = 0,                   /* Empty set of flags. */
 	FULL_VINFO  = (1 << NUM_VINFO) - 1 /* Full set of flags. */
@@ -259,7 +260,11 @@ typedef struct config_t
 	char *status_line; /* Format string for status line. */
 	char *tab_line;    /* Nothing or lua handler for status line. */
 	int lines; /* Terminal height in lines. */
+	int list_cache; /* Memory limit of cache of directory listings in MiB. */
+	int size_cache; /* Maximum number of directory sizes stored on exit. */
+	int size_watch; /* Whether to update cached sizes on file-system events. */
 	int columns; /* Terminal width in characters. */
+	int compare_cache; /* Whether to keep fingerprints of compared files. */
 	/* Controls displaying of dot directories.  Combination of DotDirs flags. */
 	int dot_dirs;
 	/* Controls mouse support.  Combination of Mouse flags. */
@@ -357,6 +362,8 @@ typedef struct config_t
 	int fast_file_cloning;
 	/* Force writing data onto media during file copying. */
 	int data_sync;
+	/* Preserve holes of sparse files on copying them. */
+	int sparse_files;
 
 	/* Whether various things should be reset on entering/leaving custom views. */
 	int cvoptions;
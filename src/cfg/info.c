@@ -57,6 +57,7 @@
 #include "../utils/utils.h"
 #include "../bmarks.h"
 #include "../cmd_core.h"
+#include "../compare.h"
 #include "../dir_stack.h"
 #include "../filelist.h"
 #include "../flist_hist.h"
@@ -185,6 +186,8 @@
  *    by time of storing of the array) which are being merged
  */
 
+static void get_dcache_file(char buf[], size_t buf_len);
+static void get_fpcache_file(char buf[], size_t buf_len);
 static JSON_Value * read_legacy_info_file(const char info_file[]);
 static void load_state(JSON_Object *root, int reread);
 static void load_gtabs(JSON_Object *root, int reread);
@@ -304,12 +307,40 @@ state_store(void)
 {
 	write_info_file();
 
+	if(cfg.vifm_info & VINFO_CACHES)
+	{
+		char dcache_file[PATH_MAX + 16];
+		get_dcache_file(dcache_file, sizeof(dcache_file));
+		(void)dcache_store(dcache_file, cfg.size_cache);
+
+		char fpcache_file[PATH_MAX + 16];
+		get_fpcache_file(fpcache_file, sizeof(fpcache_file));
+		(void)compare_cache_store(fpcache_file);
+	}
+
 	if(sessions_active())
 	{
 		write_session_file();
 	}
 }
 
+void
+state_load_caches(void)
+{
+	if(!(cfg.vifm_info & VINFO_CACHES))
+	{
+		return;
+	}
+
+	char dcache_file[PATH_MAX + 16];
+	get_dcache_file(dcache_file, sizeof(dcache_file));
+	(void)dcache_load(dcache_file);
+
+	char fpcache_file[PATH_MAX + 16];
+	get_fpcache_file(fpcache_file, sizeof(fpcache_file));
+	(void)compare_cache_load(fpcache_file);
+}
+
 void
 state_load(int reread)
 {
@@ -340,6 +371,28 @@ state_load(int reread)
 	dir_stack_freeze();
 }
 
+void
+state_drop_dcache(void)
+{
+	char dcache_file[PATH_MAX + 16];
+	get_dcache_file(dcache_file, sizeof(dcache_file));
+	dcache_drop(dcache_file);
+}
+
+/* Formats path to the file with cache of directory sizes. */
+static void
+get_dcache_file(char buf[], size_t buf_len)
+{
+	snprintf(buf, buf_len, "%s/dcache", cfg.config_dir);
+}
+
+/* Formats path to the file with cache of fingerprints of compared files. */
+static void
+get_fpcache_file(char buf[], size_t buf_len)
+{
+	snprintf(buf, buf_len, "%s/fpcache", cfg.config_dir);
+}
+
 /* Reads legacy barely-structured vifminfo format as a JSON.  Returns JSON
  * value or NULL on error. */
 static JSON_Value *
@@ -2236,6 +2289,8 @@ store_global_options(JSON_Object *root)
 	append_dstr(options, format_str("%sautocd", cfg.auto_cd ? "" : "no"));
 	append_dstr(options, format_str("%schaselinks", cfg.chase_links ? "" : "no"));
 	append_dstr(options, format_str("columns=%d", cfg.columns));
+	append_dstr(options, format_str("%scomparecache",
+				cfg.compare_cache ? "" : "no"));
 	append_dstr(options, format_str("cpoptions=%s",
 			escape_spaces(vle_opts_get("cpoptions", OPT_GLOBAL))));
 	append_dstr(options, format_str("deleteprg=%s",
@@ -2264,6 +2319,7 @@ store_global_options(JSON_Object *root)
 				cfg.display_statusline ? "" : "no"));
 	append_dstr(options, format_str("%stitle", cfg.set_title ? "" : "no"));
 	append_dstr(options, format_str("lines=%d", cfg.lines));
+	append_dstr(options, format_str("listcache=%d", cfg.list_cache));
 	append_dstr(options, format_str("locateprg=%s",
 				escape_spaces(cfg.locate_prg)));
 	append_dstr(options, format_str("mediaprg=%s",
@@ -2287,8 +2343,10 @@ store_global_options(JSON_Object *root)
 			escape_spaces(vle_opts_get("shortmess", OPT_GLOBAL))));
 	append_dstr(options, format_str("showtabline=%s",
 			escape_spaces(vle_opts_get("showtabline", OPT_GLOBAL))));
+	append_dstr(options, format_str("sizecache=%d", cfg.size_cache));
 	append_dstr(options, format_str("sizefmt=%s",
 			escape_spaces(vle_opts_get("sizefmt", OPT_GLOBAL))));
+	append_dstr(options, format_str("%ssizewatch", cfg.size_watch ? "" : "no"));
 #ifndef _WIN32
 	append_dstr(options, format_str("slowfs=%s",
 				escape_spaces(cfg.slow_fs_list)));
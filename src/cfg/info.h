@@ -30,10 +30,18 @@ typedef void (*sessions_changed)(const char new_session[]);
  * during startup process. */
 void state_load(int reread);
 
-/* Stores state of the application.  Always writes vifminfo and stores session
- * if any is active. */
+/* Loads persistent caches of directory sizes and file fingerprints if
+ * 'vifminfo' includes them.  Meant to be called once on startup after
+ * configuration is read. */
+void state_load_caches(void);
+
+/* Stores state of the application.  Always writes vifminfo, stores caches if
+ * 'vifminfo' includes them and stores session if any is active. */
 void state_store(void);
 
+/* Forgets cached sizes of directories including those stored on disk. */
+void state_drop_dcache(void);
+
 /* Sets callback to be invoked when active session has changed.  The parameter
  * can be NULL. */
 void sessions_set_callback(sessions_changed callback);
@@ -535,6 +535,8 @@ complete_compare(const char str[])
 		{ "grouppaths",      "group files in two panes by paths" },
 
 		{ "skipempty",       "exclude empty files from comparison" },
+		{ "paranoid",        "compare contents instead of trusting hashes" },
+		{ "progressive",     "display results while comparison is running" },
 
 		{ "showidentical",   "toggle identical files viewing into comparison" },
 		{ "showdifferent",   "toggle different files viewing into comparison" },
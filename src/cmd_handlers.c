@@ -170,6 +170,7 @@ static void remove_bmark(const char path[], const char tags[], time_t timestamp,
 static char * get_bmark_dir(const cmd_info_t *cmd_info);
 static char * make_bmark_path(const char path[]);
 static int delsession_cmd(const cmd_info_t *cmd_info);
+static int dcache_cmd(const cmd_info_t *cmd_info);
 static int dirs_cmd(const cmd_info_t *cmd_info);
 static int dmap_cmd(const cmd_info_t *cmd_info);
 static int dnoremap_cmd(const cmd_info_t *cmd_info);
@@ -497,6 +498,10 @@ const cmd_add_t cmds_list[] = {
 	  .descr = "remove a session",
 	  .flags = HAS_COMMENT,
 	  .handler = &delsession_cmd,  .min_args = 1,   .max_args = 1, },
+	{ .name = "dcache",            .abbr = NULL,    .id = -1,
+	  .descr = "manage cache of directory sizes",
+	  .flags = HAS_COMMENT,
+	  .handler = &dcache_cmd,      .min_args = 1,   .max_args = 1, },
 	{ .name = "display",           .abbr = "di",    .id = -1,
 	  .descr = "display registers",
 	  .flags = 0,
@@ -2155,6 +2160,9 @@ parse_compare_properties(const cmd_info_t *cmd_info, CompareType *ct,
 		else if(strcmp(property, "grouppaths") == 0) *flags |= CF_GROUP_PATHS;
 
 		else if(strcmp(property, "skipempty") == 0)  *flags |= CF_SKIP_EMPTY;
+		else if(strcmp(property, "paranoid") == 0)   *flags |= CF_PARANOID;
+		else if(strcmp(property, "progressive") == 0)
+			*flags |= CF_PROGRESSIVE;
 
 		else if(strcmp(property, "showidentical") == 0)
 			*flags |= CF_SHOW_IDENTICAL;
@@ -2207,6 +2215,22 @@ delsession_cmd(const cmd_info_t *cmd_info)
 	return 0;
 }
 
+/* Manages cache of directory sizes. */
+static int
+dcache_cmd(const cmd_info_t *cmd_info)
+{
+	if(strcmp(cmd_info->argv[0], "drop") != 0)
+	{
+		ui_sb_errf("Unknown subcommand: %s", cmd_info->argv[0]);
+		return CMDS_ERR_CUSTOM;
+	}
+
+	state_drop_dcache();
+	ui_view_schedule_redraw(&lwin);
+	ui_view_schedule_redraw(&rwin);
+	return 0;
+}
+
 static int
 dirs_cmd(const cmd_info_t *cmd_info)
 {
@@ -4563,6 +4587,11 @@ restart_into_session(const char session[], int full)
 	}
 
 	instance_finish_restart();
+	if(full)
+	{
+		/* Persistent caches depend on configuration, so load them after it. */
+		state_load_caches();
+	}
 	return result;
 }
 
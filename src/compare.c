@@ -18,31 +18,46 @@
 
 #include "compare.h"
 
+#include <sys/stat.h> /* S_ISREG() stat */
+#ifndef _WIN32
+#include <sys/resource.h> /* RLIMIT_NOFILE RLIM_INFINITY getrlimit() rlimit */
+#include <fcntl.h> /* POSIX_FADV_SEQUENTIAL posix_fadvise() */
+#endif
+
 #include <assert.h> /* assert() */
 #include <stddef.h> /* size_t */
-#include <stdint.h> /* INTPTR_MAX INT64_MAX */
-#include <stdio.h> /* FILE fclose() feof() fopen() fread() */
-#include <stdlib.h> /* free() malloc() */
-#include <string.h> /* memcmp() */
+#include <stdint.h> /* INTPTR_MAX INT64_MAX int64_t uint64_t */
+#include <stdio.h> /* FILE _IONBF _getmaxstdio() fclose() feof() fileno() fread() setvbuf() */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* memcmp() memmove() */
+#include <time.h> /* time() */
 
+#include "cfg/config.h"
 #include "compat/fs_limits.h"
 #include "compat/os.h"
+#include "compat/pthread.h"
 #include "compat/reallocarray.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "ui/cancellation.h"
+#include "ui/fileview.h"
 #include "ui/statusbar.h"
 #include "ui/ui.h"
 #include "utils/dynarray.h"
 #include "utils/fs.h"
 #include "utils/fsdata.h"
 #include "utils/macros.h"
+#include "utils/matcher.h"
 #include "utils/path.h"
+#include "utils/path_store.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
+#include "utils/thread_pool.h"
+#include "utils/tree_walker.h"
 #include "utils/trie.h"
 #include "utils/utils.h"
 #include "filelist.h"
 #include "filtering.h"
+#include "flist_pos.h"
 #include "flist_sel.h"
 #include "fops_common.h"
 #include "fops_cpmv.h"
@@ -64,6 +79,18 @@
  *       * compute contents fingerprint for current file and insert it
  *   - there is more than one conflicting file:
  *       * compute contents fingerprint for current file and insert it
+ *
+ * Sizes of all files are known before any fingerprint is needed, so files
+ * which would be read by the scheme above are split into classes of identical
+ * files in advance by several threads in stages:
+ *   - files of unique size aren't read
+ *   - files of the same size are split by digest of their heads
+ *   - files of the same size and head are split by digest of whole contents or
+ *     in paranoid mode by reading several of them at once and comparing them
+ *     block by block
+ * This way each file is read at most once (paranoid mode rereads one file of
+ * each class per bunch of files) and fingerprints identify classes, so the
+ * scheme above which compares files pairwise is only a fallback.
  */
 
 /* This is the only unit that uses xxhash, so import it directly here. */
@@ -71,11 +98,33 @@
 #include "utils/xxhash.h"
 
 /* Amount of data to read at once. */
-#define BLOCK_SIZE (32*1024)
+#define BLOCK_SIZE (1024*1024)
 
 /* Amount of data to hash for coarse comparison. */
 #define PREFIX_SIZE (4*1024)
 
+/* Maximum number of files compared at once by a worker in paranoid mode.  Can
+ * be lowered to fit into limit on number of open files. */
+#define VERIFY_FILES 64
+
+/* Amount of data of each file to read at once in paranoid mode. */
+#define VERIFY_BLOCK_SIZE (64*1024)
+
+/* Minimal number of files compared at once in progressive mode. */
+#define PROGRESSIVE_BATCH 4096
+
+/* Minimal interval between updates of views in progressive mode in
+ * milliseconds. */
+#define PREVIEW_PERIOD_MS 1000
+
+/* Maximum number of fingerprints kept in the file of the cache. */
+#define FPCACHE_MAX_STORED 500000
+
+/* Number of threads that compute fingerprints.  Most files are read only in
+ * part, so the number limits how many small reads are in flight rather than
+ * how much hashing is done at once. */
+#define HASH_WORKERS 8
+
 /* Entry in singly-bounded list of files that have matched fingerprints. */
 typedef struct compare_record_t
 {
@@ -86,6 +135,106 @@ typedef struct compare_record_t
 }
 compare_record_t;
 
+/* Parameters of reading a tree to be compared. */
+typedef struct
+{
+	const view_t *view; /* View whose tree is read. */
+	int skip_dot_files; /* Whether dot directories are skipped. */
+	int check_filters;  /* Whether filters can be checked from threads. */
+}
+walk_params_t;
+
+/* State of displaying results of comparison of two panes. */
+typedef struct
+{
+	CompareType ct;      /* Type of comparison. */
+	ListType lt;         /* Which files are listed. */
+	int flags;           /* Flags of comparison. */
+	int shown;           /* Whether partial results were displayed. */
+	long long last_time; /* When partial results were updated last time. */
+	long long cost;      /* How long it took to update them in milliseconds. */
+}
+diff_output_t;
+
+/* State of comparison of two panes by contents which is done in batches
+ * between handling of user input. */
+typedef struct
+{
+	trie_t *trie;                /* Compare records. */
+	trie_t *hashes;              /* Precomputed fingerprints. */
+	entries_t curr;              /* Files of current view sorted by size. */
+	entries_t other;             /* Files of other view sorted by size. */
+	int ci, oi;                  /* Indexes of the first unprocessed entries. */
+	int cn, on;                  /* Numbers of processed entries, which are
+	                                moved to the beginning of the lists. */
+	int next_id;                 /* Next unused id. */
+	int cancelled;               /* Whether the last batch was cancelled. */
+	diff_output_t out;           /* State of displaying results. */
+	view_t *view;                /* View that was current on the start. */
+	const dir_entry_t *lists[2]; /* Lists of lwin and rwin after an update. */
+	int counts[2];               /* Sizes of lists of lwin and rwin. */
+}
+batch_job_t;
+
+/* File whose contents fingerprint is computed in advance. */
+typedef struct
+{
+	const dir_entry_t *entry; /* Entry of the file. */
+	int dups_only;            /* Whether the file can't start a new group. */
+	char *path;               /* Full path to the file. */
+	int failed;               /* Whether the file couldn't be read. */
+	uint64_t head;            /* Digest of the head of the file. */
+	int has_full;             /* Whether full is set. */
+	uint64_t full;            /* Digest of all contents of the file. */
+	int cls;                  /* Class of identical files or -1. */
+}
+hash_item_t;
+
+/* Range of items of files of the same size and head. */
+typedef struct
+{
+	int from; /* First item. */
+	int to;   /* Item past the last one. */
+}
+hash_group_t;
+
+/* State of a stage of computing fingerprints shared by all threads. */
+typedef struct
+{
+	hash_item_t *items;    /* All files being processed. */
+	int *todo;             /* Indexes of items to be hashed. */
+	hash_group_t *groups;  /* Groups of files to be compared. */
+	int count;             /* Number of elements of todo or groups. */
+	int bunch_size;        /* Maximum number of files compared at once. */
+	uint64_t limit;        /* Amount of data to hash, zero means all. */
+	const char *title;     /* Title of the progress message. */
+	uint64_t total_bytes;  /* Amount of data to process or zero. */
+	pthread_t owner;       /* Thread that started the computation. */
+	int last_progress;     /* Last reported progress, used only by the owner. */
+
+	pthread_mutex_t lock;  /* Protects the fields below. */
+	int done;              /* Number of processed elements. */
+	uint64_t done_bytes;   /* Amount of processed data. */
+}
+hash_job_t;
+
+static int display_diff(entries_t curr, entries_t other,
+		const diff_output_t *out, int partial);
+static int finish_diff_view(view_t *view, const diff_output_t *out);
+static int start_batches(trie_t *trie, trie_t *hashes, entries_t curr,
+		entries_t other, const diff_output_t *out);
+static int process_batch(batch_job_t *job);
+static int finish_batches(batch_job_t *job);
+static void show_preview(batch_job_t *job);
+static int display_in_place(entries_t curr, entries_t other,
+		const diff_output_t *out, int partial);
+static void remember_lists(batch_job_t *job);
+static int lists_changed(const batch_job_t *job);
+static void free_batch_job(batch_job_t *job);
+static void renumber_ids(entries_t *curr, entries_t *other, int next_id);
+static void free_dir_entries_of(entries_t *list);
+static int entry_size_sorter(const void *first, const void *second);
+static int tag_sorter(const void *first, const void *second);
 static void make_unique_lists(entries_t curr, entries_t other);
 static void leave_only_dups(entries_t *curr, entries_t *other);
 static int is_not_duplicate(view_t *view, const dir_entry_t *entry, void *arg);
@@ -98,24 +247,81 @@ static void put_side_by_side_pair(dir_entry_t *curr, dir_entry_t *other,
 		int flags, compare_stats_t *stats);
 static int id_sorter(const void *first, const void *second);
 static void put_or_free(view_t *view, dir_entry_t *entry, int id, int take);
-static entries_t make_diff_list(trie_t *trie, view_t *view, int *next_id,
-		CompareType ct, int dups_only, int flags);
+static entries_t make_diff_list(view_t *view, int flags);
 static void list_view_entries(const view_t *view, strlist_t *list);
 static int append_valid_nodes(const char name[], int valid,
 		const void *parent_data, void *data, void *arg);
-static void list_files_recursively(const view_t *view, const char path[],
+static void list_tree(const view_t *view, const char path[],
 		int skip_dot_files, int flags, strlist_t *list);
+static int walk_filter(const char dir[], const char name[], int depth,
+		void *arg);
+static int walk_cancelled(void *arg);
+static void walk_progress(void *arg);
+static void list_files_recursively(const view_t *view,
+		const tree_walker_t *walker, const char path[], int skip_dot_files,
+		int flags, strlist_t *list);
+static void precompute_fingerprints(trie_t *hashes, entries_t *lists[],
+		const int dups_only[], int nlists, int paranoid);
+static int should_be_read(const hash_item_t items[], int from, int to);
+static void store_fingerprint(trie_t *hashes, const hash_item_t *item);
+static void run_stage(hash_job_t *job, thread_pool_t *pool,
+		thread_pool_func func);
+static void report_progress(hash_job_t *job, int items, uint64_t bytes);
+static int size_sorter(const void *first, const void *second);
+static int head_sorter(const void *first, const void *second);
+static int full_sorter(const void *first, const void *second);
+static void hash_files(void *arg, int from, int to);
+static void compare_groups(void *arg, int from, int to);
+static void split_by_contents(hash_job_t *job, hash_item_t *files[], int n,
+		int *next_cls);
+static int compare_bunch(hash_job_t *job, hash_item_t *bunch[], int nreps,
+		int count, int *next_cls);
+static int get_bunch_size(void);
+static void assign_ids(trie_t *trie, trie_t *hashes, entries_t *list,
+		int *next_id, CompareType ct, int dups_only, int flags);
 static char * get_file_fingerprint(const char path[], const dir_entry_t *entry,
 		CompareType ct, int flags, int lazy);
 static char * get_contents_fingerprint(const char path[],
 		unsigned long long size);
-static int add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
-		CompareType ct, int dups_only, int flags, int *next_id);
+static int hash_contents(const char path[], unsigned long long size,
+		unsigned long long limit, hash_job_t *job, uint64_t *digest);
+static int add_file_to_diff(trie_t *trie, trie_t *hashes, const char path[],
+		dir_entry_t *entry, CompareType ct, int dups_only, int flags,
+		int *next_id);
+static int add_known_file(trie_t *trie, const char path[],
+		const char fingerprint[], int dups_only, int *next_id);
 static int files_are_identical(const char a[], const char b[]);
+static FILE * open_for_reading(const char path[]);
 static void put_file_id(trie_t *trie, const char path[],
 		const char fingerprint[], int id, int is_partial, CompareType ct);
 static void free_compare_records(void *ptr);
 static void compare_move_entry(ops_t *ops, view_t *from, view_t *to, int idx);
+static int fpcache_key(const char path[], unsigned long long size,
+		unsigned long long limit, char key[], size_t key_len);
+static int fpcache_get(const char key[], uint64_t *digest);
+static void fpcache_put(const char key[], uint64_t digest);
+static void fpcache_reset(void);
+
+/* Protects variables of cache of fingerprints below. */
+static pthread_mutex_t fpcache_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Fingerprints from previous runs or NULL. */
+static path_store_t *fpcache_stored;
+/* Maps keys of fingerprints in fpcache_keys to their index plus one. */
+static trie_t *fpcache_index;
+/* Keys of fingerprints used since the cache was loaded. */
+static char **fpcache_keys;
+/* Records of fingerprints used since the cache was loaded. */
+static path_store_rec_t *fpcache_recs;
+/* Number of used fingerprints. */
+static int fpcache_count;
+/* Number of allocated elements of fpcache_keys and fpcache_recs. */
+static int fpcache_capacity;
+
+/* Progressive comparison of two panes that is in progress or NULL. */
+static batch_job_t *batch_job;
+
+/* Minimal number of files in a batch of progressive comparison. */
+TSTATIC int progressive_batch = PROGRESSIVE_BATCH;
 
 int
 compare_two_panes(CompareType ct, ListType lt, int flags)
@@ -123,8 +329,6 @@ compare_two_panes(CompareType ct, ListType lt, int flags)
 	assert((flags & (CF_IGNORE_CASE | CF_RESPECT_CASE)) !=
 			(CF_IGNORE_CASE | CF_RESPECT_CASE) && "Wrong combination of flags.");
 
-	const int group_paths = flags & CF_GROUP_PATHS;
-
 	/* We don't compare lists of files, so skip the check if at least one of the
 	 * views is a custom one. */
 	if(!flist_custom_active(&lwin) && !flist_custom_active(&rwin) &&
@@ -134,16 +338,53 @@ compare_two_panes(CompareType ct, ListType lt, int flags)
 		return 1;
 	}
 
+	/* Results of previous comparison shouldn't replace the new ones. */
+	compare_stop();
+
 	int next_id = 1;
 	entries_t curr, other;
+	diff_output_t out = { .ct = ct, .lt = lt, .flags = flags };
 
 	trie_t *const trie = trie_create(&free_compare_records);
+	trie_t *const hashes = trie_create(&free);
 	ui_cancellation_push_on();
 
-	curr = make_diff_list(trie, curr_view, &next_id, ct, /*dups_only=*/0, flags);
-	other = make_diff_list(trie, other_view, &next_id, ct, lt == LT_DUPS, flags);
+	curr = make_diff_list(curr_view, flags);
+	other = make_diff_list(other_view, flags);
+
+	if(ct == CT_CONTENTS && (flags & CF_PROGRESSIVE))
+	{
+		const int cancelled = ui_cancellation_requested();
+		ui_cancellation_pop();
+
+		/* Clear progress message displayed by make_diff_list(). */
+		ui_sb_quick_msg_clear();
+
+		if(cancelled)
+		{
+			trie_free(hashes);
+			trie_free(trie);
+			free_dir_entries(&curr.entries, &curr.nentries);
+			free_dir_entries(&other.entries, &other.nentries);
+			ui_sb_msg("Comparison has been cancelled");
+			return 1;
+		}
+
+		return start_batches(trie, hashes, curr, other, &out);
+	}
+
+	if(ct == CT_CONTENTS)
+	{
+		entries_t *lists[] = { &curr, &other };
+		const int dups_only[] = { 0, lt == LT_DUPS };
+		precompute_fingerprints(hashes, lists, dups_only, 2, flags & CF_PARANOID);
+	}
+
+	assign_ids(trie, hashes, &curr, &next_id, ct, /*dups_only=*/0, flags);
+	assign_ids(trie, hashes, &other, &next_id, ct, lt == LT_DUPS, flags);
 
 	ui_cancellation_pop();
+	trie_free(hashes);
 	trie_free(trie);
 
 	/* Clear progress message displayed by make_diff_list(). */
@@ -157,7 +398,63 @@ compare_two_panes(CompareType ct, ListType lt, int flags)
 		return 1;
 	}
 
-	if(!group_paths || lt != LT_ALL)
+	(void)display_diff(curr, other, &out, /*partial=*/0);
+	return 0;
+}
+
+int
+compare_continue(void)
+{
+	batch_job_t *const job = batch_job;
+	if(job == NULL)
+	{
+		return 0;
+	}
+
+	if(lists_changed(job))
+	{
+		/* Views were changed by the user, results can't be merged into them. */
+		compare_stop();
+		ui_sb_msg("Comparison has been interrupted, results are incomplete");
+		return 1;
+	}
+
+	view_t *const view = job->view;
+	view_t *old_curr, *old_other;
+	ui_view_pick(view, &old_curr, &old_other);
+
+	if(process_batch(job))
+	{
+		batch_job = NULL;
+		(void)finish_batches(job);
+	}
+	else
+	{
+		show_preview(job);
+	}
+
+	ui_view_unpick(view, old_curr, old_other);
+	return 1;
+}
+
+void
+compare_stop(void)
+{
+	free_batch_job(batch_job);
+	batch_job = NULL;
+}
+
+/* Fills views with results of comparison of two panes consuming the lists.
+ * Partial results don't produce errors.  Returns zero if views were updated,
+ * otherwise non-zero is returned. */
+static int
+display_diff(entries_t curr, entries_t other, const diff_output_t *out,
+		int partial)
+{
+	const ListType lt = out->lt;
+	const int flags = out->flags;
+
+	if(!(flags & CF_GROUP_PATHS) || lt != LT_ALL)
 	{
 		/* Sort both lists according to unique file numbers to group identical files
 		 * (sorting is stable, tags are set in make_diff_list()). */
@@ -182,7 +479,7 @@ compare_two_panes(CompareType ct, ListType lt, int flags)
 
 	compare_stats_t stats = {};
 
-	if(group_paths)
+	if(flags & CF_GROUP_PATHS)
 	{
 		fill_side_by_side_by_paths(curr, other, flags, &stats);
 	}
@@ -196,20 +493,23 @@ compare_two_panes(CompareType ct, ListType lt, int flags)
 	dynarray_free(curr.entries);
 	dynarray_free(other.entries);
 
-	if(flist_custom_finish(curr_view, CV_DIFF, 0) != 0)
+	if(finish_diff_view(curr_view, out) != 0)
 	{
-		show_error_msg("Comparison", "No results to display");
-		return 0;
+		if(!partial)
+		{
+			show_error_msg("Comparison", "No results to display");
+		}
+		return 1;
 	}
-	if(flist_custom_finish(other_view, CV_DIFF, 0) != 0)
+	if(finish_diff_view(other_view, out) != 0)
 	{
 		assert(0 && "The error shouldn't be happening here.");
 	}
 
 	curr_view->list_pos = 0;
 	other_view->list_pos = 0;
-	curr_view->custom.diff_cmp_type = ct;
-	other_view->custom.diff_cmp_type = ct;
+	curr_view->custom.diff_cmp_type = out->ct;
+	other_view->custom.diff_cmp_type = out->ct;
 	curr_view->custom.diff_list_type = lt;
 	other_view->custom.diff_list_type = lt;
 	curr_view->custom.diff_cmp_flags = flags;
@@ -228,6 +528,358 @@ compare_two_panes(CompareType ct, ListType lt, int flags)
 	return 0;
 }
 
+/* Finishes filling a view with results of comparison.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+finish_diff_view(view_t *view, const diff_output_t *out)
+{
+	/* Location of the view doesn't change after it was first displayed. */
+	if(out->shown)
+	{
+		return flist_custom_refresh(view, CV_DIFF, 0);
+	}
+	return flist_custom_finish(view, CV_DIFF, 0);
+}
+
+/* Starts comparison of two panes by contents in batches of files of several
+ * sizes at a time taking ownership of the arguments.  Files of different sizes
+ * can't match, so results of every batch are final.  The first batch is
+ * processed right away and the rest is left to compare_continue().  Returns
+ * zero if views were or are going to be updated, otherwise non-zero is
+ * returned. */
+static int
+start_batches(trie_t *trie, trie_t *hashes, entries_t curr, entries_t other,
+		const diff_output_t *out)
+{
+	batch_job_t *const job = calloc(1, sizeof(*job));
+	if(job == NULL)
+	{
+		trie_free(hashes);
+		trie_free(trie);
+		free_dir_entries(&curr.entries, &curr.nentries);
+		free_dir_entries(&other.entries, &other.nentries);
+		show_error_msg("Comparison", "Not enough memory");
+		return 1;
+	}
+
+	job->trie = trie;
+	job->hashes = hashes;
+	job->curr = curr;
+	job->other = other;
+	job->next_id = 1;
+	job->out = *out;
+	job->view = curr_view;
+
+	safe_qsort(job->curr.entries, job->curr.nentries, sizeof(*curr.entries),
+			&entry_size_sorter);
+	safe_qsort(job->other.entries, job->other.nentries, sizeof(*other.entries),
+			&entry_size_sorter);
+
+	if(process_batch(job))
+	{
+		return finish_batches(job);
+	}
+
+	/* First results are displayed without a delay. */
+	job->out.last_time = time_in_ms() - PREVIEW_PERIOD_MS;
+	show_preview(job);
+
+	/* Changes of views made from now on stop the comparison. */
+	remember_lists(job);
+	batch_job = job;
+	return 0;
+}
+
+/* Assigns ids to files of the next batch.  Cancelled batch is dropped.
+ * Returns non-zero if there is nothing left to do, otherwise zero is
+ * returned. */
+static int
+process_batch(batch_job_t *job)
+{
+	entries_t *const curr = &job->curr;
+	entries_t *const other = &job->other;
+	const int dups_only = (job->out.lt == LT_DUPS);
+	const int paranoid = (job->out.flags & CF_PARANOID);
+
+	/* Batch consists of all files of several consecutive sizes. */
+	int ce = job->ci, oe = job->oi;
+	while((ce < curr->nentries || oe < other->nentries) &&
+			(ce - job->ci) + (oe - job->oi) < progressive_batch)
+	{
+		const uint64_t size = (oe == other->nentries ||
+		                       (ce < curr->nentries &&
+		                        curr->entries[ce].size <= other->entries[oe].size))
+		                    ? curr->entries[ce].size
+		                    : other->entries[oe].size;
+		while(ce < curr->nentries && curr->entries[ce].size == size)
+		{
+			++ce;
+		}
+		while(oe < other->nentries && other->entries[oe].size == size)
+		{
+			++oe;
+		}
+	}
+
+	entries_t c = { .entries = &curr->entries[job->ci],
+	                .nentries = ce - job->ci };
+	entries_t o = { .entries = &other->entries[job->oi],
+	                .nentries = oe - job->oi };
+	job->ci = ce;
+	job->oi = oe;
+
+	ui_cancellation_push_on();
+
+	entries_t *lists[] = { &c, &o };
+	const int dups[] = { 0, dups_only };
+	precompute_fingerprints(job->hashes, lists, dups, 2, paranoid);
+
+	assign_ids(job->trie, job->hashes, &c, &job->next_id, CT_CONTENTS,
+			/*dups_only=*/0, job->out.flags);
+	assign_ids(job->trie, job->hashes, &o, &job->next_id, CT_CONTENTS,
+			dups_only, job->out.flags);
+
+	job->cancelled = ui_cancellation_requested();
+	ui_cancellation_pop();
+
+	/* Clear progress message displayed while computing fingerprints. */
+	ui_sb_quick_msg_clear();
+
+	if(job->cancelled)
+	{
+		/* Results of this batch might be incomplete. */
+		free_dir_entries_of(&c);
+		free_dir_entries_of(&o);
+		return 1;
+	}
+
+	memmove(&curr->entries[job->cn], c.entries, sizeof(*c.entries)*c.nentries);
+	job->cn += c.nentries;
+	memmove(&other->entries[job->on], o.entries, sizeof(*o.entries)*o.nentries);
+	job->on += o.nentries;
+
+	return (job->ci == curr->nentries && job->oi == other->nentries);
+}
+
+/* Displays final results of comparison in batches and frees the job.  On
+ * cancellation only the files whose comparison was completed are displayed.
+ * Returns zero if views were updated, otherwise non-zero is returned. */
+static int
+finish_batches(batch_job_t *job)
+{
+	entries_t curr = job->curr, other = job->other;
+
+	entries_t rest = { .entries = &curr.entries[job->ci],
+	                   .nentries = curr.nentries - job->ci };
+	free_dir_entries_of(&rest);
+	rest.entries = &other.entries[job->oi];
+	rest.nentries = other.nentries - job->oi;
+	free_dir_entries_of(&rest);
+
+	curr.nentries = job->cn;
+	other.nentries = job->on;
+
+	const int cancelled = job->cancelled;
+	const int next_id = job->next_id;
+	const diff_output_t out = job->out;
+
+	/* Lists are consumed below. */
+	job->curr.entries = NULL;
+	job->curr.nentries = 0;
+	job->other.entries = NULL;
+	job->other.nentries = 0;
+	free_batch_job(job);
+
+	if(cancelled && curr.nentries + other.nentries == 0)
+	{
+		dynarray_free(curr.entries);
+		dynarray_free(other.entries);
+		ui_sb_msg("Comparison has been cancelled");
+		return 1;
+	}
+
+	/* Restore order in which files were listed. */
+	safe_qsort(curr.entries, curr.nentries, sizeof(*curr.entries), &tag_sorter);
+	safe_qsort(other.entries, other.nentries, sizeof(*other.entries),
+			&tag_sorter);
+	renumber_ids(&curr, &other, next_id);
+
+	const int result = display_in_place(curr, other, &out, /*partial=*/0);
+	if(cancelled)
+	{
+		ui_sb_msg("Comparison has been cancelled, results are incomplete");
+	}
+	return result;
+}
+
+/* Displays results of comparison obtained so far unless it was done recently.
+ * Lists of the job are left untouched. */
+static void
+show_preview(batch_job_t *job)
+{
+	diff_output_t *const out = &job->out;
+
+	/* Views of unique files don't have a fixed location and results of a batch
+	 * are unlikely to be interesting without results of other batches. */
+	if(out->lt == LT_UNIQUE || job->cn + job->on == 0)
+	{
+		return;
+	}
+
+	/* Rebuilding views takes time proportional to the number of results, so do
+	 * it less often as it becomes more expensive. */
+	const long long start = time_in_ms();
+	if(start - out->last_time < MAX(PREVIEW_PERIOD_MS, out->cost*4))
+	{
+		return;
+	}
+
+	entries_t c = {}, o = {};
+	replace_dir_entries(curr_view, &c.entries, &c.nentries, job->curr.entries,
+			job->cn);
+	replace_dir_entries(other_view, &o.entries, &o.nentries, job->other.entries,
+			job->on);
+	if(c.nentries != job->cn || o.nentries != job->on)
+	{
+		free_dir_entries(&c.entries, &c.nentries);
+		free_dir_entries(&o.entries, &o.nentries);
+		return;
+	}
+
+	safe_qsort(c.entries, c.nentries, sizeof(*c.entries), &tag_sorter);
+	safe_qsort(o.entries, o.nentries, sizeof(*o.entries), &tag_sorter);
+	renumber_ids(&c, &o, job->next_id);
+
+	if(display_in_place(c, o, out, /*partial=*/1) == 0)
+	{
+		out->shown = 1;
+	}
+	remember_lists(job);
+
+	out->last_time = time_in_ms();
+	out->cost = out->last_time - start;
+}
+
+/* Same as display_diff(), but keeps cursor on the same file if results were
+ * already displayed. */
+static int
+display_in_place(entries_t curr, entries_t other, const diff_output_t *out,
+		int partial)
+{
+	char name[NAME_MAX + 1] = "";
+	char dir[PATH_MAX + 1] = "";
+	int pos = curr_view->list_pos;
+
+	if(out->shown)
+	{
+		/* Side-by-side views have files at the same positions, but one of the
+		 * entries might be a placeholder. */
+		const dir_entry_t *entry = get_current_entry(curr_view);
+		if(fentry_is_fake(entry))
+		{
+			entry = get_current_entry(other_view);
+		}
+		if(!fentry_is_fake(entry))
+		{
+			copy_str(name, sizeof(name), entry->name);
+			copy_str(dir, sizeof(dir), entry->origin);
+		}
+	}
+
+	const int result = display_diff(curr, other, out, partial);
+	if(result != 0 || !out->shown)
+	{
+		return result;
+	}
+
+	if(name[0] != '\0')
+	{
+		const int curr_pos = fpos_find_entry(curr_view, name, dir);
+		pos = (curr_pos >= 0) ? curr_pos : fpos_find_entry(other_view, name, dir);
+	}
+	pos = MAX(MIN(pos, curr_view->list_rows - 1), 0);
+	curr_view->list_pos = pos;
+	other_view->list_pos = pos;
+	return 0;
+}
+
+/* Remembers lists of both views to be able to detect their changes. */
+static void
+remember_lists(batch_job_t *job)
+{
+	job->lists[0] = lwin.dir_entry;
+	job->counts[0] = lwin.list_rows;
+	job->lists[1] = rwin.dir_entry;
+	job->counts[1] = rwin.list_rows;
+}
+
+/* Checks whether lists of views were changed since they were last updated by
+ * the job.  Returns non-zero if so, otherwise zero is returned. */
+static int
+lists_changed(const batch_job_t *job)
+{
+	return job->lists[0] != lwin.dir_entry || job->counts[0] != lwin.list_rows
+	    || job->lists[1] != rwin.dir_entry || job->counts[1] != rwin.list_rows;
+}
+
+/* Frees comparison in batches along with all of its resources.  The job can
+ * be NULL. */
+static void
+free_batch_job(batch_job_t *job)
+{
+	if(job == NULL)
+	{
+		return;
+	}
+
+	trie_free(job->hashes);
+	trie_free(job->trie);
+	free_dir_entries(&job->curr.entries, &job->curr.nentries);
+	free_dir_entries(&job->other.entries, &job->other.nentries);
+	free(job);
+}
+
+/* Renumbers ids of entries of lists sorted in order of listing to be the same
+ * as if the lists were processed in this order.  Ids of entries are less than
+ * next_id. */
+static void
+renumber_ids(entries_t *curr, entries_t *other, int next_id)
+{
+	int *const new_ids = calloc(next_id, sizeof(*new_ids));
+	if(new_ids == NULL)
+	{
+		return;
+	}
+
+	int i;
+	int last_id = 0;
+	for(i = 0; i < curr->nentries + other->nentries; ++i)
+	{
+		dir_entry_t *const entry = (i < curr->nentries)
+		                         ? &curr->entries[i]
+		                         : &other->entries[i - curr->nentries];
+		if(new_ids[entry->id] == 0)
+		{
+			new_ids[entry->id] = ++last_id;
+		}
+		entry->id = new_ids[entry->id];
+	}
+
+	free(new_ids);
+}
+
+/* Frees entries of the list without freeing the list itself. */
+static void
+free_dir_entries_of(entries_t *list)
+{
+	int i;
+	for(i = 0; i < list->nentries; ++i)
+	{
+		fentry_free(&list->entries[i]);
+	}
+	list->nentries = 0;
+}
+
 /* Composes two views containing only files that are unique to each of them.
  * Assumes that both lists are sorted by id. */
 static void
@@ -601,15 +1253,30 @@ compare_one_pane(view_t *view, CompareType ct, ListType lt, int flags)
 	const char *const title = (lt == LT_ALL)  ? "compare"
 	                        : (lt == LT_DUPS) ? "dups" : "nondups";
 
+	/* Results of comparison of two panes shouldn't replace the new ones. */
+	compare_stop();
+
 	int next_id = 1;
 	entries_t curr;
 
 	trie_t *trie = trie_create(&free_compare_records);
+	trie_t *hashes = trie_create(&free);
 	ui_cancellation_push_on();
 
-	curr = make_diff_list(trie, view, &next_id, ct, /*dups_only=*/0, flags);
+	curr = make_diff_list(view, flags);
+
+	if(ct == CT_CONTENTS)
+	{
+		entries_t *lists[] = { &curr };
+		const int dups_only[] = { 0 };
+		precompute_fingerprints(hashes, lists, dups_only, 1,
+				flags & CF_PARANOID);
+	}
+
+	assign_ids(trie, hashes, &curr, &next_id, ct, /*dups_only=*/0, flags);
 
 	ui_cancellation_pop();
+	trie_free(hashes);
 	trie_free(trie);
 
 	/* Clear progress message displayed by make_diff_list(). */
@@ -693,6 +1360,30 @@ id_sorter(const void *first, const void *second)
 	return a->id == b->id ? a->tag - b->tag : a->id - b->id;
 }
 
+/* qsort() comparer that sorts entries by size keeping order of entries of the
+ * same size.  Returns standard -1, 0, 1 for comparisons. */
+static int
+entry_size_sorter(const void *first, const void *second)
+{
+	const dir_entry_t *a = first;
+	const dir_entry_t *b = second;
+	if(a->size != b->size)
+	{
+		return (a->size > b->size ? 1 : -1);
+	}
+	return a->tag - b->tag;
+}
+
+/* qsort() comparer that restores order in which entries were listed.  Returns
+ * standard -1, 0, 1 for comparisons. */
+static int
+tag_sorter(const void *first, const void *second)
+{
+	const dir_entry_t *a = first;
+	const dir_entry_t *b = second;
+	return a->tag - b->tag;
+}
+
 /* Either puts the entry into the view or frees it (depends on the take
  * argument). */
 static void
@@ -709,12 +1400,10 @@ put_or_free(view_t *view, dir_entry_t *entry, int id, int take)
 	}
 }
 
-/* Makes sorted by path list of entries that.  The trie is used to keep track of
- * identical files.  With non-zero dups_only, new files aren't added to the
- * trie. */
+/* Makes sorted by path list of entries of the view with their tags set to
+ * their positions.  Ids are assigned later by assign_ids(). */
 static entries_t
-make_diff_list(trie_t *trie, view_t *view, int *next_id, CompareType ct,
-		int dups_only, int flags)
+make_diff_list(view_t *view, int flags)
 {
 	const int skip_empty = flags & CF_SKIP_EMPTY;
 
@@ -731,8 +1420,7 @@ make_diff_list(trie_t *trie, view_t *view, int *next_id, CompareType ct,
 	}
 	else
 	{
-		list_files_recursively(view, flist_get_dir(view), view->hide_dot, flags,
-				&files);
+		list_tree(view, flist_get_dir(view), view->hide_dot, flags, &files);
 	}
 
 	show_progress("Querying...", 0);
@@ -757,14 +1445,6 @@ make_diff_list(trie_t *trie, view_t *view, int *next_id, CompareType ct,
 		}
 
 		entry->tag = i;
-		entry->id = add_file_to_diff(trie, path, entry, ct, dups_only, flags,
-				next_id);
-
-		if(entry->id == -1)
-		{
-			fentry_free(entry);
-			--r.nentries;
-		}
 
 		progress = (i*100)/files.nitems;
 		if(progress != last_progress)
@@ -825,80 +1505,832 @@ append_valid_nodes(const char name[], int valid, const void *parent_data,
 	return 0;
 }
 
-/* Collects files under specified file system tree. */
+/* Collects files under specified file system tree.  Directories are read in
+ * parallel beforehand. */
 static void
-list_files_recursively(const view_t *view, const char path[],
-		int skip_dot_files, int flags, strlist_t *list)
+list_tree(const view_t *view, const char path[], int skip_dot_files,
+		int flags, strlist_t *list)
 {
-	int i;
+	walk_params_t params = {
+		.view = view,
+		.skip_dot_files = skip_dot_files,
+		/* Querying mime types isn't thread-safe, so skip checking filters and
+		 * read a bit more than necessary. */
+		.check_filters = matcher_is_empty(view->manual_filter)
+		              || !matcher_is_mime(view->manual_filter),
+	};
+
+	const tree_walker_cbs_t cbs = {
+		.filter = &walk_filter,
+		.cancelled = &walk_cancelled,
+		.progress = &walk_progress,
+		.arg = &params,
+	};
+
+	tree_walker_t *const walker = tree_walker_walk(path, -1, &cbs);
+	list_files_recursively(view, walker, path, skip_dot_files, flags, list);
+	tree_walker_free(walker);
+}
 
-	/* Obtain sorted list of files. */
-	int len;
-	char **lst = list_all_files(path, &len);
-	if(len < 0)
-	{
-		return;
-	}
+/* tree_walker_t callback that mirrors decisions of list_files_recursively()
+ * about entering directories.  Returns non-zero if directory should be
+ * read. */
+static int
+walk_filter(const char dir[], const char name[], int depth, void *arg)
+{
+	const walk_params_t *const params = arg;
 
-	if(flags & CF_IGNORE_CASE)
+	if(params->skip_dot_files && name[0] == '.')
 	{
-		safe_qsort(lst, len, sizeof(*lst), &strcasesorter);
-	}
-	else if(flags & CF_RESPECT_CASE)
-	{
-		safe_qsort(lst, len, sizeof(*lst), &strsorter);
+		return 0;
 	}
-	else
-	{
+
+	return !params->check_filters
+	    || filters_file_is_visible(params->view, dir, name, 1, 1);
+}
+
+/* tree_walker_t callback that checks for cancellation request.  Returns
+ * non-zero if walking should stop. */
+static int
+walk_cancelled(void *arg)
+{
+	return ui_cancellation_requested();
+}
+
+/* tree_walker_t callback that reports progress of reading a tree. */
+static void
+walk_progress(void *arg)
+{
+	show_progress("Listing...", 64);
+}
+
+/* Collects files under specified file system tree.  Directories are listed
+ * from results of the walker, which can be NULL, when possible. */
+static void
+list_files_recursively(const view_t *view, const tree_walker_t *walker,
+		const char path[], int skip_dot_files, int flags, strlist_t *list)
+{
+	int i;
+
+	/* Obtain sorted list of files. */
+	int len;
+	char **lst;
+	const tree_walker_dir_t *const listing = tree_walker_get(walker, path);
+	if(listing != NULL)
+	{
+		len = 0;
+		lst = NULL;
+		for(i = 0; i < listing->count; ++i)
+		{
+			len = add_to_string_array(&lst, len, listing->entries[i].name);
+		}
+	}
+	else
+	{
+		lst = list_all_files(path, &len);
+		if(len < 0)
+		{
+			return;
+		}
+	}
+
+	if(flags & CF_IGNORE_CASE)
+	{
+		safe_qsort(lst, len, sizeof(*lst), &strcasesorter);
+	}
+	else if(flags & CF_RESPECT_CASE)
+	{
+		safe_qsort(lst, len, sizeof(*lst), &strsorter);
+	}
+	else
+	{
 		safe_qsort(lst, len, sizeof(*lst), &strossorter);
 	}
 
-	/* Visit all subdirectories ignoring symbolic links to directories. */
-	for(i = 0; i < len && !ui_cancellation_requested(); ++i)
+	/* Visit all subdirectories ignoring symbolic links to directories. */
+	for(i = 0; i < len && !ui_cancellation_requested(); ++i)
+	{
+		if(skip_dot_files && lst[i][0] == '.')
+		{
+			update_string(&lst[i], NULL);
+			continue;
+		}
+
+		char *full_path = join_paths(path, lst[i]);
+		const int dir = is_dir(full_path);
+		if(!filters_file_is_visible(view, path, lst[i], dir, 1))
+		{
+			free(full_path);
+			update_string(&lst[i], NULL);
+			continue;
+		}
+
+		if(dir)
+		{
+			if(!is_symlink(full_path))
+			{
+				list_files_recursively(view, walker, full_path, skip_dot_files, flags,
+						list);
+			}
+			free(full_path);
+			update_string(&lst[i], NULL);
+		}
+		else
+		{
+			free(lst[i]);
+			lst[i] = full_path;
+		}
+
+		show_progress("Listing...", 1000);
+	}
+
+	/* Append files. */
+	for(i = 0; i < len; ++i)
+	{
+		if(lst[i] != NULL)
+		{
+			list->nitems = put_into_string_array(&list->items, list->nitems, lst[i]);
+		}
+	}
+
+	free(lst);
+}
+
+/* Splits files of the lists into classes of identical ones if
+ * add_file_to_diff() would need to read them and stores fingerprints of the
+ * classes in the hashes trie by paths of files.  Files of lists marked in
+ * dups_only don't start new groups.  With non-zero paranoid, contents of files
+ * is compared instead of trusting digests. */
+static void
+precompute_fingerprints(trie_t *hashes, entries_t *lists[],
+		const int dups_only[], int nlists, int paranoid)
+{
+	int i, j, k;
+
+	int total = 0;
+	for(i = 0; i < nlists; ++i)
+	{
+		total += lists[i]->nentries;
+	}
+
+	hash_item_t *const items = reallocarray(NULL, total, sizeof(*items));
+	int *const todo = reallocarray(NULL, total, sizeof(*todo));
+	hash_group_t *const groups = reallocarray(NULL, total, sizeof(*groups));
+	if(items == NULL || todo == NULL || groups == NULL ||
+			ui_cancellation_requested())
+	{
+		/* Fingerprints will be computed on demand. */
+		free(items);
+		free(todo);
+		free(groups);
+		return;
+	}
+
+	k = 0;
+	for(i = 0; i < nlists; ++i)
+	{
+		for(j = 0; j < lists[i]->nentries; ++j)
+		{
+			const hash_item_t item = {
+				.entry = &lists[i]->entries[j],
+				.dups_only = dups_only[i],
+				.cls = -1,
+			};
+			items[k++] = item;
+		}
+	}
+
+	safe_qsort(items, total, sizeof(*items), &size_sorter);
+
+	/* Files of unique size don't need to be read at all. */
+	int error = 0;
+	int count = 0;
+	for(i = 0; i < total; i = j)
+	{
+		for(j = i + 1; j < total && size_sorter(&items[i], &items[j]) == 0; ++j)
+		{
+			/* Find the end of the group. */
+		}
+
+		if(!should_be_read(items, i, j))
+		{
+			continue;
+		}
+
+		for(k = i; k < j; ++k)
+		{
+			char full_path[PATH_MAX + 1];
+			get_full_path_of(items[k].entry, sizeof(full_path), full_path);
+
+			items[count] = items[k];
+			items[count].path = strdup(full_path);
+			error |= (items[count++].path == NULL);
+		}
+	}
+
+	thread_pool_t *const pool = (!error && count > 1)
+	                          ? thread_pool_new(HASH_WORKERS)
+	                          : NULL;
+	hash_job_t job = {
+		.items = items,
+		.todo = todo,
+		.groups = groups,
+		.bunch_size = get_bunch_size(),
+	};
+
+	/* Files of the same size are told apart by digests of their heads. */
+	for(i = 0; i < count && !error; ++i)
+	{
+		todo[job.count++] = i;
+		job.total_bytes += MIN(items[i].entry->size, (uint64_t)PREFIX_SIZE);
+	}
+	job.limit = PREFIX_SIZE;
+	job.title = "Hashing...";
+	run_stage(&job, pool, &hash_files);
+
+	/* Files with the same head are told apart by their whole contents. */
+	int ngroups = 0;
+	safe_qsort(items, count, sizeof(*items), &head_sorter);
+	job.count = 0;
+	job.total_bytes = 0;
+	for(i = 0; i < count && !error; i = j)
+	{
+		for(j = i + 1; j < count && head_sorter(&items[i], &items[j]) == 0; ++j)
+		{
+			/* Find the end of the group. */
+		}
+
+		if(items[i].failed || !should_be_read(items, i, j))
+		{
+			continue;
+		}
+
+		if(paranoid)
+		{
+			groups[ngroups].from = i;
+			groups[ngroups].to = j;
+			++ngroups;
+		}
+
+		/* Large groups are hashed even in paranoid mode to not compare files
+		 * which are known to be different. */
+		if(!paranoid || j - i > job.bunch_size)
+		{
+			for(k = i; k < j; ++k)
+			{
+				todo[job.count++] = k;
+				job.total_bytes += items[k].entry->size;
+			}
+		}
+	}
+	job.limit = 0;
+	run_stage(&job, pool, &hash_files);
+
+	job.count = ngroups;
+	job.total_bytes = 0;
+	for(i = 0; i < ngroups; ++i)
+	{
+		for(k = groups[i].from; k < groups[i].to; ++k)
+		{
+			job.total_bytes += items[k].entry->size;
+		}
+	}
+	job.title = "Comparing...";
+	run_stage(&job, pool, &compare_groups);
+
+	thread_pool_free(pool);
+
+	for(i = 0; i < count; ++i)
+	{
+		if(!error && !ui_cancellation_requested())
+		{
+			store_fingerprint(hashes, &items[i]);
+		}
+		free(items[i].path);
+	}
+
+	free(items);
+	free(todo);
+	free(groups);
+}
+
+/* Checks whether files in the [from; to) range of items need to be read to be
+ * told apart.  Returns non-zero if so, otherwise zero is returned. */
+static int
+should_be_read(const hash_item_t items[], int from, int to)
+{
+	if(to - from < 2)
+	{
+		return 0;
+	}
+
+	/* At least one of the files must be able to start a group. */
+	int i;
+	for(i = from; i < to; ++i)
+	{
+		if(!items[i].dups_only)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Composes fingerprint of the item out of what is known about its file and
+ * puts it into the hashes trie unless the file is already there. */
+static void
+store_fingerprint(trie_t *hashes, const hash_item_t *item)
+{
+	const unsigned long long size = item->entry->size;
+	const unsigned long long head = item->head;
+
+	char *fingerprint;
+	if(item->failed)
+	{
+		fingerprint = strdup("");
+	}
+	else if(item->cls >= 0)
+	{
+		fingerprint = format_str("%" PRINTF_ULL "|%" PRINTF_ULL "|=%d", size, head,
+				item->cls);
+	}
+	else if(item->has_full)
+	{
+		fingerprint = format_str("%" PRINTF_ULL "|%" PRINTF_ULL "|%" PRINTF_ULL,
+				size, head, (unsigned long long)item->full);
+	}
+	else
+	{
+		fingerprint = format_str("%" PRINTF_ULL "|%" PRINTF_ULL, size, head);
+	}
+
+	void *data;
+	if(fingerprint == NULL || trie_get(hashes, item->path, &data) == 0 ||
+			trie_set(hashes, item->path, fingerprint) != 0)
+	{
+		free(fingerprint);
+	}
+}
+
+/* Processes the job on the pool or by the calling thread if pool is NULL. */
+static void
+run_stage(hash_job_t *job, thread_pool_t *pool, thread_pool_func func)
+{
+	if(job->count == 0 || ui_cancellation_requested())
+	{
+		return;
+	}
+
+	job->owner = pthread_self();
+	job->last_progress = -1;
+	job->done = 0;
+	job->done_bytes = 0;
+	pthread_mutex_init(&job->lock, NULL);
+
+	show_progress(job->title, 0);
+
+	if(pool == NULL)
+	{
+		func(job, 0, job->count);
+	}
+	else
+	{
+		thread_pool_for(pool, job->count, 1, func, job);
+	}
+
+	pthread_mutex_destroy(&job->lock);
+}
+
+/* Accounts for processed items and bytes of the job.  Progress is shown only by
+ * the thread that started the job. */
+static void
+report_progress(hash_job_t *job, int items, uint64_t bytes)
+{
+	pthread_mutex_lock(&job->lock);
+	job->done += items;
+	job->done_bytes += bytes;
+	const int done = job->done;
+	const uint64_t done_bytes = job->done_bytes;
+	pthread_mutex_unlock(&job->lock);
+
+	if(!pthread_equal(pthread_self(), job->owner))
+	{
+		return;
+	}
+
+	const int progress = (job->total_bytes == 0)
+	                   ? (done*100)/job->count
+	                   : (int)MIN((done_bytes*100)/job->total_bytes, 100U);
+	if(progress != job->last_progress)
+	{
+		char progress_msg[128];
+
+		job->last_progress = progress;
+		snprintf(progress_msg, sizeof(progress_msg), "%s %d of %d (% 2d%%)",
+				job->title, done, job->count, progress);
+		show_progress(progress_msg, -1);
+	}
+}
+
+/* qsort() comparer that sorts items to be hashed by size of their files.
+ * Returns standard -1, 0, 1 for comparisons. */
+static int
+size_sorter(const void *first, const void *second)
+{
+	const hash_item_t *a = first;
+	const hash_item_t *b = second;
+	return (a->entry->size > b->entry->size) - (a->entry->size < b->entry->size);
+}
+
+/* qsort() comparer that sorts items by size of their files and then by digests
+ * of their heads placing files that couldn't be read first.  Returns standard
+ * -1, 0, 1 for comparisons. */
+static int
+head_sorter(const void *first, const void *second)
+{
+	const hash_item_t *a = first;
+	const hash_item_t *b = second;
+
+	const int by_size = size_sorter(a, b);
+	if(by_size != 0)
+	{
+		return by_size;
+	}
+	if(a->failed || b->failed)
+	{
+		return b->failed - a->failed;
+	}
+	return (a->head > b->head) - (a->head < b->head);
+}
+
+/* qsort() comparer that sorts pointers to items by digests of whole contents
+ * of their files placing files that couldn't be read first.  Returns standard
+ * -1, 0, 1 for comparisons. */
+static int
+full_sorter(const void *first, const void *second)
+{
+	const hash_item_t *a = *(hash_item_t *const *)first;
+	const hash_item_t *b = *(hash_item_t *const *)second;
+
+	if(a->failed || b->failed)
+	{
+		return b->failed - a->failed;
+	}
+	return (a->full > b->full) - (a->full < b->full);
+}
+
+/* thread_pool_for() callback that hashes files of items referred to by the
+ * [from; to) range of the todo list. */
+static void
+hash_files(void *arg, int from, int to)
+{
+	hash_job_t *const job = arg;
+
+	int i;
+	for(i = from; i < to && !ui_cancellation_requested(); ++i)
+	{
+		hash_item_t *const item = &job->items[job->todo[i]];
+
+		uint64_t digest;
+		if(hash_contents(item->path, item->entry->size, job->limit, job,
+					&digest) != 0)
+		{
+			item->failed = 1;
+		}
+		else if(job->limit == 0)
+		{
+			item->full = digest;
+			item->has_full = 1;
+		}
+		else
+		{
+			item->head = digest;
+		}
+
+		report_progress(job, 1, 0);
+	}
+}
+
+/* thread_pool_for() callback that splits groups in the [from; to) range into
+ * classes of identical files by comparing their contents. */
+static void
+compare_groups(void *arg, int from, int to)
+{
+	hash_job_t *const job = arg;
+
+	int i;
+	for(i = from; i < to && !ui_cancellation_requested(); ++i)
+	{
+		const hash_group_t *const group = &job->groups[i];
+		const int n = group->to - group->from;
+
+		hash_item_t **const files = reallocarray(NULL, n, sizeof(*files));
+		if(files == NULL)
+		{
+			int j;
+			for(j = group->from; j < group->to; ++j)
+			{
+				job->items[j].failed = 1;
+			}
+			continue;
+		}
+
+		int j, k;
+		for(j = 0; j < n; ++j)
+		{
+			files[j] = &job->items[group->from + j];
+		}
+
+		/* Files with different digests can't be identical.  Digests are equal for
+		 * all files of groups that weren't hashed. */
+		safe_qsort(files, n, sizeof(*files), &full_sorter);
+
+		int next_cls = 0;
+		for(j = 0; j < n; j = k)
+		{
+			for(k = j + 1; k < n && full_sorter(&files[j], &files[k]) == 0; ++k)
+			{
+				/* Find the end of the subgroup. */
+			}
+
+			if(!files[j]->failed)
+			{
+				split_by_contents(job, &files[j], k - j, &next_cls);
+			}
+		}
+
+		free(files);
+		report_progress(job, 1, 0);
+	}
+}
+
+/* Splits files of the same size into classes of identical ones numbering them
+ * starting with *next_cls.  Files are compared in bunches, which include first
+ * files of classes found in previous bunches. */
+static void
+split_by_contents(hash_job_t *job, hash_item_t *files[], int n, int *next_cls)
+{
+	if(n == 1)
+	{
+		files[0]->cls = (*next_cls)++;
+		return;
+	}
+
+	hash_item_t **const bunch = reallocarray(NULL, n, sizeof(*bunch));
+	if(bunch == NULL)
+	{
+		int i;
+		for(i = 0; i < n; ++i)
+		{
+			files[i]->failed = 1;
+		}
+		return;
+	}
+
+	int nreps = 0;
+	int next = 0;
+	while(next < n && !ui_cancellation_requested())
+	{
+		int count = nreps;
+		do
+		{
+			bunch[count++] = files[next++];
+		}
+		while(next < n && count < MAX(job->bunch_size, nreps + 1));
+
+		nreps = compare_bunch(job, bunch, nreps, count, next_cls);
+	}
+
+	free(bunch);
+}
+
+/* Reads all files of the bunch at the same time splitting them into classes of
+ * identical files.  First nreps files are first files of already known
+ * classes, the rest either joins one of them or starts a new class.  Returns
+ * number of first files of classes, which are moved to the front of the
+ * bunch. */
+static int
+compare_bunch(hash_job_t *job, hash_item_t *bunch[], int nreps, int count,
+		int *next_cls)
+{
+	int i, j;
+
+	const uint64_t size = bunch[0]->entry->size;
+	FILE **const files = calloc(count, sizeof(*files));
+	/* Index of the first file of a class or -1 for files that can't be read. */
+	int *const labels = reallocarray(NULL, count, sizeof(*labels));
+	int *const new_labels = reallocarray(NULL, count, sizeof(*new_labels));
+	int *const sizes = reallocarray(NULL, count, sizeof(*sizes));
+	char *const blocks = reallocarray(NULL, count, VERIFY_BLOCK_SIZE);
+
+	int error = (files == NULL || labels == NULL || new_labels == NULL ||
+	             sizes == NULL || blocks == NULL);
+
+	/* Everything starts as a single class, which is then split on every
+	 * difference. */
+	int first = -1;
+	for(i = 0; i < count && !error; ++i)
+	{
+		files[i] = open_for_reading(bunch[i]->path);
+		if(files[i] == NULL)
+		{
+			labels[i] = -1;
+			continue;
+		}
+
+		if(first == -1)
+		{
+			first = i;
+		}
+		labels[i] = first;
+	}
+
+	uint64_t offset = 0U;
+	while(!error && offset < size)
+	{
+		const size_t len = MIN((uint64_t)VERIFY_BLOCK_SIZE, size - offset);
+		offset += len;
+
+		for(i = 0; i < count; ++i)
+		{
+			sizes[i] = 0;
+		}
+		for(i = 0; i < count; ++i)
+		{
+			if(labels[i] >= 0)
+			{
+				++sizes[labels[i]];
+			}
+		}
+
+		/* Files that already differ from all others aren't read anymore. */
+		int nread = 0;
+		for(i = 0; i < count; ++i)
+		{
+			new_labels[i] = labels[i];
+			if(labels[i] < 0 || sizes[labels[i]] < 2)
+			{
+				continue;
+			}
+
+			if(fread(&blocks[i*VERIFY_BLOCK_SIZE], 1, len, files[i]) != len)
+			{
+				new_labels[i] = -1;
+				continue;
+			}
+
+			/* Leaders of new classes precede their members. */
+			for(j = 0; j < i; ++j)
+			{
+				if(new_labels[j] == j && labels[j] == labels[i] &&
+						memcmp(&blocks[i*VERIFY_BLOCK_SIZE], &blocks[j*VERIFY_BLOCK_SIZE],
+							len) == 0)
+				{
+					break;
+				}
+			}
+			new_labels[i] = j;
+			++nread;
+		}
+
+		memcpy(labels, new_labels, sizeof(*labels)*count);
+
+		report_progress(job, 0, (uint64_t)nread*len);
+		if(nread == 0)
+		{
+			break;
+		}
+		if(ui_cancellation_requested())
+		{
+			error = 1;
+		}
+	}
+
+	for(i = 0; i < count && files != NULL; ++i)
 	{
-		if(skip_dot_files && lst[i][0] == '.')
+		if(files[i] != NULL)
 		{
-			update_string(&lst[i], NULL);
-			continue;
+			fclose(files[i]);
 		}
+	}
 
-		char *full_path = join_paths(path, lst[i]);
-		const int dir = is_dir(full_path);
-		if(!filters_file_is_visible(view, path, lst[i], dir, 1))
+	int new_nreps = 0;
+	if(error)
+	{
+		for(i = nreps; i < count; ++i)
 		{
-			free(full_path);
-			update_string(&lst[i], NULL);
-			continue;
+			bunch[i]->failed = 1;
+		}
+	}
+	else
+	{
+		/* Leader is the first file of its class, so if a class has a file of a
+		 * known class, its leader is such a file. */
+		for(i = nreps; i < count; ++i)
+		{
+			if(labels[i] == i)
+			{
+				bunch[i]->cls = (*next_cls)++;
+			}
 		}
 
-		if(dir)
+		for(i = 0; i < count; ++i)
 		{
-			if(!is_symlink(full_path))
+			if(labels[i] < 0)
 			{
-				list_files_recursively(view, full_path, skip_dot_files, flags, list);
+				bunch[i]->failed |= (i >= nreps);
+			}
+			else if(labels[i] != i)
+			{
+				bunch[i]->cls = bunch[labels[i]]->cls;
 			}
-			free(full_path);
-			update_string(&lst[i], NULL);
 		}
-		else
+
+		for(i = 0; i < count; ++i)
 		{
-			free(lst[i]);
-			lst[i] = full_path;
+			if(labels[i] == i)
+			{
+				bunch[new_nreps++] = bunch[i];
+			}
 		}
+	}
 
-		show_progress("Listing...", 1000);
+	free(files);
+	free(labels);
+	free(new_labels);
+	free(sizes);
+	free(blocks);
+	return new_nreps;
+}
+
+/* Computes how many files a worker compares at once in paranoid mode.  All
+ * workers together use at most half of the limit on open files leaving the
+ * rest to the application.  Returns the number. */
+static int
+get_bunch_size(void)
+{
+#ifndef _WIN32
+	struct rlimit rl;
+	if(getrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur == RLIM_INFINITY)
+	{
+		return VERIFY_FILES;
 	}
+	const long long max_open = rl.rlim_cur;
+#else
+	const long long max_open = _getmaxstdio();
+#endif
 
-	/* Append files. */
-	for(i = 0; i < len; ++i)
+	const long long per_worker = max_open/2/HASH_WORKERS;
+	return MAX(MIN(per_worker, VERIFY_FILES), 2);
+}
+
+/* Assigns ids to entries of the list dropping entries that should be skipped.
+ * The trie is used to keep track of identical files, hashes holds contents
+ * fingerprints computed in advance.  With non-zero dups_only, new files aren't
+ * added to the trie. */
+static void
+assign_ids(trie_t *trie, trie_t *hashes, entries_t *list, int *next_id,
+		CompareType ct, int dups_only, int flags)
+{
+	int i;
+	int j = 0;
+	int last_progress = 0;
+
+	show_progress("Comparing...", 0);
+	for(i = 0; i < list->nentries; ++i)
 	{
-		if(lst[i] != NULL)
+		dir_entry_t *const entry = &list->entries[i];
+
+		/* After cancellation entries are just kept to be freed by the caller. */
+		if(!ui_cancellation_requested())
 		{
-			list->nitems = put_into_string_array(&list->items, list->nitems, lst[i]);
+			char full_path[PATH_MAX + 1];
+			get_full_path_of(entry, sizeof(full_path), full_path);
+
+			entry->id = add_file_to_diff(trie, hashes, full_path, entry, ct,
+					dups_only, flags, next_id);
+			if(entry->id == -1)
+			{
+				fentry_free(entry);
+				continue;
+			}
+		}
+
+		list->entries[j++] = *entry;
+
+		const int progress = (i*100)/list->nentries;
+		if(progress != last_progress)
+		{
+			char progress_msg[128];
+
+			last_progress = progress;
+			snprintf(progress_msg, sizeof(progress_msg), "Comparing... %d (% 2d%%)",
+					i, progress);
+			show_progress(progress_msg, -1);
 		}
 	}
 
-	free(lst);
+	list->nentries = j;
 }
 
 /* Computes fingerprint of the file specified by path and entry.  Type of the
@@ -960,54 +2392,100 @@ get_file_fingerprint(const char path[], const dir_entry_t *entry,
 static char *
 get_contents_fingerprint(const char path[], unsigned long long size)
 {
-	char block[BLOCK_SIZE];
-	size_t to_read = PREFIX_SIZE;
-	FILE *in = os_fopen(path, "rb");
-	if(in == NULL)
+	uint64_t digest;
+	if(hash_contents(path, size, PREFIX_SIZE, NULL, &digest) != 0)
 	{
 		return strdup("");
 	}
 
-	XXH3_state_t *st = XXH3_createState();
-	if(st == NULL)
-	{
-		fclose(in);
-		return strdup("");
-	}
+	return format_str("%" PRINTF_ULL "|%" PRINTF_ULL, size,
+			(unsigned long long)digest);
+}
+
+/* Computes digest of the first limit bytes of the file or of all of it if limit
+ * is zero.  Progress is reported to the job unless it's NULL.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+hash_contents(const char path[], unsigned long long size,
+		unsigned long long limit, hash_job_t *job, uint64_t *digest)
+{
+	const unsigned long long to_hash = (limit == 0U ? size : MIN(size, limit));
 
-	if(XXH3_64bits_reset(st) == XXH_ERROR)
+	char key[256];
+	const int cached = (fpcache_key(path, size, limit, key, sizeof(key)) == 0);
+	if(cached && fpcache_get(key, digest) == 0)
 	{
-		fclose(in);
-		XXH3_freeState(st);
-		return strdup("");
+		if(job != NULL)
+		{
+			report_progress(job, 0, to_hash);
+		}
+		return 0;
 	}
 
-	while(to_read != 0U)
+	const size_t block_size = MIN((unsigned long long)BLOCK_SIZE,
+			MAX(to_hash, 1U));
+	char *const block = malloc(block_size);
+	FILE *const in = open_for_reading(path);
+	XXH3_state_t *const st = XXH3_createState();
+
+	int error = (block == NULL || in == NULL || st == NULL ||
+	             XXH3_64bits_reset(st) == XXH_ERROR);
+
+	unsigned long long to_read = to_hash;
+	while(!error && to_read != 0U)
 	{
-		const size_t portion = MIN(sizeof(block), to_read);
-		const size_t nread = fread(&block, 1, portion, in);
+		const size_t portion = MIN(block_size, to_read);
+		const size_t nread = fread(block, 1, portion, in);
 		if(nread == 0U)
 		{
+			/* File got shorter since its size was queried, it's being changed and
+			 * has to be treated as unreadable to not match other files by a digest
+			 * of a part of it. */
+			error = 1;
 			break;
 		}
 
 		XXH3_64bits_update(st, block, nread);
 		to_read -= nread;
+
+		if(job != NULL)
+		{
+			report_progress(job, 0, nread);
+			error = ui_cancellation_requested();
+		}
 	}
-	fclose(in);
 
-	const unsigned long long digest = XXH3_64bits_digest(st);
-	XXH3_freeState(st);
+	if(!error)
+	{
+		*digest = XXH3_64bits_digest(st);
+		if(cached)
+		{
+			fpcache_put(key, *digest);
+		}
+	}
 
-	return format_str("%" PRINTF_ULL "|%" PRINTF_ULL, size, digest);
+	if(in != NULL)
+	{
+		fclose(in);
+	}
+	XXH3_freeState(st);
+	free(block);
+	return error;
 }
 
 /* Looks up file in the trie by its fingerprint.  Returns id for the file or -1
  * if it should be skipped. */
 static int
-add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
-		CompareType ct, int dups_only, int flags, int *next_id)
+add_file_to_diff(trie_t *trie, trie_t *hashes, const char path[],
+		dir_entry_t *entry, CompareType ct, int dups_only, int flags, int *next_id)
 {
+	void *data = NULL;
+	if(ct == CT_CONTENTS && trie_get(hashes, path, &data) == 0)
+	{
+		/* The file was already told apart from all files it can match. */
+		return add_known_file(trie, path, data, dups_only, next_id);
+	}
+
 	char *fingerprint = get_file_fingerprint(path, entry, ct, flags, /*lazy=*/1);
 	if(is_null_or_empty(fingerprint))
 	{
@@ -1017,7 +2495,6 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 		return -1;
 	}
 
-	void *data = NULL;
 	(void)trie_get(trie, fingerprint, &data);
 
 	compare_record_t *record = data;
@@ -1030,7 +2507,7 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 		free(fingerprint);
 		is_partial = 0;
 
-		fingerprint = get_file_fingerprint(path, entry, ct, flags, /*lazy=*/0);
+		fingerprint = get_contents_fingerprint(path, entry->size);
 		if(is_null_or_empty(fingerprint))
 		{
 			/* In case we couldn't obtain fingerprint (e.g., comparing by contents and
@@ -1063,20 +2540,16 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 		}
 
 		/* Repeat trie lookup with contents fingerprint. */
+		data = NULL;
 		(void)trie_get(trie, fingerprint, &data);
 		record = data;
 
 		/* Fingerprint does not guarantee a match, go through files and find file
 		 * with identical contents. */
-		do
+		while(record != NULL && !files_are_identical(path, record->path))
 		{
-			if(files_are_identical(path, record->path))
-			{
-				break;
-			}
 			record = record->next;
 		}
-		while(record != NULL);
 	}
 
 	if(record != NULL)
@@ -1099,32 +2572,54 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 	return id;
 }
 
-/* Checks whether two files specified by their names hold identical content.
- * Returns non-zero if so, otherwise zero is returned. */
+/* Looks up file in the trie by fingerprint that identifies its class of
+ * identical files.  Returns id for the file or -1 if it should be skipped. */
 static int
-files_are_identical(const char a[], const char b[])
+add_known_file(trie_t *trie, const char path[], const char fingerprint[],
+		int dups_only, int *next_id)
 {
-	char a_block[BLOCK_SIZE], b_block[BLOCK_SIZE];
-	FILE *const a_file = fopen(a, "rb");
-	FILE *const b_file = fopen(b, "rb");
+	if(fingerprint[0] == '\0')
+	{
+		/* The file couldn't be read. */
+		return -1;
+	}
 
-	if(a_file == NULL || b_file == NULL)
+	void *data = NULL;
+	(void)trie_get(trie, fingerprint, &data);
+
+	compare_record_t *const record = data;
+	if(record != NULL)
 	{
-		if(a_file != NULL)
-		{
-			fclose(a_file);
-		}
-		if(b_file != NULL)
-		{
-			fclose(b_file);
-		}
-		return 0;
+		return record->id;
+	}
+
+	if(dups_only)
+	{
+		return -1;
 	}
 
-	while(1)
+	int id = *next_id;
+	++*next_id;
+	put_file_id(trie, path, fingerprint, id, /*is_partial=*/0, CT_CONTENTS);
+	return id;
+}
+
+/* Checks whether two files specified by their names hold identical content.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+files_are_identical(const char a[], const char b[])
+{
+	char *const a_block = malloc(BLOCK_SIZE);
+	char *const b_block = malloc(BLOCK_SIZE);
+	FILE *const a_file = open_for_reading(a);
+	FILE *const b_file = open_for_reading(b);
+
+	int identical = (a_block != NULL && b_block != NULL && a_file != NULL &&
+	                 b_file != NULL);
+	while(identical)
 	{
-		const size_t a_read = fread(&a_block, 1, sizeof(a_block), a_file);
-		const size_t b_read = fread(&b_block, 1, sizeof(b_block), b_file);
+		const size_t a_read = fread(a_block, 1, BLOCK_SIZE, a_file);
+		const size_t b_read = fread(b_block, 1, BLOCK_SIZE, b_file);
 		if(a_read == 0U && b_read == 0U && feof(a_file) && feof(b_file))
 		{
 			/* Ends of both files are reached. */
@@ -1132,17 +2627,43 @@ files_are_identical(const char a[], const char b[])
 		}
 
 		if(a_read == 0 || b_read == 0U || a_read != b_read ||
-				memcmp(a_block, b_block, a_read) != 0)
+				memcmp(a_block, b_block, a_read) != 0 || ui_cancellation_requested())
 		{
-			fclose(a_file);
-			fclose(b_file);
-			return 0;
+			identical = 0;
 		}
 	}
 
-	fclose(a_file);
-	fclose(b_file);
-	return 1;
+	if(a_file != NULL)
+	{
+		fclose(a_file);
+	}
+	if(b_file != NULL)
+	{
+		fclose(b_file);
+	}
+	free(a_block);
+	free(b_block);
+	return identical;
+}
+
+/* Opens a file for reading it sequentially in large blocks.  Returns the
+ * stream or NULL on error. */
+static FILE *
+open_for_reading(const char path[])
+{
+	FILE *const file = os_fopen(path, "rb");
+	if(file == NULL)
+	{
+		return NULL;
+	}
+
+	/* Reads are large enough, buffering of the stream would only add
+	 * copying. */
+	(void)setvbuf(file, NULL, _IONBF, 0);
+#ifdef POSIX_FADV_SEQUENTIAL
+	(void)posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+	return file;
 }
 
 /* Stores id of a file with given fingerprint in the trie. */
@@ -1203,6 +2724,10 @@ compare_move(view_t *from, view_t *to)
 		return 1;
 	}
 
+	/* Results of comparison are going to be changed in place and can't be
+	 * rebuilt anymore. */
+	compare_stop();
+
 	char *from_dir = strdup(replace_home_part(flist_get_dir(from)));
 	char *to_dir = strdup(replace_home_part(flist_get_dir(to)));
 	if(from_dir == NULL || to_dir == NULL)
@@ -1306,5 +2831,216 @@ compare_move_entry(ops_t *ops, view_t *from, view_t *to, int idx)
 	free(to_fingerprint);
 }
 
+int
+compare_cache_load(const char path[])
+{
+	path_store_t *const stored = path_store_open(path);
+
+	pthread_mutex_lock(&fpcache_lock);
+	fpcache_reset();
+	fpcache_stored = stored;
+	pthread_mutex_unlock(&fpcache_lock);
+
+	return (stored == NULL);
+}
+
+int
+compare_cache_store(const char path[])
+{
+	int i;
+	int error = 0;
+
+	pthread_mutex_lock(&fpcache_lock);
+
+	/* Nothing to add to the file. */
+	if(fpcache_count == 0)
+	{
+		pthread_mutex_unlock(&fpcache_lock);
+		return 0;
+	}
+
+	/* Merge with the current version of the file to keep what other instances
+	 * might have stored since it was loaded. */
+	path_store_t *const current = path_store_open(path);
+	const int stored_count = path_store_count(current);
+
+	const int max_count = fpcache_count + stored_count;
+	const char **const keys = reallocarray(NULL, max_count, sizeof(*keys));
+	path_store_rec_t *const recs = reallocarray(NULL, max_count, sizeof(*recs));
+	error = (keys == NULL || recs == NULL);
+
+	int count = 0;
+	for(i = 0; i < fpcache_count && !error; ++i, ++count)
+	{
+		keys[count] = fpcache_keys[i];
+		recs[count] = fpcache_recs[i];
+	}
+	for(i = 0; i < stored_count && !error; ++i)
+	{
+		void *data;
+		const char *const key = path_store_at(current, i, &recs[count]);
+		if(trie_get(fpcache_index, key, &data) != 0)
+		{
+			keys[count++] = key;
+		}
+	}
+
+	if(!error)
+	{
+		error = path_store_write(path, keys, recs, count, FPCACHE_MAX_STORED);
+	}
+
+	pthread_mutex_unlock(&fpcache_lock);
+
+	path_store_close(current);
+	free(keys);
+	free(recs);
+	return error;
+}
+
+/* Formats key of the cache of fingerprints that identifies current state of
+ * the file.  Returns zero on success and non-zero if fingerprint of the file
+ * shouldn't be cached. */
+static int
+fpcache_key(const char path[], unsigned long long size,
+		unsigned long long limit, char key[], size_t key_len)
+{
+#ifndef _WIN32
+	struct stat st;
+	if(!cfg.compare_cache || os_stat(path, &st) != 0 || !S_ISREG(st.st_mode) ||
+			(unsigned long long)st.st_size != size)
+	{
+		return 1;
+	}
+
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+	const int64_t mtime = st.st_mtim.tv_sec*1000000000LL + st.st_mtim.tv_nsec;
+	const int64_t ctime = st.st_ctim.tv_sec*1000000000LL + st.st_ctim.tv_nsec;
+#else
+	const int64_t mtime = st.st_mtime*1000000000LL;
+	const int64_t ctime = st.st_ctime*1000000000LL;
+#endif
+
+	/* Amount of hashed data (zero for all of it) goes first to not mix digests
+	 * of different kinds. */
+	snprintf(key, key_len, "%" PRINTF_ULL ":%" PRINTF_ULL ":%" PRINTF_ULL
+			":%" PRINTF_ULL ":%lld:%lld", limit, (unsigned long long)st.st_dev,
+			(unsigned long long)st.st_ino, size, (long long)mtime, (long long)ctime);
+	return 0;
+#else
+	/* There are no inode numbers to identify files by. */
+	return 1;
+#endif
+}
+
+/* Looks up digest by its key in the cache of fingerprints.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+fpcache_get(const char key[], uint64_t *digest)
+{
+	pthread_mutex_lock(&fpcache_lock);
+
+	void *data;
+	if(trie_get(fpcache_index, key, &data) == 0)
+	{
+		*digest = fpcache_recs[(intptr_t)data - 1].value;
+		pthread_mutex_unlock(&fpcache_lock);
+		return 0;
+	}
+
+	path_store_rec_t rec;
+	const int found = (path_store_get(fpcache_stored, key, &rec) == 0);
+	pthread_mutex_unlock(&fpcache_lock);
+
+	if(!found)
+	{
+		return 1;
+	}
+
+	*digest = rec.value;
+	/* Remember the use to keep the fingerprint in the file. */
+	fpcache_put(key, rec.value);
+	return 0;
+}
+
+/* Adds digest to the cache of fingerprints. */
+static void
+fpcache_put(const char key[], uint64_t digest)
+{
+	pthread_mutex_lock(&fpcache_lock);
+
+	if(fpcache_index == NULL)
+	{
+		fpcache_index = trie_create(NULL);
+	}
+
+	void *data;
+	if(trie_get(fpcache_index, key, &data) == 0)
+	{
+		pthread_mutex_unlock(&fpcache_lock);
+		return;
+	}
+
+	if(fpcache_count == fpcache_capacity)
+	{
+		const int capacity = (fpcache_capacity == 0 ? 256 : fpcache_capacity*2);
+		char **const keys = reallocarray(fpcache_keys, capacity, sizeof(*keys));
+		if(keys != NULL)
+		{
+			fpcache_keys = keys;
+		}
+		path_store_rec_t *const recs = reallocarray(fpcache_recs, capacity,
+				sizeof(*recs));
+		if(recs != NULL)
+		{
+			fpcache_recs = recs;
+		}
+		if(keys == NULL || recs == NULL)
+		{
+			pthread_mutex_unlock(&fpcache_lock);
+			return;
+		}
+		fpcache_capacity = capacity;
+	}
+
+	char *const copy = strdup(key);
+	if(copy == NULL ||
+			trie_set(fpcache_index, key, (void *)(intptr_t)(fpcache_count + 1)) != 0)
+	{
+		free(copy);
+		pthread_mutex_unlock(&fpcache_lock);
+		return;
+	}
+
+	const path_store_rec_t rec = {
+		.value = digest,
+		.timestamp = time(NULL),
+	};
+	fpcache_keys[fpcache_count] = copy;
+	fpcache_recs[fpcache_count] = rec;
+	++fpcache_count;
+
+	pthread_mutex_unlock(&fpcache_lock);
+}
+
+/* Empties the cache of fingerprints.  Must be called with fpcache_lock
+ * held. */
+static void
+fpcache_reset(void)
+{
+	path_store_close(fpcache_stored);
+	fpcache_stored = NULL;
+
+	trie_free(fpcache_index);
+	fpcache_index = NULL;
+
+	free_string_array(fpcache_keys, fpcache_count);
+	fpcache_keys = NULL;
+	free(fpcache_recs);
+	fpcache_recs = NULL;
+	fpcache_count = 0;
+	fpcache_capacity = 0;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 : */
@@ -20,6 +20,7 @@
 #define VIFM__DIFF_H__
 
 #include "ui/ui.h"
+#include "utils/test_helpers.h"
 
 /* Comparison flags. */
 typedef enum
@@ -38,6 +39,10 @@ typedef enum
 	CF_SHOW_UNIQUE_RIGHT = 128, /* Show unique right files in comparison. */
 
 	CF_SINGLE_PANE       = 256, /* Single pane mode */
+	CF_PARANOID          = 512, /* Compare contents of files instead of trusting
+	                               digests of contents. */
+	CF_PROGRESSIVE      = 1024, /* Compare two panes in batches between handling
+	                               of user input displaying results so far. */
 
 	/* Mask of show* flags. */
 	CF_SHOW = CF_SHOW_IDENTICAL
@@ -51,6 +56,15 @@ CompareFlags;
  * system trees.  Returns non-zero if status bar message should be preserved. */
 int compare_two_panes(CompareType ct, ListType lt, int flags);
 
+/* Processes next batch of files of progressive comparison of two panes, if
+ * any.  Returns non-zero if there was something to do, otherwise zero is
+ * returned. */
+int compare_continue(void);
+
+/* Stops progressive comparison of two panes, if any.  Results displayed so far
+ * are left in views. */
+void compare_stop(void);
+
 /* Replaces single pane with information derived from its files.  Returns
  * non-zero if status bar message should be preserved. */
 int compare_one_pane(view_t *view, CompareType ct, ListType lt, int flags);
@@ -59,6 +73,19 @@ int compare_one_pane(view_t *view, CompareType ct, ListType lt, int flags);
  * bar message should be preserved. */
 int compare_move(view_t *from, view_t *to);
 
+/* Replaces cache of contents fingerprints with the one stored in the file at
+ * the path.  Returns zero on success, otherwise non-zero is returned. */
+int compare_cache_load(const char path[]);
+
+/* Writes fingerprints used since the cache was loaded to the file at the path
+ * merging them with its current contents.  Returns zero on success, otherwise
+ * non-zero is returned. */
+int compare_cache_store(const char path[]);
+
+TSTATIC_DEFS(
+	int progressive_batch;
+)
+
 #endif /* VIFM__DIFF_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
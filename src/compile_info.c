@@ -0,0 +1 @@
+const char GIT_INFO[] = "874bb0ca57d6";
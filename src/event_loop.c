@@ -51,10 +51,14 @@
 #include "utils/utils.h"
 #include "background.h"
 #include "bracket_notation.h"
+#include "compare.h"
 #include "filelist.h"
+#include "filtering.h"
 #include "instance.h"
 #include "ipc.h"
 #include "registers.h"
+#include "search.h"
+#include "size_watch.h"
 #include "status.h"
 #include "vcache.h"
 #include "vifm.h"
@@ -385,6 +389,7 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout)
 		{
 			check_view_for_changes(curr_view);
 			check_view_for_changes(other_view);
+			size_watch_check();
 		}
 
 		process_scheduled_updates();
@@ -492,6 +497,13 @@ process_scheduled_updates(void)
 
 	ui_stat_job_bar_check_for_updates();
 
+	/* Comparison rebuilds both views, so let it proceed only when the user
+	 * isn't in the middle of doing something with them. */
+	if(vle_mode_is(NORMAL_MODE))
+	{
+		(void)compare_continue();
+	}
+
 	if(vle_mode_get_primary() != MENU_MODE)
 	{
 		need_redraw += (process_scheduled_updates_of_view(curr_view) != 0);
@@ -516,6 +528,11 @@ process_scheduled_updates_of_view(view_t *view)
 		return 0;
 	}
 
+	/* This schedules a redraw if there was something to do. */
+	(void)local_filter_continue(view);
+	(void)search_continue(view);
+	(void)flist_fold_continue(view);
+
 	switch(ui_view_query_scheduled_event(view))
 	{
 		case UUE_NONE:
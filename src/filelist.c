@@ -44,6 +44,7 @@
 #include "compat/fs_limits.h"
 #include "compat/os.h"
 #include "compat/pthread.h"
+#include "compat/reallocarray.h"
 #include "engine/autocmds.h"
 #include "engine/mode.h"
 #include "int/fuse.h"
@@ -57,6 +58,9 @@
 #include "ui/statusline.h"
 #include "ui/tabs.h"
 #include "ui/ui.h"
+#ifndef _WIN32
+#include "utils/dir_reader.h"
+#endif
 #include "utils/dynarray.h"
 #include "utils/env.h"
 #include "utils/fs.h"
@@ -70,10 +74,13 @@
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
+#include "utils/thread_pool.h"
+#include "utils/tree_walker.h"
 #include "utils/trie.h"
 #include "utils/utf8.h"
 #include "utils/utils.h"
 #include "filtering.h"
+#include "flist_cache.h"
 #include "flist_hist.h"
 #include "flist_pos.h"
 #include "flist_sel.h"
@@ -82,11 +89,21 @@
 #include "marks.h"
 #include "opt_handlers.h"
 #include "registers.h"
+#include "search.h"
 #include "running.h"
 #include "sort.h"
 #include "status.h"
 #include "types.h"
 
+/* Number of threads that load postponed meta-data of entries. */
+#define META_WORKERS 8
+
+/* Minimal number of entries to load their meta-data in parallel. */
+#define MIN_PARALLEL_META 256
+
+/* Number of entries processed by a meta-data worker at a time. */
+#define META_CHUNK 64
+
 /* State of a fold. */
 typedef enum
 {
@@ -99,6 +116,41 @@ typedef enum
 }
 FoldState;
 
+/* Parameters of reading a tree in parallel. */
+typedef struct
+{
+	view_t *view;           /* View for which the tree is built. */
+	trie_t *excluded_paths; /* Paths to skip. */
+	trie_t *folded_paths;   /* States of folds. */
+	int check_filters;      /* Whether filters can be checked from threads. */
+}
+walk_params_t;
+
+/* Reading of subtree of unfolded directory of a tree view in background. */
+struct subtree_job_t
+{
+	walk_params_t params;  /* Parameters of the walk, must be the first field. */
+	char *path;            /* Path to the directory. */
+	pthread_t thread;      /* Thread that performs the walk. */
+	pthread_mutex_t lock;  /* Protects fields below. */
+	int done;              /* Whether the walk is over. */
+	int cancelled;         /* Whether the walk should stop. */
+	tree_walker_t *walker; /* Results of the walk or NULL. */
+};
+
+#ifndef _WIN32
+
+/* Work item for loading postponed meta-data in parallel. */
+typedef struct
+{
+	dir_entry_t **entries; /* Entries whose meta-data is being loaded. */
+	struct stat *stats;    /* Results of lstat() for every entry. */
+	char *failed;          /* Whether lstat() has failed for every entry. */
+}
+meta_job_t;
+
+#endif
+
 static void init_flist(view_t *view);
 static void reset_view(view_t *view);
 static void init_view_history(view_t *view);
@@ -109,6 +161,13 @@ static void on_custom_view_leave(view_t *view);
 #ifndef _WIN32
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
 		const struct dirent *d);
+static int fill_dir_entry_from_stat(dir_entry_t *entry, const char path[],
+		const struct stat *s, FileType type_hint);
+static void fill_dir_entry_lazily(dir_entry_t *entry, const char path[],
+		FileType type);
+static void finish_lazy_entry(dir_entry_t *entry, const char path[],
+		const struct stat *s);
+static void stat_pending_entries(void *arg, int from, int to);
 static int data_is_dir_entry(const struct dirent *d, const char path[]);
 #else
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
@@ -146,6 +205,12 @@ static void fix_tree_links(dir_entry_t *entries, dir_entry_t *entry,
 static int is_dir_big(const char path[]);
 static void free_view_entries(view_t *view);
 static int update_dir_list(view_t *view, int reload);
+static int read_dir_content(view_t *view, int reload);
+#ifndef _WIN32
+static int read_dir_content_async(view_t *view, int draw_partial);
+static void add_read_entry_to_view(view_t *view, dir_reader_entry_t *rentry);
+static void draw_partial_list(view_t *view);
+#endif
 static void start_dir_list_change(view_t *view, dir_entry_t **entries, int *len,
 		int reload);
 static void finish_dir_list_change(view_t *view, dir_entry_t *entries, int len);
@@ -162,9 +227,22 @@ static int correct_pos(view_t *view, int pos, int dist, int closest);
 static int rescue_from_empty_filelist(view_t *view);
 static void add_parent_entry(view_t *view, dir_entry_t **entries, int *count);
 static void init_dir_entry(view_t *view, dir_entry_t *entry, const char name[]);
+static void free_entry_name(dir_entry_t *entry);
+static void renew_name_pool(view_t *view);
 static dir_entry_t * alloc_dir_entry(dir_entry_t **list, int list_size);
+static int apply_dir_changes(view_t *view,
+		const fswatch_change_t changes[], int nchanges);
 static int tree_has_changed(const dir_entry_t *entries, size_t nchildren);
-static FSWatchState poll_watcher(fswatch_t *watch, const char path[]);
+static FSWatchState poll_watcher(fswatch_t *watch, const char path[],
+		fswatch_change_t **changes, int *nchanges);
+static int start_subtree_job(view_t *view, int pos);
+static void * subtree_job_main(void *arg);
+static int subtree_walk_cancelled(void *arg);
+static void drop_subtree_job(view_t *view);
+static void free_subtree_job(struct subtree_job_t *job);
+static int find_tree_entry(const view_t *view, const char path[]);
+static int can_splice_subtree(const view_t *view, int pos);
+static int splice_subtree(view_t *view, int pos, const tree_walker_t *walker);
 static void remove_child_entries(view_t *view, dir_entry_t *entry);
 static void find_dir_in_cdpath(const char base_dir[], const char dst[],
 		char buf[], size_t buf_size);
@@ -186,13 +264,20 @@ static int complete_tree(const char name[], int valid, const void *parent_data,
 		void *data, void *arg);
 static void reset_entry_list(view_t *view, dir_entry_t **entries, int *count);
 static void drop_tops(dir_entry_t *entries, int *nentries, int extra);
-static int add_files_recursively(view_t *view, const char path[],
-		trie_t *excluded_paths, trie_t *folded_paths, int parent_pos,
-		int no_direct_parent, int depth);
+static tree_walker_t * walk_tree(view_t *view, const char path[],
+		trie_t *excluded_paths, trie_t *folded_paths, int depth);
+static int walk_filter(const char dir[], const char name[], int depth,
+		void *arg);
+static int walk_cancelled(void *arg);
+static void walk_progress(void *arg);
+static int add_files_recursively(view_t *view, const tree_walker_t *walker,
+		const char path[], trie_t *excluded_paths, trie_t *folded_paths,
+		int parent_pos, int no_direct_parent, int depth);
 static FoldState get_fold_state(trie_t *folded_paths, const char full_path[]);
 static int set_fold_state(trie_t *folded_paths, const char full_path[],
 		FoldState state);
 static int entry_is_visible(view_t *view, const char name[], const void *data);
+static int name_is_visible(view_t *view, const char name[], int is_dir);
 static int tree_candidate_is_visible(view_t *view, const char path[],
 		const char name[], int is_dir, int apply_local_filter);
 static int add_directory_leaf(view_t *view, const char path[], int parent_pos);
@@ -236,8 +321,11 @@ init_flist(view_t *view)
 
 	view->watched_dir = NULL;
 	view->last_dir = NULL;
+	view->name_pool = NULL;
 
 	view->matches = 0;
+	view->search_state = NULL;
+	view->subtree_job = NULL;
 
 	view->custom.entries = NULL;
 	view->custom.entry_count = 0;
@@ -247,6 +335,7 @@ init_flist(view_t *view)
 	/* Load fake empty element to make dir_entry valid. */
 	view->dir_entry = dynarray_cextend(NULL, sizeof(dir_entry_t));
 	view->dir_entry[0].name = strdup("");
+	view->dir_entry[0].name_pool = NULL;
 	view->dir_entry[0].type = FT_DIR;
 	view->dir_entry[0].hi_num = -1;
 	view->dir_entry[0].name_dec_num = -1;
@@ -283,6 +372,12 @@ flist_free_view(view_t *view)
 	view->local_filter.unfiltered_count = 0;
 
 	update_string(&view->local_filter.prev, NULL);
+
+	search_cancel(view);
+	drop_subtree_job(view);
+
+	str_pool_unref(view->name_pool);
+	view->name_pool = NULL;
 	free(view->local_filter.poshist);
 	view->local_filter.poshist = NULL;
 
@@ -412,7 +507,9 @@ get_current_entry(const view_t *view)
 		return NULL;
 	}
 
-	return &view->dir_entry[view->list_pos];
+	dir_entry_t *const entry = &view->dir_entry[view->list_pos];
+	fentry_load_meta(entry);
+	return entry;
 }
 
 char *
@@ -858,6 +955,7 @@ flist_custom_start(view_t *view, const char title[])
 {
 	free_dir_entries(&view->custom.entries, &view->custom.entry_count);
 	(void)replace_string(&view->custom.next_title, title);
+	renew_name_pool(view);
 
 	trie_free(view->custom.paths_cache);
 	view->custom.paths_cache = trie_create(/*free_func=*/NULL);
@@ -940,10 +1038,26 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 		return 1;
 	}
 
-	entry->type = get_type_from_mode(s.st_mode);
+	FileType type_hint = FT_UNK;
+	if(get_type_from_mode(s.st_mode) == FT_UNK && d != NULL)
+	{
+		type_hint = type_from_dir_entry(d, path);
+	}
+
+	return fill_dir_entry_from_stat(entry, path, &s, type_hint);
+}
+
+/* Fills fields of the entry from already retrieved lstat() information of the
+ * file specified by its path.  type_hint is used if type can't be derived from
+ * the mode.  Returns zero on success, otherwise non-zero is returned. */
+static int
+fill_dir_entry_from_stat(dir_entry_t *entry, const char path[],
+		const struct stat *s, FileType type_hint)
+{
+	entry->type = get_type_from_mode(s->st_mode);
 	if(entry->type == FT_UNK)
 	{
-		entry->type = (d == NULL) ? FT_UNK : type_from_dir_entry(d, path);
+		entry->type = type_hint;
 	}
 	if(entry->type == FT_UNK)
 	{
@@ -951,15 +1065,15 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 		return 1;
 	}
 
-	entry->size = (uintmax_t)s.st_size;
-	entry->uid = s.st_uid;
-	entry->gid = s.st_gid;
-	entry->mode = s.st_mode;
-	entry->inode = s.st_ino;
-	entry->mtime = s.st_mtime;
-	entry->atime = s.st_atime;
-	entry->ctime = s.st_ctime;
-	entry->nlinks = s.st_nlink;
+	entry->size = (uintmax_t)s->st_size;
+	entry->uid = s->st_uid;
+	entry->gid = s->st_gid;
+	entry->mode = s->st_mode;
+	entry->inode = s->st_ino;
+	entry->mtime = s->st_mtime;
+	entry->atime = s->st_atime;
+	entry->ctime = s->st_ctime;
+	entry->nlinks = s->st_nlink;
 
 	if(entry->type == FT_LINK)
 	{
@@ -970,7 +1084,7 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 		entry->slow_target = (symlink_type == SLT_SLOW);
 
 		/* Query mode of symbolic link target. */
-		if(!entry->slow_target && os_stat(entry->name, &s) == 0)
+		if(!entry->slow_target && os_stat(path, &s) == 0)
 		{
 			entry->mode = s.st_mode;
 		}
@@ -979,6 +1093,59 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 	return 0;
 }
 
+/* Fills only type of the entry postponing querying of the rest of its
+ * meta-data until it's needed. */
+static void
+fill_dir_entry_lazily(dir_entry_t *entry, const char path[], FileType type)
+{
+	entry->type = type;
+	entry->meta_pending = 1;
+
+	if(type == FT_LINK)
+	{
+		const SymLinkType symlink_type = get_symlink_type(path);
+		entry->dir_link = (symlink_type != SLT_UNKNOWN);
+		entry->slow_target = (symlink_type == SLT_SLOW);
+	}
+}
+
+/* Completes lazily filled entry with meta-data. */
+static void
+finish_lazy_entry(dir_entry_t *entry, const char path[], const struct stat *s)
+{
+	const FileType type = entry->type;
+
+	entry->meta_pending = 0;
+	if(fill_dir_entry_from_stat(entry, path, s, type) != 0)
+	{
+		entry->type = type;
+	}
+
+	/* Type might become more precise (e.g., executable file), which affects
+	 * highlighting and decorations. */
+	if(entry->type != type)
+	{
+		entry->hi_num = -1;
+		entry->name_dec_num = -1;
+	}
+}
+
+/* Queries meta-data of entries in the [from; to) range of a job.  arg points
+ * at meta_job_t. */
+static void
+stat_pending_entries(void *arg, int from, int to)
+{
+	meta_job_t *const job = arg;
+
+	int i;
+	for(i = from; i < to; ++i)
+	{
+		char full_path[PATH_MAX + 1];
+		get_full_path_of(job->entries[i], sizeof(full_path), full_path);
+		job->failed[i] = (os_lstat(full_path, &job->stats[i]) != 0);
+	}
+}
+
 /* Checks whether file is a directory.  Returns non-zero if so, otherwise zero
  * is returned. */
 static int
@@ -1039,7 +1206,7 @@ fill_dir_entry(dir_entry_t *entry, const char path[],
 	else if(ffd->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
 	{
 		/* Windows doesn't like returning size of directories when it can. */
-		entry->size = get_file_size(entry->name);
+		entry->size = get_file_size(path);
 		entry->type = FT_DIR;
 	}
 	else if(is_win_executable(path))
@@ -1071,6 +1238,14 @@ flist_custom_finish(view_t *view, CVType type, int allow_empty)
 			allow_empty);
 }
 
+int
+flist_custom_refresh(view_t *view, CVType type, int allow_empty)
+{
+	assert(flist_custom_active(view) && "Refreshing a non-custom view.");
+	return flist_custom_finish_internal(view, type, 1, flist_get_dir(view),
+			allow_empty);
+}
+
 /* Finishes file list population, handles empty resulting list corner case.
  * reload flag suppresses actions taken on location change.  dir is current
  * directory of the view.  Returns zero on success, otherwise (on empty list)
@@ -1136,6 +1311,7 @@ flist_custom_finish_internal(view_t *view, CVType type, int reload,
 	view->custom.entry_count = 0;
 	view->dir_entry = dynarray_shrink(view->dir_entry);
 	view->filtered = 0;
+	search_cancel(view);
 	view->matches = 0;
 
 	/* Kind of custom view must be set to correct value before option loading and
@@ -1401,7 +1577,7 @@ flist_custom_clone(view_t *to, const view_t *from, int as_tree)
 		}
 
 		dst[j] = src[i];
-		dst[j].name = strdup(dst[j].name);
+		(void)fentry_dup_name(&dst[j]);
 		dst[j].origin = (dst[j].owns_origin ? strdup(dst[j].origin) : to->curr_dir);
 
 		if(!dst_is_tree)
@@ -1709,8 +1885,6 @@ load_dir_list_internal(view_t *view, int reload, int draw_only)
 static int
 populate_dir_list_internal(view_t *view, int reload)
 {
-	char *saved_cwd;
-
 	view->filtered = 0;
 
 	/* List reload usually implies that something related to file list has
@@ -1732,17 +1906,19 @@ populate_dir_list_internal(view_t *view, int reload)
 		ui_sb_quick_msgf("%s", "Reading directory...");
 	}
 
+	renew_name_pool(view);
+
 	if(curr_stats.load_stage < 2)
 	{
 		update_all_windows();
 	}
 
-	saved_cwd = save_cwd();
-	/* this is needed for lstat() below */
-	if(vifm_chdir(view->curr_dir) != 0 && !is_unc_root(view->curr_dir))
+	/* Files are queried by their full paths, so there is no need to change
+	 * current directory of the process, but lack of search permission has to be
+	 * detected here. */
+	if(!directory_accessible(view->curr_dir))
 	{
-		LOG_SERROR_MSG(errno, "Can't chdir() into \"%s\"", view->curr_dir);
-		restore_cwd(saved_cwd);
+		LOG_SERROR_MSG(errno, "Can't access \"%s\"", view->curr_dir);
 		return 1;
 	}
 
@@ -1751,7 +1927,7 @@ populate_dir_list_internal(view_t *view, int reload)
 			stroscmp(view->watched_dir, view->curr_dir) == 0)
 	{
 		/* Drain all events that happened before this point. */
-		(void)poll_watcher(view->watch, view->curr_dir);
+		(void)poll_watcher(view->watch, view->curr_dir, NULL, NULL);
 	}
 
 	if(is_unc_root(view->curr_dir))
@@ -1812,7 +1988,6 @@ populate_dir_list_internal(view_t *view, int reload)
 	{
 		if(rescue_from_empty_filelist(view))
 		{
-			restore_cwd(saved_cwd);
 			return 0;
 		}
 
@@ -1834,7 +2009,6 @@ populate_dir_list_internal(view_t *view, int reload)
 		vle_aucmd_execute("DirEnter", view->curr_dir, view);
 	}
 
-	restore_cwd(saved_cwd);
 	return 0;
 }
 
@@ -2005,7 +2179,7 @@ zap_compare_view(view_t *view, view_t *other, zap_filter filter, void *arg)
 				}
 				continue;
 			}
-			replace_string(&entry->name, "");
+			(void)fentry_set_name(entry, "");
 			entry->type = FT_UNK;
 			entry->id = other->dir_entry[i].id;
 		}
@@ -2299,10 +2473,26 @@ update_dir_list(view_t *view, int reload)
 
 	start_dir_list_change(view, &prev_dir_entries, &prev_list_rows, reload);
 
-	if(enum_dir_content(view->curr_dir, &add_file_entry_to_view, view) != 0)
+	if(!reload && flist_cache_get(view))
+	{
+		/* Sizes of directories and alike might have changed since the listing was
+		 * sorted. */
+		if(sort_needs_meta(view->sort))
+		{
+			sort_dir_list(1, view);
+		}
+		finish_dir_list_change(view, NULL, 0);
+		return 0;
+	}
+
+	/* Watching must start before reading to not miss any changes. */
+	fswatch_t *const watch = flist_cache_prepare(view->curr_dir);
+
+	if(read_dir_content(view, reload) != 0)
 	{
-		LOG_SERROR_MSG(errno, "Can't opendir() \"%s\"", view->curr_dir);
+		LOG_SERROR_MSG(errno, "Can't read \"%s\"", view->curr_dir);
 		free_dir_entries(&prev_dir_entries, &prev_list_rows);
+		fswatch_free(watch);
 		return 1;
 	}
 
@@ -2312,15 +2502,189 @@ update_dir_list(view_t *view, int reload)
 		add_parent_dir(view);
 	}
 
-	sort_dir_list(!reload, view);
+	/* On reload most of the files are usually where they were. */
+	if(!reload ||
+			sort_view_incrementally(view, prev_dir_entries, prev_list_rows) != 0)
+	{
+		sort_dir_list(!reload, view);
+	}
 
 	/* Merging must be performed after sorting so that list position remains fixed
 	 * (sorting doesn't preserve it). */
 	finish_dir_list_change(view, prev_dir_entries, prev_list_rows);
 
+	flist_cache_put(view, watch);
+
 	return 0;
 }
 
+/* Fills list of entries of the view with contents of its current directory.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+read_dir_content(view_t *view, int reload)
+{
+#ifndef _WIN32
+	/* Big directories are read in background and displayed as soon as beginning
+	 * of the list is available, which also allows cancelling the reading. */
+	if(is_dir_big(view->curr_dir))
+	{
+		return read_dir_content_async(view, !reload);
+	}
+#endif
+
+	return enum_dir_content(view->curr_dir, &add_file_entry_to_view, view);
+}
+
+#ifndef _WIN32
+
+/* Reads contents of current directory of the view on a separate thread
+ * streaming its entries into the view.  The draw_partial parameter enables
+ * drawing of the first screenful of entries before the reading is done.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+read_dir_content_async(view_t *view, int draw_partial)
+{
+	/* Sorting and layout of ls-like view might need meta-data of every entry
+	 * before the list can be displayed.  Filters need only types of files while
+	 * columns and highlighting need meta-data only for visible entries, which get
+	 * it on being drawn. */
+	const int lazy = !sort_needs_meta(view->sort)
+	              && !ui_view_names_need_meta(view);
+
+	dir_reader_t *const reader = dir_reader_start(view->curr_dir, lazy);
+	if(reader == NULL)
+	{
+		return 1;
+	}
+
+	int partial_drawn = !draw_partial;
+	DirReaderState state;
+
+	show_progress("", 0);
+	ui_cancellation_push_on();
+	do
+	{
+		dir_reader_batch_t batch;
+		state = dir_reader_next(reader, 100, &batch);
+
+		if(state == DRS_BATCH)
+		{
+			int i;
+			for(i = 0; i < batch.count; ++i)
+			{
+				add_read_entry_to_view(view, &batch.entries[i]);
+				if(draw_partial)
+				{
+					show_progress("Reading directory...", 1000);
+				}
+			}
+			dir_reader_free_batch(&batch);
+		}
+
+		if(!partial_drawn && view->list_rows >= MAX(view->window_cells, 1))
+		{
+			draw_partial_list(view);
+			partial_drawn = 1;
+		}
+
+		if(ui_cancellation_requested())
+		{
+			LOG_INFO_MSG("Reading of \"%s\" was cancelled", view->curr_dir);
+			state = DRS_FAILED;
+		}
+	}
+	while(state == DRS_BATCH || state == DRS_TIMEOUT);
+	ui_cancellation_pop();
+
+	dir_reader_free(reader);
+	return (state == DRS_DONE ? 0 : 1);
+}
+
+/* Appends entry produced by directory reader to the list of the view unless
+ * it's filtered out. */
+static void
+add_read_entry_to_view(view_t *view, dir_reader_entry_t *rentry)
+{
+	const char *const name = rentry->name;
+	if(view->hide_dot && name[0] == '.')
+	{
+		++view->filtered;
+		return;
+	}
+
+	char full_path[PATH_MAX + 1];
+	snprintf(full_path, sizeof(full_path), "%s/%s", flist_get_dir(view), name);
+
+	if(rentry->stat_failed)
+	{
+		LOG_ERROR_MSG("Can't lstat() \"%s\"", full_path);
+		return;
+	}
+
+	const FileType type = rentry->stat_skipped
+	                    ? type_from_dtype(rentry->dtype)
+	                    : get_type_from_mode(rentry->stat.st_mode);
+	const int is_dir = (type == FT_LINK)
+	                 ? (get_symlink_type(full_path) != SLT_UNKNOWN)
+	                 : (type == FT_DIR);
+	if(!filters_file_is_visible(view, view->curr_dir, name, is_dir,
+				/*apply_local_filter=*/1))
+	{
+		++view->filtered;
+		return;
+	}
+
+	dir_entry_t *const entry = alloc_dir_entry(&view->dir_entry,
+			view->list_rows);
+	if(entry == NULL)
+	{
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		return;
+	}
+
+	init_dir_entry(view, entry, name);
+
+	if(rentry->stat_skipped)
+	{
+		fill_dir_entry_lazily(entry, full_path, type);
+		++view->list_rows;
+	}
+	else if(fill_dir_entry_from_stat(entry, full_path, &rentry->stat,
+				type_from_dtype(rentry->dtype)) == 0)
+	{
+		++view->list_rows;
+	}
+	else
+	{
+		fentry_free(entry);
+	}
+}
+
+/* Displays beginning of file list of the view which is still being loaded. */
+static void
+draw_partial_list(view_t *view)
+{
+	const int list_pos = view->list_pos;
+	const int top_line = view->top_line;
+	const int curr_line = view->curr_line;
+
+	view->list_pos = 0;
+	view->top_line = 0;
+	view->curr_line = 0;
+
+	sort_view(view);
+	fview_update_geometry(view);
+	fview_list_updated(view);
+	draw_dir_list_only(view);
+	ui_refresh_win(view->win);
+
+	view->list_pos = list_pos;
+	view->top_line = top_line;
+	view->curr_line = curr_line;
+}
+
+#endif
+
 /* Starts file list update, saving previous list for future reference if
  * necessary. */
 static void
@@ -2340,6 +2704,7 @@ start_dir_list_change(view_t *view, dir_entry_t **entries, int *len, int reload)
 		free_view_entries(view);
 	}
 
+	search_cancel(view);
 	view->matches = 0;
 	view->selected_files = 0;
 }
@@ -2389,7 +2754,10 @@ add_file_entry_to_view(const char name[], const void *data, void *param)
 
 	init_dir_entry(view, entry, name);
 
-	if(fill_dir_entry(entry, entry->name, data) == 0)
+	char full_path[PATH_MAX + 1];
+	snprintf(full_path, sizeof(full_path), "%s/%s", flist_get_dir(view), name);
+
+	if(fill_dir_entry(entry, full_path, data) == 0)
 	{
 		++view->list_rows;
 	}
@@ -2452,7 +2820,7 @@ merge_lists(view_t *view, dir_entry_t *entries, int len)
 		add_to_trie(prev_names, view, &entries[i]);
 
 		/* We won't use the name later, so free some memory. */
-		update_string(&entries[i].name, NULL);
+		(void)fentry_set_name(&entries[i], NULL);
 	}
 
 	closest_dist = INT_MIN;
@@ -2641,7 +3009,14 @@ add_parent_entry(view_t *view, dir_entry_t **entries, int *count)
 		return;
 	}
 
-	if(init_parent_entry(view, dir_entry, "..") == 0)
+	char path[PATH_MAX + 1];
+	copy_str(path, sizeof(path), flist_get_dir(view));
+	if(!is_root_dir(path))
+	{
+		remove_last_path_component(path);
+	}
+
+	if(init_parent_entry(view, dir_entry, path) == 0)
 	{
 		++*count;
 	}
@@ -2652,7 +3027,16 @@ add_parent_entry(view_t *view, dir_entry_t **entries, int *count)
 static void
 init_dir_entry(view_t *view, dir_entry_t *entry, const char name[])
 {
-	entry->name = strdup(name);
+	entry->name_pool = view->name_pool;
+	if(entry->name_pool == NULL)
+	{
+		entry->name = strdup(name);
+	}
+	else
+	{
+		entry->name = str_pool_dup(entry->name_pool, name);
+		str_pool_ref(entry->name_pool);
+	}
 	entry->origin = &view->curr_dir[0];
 
 	entry->size = 0ULL;
@@ -2711,7 +3095,7 @@ replace_dir_entries(view_t *view, dir_entry_t **entries, int *count,
 	{
 		dir_entry_t *const entry = &new[i];
 
-		entry->name = strdup(entry->name);
+		(void)fentry_dup_name(entry);
 		entry->origin = strdup(entry->origin);
 		entry->owns_origin = 1;
 
@@ -2745,8 +3129,7 @@ free_dir_entries(dir_entry_t **entries, int *count)
 void
 fentry_free(dir_entry_t *entry)
 {
-	free(entry->name);
-	entry->name = NULL;
+	free_entry_name(entry);
 
 	if(entry->owns_origin)
 	{
@@ -2755,6 +3138,64 @@ fentry_free(dir_entry_t *entry)
 	}
 }
 
+int
+fentry_set_name(dir_entry_t *entry, const char name[])
+{
+	char *copy = NULL;
+	if(name != NULL)
+	{
+		copy = strdup(name);
+		if(copy == NULL)
+		{
+			return 1;
+		}
+	}
+
+	free_entry_name(entry);
+	entry->name = copy;
+	return 0;
+}
+
+int
+fentry_dup_name(dir_entry_t *entry)
+{
+	if(entry->name_pool != NULL)
+	{
+		str_pool_ref(entry->name_pool);
+		return 0;
+	}
+
+	entry->name = strdup(entry->name);
+	return (entry->name == NULL);
+}
+
+/* Frees name of the entry, which might be stored in a pool. */
+static void
+free_entry_name(dir_entry_t *entry)
+{
+	if(entry->name_pool == NULL)
+	{
+		free(entry->name);
+	}
+	else if(entry->name != NULL)
+	{
+		str_pool_unref(entry->name_pool);
+	}
+
+	entry->name = NULL;
+	entry->name_pool = NULL;
+}
+
+/* Replaces storage for names of entries that are about to be loaded into the
+ * view.  Names of the previous listing keep their pool alive for as long as
+ * they need it. */
+static void
+renew_name_pool(view_t *view)
+{
+	str_pool_unref(view->name_pool);
+	view->name_pool = str_pool_new();
+}
+
 dir_entry_t *
 add_dir_entry(dir_entry_t **list, size_t *list_size, const dir_entry_t *entry)
 {
@@ -2814,6 +3255,8 @@ void
 check_if_filelist_has_changed(view_t *view)
 {
 	int failed, changed;
+	fswatch_change_t *changes = NULL;
+	int nchanges = -1;
 	const char *const curr_dir = flist_get_dir(view);
 
 	if(view->on_slow_fs ||
@@ -2833,7 +3276,8 @@ check_if_filelist_has_changed(view_t *view)
 	}
 	else
 	{
-		FSWatchState state = poll_watcher(view->watch, curr_dir);
+		FSWatchState state = poll_watcher(view->watch, curr_dir, &changes,
+				&nchanges);
 		changed = (state != FSWS_UNCHANGED);
 		failed = (state == FSWS_ERRORED);
 	}
@@ -2848,6 +3292,8 @@ check_if_filelist_has_changed(view_t *view)
 
 	if(failed)
 	{
+		fswatch_free_changes(changes, nchanges);
+
 		show_error_msgf("Directory Check", "Cannot open %s", curr_dir);
 
 		leave_invalid_dir(view);
@@ -2859,7 +3305,15 @@ check_if_filelist_has_changed(view_t *view)
 
 	if(changed)
 	{
-		ui_view_schedule_reload(view);
+		/* Small changes are applied in place, the rest requires a reload. */
+		if(nchanges >= 0 && apply_dir_changes(view, changes, nchanges) == 0)
+		{
+			ui_view_schedule_redraw(view);
+		}
+		else
+		{
+			ui_view_schedule_reload(view);
+		}
 	}
 	else if(flist_custom_active(view) && cv_tree(view->custom.type))
 	{
@@ -2877,27 +3331,205 @@ check_if_filelist_has_changed(view_t *view)
 			ui_view_schedule_redraw(view);
 		}
 	}
+
+	fswatch_free_changes(changes, nchanges);
 }
 
-/* Checks whether tree-view needs a reload (any of subdirectories were changed).
- * Returns non-zero if so, otherwise zero is returned. */
+/* Updates list of a regular view according to changes of entries of its
+ * directory: gone files are removed, new ones are inserted at their sorted
+ * positions and changed ones are updated.  Returns zero on success and
+ * non-zero if the list needs to be reloaded instead. */
 static int
-tree_has_changed(const dir_entry_t *entries, size_t nchildren)
+apply_dir_changes(view_t *view, const fswatch_change_t changes[], int nchanges)
 {
-	size_t pos = 0U;
-	while(pos < nchildren)
+	const int only_parent = (view->list_rows == 1)
+	                     && is_parent_dir(view->dir_entry[0].name);
+
+	/* Reading whole directory anew is cheaper when most of it has changed.  Lists
+	 * consisting of forced ".." entry and selection ranges of Visual mode are
+	 * better left to reloading. */
+	if(flist_custom_active(view) || nchanges > view->list_rows ||
+			only_parent || view->local_filter.in_progress ||
+			vle_mode_is(VISUAL_MODE) || curr_stats.load_stage < 2)
 	{
-		const dir_entry_t *const entry = &entries[pos];
-		if(entry->type == FT_DIR && !is_parent_dir(entry->name))
-		{
-			char full_path[PATH_MAX + 1];
-			struct stat s;
+		return 1;
+	}
 
-			get_full_path_of(entry, sizeof(full_path), full_path);
-			if(os_stat(full_path, &s) != 0 || entry->mtime != s.st_mtime)
-			{
-				return 1;
-			}
+	trie_t *const names = trie_create(/*free_func=*/NULL);
+	char *const seen = calloc(nchanges, 1);
+	if(names == NULL || seen == NULL)
+	{
+		trie_free(names);
+		free(seen);
+		return 1;
+	}
+
+	int i;
+	for(i = 0; i < nchanges; ++i)
+	{
+		(void)trie_set(names, changes[i].name, &changes[i]);
+	}
+
+	char curr_path[PATH_MAX + 1];
+	get_current_full_path(view, sizeof(curr_path), curr_path);
+
+	const int reorder = sort_needs_meta(view->sort);
+	dir_entry_t *moved = NULL;
+	size_t nmoved = 0U;
+
+	/* Update or drop entries that are already in the list. */
+	int j = 0;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		dir_entry_t entry = view->dir_entry[i];
+		void *data;
+
+		if(view->matches != 0)
+		{
+			/* Like on reload, search results become outdated. */
+			entry.search_match = 0;
+		}
+
+		if(is_parent_dir(entry.name) || trie_get(names, entry.name, &data) != 0)
+		{
+			view->dir_entry[j++] = entry;
+			continue;
+		}
+
+		seen[(const fswatch_change_t *)data - changes] = 1;
+
+		char full_path[PATH_MAX + 1];
+		snprintf(full_path, sizeof(full_path), "%s/%s", flist_get_dir(view),
+				entry.name);
+
+		const FileType old_type = entry.type;
+		const int was_dir = fentry_is_dir(&entry);
+		entry.meta_pending = 0;
+		entry.hi_num = -1;
+		entry.name_dec_num = -1;
+
+		if(fill_dir_entry_by_path(&entry, full_path) != 0)
+		{
+			fentry_free(&entry);
+			continue;
+		}
+
+		if(!name_is_visible(view, entry.name, fentry_is_dir(&entry)))
+		{
+			fentry_free(&entry);
+			++view->filtered;
+			continue;
+		}
+
+		if(reorder || entry.type != old_type || fentry_is_dir(&entry) != was_dir)
+		{
+			/* Position of the entry might have changed. */
+			if(add_dir_entry(&moved, &nmoved, &entry) == NULL)
+			{
+				fentry_free(&entry);
+			}
+			continue;
+		}
+
+		view->dir_entry[j++] = entry;
+	}
+	view->list_rows = j;
+	search_cancel(view);
+	view->matches = 0;
+
+	/* Add entries that aren't in the list yet. */
+	for(i = 0; i < nchanges; ++i)
+	{
+		if(seen[i])
+		{
+			continue;
+		}
+
+		const fswatch_change_t *const change = &changes[i];
+
+		char full_path[PATH_MAX + 1];
+		snprintf(full_path, sizeof(full_path), "%s/%s", flist_get_dir(view),
+				change->name);
+
+		dir_entry_t entry;
+		init_dir_entry(view, &entry, change->name);
+		if(entry.name == NULL)
+		{
+			continue;
+		}
+
+		if(fill_dir_entry_by_path(&entry, full_path) != 0)
+		{
+			/* Entry that existed but wasn't listed must have been filtered out. */
+			if(change->existed && view->filtered > 0 &&
+					!name_is_visible(view, change->name, 0) &&
+					!name_is_visible(view, change->name, 1))
+			{
+				--view->filtered;
+			}
+			fentry_free(&entry);
+			continue;
+		}
+
+		if(!name_is_visible(view, entry.name, fentry_is_dir(&entry)))
+		{
+			view->filtered += !change->existed;
+			fentry_free(&entry);
+			continue;
+		}
+
+		if(change->existed && view->filtered > 0)
+		{
+			--view->filtered;
+		}
+
+		if(add_dir_entry(&moved, &nmoved, &entry) == NULL)
+		{
+			fentry_free(&entry);
+		}
+	}
+
+	trie_free(names);
+	free(seen);
+
+	if(sort_merge_into_view(view, moved, nmoved) != 0)
+	{
+		int count = nmoved;
+		free_dir_entries(&moved, &count);
+		return 1;
+	}
+	dynarray_free(moved);
+
+	if(view->list_rows == 0)
+	{
+		add_parent_dir(view);
+	}
+
+	flist_sel_recount(view);
+	flist_goto_by_path(view, curr_path);
+	fpos_ensure_valid_pos(view);
+	return 0;
+}
+
+/* Checks whether tree-view needs a reload (any of subdirectories were changed).
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+tree_has_changed(const dir_entry_t *entries, size_t nchildren)
+{
+	size_t pos = 0U;
+	while(pos < nchildren)
+	{
+		const dir_entry_t *const entry = &entries[pos];
+		if(entry->type == FT_DIR && !is_parent_dir(entry->name))
+		{
+			char full_path[PATH_MAX + 1];
+			struct stat s;
+
+			get_full_path_of(entry, sizeof(full_path), full_path);
+			if(os_stat(full_path, &s) != 0 || entry->mtime != s.st_mtime)
+			{
+				return 1;
+			}
 
 			if(tree_has_changed(entry + 1, entry->child_count))
 			{
@@ -2938,7 +3570,7 @@ flist_update_cache(view_t *view, cached_entries_t *cache, const char path[])
 		update = 1;
 	}
 
-	if(poll_watcher(cache->watch, path) != FSWS_UNCHANGED || update)
+	if(poll_watcher(cache->watch, path, NULL, NULL) != FSWS_UNCHANGED || update)
 	{
 		free_dir_entries(&cache->entries.entries, &cache->entries.nentries);
 		cache->entries = flist_list_in(view, path, 0, 1);
@@ -2949,11 +3581,15 @@ flist_update_cache(view_t *view, cached_entries_t *cache, const char path[])
 }
 
 /* Polls file-system watcher and re-enters current working directory of the
- * process if necessary.  Returns watcher's state. */
+ * process if necessary.  Changed entries are requested only if changes isn't
+ * NULL, see fswatch_poll_changes().  Returns watcher's state. */
 static FSWatchState
-poll_watcher(fswatch_t *watch, const char path[])
+poll_watcher(fswatch_t *watch, const char path[], fswatch_change_t **changes,
+		int *nchanges)
 {
-	FSWatchState state = fswatch_poll(watch);
+	FSWatchState state = (changes == NULL)
+	                   ? fswatch_poll(watch)
+	                   : fswatch_poll_changes(watch, changes, nchanges);
 
 	if(state == FSWS_ERRORED || state == FSWS_REPLACED)
 	{
@@ -3028,11 +3664,291 @@ flist_toggle_fold(view_t *view)
 
 	if(set_fold_state(view->custom.folded_paths, full_path, state))
 	{
+		/* Reload takes care of a directory that is still being read. */
+		const int pending = (view->subtree_job != NULL);
+		drop_subtree_job(view);
+
 		curr->folded = !curr->folded;
-		/* We reload even on folding to update number of filtered entries
-		 * properly. */
+		/* Unfolded subtree is read on its own in background when possible.
+		 * Otherwise we reload and do it even on folding to update number of
+		 * filtered entries properly. */
+		if(curr->folded || pending ||
+				start_subtree_job(view, curr - view->dir_entry) != 0)
+		{
+			ui_view_schedule_reload(view);
+		}
+	}
+}
+
+int
+flist_fold_continue(view_t *view)
+{
+	struct subtree_job_t *const job = view->subtree_job;
+	if(job == NULL)
+	{
+		return 0;
+	}
+
+	pthread_mutex_lock(&job->lock);
+	const int done = job->done;
+	pthread_mutex_unlock(&job->lock);
+	if(!done)
+	{
+		return 0;
+	}
+
+	pthread_join(job->thread, NULL);
+	view->subtree_job = NULL;
+
+	/* The list could have changed while the subtree was being read, in which
+	 * case it might already contain the subtree. */
+	const int pos = find_tree_entry(view, job->path);
+	if(pos >= 0 && can_splice_subtree(view, pos) &&
+			splice_subtree(view, pos, job->walker) != 0)
+	{
 		ui_view_schedule_reload(view);
 	}
+
+	free_subtree_job(job);
+	return 1;
+}
+
+/* Starts reading subtree of just unfolded directory at specified position in
+ * background.  flist_fold_continue() inserts it into the list when it's
+ * ready.  Returns zero on success, otherwise non-zero is returned. */
+static int
+start_subtree_job(view_t *view, int pos)
+{
+	if(!can_splice_subtree(view, pos))
+	{
+		return 1;
+	}
+
+	struct subtree_job_t *const job = calloc(1, sizeof(*job));
+	if(job == NULL)
+	{
+		return 1;
+	}
+
+	char full_path[PATH_MAX + 1];
+	get_full_path_of(&view->dir_entry[pos], sizeof(full_path), full_path);
+
+	/* The walk can't access the view, because it can change in the meantime.
+	 * Filters aren't checked and states of folds are copied. */
+	job->path = strdup(full_path);
+	job->params.excluded_paths = trie_clone(view->custom.excluded_paths);
+	job->params.folded_paths = trie_clone(view->custom.folded_paths);
+	job->params.check_filters = 0;
+	if(job->path == NULL ||
+			(view->custom.excluded_paths != NULL &&
+			 job->params.excluded_paths == NULL) ||
+			(view->custom.folded_paths != NULL && job->params.folded_paths == NULL) ||
+			pthread_mutex_init(&job->lock, NULL) != 0)
+	{
+		trie_free(job->params.excluded_paths);
+		trie_free(job->params.folded_paths);
+		free(job->path);
+		free(job);
+		return 1;
+	}
+
+	if(pthread_create(&job->thread, NULL, &subtree_job_main, job) != 0)
+	{
+		pthread_mutex_destroy(&job->lock);
+		trie_free(job->params.excluded_paths);
+		trie_free(job->params.folded_paths);
+		free(job->path);
+		free(job);
+		return 1;
+	}
+
+	view->subtree_job = job;
+	return 0;
+}
+
+/* Entry point of a thread that reads subtree of a directory. */
+static void *
+subtree_job_main(void *arg)
+{
+	struct subtree_job_t *const job = arg;
+
+	/* Parameters of the walk are the first field of the job, so the same
+	 * argument is passed to all callbacks. */
+	const tree_walker_cbs_t cbs = {
+		.filter = &walk_filter,
+		.cancelled = &subtree_walk_cancelled,
+		.arg = job,
+	};
+
+	tree_walker_t *const walker = tree_walker_walk(job->path, INT_MAX, &cbs);
+
+	pthread_mutex_lock(&job->lock);
+	job->walker = walker;
+	job->done = 1;
+	pthread_mutex_unlock(&job->lock);
+	return NULL;
+}
+
+/* tree_walker_t callback that checks whether reading of a subtree was dropped.
+ * Returns non-zero if walking should stop. */
+static int
+subtree_walk_cancelled(void *arg)
+{
+	struct subtree_job_t *const job = arg;
+	pthread_mutex_lock(&job->lock);
+	const int cancelled = job->cancelled;
+	pthread_mutex_unlock(&job->lock);
+	return cancelled;
+}
+
+/* Stops reading of a subtree of the view, if any, and discards its results. */
+static void
+drop_subtree_job(view_t *view)
+{
+	struct subtree_job_t *const job = view->subtree_job;
+	if(job == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&job->lock);
+	job->cancelled = 1;
+	pthread_mutex_unlock(&job->lock);
+
+	pthread_join(job->thread, NULL);
+	free_subtree_job(job);
+	view->subtree_job = NULL;
+}
+
+/* Frees reading of a subtree whose thread is over. */
+static void
+free_subtree_job(struct subtree_job_t *job)
+{
+	tree_walker_free(job->walker);
+	pthread_mutex_destroy(&job->lock);
+	trie_free(job->params.excluded_paths);
+	trie_free(job->params.folded_paths);
+	free(job->path);
+	free(job);
+}
+
+/* Looks up an entry of a tree view by its full path.  Returns its position or
+ * -1 if it's not found. */
+static int
+find_tree_entry(const view_t *view, const char path[])
+{
+	if(!flist_custom_active(view) || view->custom.type != CV_TREE)
+	{
+		return -1;
+	}
+
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		char full_path[PATH_MAX + 1];
+		get_full_path_of(&view->dir_entry[i], sizeof(full_path), full_path);
+		if(stroscmp(full_path, path) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* Checks whether subtree of a directory at specified position can be inserted
+ * into the list on its own.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+can_splice_subtree(const view_t *view, int pos)
+{
+	/* Local filter and trees built out of custom views require the whole tree to
+	 * be processed. */
+	return view->custom.type == CV_TREE
+	    && view->dir_entry[pos].type == FT_DIR
+	    && !view->dir_entry[pos].folded
+	    && view->dir_entry[pos].child_count == 0
+	    && view->custom.entry_count == 0
+	    && view->custom.full.nentries == 0
+	    && filter_is_empty(&view->local_filter.filter);
+}
+
+/* Inserts subtree of unfolded directory at specified position right after
+ * the directory fixing up tree metadata, which is cheaper than rebuilding the
+ * whole tree.  Directories are listed from results of the walker, which can be
+ * NULL, when possible.  Returns zero on success, otherwise non-zero is returned
+ * and the view is left intact. */
+static int
+splice_subtree(view_t *view, int pos, const tree_walker_t *walker)
+{
+	char full_path[PATH_MAX + 1];
+	get_full_path_of(&view->dir_entry[pos], sizeof(full_path), full_path);
+
+	trie_t *const excluded_paths = view->custom.excluded_paths;
+	trie_t *const folded_paths = view->custom.folded_paths;
+
+	trie_free(view->custom.paths_cache);
+	view->custom.paths_cache = trie_create(/*free_func=*/NULL);
+
+	ui_cancellation_push_on();
+	show_progress("Building tree...", 0);
+	int nfiltered = add_files_recursively(view, walker, full_path,
+			excluded_paths, folded_paths, -1, 0, INT_MAX);
+	ui_cancellation_pop();
+
+	ui_sb_quick_msg_clear();
+
+	if(nfiltered >= 0 && !ui_cancellation_requested() &&
+			view->custom.entry_count == 0 && (cfg.dot_dirs & DD_TREE_LEAFS_PARENT))
+	{
+		if(add_directory_leaf(view, full_path, -1) != 0)
+		{
+			nfiltered = -1;
+		}
+	}
+
+	trie_free(view->custom.paths_cache);
+	view->custom.paths_cache = NULL;
+
+	const int count = view->custom.entry_count;
+	dir_entry_t *const list = (count == 0 ? view->dir_entry
+	                                      : dynarray_extend(view->dir_entry,
+	                                            count*sizeof(*list)));
+	if(nfiltered < 0 || ui_cancellation_requested() || list == NULL)
+	{
+		free_dir_entries(&view->custom.entries, &view->custom.entry_count);
+		return 1;
+	}
+
+	view->dir_entry = list;
+
+	/* Account for new entries while the list still has its old layout. */
+	fix_tree_links(list, &list[pos], pos, pos, 0, count);
+
+	memmove(&list[pos + 1 + count], &list[pos + 1],
+			sizeof(*list)*(view->list_rows - (pos + 1)));
+	memcpy(&list[pos + 1], view->custom.entries, sizeof(*list)*count);
+	view->list_rows += count;
+
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		/* Top-level entries of the subtree were added without a parent. */
+		if(list[pos + 1 + i].child_pos == 0)
+		{
+			list[pos + 1 + i].child_pos = 1 + i;
+		}
+	}
+	list[pos].child_count = count;
+
+	dynarray_free(view->custom.entries);
+	view->custom.entries = NULL;
+	view->custom.entry_count = 0;
+
+	view->filtered += nfiltered;
+
+	sort_subtree(view, pos);
+	ui_view_schedule_redraw(view);
+	return 0;
 }
 
 /* Folds a single entry by removing all of its children and updating tree
@@ -3542,6 +4458,7 @@ iter_entries(view_t *view, dir_entry_t **entry, entry_predicate pred,
 		dir_entry_t *const e = &view->dir_entry[next];
 		if((!valid_only || fentry_is_valid(e)) && pred(e))
 		{
+			fentry_load_meta(e);
 			*entry = e;
 			return 1;
 		}
@@ -3822,7 +4739,7 @@ flist_custom_end(view_t *view, int very)
 void
 fentry_rename(view_t *view, dir_entry_t *entry, const char to[])
 {
-	char *const old_name = entry->name;
+	dir_entry_t old = *entry;
 
 	/* Rename file in internal structures for correct positioning of cursor
 	 * after reloading, as cursor will be positioned on the file with the same
@@ -3830,9 +4747,11 @@ fentry_rename(view_t *view, dir_entry_t *entry, const char to[])
 	entry->name = strdup(to);
 	if(entry->name == NULL)
 	{
-		entry->name = old_name;
+		entry->name = old.name;
 		return;
 	}
+	entry->name_pool = NULL;
+	const char *const old_name = old.name;
 
 	/* Name change can affect name specific highlight and decorations, so reset
 	 * the caches. */
@@ -3895,7 +4814,7 @@ fentry_rename(view_t *view, dir_entry_t *entry, const char to[])
 		}
 	}
 
-	free(old_name);
+	free_entry_name(&old);
 }
 
 int
@@ -3943,6 +4862,100 @@ fentry_points_to(const dir_entry_t *entry, const char path[])
 	return paths_are_equal(path, previewed);
 }
 
+void
+fentry_load_meta(dir_entry_t *entry)
+{
+#ifndef _WIN32
+	if(!entry->meta_pending)
+	{
+		return;
+	}
+
+	char full_path[PATH_MAX + 1];
+	get_full_path_of(entry, sizeof(full_path), full_path);
+
+	struct stat s;
+	if(os_lstat(full_path, &s) != 0)
+	{
+		LOG_SERROR_MSG(errno, "Can't lstat() \"%s\"", full_path);
+		entry->meta_pending = 0;
+		return;
+	}
+
+	finish_lazy_entry(entry, full_path, &s);
+#endif
+}
+
+void
+flist_load_meta(view_t *view)
+{
+#ifndef _WIN32
+	int count = 0;
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		count += view->dir_entry[i].meta_pending;
+	}
+
+	if(count == 0)
+	{
+		return;
+	}
+
+	meta_job_t job = {
+		.entries = reallocarray(NULL, count, sizeof(*job.entries)),
+		.stats = reallocarray(NULL, count, sizeof(*job.stats)),
+		.failed = calloc(count, sizeof(*job.failed)),
+	};
+	thread_pool_t *const pool = (count >= MIN_PARALLEL_META)
+	                          ? thread_pool_new(META_WORKERS)
+	                          : NULL;
+
+	if(pool == NULL || job.entries == NULL || job.stats == NULL ||
+			job.failed == NULL)
+	{
+		/* Fallback to loading entries one by one. */
+		for(i = 0; i < view->list_rows; ++i)
+		{
+			fentry_load_meta(&view->dir_entry[i]);
+		}
+	}
+	else
+	{
+		int j = 0;
+		for(i = 0; i < view->list_rows; ++i)
+		{
+			if(view->dir_entry[i].meta_pending)
+			{
+				job.entries[j++] = &view->dir_entry[i];
+			}
+		}
+
+		thread_pool_for(pool, count, META_CHUNK, &stat_pending_entries, &job);
+
+		for(j = 0; j < count; ++j)
+		{
+			char full_path[PATH_MAX + 1];
+			get_full_path_of(job.entries[j], sizeof(full_path), full_path);
+
+			if(job.failed[j])
+			{
+				LOG_ERROR_MSG("Can't lstat() \"%s\"", full_path);
+				job.entries[j]->meta_pending = 0;
+				continue;
+			}
+
+			finish_lazy_entry(job.entries[j], full_path, &job.stats[j]);
+		}
+	}
+
+	thread_pool_free(pool);
+	free(job.entries);
+	free(job.stats);
+	free(job.failed);
+#endif
+}
+
 int
 flist_load_tree(view_t *view, const char path[], int depth)
 {
@@ -4049,6 +5062,9 @@ make_tree(view_t *view, const char path[], int reload, trie_t *excluded_paths,
 	const int from_custom = flist_custom_active(view)
 	                     && ONE_OF(view->custom.type, CV_REGULAR, CV_VERY);
 
+	/* New tree includes whatever subtree is being read at the moment. */
+	drop_subtree_job(view);
+
 	flist_custom_start(view, from_custom ? view->custom.title : "");
 
 	show_progress("Building tree...", 0);
@@ -4062,8 +5078,12 @@ make_tree(view_t *view, const char path[], int reload, trie_t *excluded_paths,
 	}
 	else
 	{
-		nfiltered = add_files_recursively(view, path, excluded_paths, folded_paths,
-				-1, 0, depth);
+		tree_walker_t *const walker = walk_tree(view, path, excluded_paths,
+				folded_paths, depth);
+		show_progress("Building tree...", 0);
+		nfiltered = add_files_recursively(view, walker, path, excluded_paths,
+				folded_paths, -1, 0, depth);
+		tree_walker_free(walker);
 		type = CV_TREE;
 	}
 	ui_cancellation_pop();
@@ -4167,6 +5187,7 @@ complete_tree(const char name[], int valid, const void *parent_data, void *data,
 		*dir_entry = **(dir_entry_t **)data;
 		dir_entry->child_count = 0;
 		(*(dir_entry_t **)data)->name = NULL;
+		(*(dir_entry_t **)data)->name_pool = NULL;
 		(*(dir_entry_t **)data)->origin = NULL;
 	}
 	else
@@ -4257,24 +5278,117 @@ drop_tops(dir_entry_t *entries, int *nentries, int extra)
 	}
 }
 
-/* Adds custom view entries corresponding to file system tree.  parent_pos is
- * expected to be negative for the outermost invocation.  The depth parameter
- * is used to limit nesting level, when it's negative, parent node is just
- * marked as folded.  Returns number of filtered out files on success or partial
- * success and negative value on serious error. */
+/* Reads directories of the tree that add_files_recursively() is going to visit
+ * in parallel.  Returns results of the walk or NULL. */
+static tree_walker_t *
+walk_tree(view_t *view, const char path[], trie_t *excluded_paths,
+		trie_t *folded_paths, int depth)
+{
+	walk_params_t params = {
+		.view = view,
+		.excluded_paths = excluded_paths,
+		.folded_paths = folded_paths,
+		/* Querying mime types isn't thread-safe, so skip checking filters and
+		 * read a bit more than necessary. */
+		.check_filters = matcher_is_empty(view->manual_filter)
+		              || !matcher_is_mime(view->manual_filter),
+	};
+
+	const tree_walker_cbs_t cbs = {
+		.filter = &walk_filter,
+		.cancelled = &walk_cancelled,
+		.progress = &walk_progress,
+		.arg = &params,
+	};
+
+	show_progress("Scanning tree...", 0);
+	return tree_walker_walk(path, depth, &cbs);
+}
+
+/* tree_walker_t callback that mirrors decisions of add_files_recursively()
+ * about entering directories.  Only reads data which isn't modified until the
+ * walk is over.  Returns non-zero if directory should be read. */
 static int
-add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
-		trie_t *folded_paths, int parent_pos, int no_direct_parent, int depth)
+walk_filter(const char dir[], const char name[], int depth, void *arg)
+{
+	const walk_params_t *const params = arg;
+
+	char full_path[PATH_MAX + 1];
+	snprintf(full_path, sizeof(full_path), "%s/%s", dir, name);
+
+	void *dummy;
+	if(trie_get(params->excluded_paths, full_path, &dummy) == 0)
+	{
+		return 0;
+	}
+
+	const FoldState state = get_fold_state(params->folded_paths, full_path);
+	if(state == FOLD_USER_CLOSED || state == FOLD_AUTO_CLOSED)
+	{
+		return 0;
+	}
+
+	const FoldState parent_fold = get_fold_state(params->folded_paths, dir);
+	if(depth == 0 ||
+			(state == FOLD_UNDEFINED && parent_fold == FOLD_AUTO_OPENED))
+	{
+		return 0;
+	}
+
+	if(!params->check_filters ||
+			tree_candidate_is_visible(params->view, dir, name, 1, 1))
+	{
+		return 1;
+	}
+
+	/* Invisible directories are traversed to look for visible files. */
+	return depth > 0 && tree_candidate_is_visible(params->view, dir, name, 1, 0);
+}
+
+/* tree_walker_t callback that checks for cancellation request.  Returns
+ * non-zero if walking should stop. */
+static int
+walk_cancelled(void *arg)
+{
+	return ui_cancellation_requested();
+}
+
+/* tree_walker_t callback that reports progress of reading a tree. */
+static void
+walk_progress(void *arg)
+{
+	show_progress("Scanning tree...", 64);
+}
+
+/* Adds custom view entries corresponding to file system tree.  Directories are
+ * listed from results of the walker, which can be NULL, when possible.
+ * parent_pos is expected to be negative for the outermost invocation.  The
+ * depth parameter is used to limit nesting level, when it's negative, parent
+ * node is just marked as folded.  Returns number of filtered out files on
+ * success or partial success and negative value on serious error. */
+static int
+add_files_recursively(view_t *view, const tree_walker_t *walker,
+		const char path[], trie_t *excluded_paths, trie_t *folded_paths,
+		int parent_pos, int no_direct_parent, int depth)
 {
 	int i;
 	const int prev_count = view->custom.entry_count;
 	int nfiltered = 0;
 
 	int len;
-	char **lst = list_all_files(path, &len);
-	if(len < 0)
+	char **lst = NULL;
+	const tree_walker_dir_t *const listing = tree_walker_get(walker, path);
+	if(listing != NULL)
 	{
-		return -1;
+		len = listing->count;
+	}
+	else
+	{
+		lst = list_all_files(path, &len);
+		if(len < 0)
+		{
+			return -1;
+		}
 	}
 
 	FoldState parent_fold = get_fold_state(folded_paths, path);
@@ -4284,7 +5398,9 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 		int dir;
 		void *dummy;
 		dir_entry_t *entry;
-		char *const full_path = format_str("%s/%s", path, lst[i]);
+		const char *const name = (listing != NULL ? listing->entries[i].name
+		                                          : lst[i]);
+		char *const full_path = format_str("%s/%s", path, name);
 
 		if(trie_get(excluded_paths, full_path, &dummy) == 0)
 		{
@@ -4292,10 +5408,12 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			continue;
 		}
 
-		dir = is_dir(full_path);
-		if(!tree_candidate_is_visible(view, path, lst[i], dir, 1))
+		dir = (listing != NULL ? listing->entries[i].is_dir : is_dir(full_path));
+		if(!tree_candidate_is_visible(view, path, name, dir, 1))
 		{
-			const int real_dir = (dir && !is_symlink(full_path));
+			const int real_dir = (listing != NULL)
+			                   ? listing->entries[i].real_dir
+			                   : (dir && !is_symlink(full_path));
 
 			FoldState state;
 			if(real_dir)
@@ -4316,12 +5434,12 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			/* Traverse directory (but not symlink to it) even if we're skipping it,
 			 * because we might need files that are inside of it. */
 			if(real_dir && depth > 0 &&
-					tree_candidate_is_visible(view, path, lst[i], dir, 0))
+					tree_candidate_is_visible(view, path, name, dir, 0))
 			{
 				if(state != FOLD_AUTO_CLOSED && state != FOLD_USER_CLOSED)
 				{
-					nfiltered += add_files_recursively(view, full_path, excluded_paths,
-							folded_paths, parent_pos, 1, depth - 1);
+					nfiltered += add_files_recursively(view, walker, full_path,
+							excluded_paths, folded_paths, parent_pos, 1, depth - 1);
 				}
 			}
 
@@ -4334,7 +5452,10 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 		if(entry == NULL)
 		{
 			free(full_path);
-			free_string_array(lst, len);
+			if(lst != NULL)
+			{
+				free_string_array(lst, len);
+			}
 			return -1;
 		}
 
@@ -4362,7 +5483,7 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			else
 			{
 				const int idx = view->custom.entry_count - 1;
-				const int filtered = add_files_recursively(view, full_path,
+				const int filtered = add_files_recursively(view, walker, full_path,
 						excluded_paths, folded_paths, idx, 0, depth - 1);
 				/* Keep going in case of error and load partial list. */
 				if(filtered >= 0)
@@ -4381,7 +5502,10 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 		show_progress("Building tree...", 1000);
 	}
 
-	free_string_array(lst, len);
+	if(lst != NULL)
+	{
+		free_string_array(lst, len);
+	}
 
 	/* The prev_count != 0 check is to make sure that we won't create leaf instead
 	 * of the whole tree (this is handled in flist_custom_finish()). */
@@ -4435,6 +5559,19 @@ entry_is_visible(view_t *view, const char name[], const void *data)
 	snprintf(full_path, sizeof(full_path), "%s/%s", flist_get_dir(view), name);
 
 	const int is_dir = data_is_dir_entry(data, full_path);
+	return name_is_visible(view, name, is_dir);
+}
+
+/* Checks whether file with the specified name in current directory of the view
+ * should be listed.  Returns non-zero if so, otherwise zero is returned. */
+static int
+name_is_visible(view_t *view, const char name[], int is_dir)
+{
+	if(view->hide_dot && name[0] == '.')
+	{
+		return 0;
+	}
+
 	return filters_file_is_visible(view, flist_get_dir(view), name, is_dir,
 			/*apply_local_filter=*/1);
 }
@@ -4496,14 +5633,14 @@ add_directory_leaf(view_t *view, const char path[], int parent_pos)
 	return 0;
 }
 
-/* Fills given entry of the view at specified path (can be relative, i.e. "..").
- * Returns zero on success, otherwise non-zero is returned. */
+/* Fills given ".." entry of the view with information about directory at
+ * specified path.  Returns zero on success, otherwise non-zero is returned. */
 static int
 init_parent_entry(view_t *view, dir_entry_t *entry, const char path[])
 {
 	struct stat s;
 
-	init_dir_entry(view, entry, get_last_path_component(path));
+	init_dir_entry(view, entry, "..");
 	entry->type = FT_DIR;
 
 	/* Load the inode info or leave blank values in entry. */
@@ -4523,7 +5660,7 @@ init_parent_entry(view_t *view, dir_entry_t *entry, const char path[])
 	entry->inode = s.st_ino;
 #else
 	/* Windows doesn't like returning size of directories even if it can. */
-	entry->size = get_file_size(entry->name);
+	entry->size = get_file_size(path);
 #endif
 	entry->mtime = s.st_mtime;
 	entry->atime = s.st_atime;
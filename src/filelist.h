@@ -133,6 +133,11 @@ void flist_custom_add_separator(view_t *view, int id);
  * Non-zero allow_empty makes a single-entry (..) view instead of aborting.
  * Returns zero on success, otherwise (on empty list) non-zero is returned. */
 int flist_custom_finish(view_t *view, CVType type, int allow_empty);
+/* Same as flist_custom_finish(), but for replacing list of files of a view that
+ * is already a custom one without taking actions performed on location
+ * change.  Returns zero on success, otherwise (on empty list) non-zero is
+ * returned. */
+int flist_custom_refresh(view_t *view, CVType type, int allow_empty);
 /* A more high level version of flist_custom_finish(), which takes care of error
  * handling and cursor position. */
 void flist_custom_end(view_t *view, int very);
@@ -281,6 +286,14 @@ dir_entry_t * entry_list_add(view_t *view, dir_entry_t **list, int *list_size,
 void free_dir_entries(dir_entry_t **entries, int *count);
 /* Frees single directory entry. */
 void fentry_free(dir_entry_t *entry);
+/* Replaces name of an entry with a copy of the name, which can be NULL to just
+ * free the old one.  Returns zero on success, otherwise non-zero is returned
+ * and the entry isn't changed. */
+int fentry_set_name(dir_entry_t *entry, const char name[]);
+/* Makes name of a copy of an entry independent of the name of the original
+ * entry.  Returns zero on success, otherwise non-zero is returned and name of
+ * the entry is set to NULL. */
+int fentry_dup_name(dir_entry_t *entry);
 /* Adds parent directory entry (..) to filelist. */
 void add_parent_dir(view_t *view);
 /* Changes name of a file entry, performing additional required updates. */
@@ -298,6 +311,10 @@ int fentry_is_dir(const dir_entry_t *entry);
 /* Checks whether entry points to a path resolving symbolic links if necessary.
  * Returns non-zero if so, otherwise zero is returned. */
 int fentry_points_to(const dir_entry_t *entry, const char path[]);
+/* Loads meta-data of the entry if its loading was postponed. */
+void fentry_load_meta(dir_entry_t *entry);
+/* Loads meta-data of all entries of the view whose loading was postponed. */
+void flist_load_meta(view_t *view);
 /* Loads directory tree specified by its path into the view.  The depth
  * parameter can be used to limit nesting level (>= 0).  Considers various
  * filters.  Returns zero on success, otherwise non-zero is returned. */
@@ -317,6 +334,10 @@ void flist_free_cache(cached_entries_t *cache);
 void flist_update_origins(view_t *view);
 /* Toggles fold of the current entry if applicable. */
 void flist_toggle_fold(view_t *view);
+/* Inserts subtree of unfolded directory into the list if it has been read by
+ * now.  Returns non-zero if reading of the subtree is over, otherwise zero is
+ * returned. */
+int flist_fold_continue(view_t *view);
 /* Checks whether file list synchronizes with FS.  Returns non-zero if so,
  * otherwise zero is returned. */
 int flist_is_fs_backed(const view_t *view);
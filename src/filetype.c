@@ -32,6 +32,7 @@
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/path.h"
+#include "utils/rule_index.h"
 #include "utils/utils.h"
 
 static const char * find_existing_cmd(const assoc_list_t *record_list,
@@ -43,6 +44,8 @@ static assoc_records_t parse_command_list(const char cmds[], int with_descr);
 static void register_assoc(assoc_t assoc, int for_x, int in_x);
 static assoc_records_t clone_all_matching_records(const char file[],
 		const assoc_list_t *record_list);
+static const int * find_matching(const assoc_list_t *assoc_list,
+		const char file[], int *count);
 static int add_assoc(assoc_list_t *assoc_list, assoc_t assoc);
 static void assoc_viewers(matchers_t *matchers, const assoc_records_t *viewers);
 static assoc_records_t clone_assoc_records(const assoc_records_t *records,
@@ -116,15 +119,13 @@ ft_get_viewers(const char file[])
 {
 	strlist_t viewers = {};
 
+	int count;
+	const int *const matched = find_matching(&fileviewers, file, &count);
+
 	int i;
-	for(i = 0; i < fileviewers.count; ++i)
+	for(i = 0; i < count; ++i)
 	{
-		assoc_t *const assoc = &fileviewers.list[i];
-
-		if(!matchers_match(assoc->matchers, file))
-		{
-			continue;
-		}
+		assoc_t *const assoc = &fileviewers.list[matched[i]];
 
 		int j;
 		for(j = 0; j < assoc->records.count; ++j)
@@ -147,17 +148,14 @@ ft_get_viewers(const char file[])
 static const char *
 find_existing_cmd(const assoc_list_t *record_list, const char file[])
 {
-	int i;
+	int count;
+	const int *const matched = find_matching(record_list, file, &count);
 
-	for(i = 0; i < record_list->count; ++i)
+	int i;
+	for(i = 0; i < count; ++i)
 	{
 		assoc_record_t prog;
-		assoc_t *const assoc = &record_list->list[i];
-
-		if(!matchers_match(assoc->matchers, file))
-		{
-			continue;
-		}
+		assoc_t *const assoc = &record_list->list[matched[i]];
 
 		prog = find_existing_cmd_record(&assoc->records);
 		if(!is_assoc_record_empty(&prog))
@@ -281,21 +279,34 @@ ft_get_all_viewers(const char file[])
 static assoc_records_t
 clone_all_matching_records(const char file[], const assoc_list_t *record_list)
 {
-	int i;
 	assoc_records_t result = {};
 
-	for(i = 0; i < record_list->count; ++i)
+	int count;
+	const int *const matched = find_matching(record_list, file, &count);
+
+	int i;
+	for(i = 0; i < count; ++i)
 	{
-		assoc_t *const assoc = &record_list->list[i];
-		if(matchers_match(assoc->matchers, file))
-		{
-			ft_assoc_record_add_all(&result, &assoc->records);
-		}
+		ft_assoc_record_add_all(&result, &record_list->list[matched[i]].records);
 	}
 
 	return result;
 }
 
+/* Looks up associations of the list whose matchers match the file.  Returns
+ * their indexes in increasing order, the array is valid until the next lookup
+ * in the list. */
+static const int *
+find_matching(const assoc_list_t *assoc_list, const char file[], int *count)
+{
+	if(assoc_list->index == NULL)
+	{
+		*count = 0;
+		return NULL;
+	}
+	return rule_index_find(assoc_list->index, file, count);
+}
+
 void
 ft_set_viewers(matchers_t *matchers, const char viewers[])
 {
@@ -351,6 +362,18 @@ add_assoc(assoc_list_t *assoc_list, assoc_t assoc)
 	}
 
 	assoc_list->list = p;
+
+	if(assoc_list->index == NULL)
+	{
+		assoc_list->index = rule_index_alloc();
+	}
+	if(assoc_list->index == NULL ||
+			rule_index_add(assoc_list->index, assoc.matchers) != 0)
+	{
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		return 1;
+	}
+
 	assoc_list->list[assoc_list->count] = assoc;
 	assoc_list->count++;
 	return 0;
@@ -422,6 +445,9 @@ reset_list_head(assoc_list_t *assoc_list)
 	free(assoc_list->list);
 	assoc_list->list = NULL;
 	assoc_list->count = 0;
+
+	rule_index_free(assoc_list->index);
+	assoc_list->index = NULL;
 }
 
 static void
@@ -23,6 +23,7 @@
 #define VIFM_PSEUDO_CMD "vifm"
 
 struct matchers_t;
+struct rule_index_t;
 
 /* Type of file association by its source. */
 typedef enum
@@ -70,6 +71,7 @@ typedef struct
 {
 	assoc_t *list;
 	int count;
+	struct rule_index_t *index; /* Index of matchers of the list. */
 }
 assoc_list_t;
 
@@ -20,6 +20,7 @@
 #include "filtering.h"
 
 #include <assert.h> /* assert() */
+#include <stdlib.h> /* free() */
 #include <string.h> /* strdup() */
 
 #include "cfg/config.h"
@@ -37,6 +38,13 @@
 #include "flist_sel.h"
 #include "opt_handlers.h"
 
+/* Time in milliseconds that interactive filtering can take before displaying
+ * partial result. */
+#define FILTERING_BUDGET_MS 30
+
+/* How often (in entries) filtering checks whether its time budget is over. */
+#define FILTERING_CHECK_PERIOD 1024
+
 static void reset_filter(filter_t *filter);
 static int is_newly_filtered(view_t *view, const dir_entry_t *entry, void *arg);
 static void replace_matcher(matcher_t **matcher, const char expr[]);
@@ -44,7 +52,9 @@ static int get_unfiltered_pos(const view_t *view, int pos);
 static int load_unfiltered_list(view_t *view);
 static int list_is_incomplete(view_t *view);
 static void store_local_filter_position(view_t *view, int pos);
-static int update_filtering_lists(view_t *view, int add, int clear);
+static int update_filtering_lists(view_t *view, int add, int clear,
+		int narrow, int budget);
+static int continue_filtering(view_t *view, int add, int clear, int budget);
 static void reparent_tree_node(dir_entry_t *original, dir_entry_t *filtered);
 static void ensure_filtered_list_not_empty(view_t *view,
 		dir_entry_t *parent_entry);
@@ -68,6 +78,8 @@ filters_view_reset(view_t *view)
 	(void)replace_string(&view->local_filter.prev, "");
 	reset_filter(&view->local_filter.filter);
 	view->local_filter.in_progress = 0;
+	view->local_filter.pending = 0;
+	view->local_filter.narrowable = 0;
 	view->local_filter.saved = NULL;
 	view->local_filter.poshist = NULL;
 	view->local_filter.poshist_len = 0U;
@@ -399,16 +411,44 @@ local_filter_set(view_t *view, const char filter[])
 		store_local_filter_position(view, current_file_pos);
 	}
 
+	char *const prev = strdup(view->local_filter.filter.raw);
+	const int prev_case_sensitive =
+		!(view->local_filter.filter.cflags & REG_ICASE);
+
 	result = (filter_change(&view->local_filter.filter, filter,
 			!regexp_should_ignore_case(filter)) ? -1 : 0);
 
-	if(update_filtering_lists(view, 1, 0) != 0 && result == 0)
+	/* Extending a pattern can only reduce the set of matching files, so it's
+	 * enough to check files that passed previous filter. */
+	const int narrow = result == 0
+	                && prev != NULL
+	                && view->local_filter.narrowable
+	                && filter_narrows(&view->local_filter.filter, prev,
+	                                  prev_case_sensitive);
+	free(prev);
+
+	if(update_filtering_lists(view, 1, 0, narrow, FILTERING_BUDGET_MS) != 0 &&
+			result == 0)
 	{
 		result = 1;
 	}
 	return result;
 }
 
+int
+local_filter_continue(view_t *view)
+{
+	if(!view->local_filter.in_progress || !view->local_filter.pending)
+	{
+		return 0;
+	}
+
+	(void)continue_filtering(view, 1, 0, FILTERING_BUDGET_MS);
+	local_filter_update_view(view, view->list_pos - view->top_line);
+	ui_view_schedule_redraw(view);
+	return 1;
+}
+
 /* Gets position of an item in dir_entry list at position pos in the unfiltered
  * list.  Returns index on success, otherwise -1 is returned. */
 static int
@@ -436,6 +476,8 @@ load_unfiltered_list(view_t *view)
 	int current_file_pos = view->list_pos;
 
 	view->local_filter.in_progress = 1;
+	view->local_filter.pending = 0;
+	view->local_filter.narrowable = 0;
 
 	view->local_filter.saved = strdup(view->local_filter.filter.raw);
 
@@ -521,25 +563,74 @@ store_local_filter_position(view_t *view, int pos)
 /* Copies/moves elements of the unfiltered list into dir_entry list.  add
  * parameter controls whether entries matching filter are copied into dir_entry
  * list.  clear parameter controls whether entries not matching filter are
- * cleared in unfiltered list.  Returns zero unless addition is performed in
- * which case can return non-zero when all files got filtered out. */
+ * cleared in unfiltered list.  narrow limits checks to entries that passed
+ * previous filtering.  Positive budget limits time (in milliseconds) spent on
+ * adding entries, the rest of the work is then left to
+ * local_filter_continue().  Returns zero unless addition is performed and
+ * finished in which case can return non-zero when all files got filtered
+ * out. */
+static int
+update_filtering_lists(view_t *view, int add, int clear, int narrow,
+		int budget)
+{
+	struct local_filter_t *const lf = &view->local_filter;
+
+	assert((!narrow || !clear) && "Narrowing skips entries, can't clear them.");
+
+	lf->pending = 0;
+	lf->next = 0U;
+	lf->narrowing = narrow;
+	lf->parent_entry = NULL;
+	lf->parent_added = 0;
+
+	if(add)
+	{
+		view->list_rows = 0;
+		/* Tags of entries that weren't processed yet don't correspond to new
+		 * filter unless it's narrower than previous one. */
+		lf->narrowable = narrow;
+	}
+
+	return continue_filtering(view, add, clear, budget);
+}
+
+/* Performs the work of update_filtering_lists() starting with the state it
+ * stored in the view.  Returns the same as update_filtering_lists(). */
 static int
-update_filtering_lists(view_t *view, int add, int clear)
+continue_filtering(view_t *view, int add, int clear, int budget)
 {
 	/* filters_drop_temporaries() is a similar function. */
 
+	struct local_filter_t *const lf = &view->local_filter;
+	const long long deadline = (add && budget > 0) ? time_in_ms() + budget : 0;
+
 	size_t i;
-	size_t list_size = 0U;
-	dir_entry_t *parent_entry = NULL;
-	int parent_added = 0;
+	size_t list_size = add ? (size_t)view->list_rows : 0U;
+	dir_entry_t *parent_entry = lf->parent_entry;
+	int parent_added = lf->parent_added;
 
-	for(i = 0; i < view->local_filter.unfiltered_count; ++i)
+	for(i = lf->next; i < lf->unfiltered_count; ++i)
 	{
+		/* Showing empty partial list isn't an option. */
+		if(deadline != 0 && i != lf->next && i%FILTERING_CHECK_PERIOD == 0 &&
+				list_size != 0U && time_in_ms() >= deadline)
+		{
+			lf->pending = 1;
+			lf->next = i;
+			lf->parent_entry = parent_entry;
+			lf->parent_added = parent_added;
+
+			view->list_rows = list_size;
+			view->filtered = lf->prefiltered_count + lf->unfiltered_count
+			               - list_size;
+			return 0;
+		}
+
 		/* FIXME: some very long file names won't be matched against some
 		 * regexps. */
 		char name_with_slash[NAME_MAX + 1 + 1];
 
-		dir_entry_t *const entry = &view->local_filter.unfiltered[i];
+		dir_entry_t *const entry = &lf->unfiltered[i];
 		const char *name = entry->name;
 
 		if(is_parent_dir(name))
@@ -555,7 +646,7 @@ update_filtering_lists(view_t *view, int add, int clear)
 				}
 				continue;
 			}
-			else if(!filter_is_empty(&view->local_filter.filter))
+			else if(!filter_is_empty(&lf->filter))
 			{
 				if(clear)
 				{
@@ -565,6 +656,12 @@ update_filtering_lists(view_t *view, int add, int clear)
 			}
 		}
 
+		/* Entry that didn't pass previous filter can't pass narrower one. */
+		if(lf->narrowing && entry->tag < 0)
+		{
+			continue;
+		}
+
 		if(fentry_is_dir(entry))
 		{
 			append_slash(name, name_with_slash, sizeof(name_with_slash));
@@ -574,7 +671,7 @@ update_filtering_lists(view_t *view, int add, int clear)
 		/* tag links to position of nodes passed through filter in list of visible
 		 * files.  Nodes that didn't pass have -1. */
 		entry->tag = -1;
-		if(filter_matches(&view->local_filter.filter, name) != 0)
+		if(filter_matches(&lf->filter, name) != 0)
 		{
 			if(add)
 			{
@@ -597,6 +694,8 @@ update_filtering_lists(view_t *view, int add, int clear)
 		}
 	}
 
+	lf->pending = 0;
+
 	if(clear)
 	{
 		/* XXX: the check of name pointer is horrible, but is needed to prevent
@@ -609,13 +708,15 @@ update_filtering_lists(view_t *view, int add, int clear)
 	}
 	if(add)
 	{
+		lf->narrowable = 1;
+
 		view->list_rows = list_size;
-		view->filtered = view->local_filter.prefiltered_count
-		               + view->local_filter.unfiltered_count - list_size;
+		view->filtered = lf->prefiltered_count + lf->unfiltered_count
+		               - list_size;
 		ensure_filtered_list_not_empty(view, parent_entry);
 		return list_size == 0U
 		    || (list_size == 1U && parent_added &&
-						(filter_matches(&view->local_filter.filter, "../") == 0));
+						(filter_matches(&lf->filter, "../") == 0));
 	}
 	return 0;
 }
@@ -785,7 +886,13 @@ local_filter_accept(view_t *view, int update_history)
 		return;
 	}
 
-	update_filtering_lists(view, 0, 1);
+	if(view->local_filter.pending)
+	{
+		/* The list of files must be complete. */
+		(void)continue_filtering(view, 1, 0, /*budget=*/0);
+	}
+
+	update_filtering_lists(view, 0, 1, /*narrow=*/0, /*budget=*/0);
 
 	local_filter_finish(view);
 
@@ -831,7 +938,7 @@ local_filter_cancel(view_t *view)
 	view->dir_entry = NULL;
 	view->list_rows = 0;
 
-	update_filtering_lists(view, 1, 1);
+	update_filtering_lists(view, 1, 1, /*narrow=*/0, /*budget=*/0);
 	local_filter_finish(view);
 }
 
@@ -842,6 +949,7 @@ local_filter_finish(view_t *view)
 	dynarray_free(view->local_filter.unfiltered);
 	free(view->local_filter.saved);
 	view->local_filter.in_progress = 0;
+	view->local_filter.pending = 0;
 
 	free(view->local_filter.poshist);
 	view->local_filter.poshist = NULL;
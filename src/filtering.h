@@ -96,6 +96,11 @@ void name_filters_restore(struct view_t *view);
  * files were filtered out. */
 int local_filter_set(struct view_t *view, const char filter[]);
 
+/* Continues interactive filtering that didn't fit into its time budget.
+ * Returns non-zero if list of files was updated, otherwise zero is
+ * returned. */
+int local_filter_continue(struct view_t *view);
+
 /* Updates last recorded cursor position. */
 void local_filter_update_pos(struct view_t *view);
 
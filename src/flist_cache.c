@@ -0,0 +1,373 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "flist_cache.h"
+
+#include <assert.h> /* assert() */
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* memcpy() memmove() strcmp() strdup() strlen() */
+
+#include "cfg/config.h"
+#include "ui/ui.h"
+#include "utils/darray.h"
+#include "utils/dynarray.h"
+#include "utils/filter.h"
+#include "utils/fswatch.h"
+#include "utils/matcher.h"
+#include "utils/str.h"
+#include "utils/str_pool.h"
+#include "filelist.h"
+
+/* Maximum number of listings to keep.  Each of them holds a file-system
+ * watch, which is a limited resource. */
+enum { MAX_LISTINGS = 16 };
+
+/* Cached listing of a single directory. */
+typedef struct
+{
+	char *path;           /* Path to the directory. */
+	char *signature;      /* Parameters of the view the listing was made for. */
+	fswatch_t *watch;     /* Tracker of changes in the directory. */
+	dir_entry_t *entries; /* Copy of the entries. */
+	str_pool_t *names;    /* Storage of names of the entries. */
+	int nentries;         /* Number of entries. */
+	int filtered;         /* Number of entries that were filtered out. */
+	size_t size;          /* Size taken up by this listing. */
+}
+listing_t;
+
+static int find_listing(const char path[]);
+static void drop_listing(int idx);
+static void free_listing(listing_t *listing);
+static char * make_signature(const view_t *view);
+static size_t get_max_size(void);
+
+/* Declarations to enable use of DA_* on cache. */
+static DA_INSTANCE(cache);
+/* Cached listings ordered from least to most recently used. */
+static listing_t **cache;
+/* Total size of all listings. */
+static size_t cache_size;
+/* Number of successful lookups. */
+static unsigned long hits;
+/* Number of failed lookups. */
+static unsigned long misses;
+
+struct fswatch_t *
+flist_cache_prepare(const char path[])
+{
+	if(get_max_size() == 0U)
+	{
+		return NULL;
+	}
+	return fswatch_create(path);
+}
+
+void
+flist_cache_put(view_t *view, struct fswatch_t *watch)
+{
+	const int existing = find_listing(view->curr_dir);
+	if(existing >= 0)
+	{
+		drop_listing(existing);
+	}
+
+	/* Listing shaped by local filter is temporary. */
+	if(watch == NULL || !filter_is_empty(&view->local_filter.filter))
+	{
+		fswatch_free(watch);
+		return;
+	}
+
+	/* Lower bound of the size to not copy listings that won't fit anyway. */
+	size_t size = sizeof(listing_t) + sizeof(dir_entry_t)*view->list_rows;
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		size += strlen(view->dir_entry[i].name) + 1U;
+	}
+
+	if(size > get_max_size())
+	{
+		fswatch_free(watch);
+		return;
+	}
+
+	listing_t *const listing = calloc(1, sizeof(*listing));
+	if(listing == NULL)
+	{
+		fswatch_free(watch);
+		return;
+	}
+
+	listing->watch = watch;
+	listing->path = strdup(view->curr_dir);
+	listing->signature = make_signature(view);
+	listing->entries = malloc(sizeof(*listing->entries)*(view->list_rows + 1));
+	/* Names are copied instead of referencing pool of the view, which can hold
+	 * names of other listings and wouldn't be accounted for. */
+	listing->names = str_pool_new();
+	if(listing->path == NULL || listing->signature == NULL ||
+			listing->entries == NULL || listing->names == NULL)
+	{
+		free_listing(listing);
+		return;
+	}
+
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		dir_entry_t *const entry = &listing->entries[i];
+		*entry = view->dir_entry[i];
+
+		entry->name = str_pool_dup(listing->names, view->dir_entry[i].name);
+		entry->name_pool = listing->names;
+		if(entry->name == NULL)
+		{
+			free_listing(listing);
+			return;
+		}
+		str_pool_ref(listing->names);
+
+		/* Restored listing is going to belong to a different list. */
+		entry->origin = NULL;
+		entry->selected = 0;
+		entry->was_selected = 0;
+		entry->marked = 0;
+		entry->search_match = 0;
+		entry->hi_num = -1;
+		entry->name_dec_num = -1;
+		++listing->nentries;
+	}
+	listing->filtered = view->filtered;
+	listing->size = sizeof(listing_t) + sizeof(dir_entry_t)*view->list_rows
+	              + str_pool_size(listing->names);
+	size = listing->size;
+	if(size > get_max_size())
+	{
+		free_listing(listing);
+		return;
+	}
+
+	/* Make room for the new listing. */
+	while(DA_SIZE(cache) != 0U &&
+			(DA_SIZE(cache) >= MAX_LISTINGS || cache_size + size > get_max_size()))
+	{
+		drop_listing(0);
+	}
+
+	listing_t **const slot = DA_EXTEND(cache);
+	if(slot == NULL)
+	{
+		free_listing(listing);
+		return;
+	}
+
+	*slot = listing;
+	DA_COMMIT(cache);
+	cache_size += size;
+}
+
+int
+flist_cache_get(view_t *view)
+{
+	if(get_max_size() == 0U)
+	{
+		return 0;
+	}
+
+	const int idx = find_listing(view->curr_dir);
+	if(idx < 0)
+	{
+		++misses;
+		return 0;
+	}
+
+	listing_t *const listing = cache[idx];
+
+	char *const signature = make_signature(view);
+	const int matches = (signature != NULL)
+	                 && strcmp(signature, listing->signature) == 0;
+	free(signature);
+
+	if(!matches || !filter_is_empty(&view->local_filter.filter))
+	{
+		++misses;
+		return 0;
+	}
+
+	if(fswatch_poll(listing->watch) != FSWS_UNCHANGED)
+	{
+		drop_listing(idx);
+		++misses;
+		return 0;
+	}
+
+	dir_entry_t *entries =
+		dynarray_extend(NULL, sizeof(*entries)*listing->nentries);
+	if(entries == NULL)
+	{
+		++misses;
+		return 0;
+	}
+
+	int i;
+	for(i = 0; i < listing->nentries; ++i)
+	{
+		entries[i] = listing->entries[i];
+		entries[i].origin = &view->curr_dir[0];
+		if(fentry_dup_name(&entries[i]) != 0)
+		{
+			int count_so_far = i;
+			free_dir_entries(&entries, &count_so_far);
+			++misses;
+			return 0;
+		}
+	}
+
+	free_dir_entries(&view->dir_entry, &view->list_rows);
+	view->dir_entry = entries;
+	view->list_rows = listing->nentries;
+	view->filtered = listing->filtered;
+
+	/* Make the most recently used listing the last one. */
+	memmove(cache + idx, cache + idx + 1,
+			sizeof(*cache)*(DA_SIZE(cache) - 1U - idx));
+	cache[DA_SIZE(cache) - 1U] = listing;
+
+	++hits;
+	return 1;
+}
+
+void
+flist_cache_shrink(void)
+{
+	while(DA_SIZE(cache) != 0U && cache_size > get_max_size())
+	{
+		drop_listing(0);
+	}
+}
+
+void
+flist_cache_clear(void)
+{
+	while(DA_SIZE(cache) != 0U)
+	{
+		drop_listing(DA_SIZE(cache) - 1U);
+	}
+	hits = 0;
+	misses = 0;
+}
+
+void
+flist_cache_get_stats(flist_cache_stats_t *stats)
+{
+	stats->count = DA_SIZE(cache);
+	stats->size = cache_size;
+	stats->hits = hits;
+	stats->misses = misses;
+}
+
+/* Looks up listing of the specified directory.  Returns its index or -1. */
+static int
+find_listing(const char path[])
+{
+	size_t i;
+	for(i = 0U; i < DA_SIZE(cache); ++i)
+	{
+		if(stroscmp(cache[i]->path, path) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* Removes listing from the cache and frees it. */
+static void
+drop_listing(int idx)
+{
+	listing_t *const listing = cache[idx];
+	cache_size -= listing->size;
+	DA_REMOVE(cache, &cache[idx]);
+	free_listing(listing);
+}
+
+/* Frees a listing along with all of its resources. */
+static void
+free_listing(listing_t *listing)
+{
+	int i;
+	for(i = 0; i < listing->nentries; ++i)
+	{
+		fentry_free(&listing->entries[i]);
+	}
+	free(listing->entries);
+	str_pool_unref(listing->names);
+	free(listing->signature);
+	free(listing->path);
+	fswatch_free(listing->watch);
+	free(listing);
+}
+
+/* Composes a string that describes all parameters of a view which affect
+ * contents of a listing and its order.  Returns newly allocated string or
+ * NULL. */
+static char *
+make_signature(const view_t *view)
+{
+	char sort[SK_COUNT*4 + 1];
+	size_t len = 0U;
+	int i;
+	for(i = 0; i < SK_COUNT; ++i)
+	{
+		len += snprintf(sort + len, sizeof(sort) - len, "%d,", view->sort[i]);
+	}
+
+	const char *const manual = (view->manual_filter == NULL)
+	                         ? ""
+	                         : matcher_get_expr(view->manual_filter);
+	const char *const automatic = (view->auto_filter.raw == NULL)
+	                            ? ""
+	                            : view->auto_filter.raw;
+	const char *const groups = (view->sort_groups == NULL)
+	                         ? ""
+	                         : view->sort_groups;
+
+	/* Lengths of strings make the signature unambiguous. */
+	return format_str("%s%d:%d:%d:%d:%zu:%s%zu:%s%zu:%s", sort, view->hide_dot,
+			view->invert, cfg.sort_numbers, cfg.dot_dirs, strlen(groups), groups,
+			strlen(manual), manual, strlen(automatic), automatic);
+}
+
+/* Retrieves size limit of the cache.  Returns the limit in bytes. */
+static size_t
+get_max_size(void)
+{
+	/* Watcher that notices only changes of the list of files can't tell whether
+	 * a listing is up to date, so the cache is disabled in this case. */
+	if(!fswatch_tracks_files())
+	{
+		return 0U;
+	}
+	return (size_t)cfg.list_cache*1024U*1024U;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
@@ -0,0 +1,68 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__FLIST_CACHE_H__
+#define VIFM__FLIST_CACHE_H__
+
+/* This unit keeps sorted and filtered listings of recently visited directories
+ * to make returning to them cheap.  Listings are validated by file-system
+ * watchers which are started before directories are read, so no change can
+ * slip between reading and caching. */
+
+#include <stddef.h> /* size_t */
+
+struct fswatch_t;
+struct view_t;
+
+/* Statistics of the cache. */
+typedef struct
+{
+	int count;            /* Number of cached listings. */
+	size_t size;          /* Memory taken up by the listings (lower bound). */
+	unsigned long hits;   /* Number of lookups that provided a listing. */
+	unsigned long misses; /* Number of lookups that provided nothing. */
+}
+flist_cache_stats_t;
+
+/* Starts watching a directory which is about to be read.  Returns a watcher to
+ * be passed to flist_cache_put() or NULL if listing can't be cached. */
+struct fswatch_t * flist_cache_prepare(const char path[]);
+
+/* Caches copy of the list of a view.  Takes ownership of the watch, which can
+ * be NULL. */
+void flist_cache_put(struct view_t *view, struct fswatch_t *watch);
+
+/* Fills list of a view with cached listing of its current directory if it's
+ * up to date and matches current parameters of the view.  Returns non-zero on
+ * success, otherwise zero is returned. */
+int flist_cache_get(struct view_t *view);
+
+/* Drops least recently used listings until the cache fits into the limit set
+ * by the 'listcache' option. */
+void flist_cache_shrink(void);
+
+/* Drops all cached listings. */
+void flist_cache_clear(void);
+
+/* Retrieves current statistics of the cache. */
+void flist_cache_get_stats(flist_cache_stats_t *stats);
+
+#endif /* VIFM__FLIST_CACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
@@ -38,7 +38,6 @@
 #include <stdio.h> /* FILE snprintf() */
 #include <stdlib.h> /* free() malloc() */
 #include <string.h> /* memset() strcat() strcmp() strdup() strlen() */
-#include <time.h> /* clock_gettime() */
 
 #include "cfg/config.h"
 #include "compat/dtype.h"
@@ -164,7 +163,6 @@ static int ui_cancellation_hook(void *arg);
 TSTATIC char ** edit_list(struct ext_edit_t *ext_edit, size_t orig_len,
 		char *orig[], int *edited_len, int load_always);
 TSTATIC progress_data_t * alloc_progress_data(int bg, void *info);
-static long long time_in_ms(void);
 
 line_prompt_func fops_line_prompt;
 options_prompt_func fops_options_prompt;
@@ -476,6 +474,7 @@ io_progress_fg(const io_progress_t *state, int progress)
 {
 	char current_size_str[64];
 	char total_size_str[64];
+	char parallel_str[64];
 	char src_path[PATH_MAX + 1];
 	const char *title, *ctrl_msg;
 	const char *target_name;
@@ -532,18 +531,26 @@ io_progress_fg(const io_progress_t *state, int progress)
 
 	item_num = MIN(estim->current_item + 1, estim->total_items);
 
+	parallel_str[0] = '\0';
+	if(estim->parallel_items != 0)
+	{
+		snprintf(parallel_str, sizeof(parallel_str), " (+%d in background)",
+				(int)estim->parallel_items);
+	}
+
 	update_io_stats(pdata, estim);
 
 	if(progress < 0)
 	{
 		/* Simplified message for unknown total size. */
 		draw_msgf(title, ctrl_msg, pdata->width,
-				"Location: %s\nItem:     %d of %" PRINTF_ULL "\n"
+				"Location: %s\nItem:     %d of %" PRINTF_ULL "%s\n"
 				"Overall:  %s %s\n"
 				" \n" /* Space is on purpose to preserve empty line. */
 				"file %s\nfrom %s%s",
 				replace_home_part(ops->target_dir), item_num,
-				(unsigned long long)estim->total_items, total_size_str, pdata->rate_str,
+				(unsigned long long)estim->total_items, parallel_str, total_size_str,
+				pdata->rate_str,
 				item_name, src_path, as_part);
 	}
 	else
@@ -552,13 +559,13 @@ io_progress_fg(const io_progress_t *state, int progress)
 		update_progress_bar(pdata, estim);
 
 		draw_msgf(title, ctrl_msg, pdata->width,
-				"Location: %s\nItem:     %d of %" PRINTF_ULL "\n"
+				"Location: %s\nItem:     %d of %" PRINTF_ULL "%s\n"
 				"Overall:  %5s/%-5s (%d%%)  |  %s  %s  %s\n"
 				"%s\n"
 				" \n" /* Space is on purpose to preserve empty line. */
 				"file %s\nfrom %s%s%s",
 				replace_home_part(ops->target_dir), item_num,
-				(unsigned long long)estim->total_items, current_size_str,
+				(unsigned long long)estim->total_items, parallel_str, current_size_str,
 				total_size_str, progress/IO_PRECISION, pdata->rate_str,
 				pdata->eta_str[0] == '\0' ? "" : "|", pdata->eta_str,
 				pdata->progress_bar, item_name, src_path, as_part, file_progress);
@@ -1165,19 +1172,6 @@ alloc_progress_data(int bg, void *info)
 	return pdata;
 }
 
-/* Retrieves current time in milliseconds. */
-static long long
-time_in_ms(void)
-{
-	struct timespec current_time;
-	if(clock_gettime(CLOCK_MONOTONIC, &current_time) != 0)
-	{
-		return 0;
-	}
-
-	return current_time.tv_sec*1000 + current_time.tv_nsec/1000000;
-}
-
 int
 fops_active(const ops_t *ops)
 {
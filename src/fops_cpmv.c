@@ -266,7 +266,7 @@ fops_replace_entry(ops_t *ops, view_t *src, const dir_entry_t *src_entry,
 					ops, /*force=*/0) == 0 && !dst_exists)
 		{
 			/* Update the destination entry to not be fake. */
-			replace_string(&dst_entry->name, src_entry->name);
+			(void)fentry_set_name(dst_entry, src_entry->name);
 			replace_string(&dst_entry->origin, dst_dir);
 		}
 	}
@@ -23,6 +23,7 @@
 #include <sys/types.h> /* gid_t uid_t */
 
 #include <string.h> /* strdup() strlen() */
+#include <time.h> /* time_t */
 
 #include "cfg/config.h"
 #include "compat/os.h"
@@ -32,6 +33,7 @@
 #include "ui/statusbar.h"
 #include "ui/ui.h"
 #include "utils/cancellation.h"
+#include "utils/dir_size.h"
 #include "utils/fs.h"
 #include "utils/path.h"
 #include "utils/str.h"
@@ -90,6 +92,11 @@ static void start_dir_size_calc(const char path[], int force);
 static void dir_size_bg(bg_op_t *bg_op, void *arg);
 static void dir_size(bg_op_t *bg_op, const char path[], int force);
 static int bg_cancellation_hook(void *arg);
+static int get_cached_dir_size(const char path[], time_t mtime, uint64_t inode,
+		uint64_t *size, void *arg);
+static void cache_dir_size(const char path[], uint64_t inode,
+		const dir_size_t *size, void *arg);
+static int is_dir_size_cancelled(void *arg);
 #ifndef _WIN32
 static void change_owner_cb(const char new_owner[], void *arg);
 static int complete_owner(const char str[], void *arg);
@@ -1322,10 +1329,6 @@ uint64_t
 fops_dir_size(const char path[], int force_update,
 		const cancellation_t *cancellation)
 {
-	struct dirent *dentry;
-	const char *slash;
-	uint64_t size;
-
 	time_t mtime = 0;
 	uint64_t inode = DCACHE_UNKNOWN;
 	struct stat s;
@@ -1335,8 +1338,6 @@ fops_dir_size(const char path[], int force_update,
 		inode = s.st_ino;
 	}
 
-	/* The check is at the top and not in the loop to do only one stat() for each
-	 * path. */
 	if(!force_update)
 	{
 		uint64_t dir_size;
@@ -1347,47 +1348,45 @@ fops_dir_size(const char path[], int force_update,
 		}
 	}
 
-	DIR *dir = os_opendir(path);
-	if(dir == NULL)
-	{
-		return 0U;
-	}
+	const dir_size_cbs_t cbs = {
+		.cached = force_update ? NULL : &get_cached_dir_size,
+		.done = &cache_dir_size,
+		.cancelled = &is_dir_size_cancelled,
+		.arg = (void *)cancellation,
+	};
 
-	slash = (ends_with_slash(path) ? "" : "/");
-	size = 0U;
-	while((dentry = os_readdir(dir)) != NULL)
+	dir_size_t size;
+	if(dir_size_calc(path, &cbs, &size) != 0)
 	{
-		char full_path[PATH_MAX + 1];
-
-		if(is_builtin_dir(dentry->d_name))
-		{
-			continue;
-		}
-
-		snprintf(full_path, sizeof(full_path), "%s%s%s", path, slash,
-				dentry->d_name);
-		if(fops_is_dir_entry(full_path, dentry))
-		{
-			size += fops_dir_size(full_path, force_update, cancellation);
-		}
-		else
-		{
-			size += get_file_size(full_path);
-		}
-
-		if(cancellation_requested(cancellation))
-		{
-			os_closedir(dir);
-			return 0U;
-		}
+		return 0U;
 	}
+	return size.size;
+}
 
-	os_closedir(dir);
+/* Implementation of dir_size_cached callback that queries dcache. */
+static int
+get_cached_dir_size(const char path[], time_t mtime, uint64_t inode,
+		uint64_t *size, void *arg)
+{
+	dcache_get_at(path, mtime, inode, size, NULL);
+	return (*size != DCACHE_UNKNOWN);
+}
 
+/* Implementation of dir_size_done callback that fills dcache. */
+static void
+cache_dir_size(const char path[], uint64_t inode, const dir_size_t *size,
+		void *arg)
+{
 	/* Could calculate nitems here, but they aren't recursive and might only take
 	 * up memory, because interest in size sort of excludes interest in nitems. */
-	(void)dcache_set_at(path, inode, size, DCACHE_UNKNOWN);
-	return size;
+	(void)dcache_set_at(path, inode, size->size, DCACHE_UNKNOWN);
+}
+
+/* Implementation of dir_size_cancelled callback that checks cancellation_t. */
+static int
+is_dir_size_cancelled(void *arg)
+{
+	return cancellation_requested(arg);
 }
 
 #ifndef _WIN32
@@ -125,6 +125,10 @@ struct io_args_t
 			unsigned int fast_file_cloning : 1;
 			/* Whether to call fdatasync() periodically. */
 			unsigned int data_sync : 1;
+			/* Whether to skip holes of sparse files instead of writing zeroes. */
+			unsigned int sparse_files : 1;
+			/* Whether to remove destination file if copying into it fails. */
+			unsigned int remove_on_failure : 1;
 		};
 	}
 	arg4;
@@ -53,6 +53,10 @@ typedef struct ioeta_estim_t
 	/* Number of inspected items. */
 	size_t inspected_items;
 
+	/* Number of items being processed in background in addition to the current
+	 * one. */
+	size_t parallel_items;
+
 	/* Path to currently processed file. */
 	char *item;
 
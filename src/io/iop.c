@@ -22,19 +22,26 @@
 
 #include "iop.h"
 
+#ifdef __linux__
+#include <sys/sendfile.h> /* sendfile() */
+#include <sys/syscall.h> /* SYS_copy_file_range */
+#endif
 #ifndef _WIN32
-#include <sys/ioctl.h> /* ioctl() */
+#include <sys/ioctl.h> /* _IOW() ioctl() */
 #endif
 #include <sys/stat.h> /* stat */
-#include <sys/types.h> /* mode_t */
-#include <unistd.h> /* symlink() unlink() */
+#include <sys/types.h> /* mode_t off_t */
+#include <fcntl.h> /* O_CREAT O_EXCL O_WRONLY open() */
+#include <unistd.h> /* SEEK_DATA SEEK_HOLE ssize_t close() ftruncate() lseek()
+                        pread() pwrite() symlink() syscall() unlink() */
 
 #include <assert.h> /* assert() */
-#include <errno.h> /* EEXIST ENOENT EISDIR errno */
+#include <errno.h> /* EBADF EEXIST EINTR EINVAL ENOENT ENOSYS ENXIO EISDIR
+                     EOPNOTSUPP EXDEV errno */
 #include <stddef.h> /* NULL size_t */
 #include <stdio.h> /* FILE fpos_t fclose() fgetpos() fflush() fread() fseek()
                       fsetpos() fwrite() snprintf() */
-#include <stdlib.h> /* free() */
+#include <stdlib.h> /* free() malloc() */
 #include <string.h> /* strchr() */
 
 #include "../compat/fs_limits.h"
@@ -51,8 +58,12 @@
 #include "private/ioeta.h"
 #include "ioc.h"
 
-/* Amount of data to transfer at once. */
-#define BLOCK_SIZE 32*1024
+/* Amount of data to transfer at once when copying via user space. */
+#define BLOCK_SIZE 128*1024
+
+/* Amount of data to request from kernel at once when it copies data on its
+ * own.  Bounds delay of reaction to cancellation requests. */
+#define KERNEL_BLOCK_SIZE 8*1024*1024
 
 /* Amount of data after which data flush should be performed. */
 #define FLUSH_SIZE 256*1024*1024
@@ -65,7 +76,19 @@ static IoRes iop_mkdir_internal(io_args_t *args);
 static IoRes iop_rmfile_internal(io_args_t *args);
 static IoRes iop_rmdir_internal(io_args_t *args);
 static IoRes iop_cp_internal(io_args_t *args);
+static FILE * open_new_file(const char path[]);
 static int clone_file(int dst_fd, int src_fd);
+#if !defined(_WIN32) && defined(SEEK_DATA)
+static int is_sparse(const struct stat *st);
+static int copy_sparse(io_args_t *args, int in_fd, int out_fd, off_t size,
+		int *error);
+static int copy_range(io_args_t *args, int in_fd, int out_fd, off_t offset,
+		off_t len, char buf[], size_t *ncopied);
+#endif
+#ifdef __linux__
+static int copy_in_kernel(io_args_t *args, int in_fd, int out_fd, int *error);
+static int copy_range_is_unsupported(int error);
+#endif
 #ifdef _WIN32
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
 		LARGE_INTEGER transferred, LARGE_INTEGER stream_size,
@@ -303,7 +326,7 @@ iop_cp_internal(io_args_t *args)
 
 	FILE *in, *out;
 	int error;
-	int cloned;
+	int copied;
 	struct stat src_st;
 	const char *open_mode = "wb";
 
@@ -503,7 +526,9 @@ iop_cp_internal(io_args_t *args)
 	}
 #endif
 
-	out = os_fopen(dst, open_mode);
+	/* Destination could have appeared after the check above, make sure it's not
+	 * overwritten. */
+	out = (crs == IO_CRS_FAIL) ? open_new_file(dst) : os_fopen(dst, open_mode);
 	if(out == NULL)
 	{
 		(void)ioe_errlst_append(&args->result.errors, dst, errno,
@@ -517,7 +542,7 @@ iop_cp_internal(io_args_t *args)
 	}
 
 	error = 0;
-	cloned = 0;
+	copied = 0;
 
 	if(crs == IO_CRS_APPEND_TO_FILES)
 	{
@@ -540,22 +565,46 @@ iop_cp_internal(io_args_t *args)
 	{
 		if(clone_file(fileno(out), fileno(in)) == 0)
 		{
-			cloned = 1;
+			copied = 1;
 		}
 	}
 
-	/* TODO: use sendfile() if platform supports it. */
+	/* Streams haven't been used for I/O yet, so it's safe to operate on their
+	 * file descriptors directly.  Appending relies on stream position, hence is
+	 * left to the loop below. */
+
+#if !defined(_WIN32) && defined(SEEK_DATA)
+	if(!error && !copied && crs != IO_CRS_APPEND_TO_FILES &&
+			args->arg4.sparse_files && is_sparse(&st))
+	{
+		copied = copy_sparse(args, fileno(in), fileno(out), st.st_size, &error);
+	}
+#endif
+
+#ifdef __linux__
+	if(!error && !copied && crs != IO_CRS_APPEND_TO_FILES)
+	{
+		copied = copy_in_kernel(args, fileno(in), fileno(out), &error);
+	}
+#endif
 
-	if(!error && !cloned)
+	if(!error && !copied)
 	{
-		char block[BLOCK_SIZE];
+		char *const block = malloc(BLOCK_SIZE);
 		/* Suppress possible false-positive compiler warning. */
 		size_t nread = (size_t)-1;
 #ifndef _WIN32
 		size_t ncopied = 0U;
 		const int data_sync = args->arg4.data_sync;
 #endif
-		while((nread = fread(&block, 1, sizeof(block), in)) != 0U)
+		if(block == NULL)
+		{
+			(void)ioe_errlst_append(&args->result.errors, dst, errno,
+					"Failed to allocate memory for copying");
+			error = 1;
+		}
+
+		while(block != NULL && (nread = fread(block, 1, BLOCK_SIZE, in)) != 0U)
 		{
 			if(io_cancelled(args))
 			{
@@ -563,7 +612,7 @@ iop_cp_internal(io_args_t *args)
 				break;
 			}
 
-			if(fwrite(&block, 1, nread, out) != nread)
+			if(fwrite(block, 1, nread, out) != nread)
 			{
 				(void)ioe_errlst_append(&args->result.errors, dst, errno,
 						"Write to destination file failed");
@@ -591,6 +640,8 @@ iop_cp_internal(io_args_t *args)
 					"Read from source file failed");
 		}
 
+		free(block);
+
 		/* fwrite() does caching, so we need to force flush to catch output errors
 		 * before fclose() (which also does fflush() internally). */
 		if(fflush(out) != 0)
@@ -644,23 +695,56 @@ iop_cp_internal(io_args_t *args)
 	{
 		clone_attribs(dst, src, &st);
 	}
+	else if(args->arg4.remove_on_failure && crs != IO_CRS_APPEND_TO_FILES)
+	{
+		/* Don't leave partial copy behind. */
+		(void)unlink(dst);
+	}
 
 	ioeta_update(args->estim, NULL, NULL, 1, 0);
 
 	return io_res_from_code(error);
 }
 
-/* Try to clone file fast on btrfs.  Returns 0 on success, otherwise non-zero is
- * returned. */
+/* Creates a new file for writing failing if something exists at the path.
+ * Returns opened file or NULL on error with errno set. */
+static FILE *
+open_new_file(const char path[])
+{
+#ifndef _WIN32
+	const int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0666);
+	if(fd == -1)
+	{
+		return NULL;
+	}
+
+	FILE *const file = fdopen(fd, "wb");
+	if(file == NULL)
+	{
+		const int error = errno;
+		(void)close(fd);
+		errno = error;
+	}
+	return file;
+#else
+	/* Windows copies files via CopyFileExW() which checks for existence. */
+	return os_fopen(path, "wb");
+#endif
+}
+
+/* Try to clone file fast by sharing its extents (works on btrfs, XFS, bcachefs,
+ * overlayfs on top of those and some others).  Returns 0 on success, otherwise
+ * non-zero is returned. */
 static int
 clone_file(int dst_fd, int src_fd)
 {
 #ifdef __linux__
-#undef BTRFS_IOCTL_MAGIC
-#define BTRFS_IOCTL_MAGIC 0x94
-#undef BTRFS_IOC_CLONE
-#define BTRFS_IOC_CLONE _IOW(BTRFS_IOCTL_MAGIC, 9, int)
-	return ioctl(dst_fd, BTRFS_IOC_CLONE, src_fd);
+/* Not including <linux/fs.h> for this as it defines conflicting macros. */
+#ifndef FICLONE
+/* Generalized version of BTRFS_IOC_CLONE, which has the same value. */
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+	return ioctl(dst_fd, FICLONE, src_fd);
 #else
 	(void)dst_fd;
 	(void)src_fd;
@@ -668,6 +752,280 @@ clone_file(int dst_fd, int src_fd)
 #endif
 }
 
+#if !defined(_WIN32) && defined(SEEK_DATA)
+
+/* Checks whether file occupies less space on disk than its size implies, which
+ * means that it has holes.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+is_sparse(const struct stat *st)
+{
+	/* st_blocks is always measured in 512-byte units. */
+	return S_ISREG(st->st_mode)
+	    && (uint64_t)st->st_blocks*512U < (uint64_t)st->st_size;
+}
+
+/* Copies file skipping holes in it, so that they are recreated in the
+ * destination instead of being filled with zeroes.  Holes still contribute to
+ * progress.  Sets *error on failure or cancellation.  Returns non-zero if
+ * copying was handled here and zero if caller should copy data on its own. */
+static int
+copy_sparse(io_args_t *args, int in_fd, int out_fd, off_t size, int *error)
+{
+	const char *const src = args->arg1.src;
+	const char *const dst = args->arg2.dst;
+
+	char *const buf = malloc(BLOCK_SIZE);
+	if(buf == NULL)
+	{
+		return 0;
+	}
+
+	size_t ncopied = 0U;
+	off_t offset = 0;
+	while(offset < size)
+	{
+		off_t data = lseek(in_fd, offset, SEEK_DATA);
+		if(data < 0)
+		{
+			if(errno != ENXIO)
+			{
+				free(buf);
+				if(offset == 0)
+				{
+					/* File system doesn't support looking for holes. */
+					return 0;
+				}
+
+				(void)ioe_errlst_append(&args->result.errors, src, errno,
+						"Failed to look for data in source file");
+				*error = 1;
+				return 1;
+			}
+
+			/* The rest of the file is a hole. */
+			data = size;
+		}
+
+		off_t hole = size;
+		if(data < size)
+		{
+			hole = lseek(in_fd, data, SEEK_HOLE);
+			if(hole < 0)
+			{
+				(void)ioe_errlst_append(&args->result.errors, src, errno,
+						"Failed to look for hole in source file");
+				free(buf);
+				*error = 1;
+				return 1;
+			}
+			/* The file might be growing while we're copying it. */
+			hole = MIN(hole, size);
+		}
+
+		ioeta_update(args->estim, NULL, NULL, 0, data - offset);
+
+		if(copy_range(args, in_fd, out_fd, data, hole - data, buf, &ncopied) != 0)
+		{
+			free(buf);
+			*error = 1;
+			return 1;
+		}
+
+		offset = hole;
+	}
+
+	free(buf);
+
+	/* Writing only data leaves out trailing hole. */
+	if(ftruncate(out_fd, size) != 0)
+	{
+		(void)ioe_errlst_append(&args->result.errors, dst, errno,
+				"Failed to set size of destination file");
+		*error = 1;
+	}
+
+	return 1;
+}
+
+/* Copies range of a file to the same position in another file using the
+ * buffer of BLOCK_SIZE bytes.  *ncopied tracks amount of data written since
+ * last synchronization.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+copy_range(io_args_t *args, int in_fd, int out_fd, off_t offset, off_t len,
+		char buf[], size_t *ncopied)
+{
+	const char *const src = args->arg1.src;
+	const char *const dst = args->arg2.dst;
+
+	while(len > 0)
+	{
+		if(io_cancelled(args))
+		{
+			return 1;
+		}
+
+		const ssize_t nread =
+			pread(in_fd, buf, (size_t)MIN(len, (off_t)BLOCK_SIZE), offset);
+		if(nread < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+
+			(void)ioe_errlst_append(&args->result.errors, src, errno,
+					"Read from source file failed");
+			return 1;
+		}
+		if(nread == 0)
+		{
+			/* The file has shrunk. */
+			break;
+		}
+
+		ssize_t nwritten = 0;
+		while(nwritten < nread)
+		{
+			const ssize_t n = pwrite(out_fd, buf + nwritten, nread - nwritten,
+					offset + nwritten);
+			if(n < 0)
+			{
+				if(errno == EINTR)
+				{
+					continue;
+				}
+
+				(void)ioe_errlst_append(&args->result.errors, dst, errno,
+						"Write to destination file failed");
+				return 1;
+			}
+			nwritten += n;
+		}
+
+		ioeta_update(args->estim, NULL, NULL, 0, nread);
+
+		offset += nread;
+		len -= nread;
+
+		/* Force flushing data to disk to not pollute RAM with this data too
+		 * much. */
+		*ncopied += nread;
+		if(args->arg4.data_sync && *ncopied >= FLUSH_SIZE)
+		{
+			(void)os_fdatasync(out_fd);
+			*ncopied -= FLUSH_SIZE;
+		}
+	}
+
+	return 0;
+}
+
+#endif
+
+#ifdef __linux__
+
+/* Copies rest of the file without passing its data through user space.  Tries
+ * copy_file_range() first (it can reflink or copy on server side for network
+ * file systems) and sendfile() after it.  Sets *error on failure or
+ * cancellation.  Returns non-zero if copying was handled here and zero if
+ * caller should copy data on its own. */
+static int
+copy_in_kernel(io_args_t *args, int in_fd, int out_fd, int *error)
+{
+	const char *const dst = args->arg2.dst;
+	const int data_sync = args->arg4.data_sync;
+
+	size_t ncopied = 0U;
+	int first = 1;
+#ifdef SYS_copy_file_range
+	int use_sendfile = 0;
+#else
+	int use_sendfile = 1;
+#endif
+
+	while(1)
+	{
+		ssize_t n;
+
+		if(io_cancelled(args))
+		{
+			*error = 1;
+			return 1;
+		}
+
+#ifdef SYS_copy_file_range
+		if(!use_sendfile)
+		{
+			n = syscall(SYS_copy_file_range, in_fd, NULL, out_fd, NULL,
+					(size_t)KERNEL_BLOCK_SIZE, 0U);
+			/* Zero on the first call might also mean that the file is a pseudo-file
+			 * (like those in /proc), which have zero size. */
+			if(first && (n == 0 || (n < 0 && copy_range_is_unsupported(errno))))
+			{
+				use_sendfile = 1;
+				continue;
+			}
+		}
+		else
+#endif
+		{
+			n = sendfile(out_fd, in_fd, NULL, KERNEL_BLOCK_SIZE);
+			if(first && (n == 0 || (n < 0 && (errno == EINVAL || errno == ENOSYS))))
+			{
+				/* Let reading from the file decide whether it's really empty. */
+				return 0;
+			}
+		}
+
+		if(n < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+
+			(void)ioe_errlst_append(&args->result.errors, dst, errno,
+					"Failed to copy file data");
+			*error = 1;
+			return 1;
+		}
+
+		if(n == 0)
+		{
+			return 1;
+		}
+
+		first = 0;
+		ioeta_update(args->estim, NULL, NULL, 0, n);
+
+		/* Force flushing data to disk to not pollute RAM with this data too
+		 * much. */
+		ncopied += n;
+		if(data_sync && ncopied >= FLUSH_SIZE)
+		{
+			(void)os_fdatasync(out_fd);
+			ncopied -= FLUSH_SIZE;
+		}
+	}
+}
+
+/* Checks whether error code returned by copy_file_range() means that it can't
+ * be used for this pair of files.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+copy_range_is_unsupported(int error)
+{
+	return error == ENOSYS
+	    || error == EXDEV
+	    || error == EINVAL
+	    || error == EOPNOTSUPP
+	    || error == EBADF;
+}
+
+#endif
+
 #ifdef _WIN32
 
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
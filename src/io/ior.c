@@ -35,6 +35,7 @@
 #include "../utils/str.h"
 #include "../utils/utils.h"
 #include "../background.h"
+#include "private/copier.h"
 #include "private/ioc.h"
 #include "private/ioe.h"
 #include "private/ioeta.h"
@@ -42,6 +43,14 @@
 #include "ioc.h"
 #include "iop.h"
 
+/* State of copying a subtree. */
+typedef struct
+{
+	io_args_t *args;  /* Arguments of the operation. */
+	copier_t *copier; /* Copier of files in parallel or NULL. */
+}
+cp_state_t;
+
 static VisitResult rm_visitor(const char full_path[], VisitAction action,
 		void *param);
 static VisitResult cp_visitor(const char full_path[], VisitAction action,
@@ -53,8 +62,15 @@ static int is_file(const char path[]);
 static VisitResult mv_visitor(const char full_path[], VisitAction action,
 		void *param);
 static VisitResult cp_mv_visitor(const char full_path[], VisitAction action,
-		void *param, int cp);
+		io_args_t *cp_args, copier_t *copier, int cp);
+static VisitResult cp_file(io_args_t *cp_args, const char src[],
+		const char dst[]);
+static VisitResult cp_mv_file(io_args_t *cp_args, const char src[],
+		const char dst[], int cp);
+static VisitResult finish_dir(io_args_t *cp_args, const char src[],
+		const char dst[]);
 static VisitResult vr_from_io_res(IoRes result);
+static IoRes io_res_from_vr(VisitResult result);
 
 IoRes
 ior_rm(io_args_t *args)
@@ -154,7 +170,25 @@ ior_cp(io_args_t *args)
 		}
 	}
 
-	return traverse(src, &cp_visitor, args);
+	/* Files of a directory are copied in parallel. */
+	cp_state_t state = { .args = args };
+	if(is_dir(src) && !is_symlink(src))
+	{
+		state.copier = copier_new(args, &cp_file, &finish_dir);
+	}
+
+	IoRes result = traverse(src, &cp_visitor, &state);
+
+	if(state.copier != NULL)
+	{
+		const VisitResult copier_result = copier_finish(state.copier);
+		if(result == IO_RES_SUCCEEDED)
+		{
+			result = io_res_from_vr(copier_result);
+		}
+	}
+
+	return result;
 }
 
 /* Implementation of traverse() visitor for subtree copying.  Returns 0 on
@@ -162,7 +196,8 @@ ior_cp(io_args_t *args)
 static VisitResult
 cp_visitor(const char full_path[], VisitAction action, void *param)
 {
-	return cp_mv_visitor(full_path, action, param, 1);
+	cp_state_t *const state = param;
+	return cp_mv_visitor(full_path, action, state->args, state->copier, 1);
 }
 
 IoRes
@@ -377,15 +412,16 @@ is_file(const char path[])
 static VisitResult
 mv_visitor(const char full_path[], VisitAction action, void *param)
 {
-	return cp_mv_visitor(full_path, action, param, 0);
+	return cp_mv_visitor(full_path, action, param, NULL, 0);
 }
 
 /* Generic implementation of traverse() visitor for subtree copying/moving.
- * Returns 0 on success, otherwise non-zero is returned. */
+ * copier can be NULL.  Returns 0 on success, otherwise non-zero is
+ * returned. */
 static VisitResult
-cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp)
+cp_mv_visitor(const char full_path[], VisitAction action, io_args_t *cp_args,
+		copier_t *copier, int cp)
 {
-	io_args_t *const cp_args = param;
 	const char *dst_full_path;
 	char *free_me = NULL;
 	VisitResult result = VR_OK;
@@ -422,65 +458,40 @@ cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp)
 				result = vr_from_io_res(iop_mkdir(&args));
 				cp_args->result = args.result;
 			}
+			if(result == VR_OK && copier != NULL)
+			{
+				result = copier_enter_dir(copier, full_path, dst_full_path);
+			}
 			break;
 		case VA_FILE:
+			result = (copier != NULL)
+			       ? copier_file(copier, full_path, dst_full_path)
+			       : cp_mv_file(cp_args, full_path, dst_full_path, cp);
+			break;
+		case VA_DIR_LEAVE:
+			if(cp_args->arg3.crs == IO_CRS_REPLACE_FILES && !cp)
 			{
-				io_args_t args = {
-					.arg1.src = full_path,
-					.arg2.dst = dst_full_path,
-					.arg3.crs = cp_args->arg3.crs,
-					/* It's safe to always use fast file cloning on moving files. */
-					.arg4.fast_file_cloning = cp ? cp_args->arg4.fast_file_cloning : 1,
-					.arg4.data_sync = cp_args->arg4.data_sync,
+				io_args_t rm_args = {
+					.arg1.path = full_path,
 
 					.cancellation = cp_args->cancellation,
-					.confirm = cp_args->confirm,
 					.estim = cp_args->estim,
 
 					.result = cp_args->result,
 				};
 
-				result = vr_from_io_res(cp ? iop_cp(&args) : ior_mv(&args));
-				cp_args->result = args.result;
-				break;
+				result = vr_from_io_res(iop_rmdir(&rm_args));
 			}
-		case VA_DIR_LEAVE:
+			else if(copier != NULL)
 			{
-				struct stat st;
-
-				if(cp_args->arg3.crs == IO_CRS_REPLACE_FILES && !cp)
-				{
-					io_args_t rm_args = {
-						.arg1.path = full_path,
-
-						.cancellation = cp_args->cancellation,
-						.estim = cp_args->estim,
-
-						.result = cp_args->result,
-					};
-
-					result = vr_from_io_res(iop_rmdir(&rm_args));
-				}
-				else if(os_stat(full_path, &st) == 0)
-				{
-					result = (os_chmod(dst_full_path, st.st_mode & 07777) == 0)
-									? VR_OK
-									: VR_ERROR;
-					if(result == VR_ERROR)
-					{
-						(void)ioe_errlst_append(&cp_args->result.errors, dst_full_path,
-								errno, "Failed to setup directory permissions");
-					}
-					clone_attribs(dst_full_path, full_path, &st);
-				}
-				else
-				{
-					(void)ioe_errlst_append(&cp_args->result.errors, full_path, errno,
-							"Failed to stat() source directory");
-					result = VR_ERROR;
-				}
-				break;
+				/* Attributes are set after all files of the directory are copied. */
+				result = copier_leave_dir(copier);
+			}
+			else
+			{
+				result = finish_dir(cp_args, full_path, dst_full_path);
 			}
+			break;
 	}
 
 	free(free_me);
@@ -488,6 +499,66 @@ cp_mv_visitor(const char full_path[], VisitAction action, void *param, int cp)
 	return result;
 }
 
+/* Copies a file as part of copying a subtree.  Returns result of the
+ * operation. */
+static VisitResult
+cp_file(io_args_t *cp_args, const char src[], const char dst[])
+{
+	return cp_mv_file(cp_args, src, dst, 1);
+}
+
+/* Copies or moves a file as part of processing a subtree.  Returns result of
+ * the operation. */
+static VisitResult
+cp_mv_file(io_args_t *cp_args, const char src[], const char dst[], int cp)
+{
+	io_args_t args = {
+		.arg1.src = src,
+		.arg2.dst = dst,
+		.arg3.crs = cp_args->arg3.crs,
+		/* It's safe to always use fast file cloning on moving files. */
+		.arg4.fast_file_cloning = cp ? cp_args->arg4.fast_file_cloning : 1,
+		.arg4.data_sync = cp_args->arg4.data_sync,
+		.arg4.sparse_files = cp_args->arg4.sparse_files,
+
+		.cancellation = cp_args->cancellation,
+		.confirm = cp_args->confirm,
+		.estim = cp_args->estim,
+
+		.result = cp_args->result,
+	};
+
+	const VisitResult result = vr_from_io_res(cp ? iop_cp(&args)
+	                                             : ior_mv(&args));
+	cp_args->result = args.result;
+	return result;
+}
+
+/* Applies attributes of a source directory to its copy.  Returns result of the
+ * operation. */
+static VisitResult
+finish_dir(io_args_t *cp_args, const char src[], const char dst[])
+{
+	struct stat st;
+	if(os_stat(src, &st) != 0)
+	{
+		(void)ioe_errlst_append(&cp_args->result.errors, src, errno,
+				"Failed to stat() source directory");
+		return VR_ERROR;
+	}
+
+	const VisitResult result = (os_chmod(dst, st.st_mode & 07777) == 0)
+	                         ? VR_OK
+	                         : VR_ERROR;
+	if(result == VR_ERROR)
+	{
+		(void)ioe_errlst_append(&cp_args->result.errors, dst, errno,
+				"Failed to setup directory permissions");
+	}
+	clone_attribs(dst, src, &st);
+	return result;
+}
+
 /* Turns IoRes into VisitResult.  Returns VisitResult. */
 static VisitResult
 vr_from_io_res(IoRes result)
@@ -506,5 +577,23 @@ vr_from_io_res(IoRes result)
 	return VR_ERROR;
 }
 
+/* Turns VisitResult into IoRes.  Returns IoRes. */
+static IoRes
+io_res_from_vr(VisitResult result)
+{
+	switch(result)
+	{
+		case VR_OK:
+		case VR_SKIP_DIR_LEAVE:
+			return IO_RES_SUCCEEDED;
+		case VR_CANCELLED:
+			return IO_RES_ABORTED;
+		case VR_ERROR:
+			return IO_RES_FAILED;
+	}
+
+	return IO_RES_FAILED;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
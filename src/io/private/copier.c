@@ -0,0 +1,588 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "copier.h"
+
+#include <sys/stat.h> /* S_ISREG() stat */
+
+#include <assert.h> /* assert() */
+#include <errno.h> /* ENOENT ENOMEM ETIMEDOUT errno */
+#include <stddef.h> /* NULL */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* strdup() */
+#include <time.h> /* CLOCK_REALTIME clock_gettime() */
+
+#include "../../compat/os.h"
+#include "../../compat/pthread.h"
+#include "../../utils/utils.h"
+#include "../ioc.h"
+#include "../ioeta.h"
+#include "../iop.h"
+#include "ioc.h"
+#include "ioe.h"
+#include "ioeta.h"
+
+/* Number of threads that copy files.  They copy only small files, so a few of
+ * them are enough to hide the cost of creating files without competing for
+ * bandwidth with big files copied by the calling thread. */
+#define WORKERS 4
+
+/* Maximum number of files that are being copied in background at a time. */
+#define MAX_PENDING_FILES 64
+
+/* Maximum total size of files that are being copied in background at a
+ * time. */
+#define MAX_PENDING_BYTES (64*1024*1024)
+
+/* Larger files are copied on the calling thread to report their progress and
+ * react to cancellation while they are being copied. */
+#define MAX_FILE_SIZE (1024*1024)
+
+/* Period of checking for cancellation while waiting for workers. */
+#define WAIT_PERIOD_MS 50
+
+/* Directory whose attributes are applied after all of its contents is
+ * copied. */
+typedef struct dir_t
+{
+	char *src;             /* Source path. */
+	char *dst;             /* Destination path. */
+	int refs;              /* Number of unfinished files and subdirectories plus
+	                          one while directory is being traversed. */
+	struct dir_t *parent;  /* Parent directory or NULL. */
+}
+dir_t;
+
+/* File copied in background. */
+typedef struct job_t
+{
+	char *src;           /* Source path. */
+	char *dst;           /* Destination path. */
+	uint64_t size;       /* Size of the file. */
+	dir_t *dir;          /* Directory that contains the file or NULL. */
+	IoRes result;        /* Result of copying. */
+	ioe_errlst_t errors; /* Errors that happened during copying. */
+	struct job_t *next;  /* Next job in a list. */
+}
+job_t;
+
+/* State of a copier. */
+struct copier_t
+{
+	io_args_t *args;        /* Arguments of the whole operation. */
+	io_args_t worker_args;  /* Template of arguments for workers. */
+	copier_func copy_file;  /* Copies a file on the calling thread. */
+	copier_func finish_dir; /* Finishes copying of a directory. */
+
+	/* Fields below are accessed only by the calling thread. */
+	VisitResult result; /* First unsuccessful result or VR_OK. */
+	dir_t *top;         /* Innermost directory being traversed or NULL. */
+	size_t nfiles;      /* Number of files being copied in background. */
+	uint64_t nbytes;    /* Total size of files being copied in background. */
+
+	pthread_t workers[WORKERS]; /* Worker threads. */
+	int nworkers;               /* Number of started workers. */
+
+	pthread_mutex_t lock;   /* Protects fields below. */
+	pthread_cond_t work_cv; /* Signaled on new job and on shutdown. */
+	pthread_cond_t done_cv; /* Signaled when a job is done. */
+
+	job_t *queue;      /* Jobs waiting to be picked up by workers. */
+	job_t *queue_tail; /* Last element of the queue or NULL. */
+	job_t *done;       /* Finished jobs in reverse order. */
+	int cancelled;     /* Whether the operation was cancelled. */
+	int stop;          /* Whether workers should exit. */
+};
+
+static int can_copy_in_background(const copier_t *copier, const char src[],
+		const char dst[], uint64_t *size);
+static int start_workers(copier_t *copier);
+static void * worker_main(void *arg);
+static IoRes copy_in_background(copier_t *copier, job_t *job);
+static int is_cancelled(void *arg);
+static void poll_workers(copier_t *copier);
+static void wait_for_workers(copier_t *copier);
+static void handle_done_job(copier_t *copier, job_t *job);
+static void unref_dir(copier_t *copier, dir_t *dir);
+static void update_parallel_items(copier_t *copier);
+static VisitResult merge_result(copier_t *copier, VisitResult result);
+static void compute_deadline(struct timespec *ts, int timeout_ms);
+
+copier_t *
+copier_new(io_args_t *args, copier_func copy_file, copier_func finish_dir)
+{
+#ifdef _WIN32
+	/* Copying on Windows reports progress via a callback with static state. */
+	(void)args;
+	(void)copy_file;
+	(void)finish_dir;
+	return NULL;
+#else
+	copier_t *const copier = calloc(1, sizeof(*copier));
+	if(copier == NULL)
+	{
+		return NULL;
+	}
+
+	copier->args = args;
+	/* Workers can't ask for confirmation, so they don't touch existing files and
+	 * don't leave partial copies for the calling thread to deal with. */
+	copier->worker_args.arg3.crs = IO_CRS_FAIL;
+	copier->worker_args.arg4 = args->arg4;
+	copier->worker_args.arg4.remove_on_failure = 1;
+	copier->worker_args.cancellation.hook = &is_cancelled;
+	copier->worker_args.cancellation.arg = copier;
+	copier->copy_file = copy_file;
+	copier->finish_dir = finish_dir;
+	copier->result = VR_OK;
+
+	pthread_mutex_init(&copier->lock, NULL);
+	pthread_cond_init(&copier->work_cv, NULL);
+	pthread_cond_init(&copier->done_cv, NULL);
+
+	return copier;
+#endif
+}
+
+VisitResult
+copier_enter_dir(copier_t *copier, const char src[], const char dst[])
+{
+	poll_workers(copier);
+
+	dir_t *const dir = calloc(1, sizeof(*dir));
+	if(dir == NULL || (dir->src = strdup(src)) == NULL ||
+			(dir->dst = strdup(dst)) == NULL)
+	{
+		if(dir != NULL)
+		{
+			free(dir->src);
+			free(dir);
+		}
+		(void)ioe_errlst_append(&copier->args->result.errors, src, ENOMEM,
+				"Not enough memory");
+		return merge_result(copier, VR_ERROR);
+	}
+
+	dir->refs = 1;
+	dir->parent = copier->top;
+	if(dir->parent != NULL)
+	{
+		++dir->parent->refs;
+	}
+	copier->top = dir;
+
+	return copier->result;
+}
+
+VisitResult
+copier_file(copier_t *copier, const char src[], const char dst[])
+{
+	poll_workers(copier);
+	if(copier->result != VR_OK)
+	{
+		return copier->result;
+	}
+
+	uint64_t size;
+	if(!can_copy_in_background(copier, src, dst, &size))
+	{
+		return merge_result(copier, copier->copy_file(copier->args, src, dst));
+	}
+
+	/* Wait for some of the jobs to finish if budget is exhausted. */
+	while(copier->nfiles >= MAX_PENDING_FILES ||
+			(copier->nfiles > 0 && copier->nbytes + size > MAX_PENDING_BYTES))
+	{
+		wait_for_workers(copier);
+		poll_workers(copier);
+		if(copier->result != VR_OK)
+		{
+			return copier->result;
+		}
+	}
+
+	job_t *const job = calloc(1, sizeof(*job));
+	if(job == NULL || !start_workers(copier) ||
+			(job->src = strdup(src)) == NULL || (job->dst = strdup(dst)) == NULL)
+	{
+		if(job != NULL)
+		{
+			free(job->src);
+			free(job);
+		}
+		return merge_result(copier, copier->copy_file(copier->args, src, dst));
+	}
+
+	job->size = size;
+	job->dir = copier->top;
+	if(job->dir != NULL)
+	{
+		++job->dir->refs;
+	}
+
+	++copier->nfiles;
+	copier->nbytes += size;
+	update_parallel_items(copier);
+
+	pthread_mutex_lock(&copier->lock);
+	if(copier->queue_tail == NULL)
+	{
+		copier->queue = job;
+	}
+	else
+	{
+		copier->queue_tail->next = job;
+	}
+	copier->queue_tail = job;
+	pthread_cond_signal(&copier->work_cv);
+	pthread_mutex_unlock(&copier->lock);
+
+	return VR_OK;
+}
+
+VisitResult
+copier_leave_dir(copier_t *copier)
+{
+	poll_workers(copier);
+
+	dir_t *const dir = copier->top;
+	assert(dir != NULL && "Unbalanced leaving of a directory.");
+	copier->top = dir->parent;
+	unref_dir(copier, dir);
+
+	return copier->result;
+}
+
+VisitResult
+copier_finish(copier_t *copier)
+{
+	while(copier->nfiles > 0)
+	{
+		wait_for_workers(copier);
+		poll_workers(copier);
+	}
+
+	pthread_mutex_lock(&copier->lock);
+	copier->stop = 1;
+	pthread_cond_broadcast(&copier->work_cv);
+	pthread_mutex_unlock(&copier->lock);
+
+	int i;
+	for(i = 0; i < copier->nworkers; ++i)
+	{
+		pthread_join(copier->workers[i], NULL);
+	}
+
+	/* These are directories whose traversal was interrupted, they are left as is
+	 * just like it happens when copying isn't parallel. */
+	while(copier->top != NULL)
+	{
+		dir_t *const dir = copier->top;
+		copier->top = dir->parent;
+		free(dir->src);
+		free(dir->dst);
+		free(dir);
+	}
+
+	if(copier->cancelled)
+	{
+		(void)merge_result(copier, VR_CANCELLED);
+	}
+
+	const VisitResult result = copier->result;
+
+	update_parallel_items(copier);
+
+	pthread_cond_destroy(&copier->done_cv);
+	pthread_cond_destroy(&copier->work_cv);
+	pthread_mutex_destroy(&copier->lock);
+	free(copier);
+
+	return result;
+}
+
+/* Checks whether file can be copied without user interaction and is small
+ * enough for not reporting progress while it's being copied.  Sets *size on
+ * success.  Returns non-zero if so, otherwise zero is returned. */
+static int
+can_copy_in_background(const copier_t *copier, const char src[],
+		const char dst[], uint64_t *size)
+{
+	struct stat st;
+
+	if(copier->args->arg3.crs == IO_CRS_APPEND_TO_FILES)
+	{
+		return 0;
+	}
+
+	if(os_lstat(src, &st) != 0 || !S_ISREG(st.st_mode) ||
+			st.st_size > MAX_FILE_SIZE)
+	{
+		return 0;
+	}
+	*size = st.st_size;
+
+	/* Existing destination might require a confirmation. */
+	struct stat dst_st;
+	return (os_lstat(dst, &dst_st) != 0 && errno == ENOENT);
+}
+
+/* Starts workers if they aren't running yet.  Returns non-zero if there are
+ * workers to process jobs, otherwise zero is returned. */
+static int
+start_workers(copier_t *copier)
+{
+	if(copier->nworkers != 0)
+	{
+		return 1;
+	}
+
+	for(copier->nworkers = 0; copier->nworkers < WORKERS; ++copier->nworkers)
+	{
+		if(pthread_create(&copier->workers[copier->nworkers], NULL, &worker_main,
+					copier) != 0)
+		{
+			break;
+		}
+	}
+
+	return (copier->nworkers != 0);
+}
+
+/* Entry point of worker threads.  Returns NULL. */
+static void *
+worker_main(void *arg)
+{
+	copier_t *const copier = arg;
+
+	block_all_thread_signals();
+
+	pthread_mutex_lock(&copier->lock);
+	while(1)
+	{
+		while(copier->queue == NULL && !copier->stop)
+		{
+			pthread_cond_wait(&copier->work_cv, &copier->lock);
+		}
+		if(copier->queue == NULL)
+		{
+			break;
+		}
+
+		job_t *const job = copier->queue;
+		copier->queue = job->next;
+		if(copier->queue == NULL)
+		{
+			copier->queue_tail = NULL;
+		}
+		const int cancelled = copier->cancelled;
+		pthread_mutex_unlock(&copier->lock);
+
+		job->errors = (ioe_errlst_t)IOE_ERRLST_INIT;
+		job->result = cancelled ? IO_RES_ABORTED
+		                        : copy_in_background(copier, job);
+
+		pthread_mutex_lock(&copier->lock);
+		job->next = copier->done;
+		copier->done = job;
+		pthread_cond_signal(&copier->done_cv);
+	}
+	pthread_mutex_unlock(&copier->lock);
+
+	return NULL;
+}
+
+/* Copies file of the job on a worker thread.  Returns status. */
+static IoRes
+copy_in_background(copier_t *copier, job_t *job)
+{
+	io_args_t args = copier->worker_args;
+	args.arg1.src = job->src;
+	args.arg2.dst = job->dst;
+	args.result.errors = job->errors;
+
+	const IoRes result = iop_cp(&args);
+	job->errors = args.result.errors;
+	return result;
+}
+
+/* Cancellation hook for workers.  Returns non-zero if operation was
+ * cancelled. */
+static int
+is_cancelled(void *arg)
+{
+	copier_t *const copier = arg;
+
+	pthread_mutex_lock(&copier->lock);
+	const int cancelled = copier->cancelled;
+	pthread_mutex_unlock(&copier->lock);
+
+	return cancelled;
+}
+
+/* Propagates cancellation to workers and handles jobs they have finished. */
+static void
+poll_workers(copier_t *copier)
+{
+	const int cancelled = io_cancelled(copier->args);
+
+	pthread_mutex_lock(&copier->lock);
+	copier->cancelled |= cancelled;
+	job_t *jobs = copier->done;
+	copier->done = NULL;
+	pthread_mutex_unlock(&copier->lock);
+
+	/* Restore order in which jobs have finished. */
+	job_t *ordered = NULL;
+	while(jobs != NULL)
+	{
+		job_t *const next = jobs->next;
+		jobs->next = ordered;
+		ordered = jobs;
+		jobs = next;
+	}
+
+	while(ordered != NULL)
+	{
+		job_t *const next = ordered->next;
+		handle_done_job(copier, ordered);
+		ordered = next;
+	}
+}
+
+/* Waits for a job to be done for a limited amount of time. */
+static void
+wait_for_workers(copier_t *copier)
+{
+	struct timespec deadline;
+	compute_deadline(&deadline, WAIT_PERIOD_MS);
+
+	pthread_mutex_lock(&copier->lock);
+	while(copier->done == NULL)
+	{
+		if(pthread_cond_timedwait(&copier->done_cv, &copier->lock,
+					&deadline) == ETIMEDOUT)
+		{
+			break;
+		}
+	}
+	pthread_mutex_unlock(&copier->lock);
+}
+
+/* Accounts for a finished job and frees it. */
+static void
+handle_done_job(copier_t *copier, job_t *job)
+{
+	io_args_t *const args = copier->args;
+
+	--copier->nfiles;
+	copier->nbytes -= job->size;
+	update_parallel_items(copier);
+
+	if(job->result == IO_RES_SUCCEEDED)
+	{
+		ioeta_update(args->estim, job->src, job->dst, 1, job->size);
+		ioe_errlst_free(&job->errors);
+	}
+	else if(copier->cancelled)
+	{
+		ioe_errlst_free(&job->errors);
+		(void)merge_result(copier, VR_CANCELLED);
+	}
+	else if(copier->result != VR_OK)
+	{
+		/* The operation is being stopped, so just keep the errors. */
+		ioe_errlst_splice(&args->result.errors, &job->errors);
+	}
+	else
+	{
+		/* Repeat the copy on this thread for the user to be able to handle errors.
+		 * Worker has removed what it created, so anything at destination appeared
+		 * from elsewhere and is subject to usual conflict resolution. */
+		ioe_errlst_free(&job->errors);
+		(void)merge_result(copier, copier->copy_file(args, job->src, job->dst));
+	}
+
+	unref_dir(copier, job->dir);
+
+	free(job->src);
+	free(job->dst);
+	free(job);
+}
+
+/* Drops a reference to a directory finishing it and its parents if they have
+ * no unfinished contents. */
+static void
+unref_dir(copier_t *copier, dir_t *dir)
+{
+	while(dir != NULL && --dir->refs == 0)
+	{
+		dir_t *const parent = dir->parent;
+
+		(void)merge_result(copier,
+				copier->finish_dir(copier->args, dir->src, dir->dst));
+
+		free(dir->src);
+		free(dir->dst);
+		free(dir);
+
+		dir = parent;
+	}
+}
+
+/* Lets progress reporting know how many files are being copied in
+ * background. */
+static void
+update_parallel_items(copier_t *copier)
+{
+	if(copier->args->estim != NULL)
+	{
+		copier->args->estim->parallel_items = copier->nfiles;
+	}
+}
+
+/* Remembers first unsuccessful result.  Returns the remembered result or
+ * VR_OK. */
+static VisitResult
+merge_result(copier_t *copier, VisitResult result)
+{
+	if(copier->result == VR_OK && result != VR_OK)
+	{
+		copier->result = result;
+	}
+	return copier->result;
+}
+
+/* Computes absolute time which is timeout_ms milliseconds in the future. */
+static void
+compute_deadline(struct timespec *ts, int timeout_ms)
+{
+	clock_gettime(CLOCK_REALTIME, ts);
+
+	ts->tv_sec += timeout_ms/1000;
+	ts->tv_nsec += (long)(timeout_ms%1000)*1000000L;
+	if(ts->tv_nsec >= 1000000000L)
+	{
+		++ts->tv_sec;
+		ts->tv_nsec -= 1000000000L;
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
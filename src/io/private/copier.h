@@ -0,0 +1,69 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__IO__PRIVATE__COPIER_H__
+#define VIFM__IO__PRIVATE__COPIER_H__
+
+#include "../ioc.h"
+#include "traverser.h"
+
+/* copier - copying files of a subtree on several threads */
+
+/* Directories are created by the caller in the order of traversal, while
+ * small files that don't require user interaction are copied by workers.
+ * Everything that might involve the user (overwrite confirmations, error
+ * handling, progress reporting) happens on the calling thread.  A copy that
+ * failed on a worker is redone on the calling thread, so that errors are
+ * reported in a regular way. */
+
+/* Opaque type of a copier. */
+typedef struct copier_t copier_t;
+
+/* Callback that processes a file or a directory on the calling thread.
+ * Returns result of the processing. */
+typedef VisitResult (*copier_func)(io_args_t *args, const char src[],
+		const char dst[]);
+
+/* Creates a copier for an operation described by the args.  copy_file is
+ * used to copy files that can't be processed in background and finish_dir is
+ * called for a directory after all of its contents is copied.  Returns the
+ * copier or NULL if copying in parallel isn't available. */
+copier_t * copier_new(io_args_t *args, copier_func copy_file,
+		copier_func finish_dir);
+
+/* Registers start of a directory, which becomes a parent for files that
+ * follow.  Returns result of earlier operations. */
+VisitResult copier_enter_dir(copier_t *copier, const char src[],
+		const char dst[]);
+
+/* Copies a file in background or right away.  Returns result of this or
+ * earlier operations. */
+VisitResult copier_file(copier_t *copier, const char src[], const char dst[]);
+
+/* Registers end of the innermost directory, which is finished after its last
+ * file is copied.  Returns result of this or earlier operations. */
+VisitResult copier_leave_dir(copier_t *copier);
+
+/* Waits for pending operations and frees the copier.  Returns overall result
+ * of the operations. */
+VisitResult copier_finish(copier_t *copier);
+
+#endif /* VIFM__IO__PRIVATE__COPIER_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
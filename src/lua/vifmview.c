@@ -255,6 +255,7 @@ VLUA_API(cursor_entry)(lua_State *lua)
 {
 	const unsigned int *id = lua_touserdata(lua, lua_upvalueindex(1));
 	view_t *view = find_view(lua, *id);
+	fentry_load_meta(&view->dir_entry[view->list_pos]);
 	vifmentry_new(lua, &view->dir_entry[view->list_pos]);
 	return 1;
 }
@@ -452,6 +453,7 @@ VLUA_API(vifmview_entry)(lua_State *lua)
 		return 1;
 	}
 
+	fentry_load_meta(&view->dir_entry[idx]);
 	vifmentry_new(lua, &view->dir_entry[idx]);
 	return 1;
 }
@@ -48,6 +48,7 @@
 #include "utils/string_array.h"
 #include "utils/utils.h"
 #include "filelist.h"
+#include "flist_cache.h"
 #include "flist_hist.h"
 #include "registers.h"
 #include "search.h"
@@ -124,6 +125,7 @@ static const char * pick_out_decoration(char classify_item[], FileType *type,
 static int validate_decorations(const char prefix[], const char suffix[]);
 static void free_file_decs(file_dec_t *name_decs, int count);
 static void columns_handler(OPT_OP op, optval_t val);
+static void comparecache_handler(OPT_OP op, optval_t val);
 static void confirm_handler(OPT_OP op, optval_t val);
 static void cpoptions_handler(OPT_OP op, optval_t val);
 static void cvoptions_handler(OPT_OP op, optval_t val);
@@ -148,6 +150,7 @@ static void incsearch_handler(OPT_OP op, optval_t val);
 static void iooptions_handler(OPT_OP op, optval_t val);
 static void laststatus_handler(OPT_OP op, optval_t val);
 static void lines_handler(OPT_OP op, optval_t val);
+static void listcache_handler(OPT_OP op, optval_t val);
 static void locateprg_handler(OPT_OP op, optval_t val);
 #ifndef _WIN32
 static void mediaprg_handler(OPT_OP op, optval_t val);
@@ -166,7 +169,9 @@ static void shell_handler(OPT_OP op, optval_t val);
 static void shellcmdflag_handler(OPT_OP op, optval_t val);
 static void shortmess_handler(OPT_OP op, optval_t val);
 static void showtabline_handler(OPT_OP op, optval_t val);
+static void sizecache_handler(OPT_OP op, optval_t val);
 static void sizefmt_handler(OPT_OP op, optval_t val);
+static void sizewatch_handler(OPT_OP op, optval_t val);
 static optval_t make_sizefmt_value(void);
 #ifndef _WIN32
 static void slowfs_handler(OPT_OP op, optval_t val);
@@ -361,6 +366,7 @@ ARRAY_GUARD(suggestoptions_vals, NUM_SUGGESTION_FLAGS);
 static const char *iooptions_vals[][2] = {
 	{ "fastfilecloning", "use COW if FS supports it" },
 	{ "datasync",        "synchronize writes to storage" },
+	{ "sparsefiles",     "preserve holes of sparse files" },
 };
 
 /* Possible flags of 'shortmess' and their count. */
@@ -551,6 +557,7 @@ static const char *vifminfo_set[][2] = {
 	[BIT(VINFO_FHISTORY)]  = { "fhistory",  "local filter history" },
 	[BIT(VINFO_MCHISTORY)] = { "mchistory", "menu cmdline history" },
 	[BIT(VINFO_TABS)]      = { "tabs",      "global or pane tabs" },
+	[BIT(VINFO_CACHES)]    = { "caches",    "directory sizes, fingerprints" },
 };
 ARRAY_GUARD(vifminfo_set, NUM_VINFO);
 
@@ -614,6 +621,10 @@ options[] = {
 	  OPT_INT, 0, NULL, &columns_handler, NULL,
 	  { .ref.int_val = &cfg.columns },
 	},
+	{ "comparecache", "", "cache fingerprints of compared files",
+	  OPT_BOOL, 0, NULL, &comparecache_handler, NULL,
+	  { .ref.bool_val = &cfg.compare_cache },
+	},
 	{ "confirm", "cf", "confirm file operations",
 	  OPT_SET, ARRAY_LEN(confirm_vals), confirm_vals, &confirm_handler, NULL,
 	  { .ref.bool_val = &cfg.confirm },
@@ -712,6 +723,10 @@ options[] = {
 	  OPT_INT, 0, NULL, &lines_handler, NULL,
 	  { .ref.int_val = &cfg.lines },
 	},
+	{ "listcache", "", "memory for cached listings in MiB",
+	  OPT_INT, 0, NULL, &listcache_handler, NULL,
+	  { .ref.int_val = &cfg.list_cache },
+	},
 	{ "locateprg", "", ":locate invocation format",
 	  OPT_STR, 0, NULL, &locateprg_handler, NULL,
 	  { .ref.str_val = &cfg.locate_prg },
@@ -783,10 +798,18 @@ options[] = {
 		&showtabline_handler, NULL,
 	  { .ref.enum_item = &cfg.show_tab_line },
 	},
+	{ "sizecache", "", "number of directory sizes kept on exit",
+	  OPT_INT, 0, NULL, &sizecache_handler, NULL,
+	  { .ref.int_val = &cfg.size_cache },
+	},
 	{ "sizefmt", "", "human-friendly size format",
 	  OPT_STRLIST, ARRAY_LEN(sizefmt_enum), sizefmt_enum, &sizefmt_handler, NULL,
 	  { .init = &init_sizefmt },
 	},
+	{ "sizewatch", "", "update cached directory sizes on changes",
+	  OPT_BOOL, 0, NULL, &sizewatch_handler, NULL,
+	  { .ref.bool_val = &cfg.size_watch },
+	},
 #ifndef _WIN32
 	{ "slowfs", "", "list of slow filesystem types",
 	  OPT_STRLIST, 0, NULL, &slowfs_handler, NULL,
@@ -1312,7 +1335,8 @@ static void
 init_iooptions(optval_t *val)
 {
 	val->set_items = (cfg.fast_file_cloning != 0) << 0
-	               | (cfg.data_sync         != 0) << 1;
+	               | (cfg.data_sync         != 0) << 1
+	               | (cfg.sparse_files      != 0) << 2;
 }
 
 /* Default-initializes whether to display file numbers. */
@@ -2047,6 +2071,14 @@ columns_handler(OPT_OP op, optval_t val)
 	vle_opts_assign("columns", val, OPT_GLOBAL);
 }
 
+/* Handles changes of 'comparecache' option.  The cache is consulted only while
+ * the option is set. */
+static void
+comparecache_handler(OPT_OP op, optval_t val)
+{
+	cfg.compare_cache = val.bool_val;
+}
+
 static void
 confirm_handler(OPT_OP op, optval_t val)
 {
@@ -2338,6 +2370,7 @@ iooptions_handler(OPT_OP op, optval_t val)
 {
 	cfg.fast_file_cloning = ((val.set_items & 1) != 0);
 	cfg.data_sync = ((val.set_items & 2) != 0);
+	cfg.sparse_files = ((val.set_items & 4) != 0);
 }
 
 static void
@@ -2391,6 +2424,24 @@ lines_handler(OPT_OP op, optval_t val)
 	vle_opts_assign("lines", val, OPT_GLOBAL);
 }
 
+/* Limits amount of memory taken up by listings of recently visited
+ * directories. */
+static void
+listcache_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val < 0)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be >= 0: %d", val.int_val);
+		error = 1;
+		val.int_val = 0;
+		vle_opts_assign("listcache", val, OPT_GLOBAL);
+		return;
+	}
+
+	cfg.list_cache = val.int_val;
+	flist_cache_shrink();
+}
+
 /* Handles updates of the 'locateprg' option. */
 static void
 locateprg_handler(OPT_OP op, optval_t val)
@@ -2698,6 +2749,22 @@ showtabline_handler(OPT_OP op, optval_t val)
 	stats_redraw_later();
 }
 
+/* Limits number of directory sizes that are kept in persistent cache. */
+static void
+sizecache_handler(OPT_OP op, optval_t val)
+{
+	if(val.int_val < 0)
+	{
+		vle_tb_append_linef(vle_err, "Argument must be >= 0: %d", val.int_val);
+		error = 1;
+		val.int_val = 0;
+		vle_opts_assign("sizecache", val, OPT_GLOBAL);
+		return;
+	}
+
+	cfg.size_cache = val.int_val;
+}
+
 /* Handles changes of 'sizefmt' option by parsing string value and updating
  * configuration values. */
 static void
@@ -2795,6 +2862,14 @@ make_sizefmt_value(void)
 	return val;
 }
 
+/* Handles changes of 'sizewatch' option.  Watching is started and stopped
+ * lazily by size_watch_check(). */
+static void
+sizewatch_handler(OPT_OP op, optval_t val)
+{
+	cfg.size_watch = val.bool_val;
+}
+
 #ifndef _WIN32
 static void
 slowfs_handler(OPT_OP op, optval_t val)
@@ -3320,6 +3395,7 @@ static void
 sorting_changed(view_t *view, int defer_slow)
 {
 	/* Reset search results, which might be outdated after resorting. */
+	search_cancel(view);
 	view->matches = 0;
 	fview_sorting_updated(view);
 	if(!defer_slow)
@@ -19,10 +19,11 @@
 
 #include "search.h"
 
-#include <regex.h> /* regmatch_t regexec() regfree() */
+#include <regex.h> /* regmatch_t regex_t regfree() */
 
 #include <assert.h> /* assert() */
 #include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() malloc() */
 #include <string.h>
 
 #include "cfg/config.h"
@@ -35,12 +36,43 @@
 #include "utils/path.h"
 #include "utils/regexp.h"
 #include "utils/str.h"
+#include "utils/test_helpers.h"
 #include "utils/utils.h"
 #include "filelist.h"
 #include "flist_sel.h"
 #include "status.h"
 
+/* Time in milliseconds that matching can take before letting user continue
+ * with a partial result. */
+#define SEARCH_BUDGET_MS 30
+
+/* Number of entries matched between checks of the time budget.  Also the
+ * number of entries matched in one direction before switching to the other
+ * one. */
+#define SEARCH_CHUNK 1024
+
+/* State of matching of a view that didn't fit into its time budget.  Entries
+ * in [lo; hi) range are already matched. */
+struct search_state_t
+{
+	regexp_t re;               /* Compiled pattern. */
+	const dir_entry_t *entries; /* List of entries at the start of matching. */
+	int count;                 /* Length of the list at the start of matching. */
+	int lo;                    /* Start of matched range. */
+	int hi;                    /* End of matched range (exclusive). */
+	int forward;               /* Direction of next extension of the range. */
+};
+
 static int find_match(view_t *view, int start, int backward);
+static int match_range(view_t *view, const regexp_t *re, int from, int to,
+		int select_matches);
+static int extend_matched_range(view_t *view);
+static void extend_to(view_t *view, int pos);
+static void finish_matching(view_t *view);
+static int has_pending_matching(view_t *view);
+
+/* Time in milliseconds that a single pass of matching can take. */
+TSTATIC int search_budget_ms = SEARCH_BUDGET_MS;
 
 int
 search_find(view_t *view, const char pattern[], int backward,
@@ -85,7 +117,7 @@ search_next(view_t *view, int backward, int stash_selection, int select_matches,
 		return save_msg;
 	}
 
-	if(view->matches == 0)
+	if(view->matches == 0 && !has_pending_matching(view))
 	{
 		const char *const pattern = hists_search_last();
 		if(search_pattern(view, pattern, stash_selection, select_matches) != 0)
@@ -134,11 +166,14 @@ find_search_match(view_t *view, int backward, int count)
 				i = find_match(view, wrap_start, backward);
 				if(i == -1)
 				{
+					finish_matching(view);
 					return -1;
 				}
 			}
 			else
 			{
+				/* Number of matches should be exact after a failure. */
+				finish_matching(view);
 				return -1;
 			}
 		}
@@ -179,6 +214,11 @@ find_match(view_t *view, int start, int backward)
 
 	for(i = begin; i != end; i += step)
 	{
+		if(has_pending_matching(view))
+		{
+			extend_to(view, i);
+		}
+
 		if(view->dir_entry[i].search_match)
 		{
 			return i;
@@ -194,7 +234,7 @@ search_pattern(view_t *view, const char pattern[], int stash_selection,
 {
 	int cflags;
 	int nmatches = 0;
-	regex_t re;
+	regexp_t re;
 	int err = 0;
 	view_t *other;
 
@@ -215,53 +255,39 @@ search_pattern(view_t *view, const char pattern[], int stash_selection,
 	}
 
 	cflags = get_regexp_cflags(pattern);
-	if((err = regexp_compile(&re, pattern, cflags)) == 0)
+	if((err = regexp_init(&re, pattern, cflags)) != 0)
 	{
-		int i;
-		for(i = 0; i < view->list_rows; ++i)
-		{
-			regmatch_t matches[1];
-			dir_entry_t *const entry = &view->dir_entry[i];
-			const char *name = entry->name;
-			char *free_this = NULL;
-
-			if(is_parent_dir(name))
-			{
-				continue;
-			}
-
-			if(fentry_is_dir(entry))
-			{
-				free_this = format_str("%s/", name);
-				name = free_this;
-			}
-
-			if(regexec(&re, name, 1, matches, 0) != 0)
-			{
-				free(free_this);
-				continue;
-			}
-
-			entry->search_match = nmatches + 1;
-			entry->match_left = matches[0].rm_so;
-			entry->match_left += escape_unreadableo(name, matches[0].rm_so);
-			entry->match_right = matches[0].rm_eo;
-			entry->match_right += escape_unreadableo(name, matches[0].rm_eo);
-			if(select_matches)
-			{
-				entry->selected = 1;
-				++view->selected_files;
-			}
-			++nmatches;
+		regexp_dispose(&re);
+		return err;
+	}
 
-			free(free_this);
-		}
-		regfree(&re);
+	if(select_matches)
+	{
+		/* Selection is expected to be complete right away. */
+		nmatches = match_range(view, &re, 0, view->list_rows, 1);
+		regexp_dispose(&re);
 	}
 	else
 	{
-		regfree(&re);
-		return err;
+		struct search_state_t *const state = malloc(sizeof(*state));
+		if(state == NULL)
+		{
+			regexp_dispose(&re);
+			return 1;
+		}
+
+		/* Start at the cursor and grow the range from there preferring visible
+		 * part of the list, so that the closest matches are found first. */
+		state->re = re;
+		state->entries = view->dir_entry;
+		state->count = view->list_rows;
+		state->lo = MIN(MAX(view->list_pos, 0), view->list_rows);
+		state->hi = state->lo;
+		state->forward = 1;
+		view->search_state = state;
+
+		(void)extend_matched_range(view);
+		nmatches = view->matches;
 	}
 
 	other = (view == &lwin) ? &rwin : &lwin;
@@ -276,6 +302,209 @@ search_pattern(view_t *view, const char pattern[], int stash_selection,
 	return err;
 }
 
+int
+search_continue(view_t *view)
+{
+	if(!has_pending_matching(view))
+	{
+		return 0;
+	}
+
+	(void)extend_matched_range(view);
+	ui_view_schedule_redraw(view);
+	return 1;
+}
+
+void
+search_cancel(view_t *view)
+{
+	struct search_state_t *const state = view->search_state;
+	if(state != NULL)
+	{
+		regexp_dispose(&state->re);
+		free(state);
+		view->search_state = NULL;
+	}
+}
+
+/* Marks entries in [from; to) range of the list that match the expression and
+ * updates number of matches of the view.  Match numbers of the entries aren't
+ * meaningful unless the whole list is matched at once.  Returns number of
+ * found matches. */
+static int
+match_range(view_t *view, const regexp_t *re, int from, int to,
+		int select_matches)
+{
+	int nmatches = 0;
+	int i;
+	for(i = from; i < to; ++i)
+	{
+		regmatch_t matches[1];
+		dir_entry_t *const entry = &view->dir_entry[i];
+		const char *name = entry->name;
+		char *free_this = NULL;
+
+		if(is_parent_dir(name))
+		{
+			continue;
+		}
+
+		if(fentry_is_dir(entry))
+		{
+			free_this = format_str("%s/", name);
+			name = free_this;
+		}
+
+		if(regexp_exec(re, name, 1, matches) != 0)
+		{
+			free(free_this);
+			continue;
+		}
+
+		entry->search_match = view->matches + 1;
+		entry->match_left = matches[0].rm_so;
+		entry->match_left += escape_unreadableo(name, matches[0].rm_so);
+		entry->match_right = matches[0].rm_eo;
+		entry->match_right += escape_unreadableo(name, matches[0].rm_eo);
+		if(select_matches)
+		{
+			entry->selected = 1;
+			++view->selected_files;
+		}
+		++view->matches;
+		++nmatches;
+
+		free(free_this);
+	}
+	return nmatches;
+}
+
+/* Grows range of matched entries in chunks alternating directions and
+ * preferring the visible part of the list.  At least one chunk is matched even
+ * if time budget is exhausted.  Returns non-zero if matching is finished. */
+static int
+extend_matched_range(view_t *view)
+{
+	struct search_state_t *const state = view->search_state;
+	const long long deadline = time_in_ms() + search_budget_ms;
+
+	while(state->lo > 0 || state->hi < view->list_rows)
+	{
+		int forward = state->forward;
+		if(state->hi == view->list_rows)
+		{
+			forward = 0;
+		}
+		else if(state->lo == 0)
+		{
+			forward = 1;
+		}
+		else if(view->top_line + view->window_cells > state->hi)
+		{
+			forward = 1;
+		}
+		else if(view->top_line < state->lo)
+		{
+			forward = 0;
+		}
+
+		if(forward)
+		{
+			const int to = MIN(state->hi + SEARCH_CHUNK, view->list_rows);
+			(void)match_range(view, &state->re, state->hi, to, 0);
+			state->hi = to;
+		}
+		else
+		{
+			const int from = MAX(state->lo - SEARCH_CHUNK, 0);
+			(void)match_range(view, &state->re, from, state->lo, 0);
+			state->lo = from;
+		}
+		state->forward = !forward;
+
+		const int done = (state->lo == 0 && state->hi == view->list_rows);
+		if(!done && time_in_ms() >= deadline)
+		{
+			return 0;
+		}
+	}
+
+	finish_matching(view);
+	return 1;
+}
+
+/* Makes sure that entry at specified position is matched. */
+static void
+extend_to(view_t *view, int pos)
+{
+	struct search_state_t *const state = view->search_state;
+
+	if(pos >= state->hi)
+	{
+		const int to = MIN(MAX(pos + 1, state->hi + SEARCH_CHUNK),
+				view->list_rows);
+		(void)match_range(view, &state->re, state->hi, to, 0);
+		state->hi = to;
+	}
+	else if(pos < state->lo)
+	{
+		const int from = MAX(MIN(pos, state->lo - SEARCH_CHUNK), 0);
+		(void)match_range(view, &state->re, from, state->lo, 0);
+		state->lo = from;
+	}
+
+	if(state->lo == 0 && state->hi == view->list_rows)
+	{
+		finish_matching(view);
+	}
+}
+
+/* Matches the rest of entries, if any, and numbers all the matches from top to
+ * bottom. */
+static void
+finish_matching(view_t *view)
+{
+	struct search_state_t *const state = view->search_state;
+	if(!has_pending_matching(view))
+	{
+		return;
+	}
+
+	(void)match_range(view, &state->re, 0, state->lo, 0);
+	(void)match_range(view, &state->re, state->hi, view->list_rows, 0);
+	search_cancel(view);
+
+	int nmatches = 0;
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		if(view->dir_entry[i].search_match != 0)
+		{
+			view->dir_entry[i].search_match = ++nmatches;
+		}
+	}
+	view->matches = nmatches;
+}
+
+/* Checks whether matching of the view is in progress dropping its state if the
+ * list has changed since matching has started.  Returns non-zero if so. */
+static int
+has_pending_matching(view_t *view)
+{
+	const struct search_state_t *const state = view->search_state;
+	if(state == NULL)
+	{
+		return 0;
+	}
+
+	if(state->entries != view->dir_entry || state->count != view->list_rows)
+	{
+		search_cancel(view);
+		return 0;
+	}
+	return 1;
+}
+
 int
 print_search_result(const view_t *view, int found, int backward,
 		print_search_msg_cb cb)
@@ -313,6 +542,12 @@ print_search_msg(const view_t *view, int backward)
 	{
 		print_search_fail_msg(view, backward);
 	}
+	else if(view->search_state != NULL)
+	{
+		/* Matches aren't numbered until all of them are found. */
+		ui_sb_msgf("%d+ matching files for: %s", view->matches,
+				hists_search_last());
+	}
 	else
 	{
 		ui_sb_msgf("%d of %d matching file%s for: %s",
@@ -326,6 +561,14 @@ print_search_next_msg(const view_t *view, int backward)
 {
 	const int match_number = get_current_entry(view)->search_match;
 	const char search_type = backward ? '?' : '/';
+
+	if(view->search_state != NULL)
+	{
+		ui_sb_msgf("(? of %d+) %c%s", view->matches, search_type,
+				hists_search_last());
+		return;
+	}
+
 	ui_sb_msgf("(%d of %d) %c%s", match_number, view->matches, search_type,
 			hists_search_last());
 }
@@ -375,6 +618,7 @@ void
 reset_search_results(view_t *view)
 {
 	int i;
+	search_cancel(view);
 	for(i = 0; i < view->list_rows; ++i)
 	{
 		view->dir_entry[i].search_match = 0;
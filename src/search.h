@@ -20,6 +20,8 @@
 #ifndef VIFM__SEARCH_H__
 #define VIFM__SEARCH_H__
 
+#include "utils/test_helpers.h"
+
 struct view_t;
 
 /* Search and navigation functions. */
@@ -47,11 +49,21 @@ int search_next(struct view_t *view, int backward, int stash_selection,
 
 /* Searches pattern in view.  Does nothing in case pattern is empty.
  * stash_selection stashes selection before the search.  select_matches selects
- * found matches.  Returns non-zero for invalid pattern, otherwise zero is
- * returned. */
+ * found matches and makes search complete before returning, otherwise matching
+ * that exceeds its time budget starts with the visible part of the list and is
+ * finished by search_continue() or on demand.  Returns non-zero for invalid
+ * pattern, otherwise zero is returned. */
 int search_pattern(struct view_t *view, const char pattern[],
 		int stash_selection, int select_matches);
 
+/* Continues search matching that didn't fit into its time budget.  Returns
+ * non-zero if there was something to do, otherwise zero is returned. */
+int search_continue(struct view_t *view);
+
+/* Stops search matching that is in progress, if any.  Matches found so far
+ * are left intact. */
+void search_cancel(struct view_t *view);
+
 /* Looks for a count's search match in specified direction from current cursor
  * position taking search wrapping into account.  Returns non-zero if something
  * was found, otherwise zero is returned. */
@@ -89,6 +101,10 @@ void reset_search_results(struct view_t *view);
 /* Prints the search messages for the n or N commands. */
 void print_search_next_msg(const struct view_t *view, int backward);
 
+TSTATIC_DEFS(
+	int search_budget_ms;
+)
+
 #endif /* VIFM__SEARCH_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -0,0 +1,672 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "size_watch.h"
+
+#include <sys/stat.h> /* stat */
+
+#include <stddef.h> /* NULL */
+#include <stdint.h> /* uint64_t uintptr_t */
+#include <stdlib.h> /* free() malloc() qsort() */
+#include <string.h> /* strcmp() strdup() */
+#include <time.h> /* time_t time() */
+
+#include "cfg/config.h"
+#include "compat/fs_limits.h"
+#include "compat/os.h"
+#include "compat/pthread.h"
+#include "compat/reallocarray.h"
+#include "ui/ui.h"
+#include "utils/dir_size.h"
+#include "utils/dirwatch.h"
+#include "utils/path.h"
+#include "utils/str.h"
+#include "utils/string_array.h"
+#include "utils/test_helpers.h"
+#include "utils/trie.h"
+#include "background.h"
+#include "filelist.h"
+#include "status.h"
+
+/* Maximum number of directories to watch.  Watches are a limited resource
+ * shared by all applications of a user. */
+enum { MAX_WATCHES = 4096 };
+
+/* Delay in milliseconds of processing directories in which files are being
+ * written to, so that a file that grows doesn't cause reading its directory
+ * too often. */
+enum { MODIFY_DELAY = 1000 };
+
+/* Size of a directory calculated in background. */
+typedef struct
+{
+	char *path;     /* Path to the directory. */
+	uint64_t inode; /* Inode number of the directory. */
+	uint64_t size;  /* Apparent size of the directory. */
+	int changed;    /* Whether the directory was reported as changed, as opposed
+	                   to its subdirectory that wasn't in the cache. */
+}
+new_size_t;
+
+/* Recalculation of sizes of a batch of changed directories.  Sizes are
+ * calculated in background and applied to the cache on the main thread. */
+typedef struct
+{
+	char **paths;      /* Changed directories, deeper ones go first. */
+	int count;         /* Number of elements in paths. */
+	const char *root;  /* Directory whose size is being calculated. */
+	bg_op_t *bg_op;    /* Background operation that performs calculation. */
+
+	pthread_mutex_t lock; /* Protects fields below. */
+	new_size_t *sizes;    /* Calculated sizes in order of calculation. */
+	int nsizes;           /* Number of elements in sizes. */
+	int capacity;         /* Number of allocated elements in sizes. */
+	trie_t *known;        /* Maps paths to indexes in sizes plus one. */
+	int finished;         /* Whether calculation is over. */
+	int abandoned;        /* Whether results won't be applied. */
+}
+update_t;
+
+static void process_changes(void);
+static void start_update(void);
+static void update_bg(bg_op_t *bg_op, void *arg);
+static void calc_dir_size(update_t *update, const char path[]);
+static int get_cached_size(const char path[], time_t mtime, uint64_t inode,
+		uint64_t *size, void *arg);
+static void cache_size(const char path[], uint64_t inode,
+		const dir_size_t *size, void *arg);
+static int is_cancelled(void *arg);
+static void add_size(update_t *update, const char path[], uint64_t inode,
+		uint64_t size, int changed);
+static int apply_update(update_t *update);
+static void abandon_update(update_t *update);
+static void free_update(update_t *update);
+static void schedule_view_update(view_t *view);
+static char * get_root(const view_t *view);
+static int same_roots(char *new_roots[2]);
+static void rebuild(char *new_roots[2]);
+static void watch_subtree(const char root[], int *nwatches);
+static int path_depth(const char path[]);
+static int deeper_first(const void *a, const void *b);
+static int shallower_first(const void *a, const void *b);
+TSTATIC void size_watch_set_modify_delay(int delay);
+
+/* Watcher of directories or NULL. */
+static dirwatch_t *watch;
+/* Resolved paths to directories of views that are being watched (can be
+ * NULL). */
+static char *roots[2];
+/* Generation of the cache at the moment of the last rebuild. */
+static unsigned int watched_gen;
+/* Time of the last rebuild. */
+static time_t rebuild_time;
+/* Recalculation that is in progress or NULL. */
+static update_t *update;
+/* Changed directories that are waiting for recalculation. */
+static char **pending;
+/* Number of elements in pending. */
+static int npending;
+/* Delay of processing written files, can be changed by tests. */
+static int modify_delay = MODIFY_DELAY;
+
+void
+size_watch_check(void)
+{
+	if(!cfg.size_watch)
+	{
+		size_watch_stop();
+		return;
+	}
+
+	if(watch == NULL)
+	{
+		watch = dirwatch_create(modify_delay);
+		if(watch == NULL)
+		{
+			return;
+		}
+		/* Make sure the set of watches gets built. */
+		rebuild_time = 0;
+		watched_gen = dcache_generation() - 1U;
+	}
+
+	process_changes();
+
+	char *new_roots[2] = { get_root(&lwin), get_root(&rwin) };
+
+	/* New sizes appear in the cache in batches, so don't rebuild the set of
+	 * watches more often than once a second unless views were navigated. */
+	if(!same_roots(new_roots) ||
+			(dcache_generation() != watched_gen && time(NULL) != rebuild_time))
+	{
+		rebuild(new_roots);
+		return;
+	}
+
+	free(new_roots[0]);
+	free(new_roots[1]);
+}
+
+void
+size_watch_stop(void)
+{
+	dirwatch_free(watch);
+	watch = NULL;
+
+	if(update != NULL)
+	{
+		abandon_update(update);
+		update = NULL;
+	}
+
+	free_string_array(pending, npending);
+	pending = NULL;
+	npending = 0;
+
+	update_string(&roots[0], NULL);
+	update_string(&roots[1], NULL);
+}
+
+/* Changes delay of processing written files for watchers created after this
+ * call. */
+TSTATIC void
+size_watch_set_modify_delay(int delay)
+{
+	modify_delay = delay;
+}
+
+/* Collects changed directories, applies results of finished recalculation and
+ * starts a new one if there are changes waiting for it. */
+static void
+process_changes(void)
+{
+	char **paths;
+	const int count = dirwatch_poll(watch, &paths);
+	if(npending == 0)
+	{
+		pending = paths;
+		npending = count;
+	}
+	else
+	{
+		int i;
+		for(i = 0; i < count; ++i)
+		{
+			const int len = put_into_string_array(&pending, npending, paths[i]);
+			if(len == npending)
+			{
+				free(paths[i]);
+			}
+			npending = len;
+		}
+		free(paths);
+	}
+
+	if(update != NULL)
+	{
+		pthread_mutex_lock(&update->lock);
+		const int finished = update->finished;
+		pthread_mutex_unlock(&update->lock);
+
+		if(!finished)
+		{
+			return;
+		}
+
+		if(apply_update(update))
+		{
+			schedule_view_update(&lwin);
+			schedule_view_update(&rwin);
+		}
+		free_update(update);
+		update = NULL;
+	}
+
+	if(npending != 0)
+	{
+		start_update();
+	}
+}
+
+/* Starts background recalculation of sizes of pending directories. */
+static void
+start_update(void)
+{
+	update_t *const u = malloc(sizeof(*u));
+	if(u == NULL)
+	{
+		return;
+	}
+
+	/* Subdirectories go first so that their parents are able to use their
+	 * updated sizes.  Directories that changed several times while previous
+	 * update was running end up next to each other. */
+	qsort(pending, npending, sizeof(*pending), &deeper_first);
+
+	int i, j = 0;
+	for(i = 0; i < npending; ++i)
+	{
+		if(j != 0 && strcmp(pending[j - 1], pending[i]) == 0)
+		{
+			free(pending[i]);
+			continue;
+		}
+		pending[j++] = pending[i];
+	}
+
+	u->paths = pending;
+	u->count = j;
+	u->root = NULL;
+	u->bg_op = NULL;
+	pthread_mutex_init(&u->lock, NULL);
+	u->sizes = NULL;
+	u->nsizes = 0;
+	u->capacity = 0;
+	u->known = trie_create(NULL);
+	u->finished = 0;
+	u->abandoned = 0;
+
+	pending = NULL;
+	npending = 0;
+
+	if(u->known == NULL ||
+			bg_execute("Updating sizes", "...", BG_UNDEFINED_TOTAL, 0, &update_bg,
+				u) != 0)
+	{
+		free_update(u);
+		return;
+	}
+
+	update = u;
+}
+
+/* Entry point of a background task that calculates sizes of changed
+ * directories. */
+static void
+update_bg(bg_op_t *bg_op, void *arg)
+{
+	update_t *const u = arg;
+	u->bg_op = bg_op;
+
+	int i;
+	for(i = 0; i < u->count && !is_cancelled(u); ++i)
+	{
+		bg_op_set_descr(bg_op, u->paths[i]);
+		calc_dir_size(u, u->paths[i]);
+	}
+
+	pthread_mutex_lock(&u->lock);
+	u->finished = 1;
+	const int abandoned = u->abandoned;
+	pthread_mutex_unlock(&u->lock);
+
+	if(abandoned)
+	{
+		free_update(u);
+	}
+}
+
+/* Calculates size of a changed directory from its files and cached sizes of
+ * its subdirectories. */
+static void
+calc_dir_size(update_t *update, const char path[])
+{
+	struct stat st;
+	if(os_stat(path, &st) != 0)
+	{
+		/* Removal is handled via parent directory. */
+		return;
+	}
+
+	/* Ignore modification time, because change of the directory is what caused
+	 * this update. */
+	uint64_t old_size;
+	dcache_get_at(path, 0, st.st_ino, &old_size, NULL);
+	if(old_size == DCACHE_UNKNOWN)
+	{
+		return;
+	}
+
+	const dir_size_cbs_t cbs = {
+		.cached = &get_cached_size,
+		.done = &cache_size,
+		.cancelled = &is_cancelled,
+		.arg = update,
+	};
+
+	update->root = path;
+
+	dir_size_t size;
+	if(dir_size_calc(path, &cbs, &size) == 0)
+	{
+		add_size(update, path, st.st_ino, size.size, 1);
+	}
+}
+
+/* Implementation of dir_size_cached callback that queries sizes calculated by
+ * this update and then dcache. */
+static int
+get_cached_size(const char path[], time_t mtime, uint64_t inode,
+		uint64_t *size, void *arg)
+{
+	update_t *const u = arg;
+
+	void *data;
+	pthread_mutex_lock(&u->lock);
+	if(trie_get(u->known, path, &data) == 0)
+	{
+		*size = u->sizes[(uintptr_t)data - 1U].size;
+		pthread_mutex_unlock(&u->lock);
+		return 1;
+	}
+	pthread_mutex_unlock(&u->lock);
+
+	dcache_get_at(path, mtime, inode, size, NULL);
+	return (*size != DCACHE_UNKNOWN);
+}
+
+/* Implementation of dir_size_done callback that records sizes of
+ * subdirectories. */
+static void
+cache_size(const char path[], uint64_t inode, const dir_size_t *size,
+		void *arg)
+{
+	update_t *const u = arg;
+	/* Size of the root is recorded once its calculation is successful. */
+	if(strcmp(path, u->root) != 0)
+	{
+		add_size(u, path, inode, size->size, 0);
+	}
+}
+
+/* Implementation of dir_size_cancelled callback.  Returns non-zero if the
+ * update should stop, otherwise zero is returned. */
+static int
+is_cancelled(void *arg)
+{
+	update_t *const u = arg;
+
+	pthread_mutex_lock(&u->lock);
+	const int abandoned = u->abandoned;
+	pthread_mutex_unlock(&u->lock);
+
+	return (abandoned || bg_op_cancelled(u->bg_op));
+}
+
+/* Records calculated size of a directory. */
+static void
+add_size(update_t *update, const char path[], uint64_t inode, uint64_t size,
+		int changed)
+{
+	char *const path_copy = strdup(path);
+	if(path_copy == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&update->lock);
+
+	if(update->nsizes == update->capacity)
+	{
+		const int capacity = (update->capacity == 0 ? 16 : update->capacity*2);
+		new_size_t *const sizes = reallocarray(update->sizes, capacity,
+				sizeof(*sizes));
+		if(sizes == NULL)
+		{
+			pthread_mutex_unlock(&update->lock);
+			free(path_copy);
+			return;
+		}
+		update->sizes = sizes;
+		update->capacity = capacity;
+	}
+
+	const uintptr_t idx = update->nsizes;
+	if(trie_set(update->known, path, (void *)(idx + 1U)) < 0)
+	{
+		pthread_mutex_unlock(&update->lock);
+		free(path_copy);
+		return;
+	}
+
+	new_size_t *const new_size = &update->sizes[update->nsizes++];
+	new_size->path = path_copy;
+	new_size->inode = inode;
+	new_size->size = size;
+	new_size->changed = changed;
+
+	pthread_mutex_unlock(&update->lock);
+}
+
+/* Puts results of finished recalculation into the cache adjusting sizes of
+ * parents of changed directories by the difference.  Returns non-zero if size
+ * of any changed directory has changed, otherwise zero is returned. */
+static int
+apply_update(update_t *update)
+{
+	int changed = 0;
+	int i;
+	for(i = 0; i < update->nsizes; ++i)
+	{
+		const new_size_t *const new_size = &update->sizes[i];
+		if(!new_size->changed)
+		{
+			/* Watch directories that appeared right away instead of waiting for a
+			 * rebuild, which doesn't happen for updates made here. */
+			(void)dcache_update_at(new_size->path, new_size->inode, new_size->size);
+			if(dirwatch_count(watch) < MAX_WATCHES)
+			{
+				(void)dirwatch_add(watch, new_size->path);
+			}
+			continue;
+		}
+
+		/* Take size at this moment, it could have changed since the calculation
+		 * has started. */
+		uint64_t old_size;
+		dcache_get_at(new_size->path, 0, new_size->inode, &old_size, NULL);
+		if(old_size == DCACHE_UNKNOWN || old_size == new_size->size)
+		{
+			continue;
+		}
+
+		(void)dcache_update_at(new_size->path, new_size->inode, new_size->size);
+		dcache_update_parent_sizes(new_size->path, new_size->size - old_size);
+		changed = 1;
+	}
+	return changed;
+}
+
+/* Makes results of recalculation not needed.  The update is freed either here
+ * or by its background task. */
+static void
+abandon_update(update_t *update)
+{
+	pthread_mutex_lock(&update->lock);
+	const int finished = update->finished;
+	update->abandoned = 1;
+	pthread_mutex_unlock(&update->lock);
+
+	if(finished)
+	{
+		free_update(update);
+	}
+}
+
+/* Frees an update. */
+static void
+free_update(update_t *update)
+{
+	int i;
+	for(i = 0; i < update->nsizes; ++i)
+	{
+		free(update->sizes[i].path);
+	}
+	free(update->sizes);
+	trie_free(update->known);
+	free_string_array(update->paths, update->count);
+	pthread_mutex_destroy(&update->lock);
+	free(update);
+}
+
+/* Makes view display updated sizes. */
+static void
+schedule_view_update(view_t *view)
+{
+	if(ui_view_sort_list_contains(view->sort, SK_BY_SIZE))
+	{
+		ui_view_schedule_reload(view);
+	}
+	else
+	{
+		ui_view_schedule_redraw(view);
+	}
+}
+
+/* Resolves path to the directory displayed by the view.  Returns newly
+ * allocated string or NULL. */
+static char *
+get_root(const view_t *view)
+{
+	char real_path[PATH_MAX + 1];
+	if(os_realpath(flist_get_dir(view), real_path) != real_path)
+	{
+		return NULL;
+	}
+	return strdup(real_path);
+}
+
+/* Checks whether new roots are the same as currently watched ones.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+same_roots(char *new_roots[2])
+{
+	int i;
+	for(i = 0; i < 2; ++i)
+	{
+		if((roots[i] == NULL) != (new_roots[i] == NULL))
+		{
+			return 0;
+		}
+		if(roots[i] != NULL && strcmp(roots[i], new_roots[i]) != 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Replaces watched directories with cached subtrees of new roots keeping
+ * watches that are still needed.  Takes ownership of the roots. */
+static void
+rebuild(char *new_roots[2])
+{
+	free(roots[0]);
+	free(roots[1]);
+	roots[0] = new_roots[0];
+	roots[1] = new_roots[1];
+
+	/* Take generation before listing, so that changes made in between cause
+	 * another rebuild. */
+	watched_gen = dcache_generation();
+	rebuild_time = time(NULL);
+
+	/* Subtree of a root that is inside of the other one is watched already. */
+	const int first_inside = (roots[0] != NULL && roots[1] != NULL)
+	                      && path_starts_with(roots[0], roots[1])
+	                      && strcmp(roots[0], roots[1]) != 0;
+	const int second_inside = (roots[0] != NULL && roots[1] != NULL)
+	                       && path_starts_with(roots[1], roots[0]);
+
+	int nwatches = 0;
+	dirwatch_begin_update(watch);
+	if(roots[0] != NULL && !first_inside)
+	{
+		watch_subtree(roots[0], &nwatches);
+	}
+	if(roots[1] != NULL && !second_inside)
+	{
+		watch_subtree(roots[1], &nwatches);
+	}
+	dirwatch_end_update(watch);
+}
+
+/* Starts watching directories of the subtree that have cached sizes giving
+ * preference to those closer to the root.  *nwatches is the number of watches
+ * added so far. */
+static void
+watch_subtree(const char root[], int *nwatches)
+{
+	int count;
+	char **const dirs = dcache_list_under(root, &count);
+	if(count == 0)
+	{
+		free(dirs);
+		return;
+	}
+
+	qsort(dirs, count, sizeof(*dirs), &shallower_first);
+
+	int i;
+	for(i = 0; i < count && *nwatches < MAX_WATCHES; ++i)
+	{
+		*nwatches += (dirwatch_add(watch, dirs[i]) == 0);
+	}
+
+	free_string_array(dirs, count);
+}
+
+/* Computes depth of a path.  Returns the depth. */
+static int
+path_depth(const char path[])
+{
+	int depth = 0;
+	while(*path != '\0')
+	{
+		depth += (*path++ == '/');
+	}
+	return depth;
+}
+
+/* qsort() comparer that puts deeper paths first.  Returns standard -1, 0, 1
+ * for comparisons. */
+static int
+deeper_first(const void *a, const void *b)
+{
+	return shallower_first(b, a);
+}
+
+/* qsort() comparer that puts shallower paths first, paths of the same depth
+ * are ordered by name.  Returns standard -1, 0, 1 for comparisons. */
+static int
+shallower_first(const void *a, const void *b)
+{
+	const char *const x = *(char *const *)a;
+	const char *const y = *(char *const *)b;
+	const int x_depth = path_depth(x);
+	const int y_depth = path_depth(y);
+	if(x_depth != y_depth)
+	{
+		return (x_depth > y_depth) - (x_depth < y_depth);
+	}
+	const int cmp = strcmp(x, y);
+	return (cmp > 0) - (cmp < 0);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
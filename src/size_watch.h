@@ -0,0 +1,46 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__SIZE_WATCH_H__
+#define VIFM__SIZE_WATCH_H__
+
+#include "utils/test_helpers.h"
+
+/* This unit keeps cached sizes of directories up to date while 'sizewatch' is
+ * set.  Directories displayed in the views and their subdirectories that have
+ * sizes in the cache are watched for changes.  Size of a changed directory is
+ * recalculated in background using cached sizes of its subdirectories (so only
+ * that directory is read) and the difference is propagated to its parents on
+ * the main thread. */
+
+/* Applies results of finished recalculation, starts recalculation for changes
+ * reported since the last call and updates set of watched directories if it's
+ * out of date.  Starts or stops watching according to 'sizewatch'. */
+void size_watch_check(void);
+
+/* Stops watching and frees associated resources. */
+void size_watch_stop(void);
+
+TSTATIC_DEFS(
+	void size_watch_set_modify_delay(int delay);
+)
+
+#endif /* VIFM__SIZE_WATCH_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
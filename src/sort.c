@@ -23,11 +23,14 @@
 
 #include <assert.h> /* assert() */
 #include <ctype.h>
-#include <stdlib.h> /* abs() */
-#include <string.h> /* strcmp() strrchr() */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* abs() free() malloc() */
+#include <string.h> /* memcpy() strcmp() strdup() strrchr() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
+#include "compat/reallocarray.h"
 #include "ui/ui.h"
 #include "utils/dynarray.h"
 #include "utils/fs.h"
@@ -36,8 +39,10 @@
 #include "utils/path.h"
 #include "utils/regexp.h"
 #include "utils/str.h"
+#include "utils/str_pool.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
+#include "utils/trie.h"
 #include "utils/utils.h"
 #include "filelist.h"
 #include "filtering.h"
@@ -79,6 +84,23 @@ const char *sort_enum[] = {
 };
 ARRAY_GUARD(sort_enum, SK_TOTAL);
 
+/* Data of an entry that's computed once per sorting round instead of on every
+ * comparison. */
+typedef struct
+{
+	const char *name;   /* Name or short path compared by default. */
+	const char *folded; /* Lower-cased name, match of a group or NULL. */
+}
+sort_key_t;
+
+/* Pair of numeric key and index of an entry for radix sorting. */
+typedef struct
+{
+	uint64_t key; /* Value to sort by. */
+	int idx;      /* Index of the entry. */
+}
+radix_item_t;
+
 static void sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
 		size_t nchildren, int root);
 static void sort_sequence(dir_entry_t *entries, size_t nentries);
@@ -86,6 +108,23 @@ static void sort_by_groups(dir_entry_t *entries, signed char key,
 		size_t nentries);
 static void sort_by_key(dir_entry_t *entries, size_t nentries, signed char key,
 		void *data);
+static int compile_groups(regex_t **groups);
+static void free_groups(regex_t groups[], int ngroups);
+static void merge_sorted(const dir_entry_t a[], int na, const dir_entry_t b[],
+		int nb, dir_entry_t out[], regex_t groups[], int ngroups);
+static int compare_by_all_keys(const dir_entry_t *a, const dir_entry_t *b,
+		regex_t groups[], int ngroups);
+static int compare_by_key(const dir_entry_t *a, const dir_entry_t *b,
+		signed char key, void *data);
+static int radix_sort(dir_entry_t entries[], size_t nentries);
+static int is_numeric_key(SortingKey key);
+static uint64_t get_numeric_key(const dir_entry_t *entry);
+static int is_parent_entry(const dir_entry_t *entry);
+static str_pool_t * prepare_keys(const dir_entry_t entries[], size_t nentries);
+static int indexed_sort(dir_entry_t entries[], size_t nentries);
+static int compare_indexes(const void *one, const void *two);
+static int reorder_entries(dir_entry_t entries[], size_t nentries,
+		const int order[]);
 static int sort_dir_list(const void *one, const void *two);
 TSTATIC int strnumcmp(const char s[], const char t[]);
 #if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
@@ -95,6 +134,7 @@ static char * skip_leading_zeros(const char str[]);
 #endif
 static int compare_entry_names(const dir_entry_t *a, const dir_entry_t *b,
 		int ignore_case);
+static int compare_name_keys(const sort_key_t *a, const sort_key_t *b);
 static int compare_full_file_names(const char s[], const char t[],
 		int ignore_case);
 static int compare_file_names(const char s[], const char t[], int ignore_case);
@@ -118,6 +158,10 @@ static int sort_descending;
 static SortingKey sort_type;
 /* Sorting key specific data. */
 static void *sort_data;
+/* Precomputed keys indexed by tags of entries or NULL. */
+static sort_key_t *sort_keys;
+/* Entries being sorted by indexed_sort(). */
+static const dir_entry_t *sorted_entries;
 
 void
 sort_view(view_t *v)
@@ -130,6 +174,11 @@ sort_view(view_t *v)
 		return;
 	}
 
+	if(sort_needs_meta(v->sort))
+	{
+		flist_load_meta(v);
+	}
+
 	view = v;
 	view_sort = v->sort;
 	view_sort_groups = v->sort_groups;
@@ -174,6 +223,320 @@ sort_view(view_t *v)
 	}
 }
 
+void
+sort_subtree(view_t *v, int pos)
+{
+	const int count = v->dir_entry[pos].child_count;
+	if(v->sort[0] > SK_LAST || count == 0)
+	{
+		return;
+	}
+
+	if(sort_needs_meta(v->sort))
+	{
+		flist_load_meta(v);
+	}
+
+	dir_entry_t *const unsorted = malloc(sizeof(*unsorted)*count);
+	if(unsorted == NULL)
+	{
+		return;
+	}
+	memcpy(unsorted, &v->dir_entry[pos + 1], sizeof(*unsorted)*count);
+
+	view = v;
+	view_sort = v->sort;
+	view_sort_groups = v->sort_groups;
+	custom_view = 1;
+
+	sort_tree_slice(&v->dir_entry[pos + 1], unsorted, count, 0);
+	free(unsorted);
+}
+
+int
+sort_merge_into_view(view_t *v, dir_entry_t entries[], int nentries)
+{
+	if(nentries == 0)
+	{
+		return 0;
+	}
+
+	const int nrows = v->list_rows + nentries;
+	dir_entry_t *const merged = dynarray_extend(NULL, sizeof(*merged)*nrows);
+	if(merged == NULL)
+	{
+		return 1;
+	}
+
+	view = v;
+	view_sort = v->sort;
+	view_sort_groups = v->sort_groups;
+	custom_view = flist_custom_active(v);
+
+	if(v->sort[0] > SK_LAST)
+	{
+		/* Without sorting new entries just go last. */
+		memcpy(merged, v->dir_entry, sizeof(*merged)*v->list_rows);
+		memcpy(merged + v->list_rows, entries, sizeof(*merged)*nentries);
+	}
+	else
+	{
+		sort_sequence(entries, nentries);
+
+		regex_t *groups = NULL;
+		const int ngroups = compile_groups(&groups);
+		merge_sorted(v->dir_entry, v->list_rows, entries, nentries, merged, groups,
+				ngroups);
+		free_groups(groups, ngroups);
+	}
+
+	dynarray_free(v->dir_entry);
+	v->dir_entry = merged;
+	v->list_rows = nrows;
+	return 0;
+}
+
+int
+sort_view_incrementally(view_t *v, const dir_entry_t prev[], int nprev)
+{
+	const int nentries = v->list_rows;
+	if(v->sort[0] > SK_LAST || nprev == 0 || nentries == 0 ||
+			flist_custom_active(v))
+	{
+		return 1;
+	}
+
+	trie_t *const names = trie_create(/*free_func=*/NULL);
+	int *const slots = malloc(sizeof(*slots)*nprev);
+	dir_entry_t *const kept = malloc(sizeof(*kept)*nentries);
+	dir_entry_t *const rest = malloc(sizeof(*rest)*nentries);
+	if(names == NULL || slots == NULL || kept == NULL || rest == NULL)
+	{
+		trie_free(names);
+		free(slots);
+		free(kept);
+		free(rest);
+		return 1;
+	}
+
+	if(sort_needs_meta(v->sort))
+	{
+		flist_load_meta(v);
+	}
+
+	view = v;
+	view_sort = v->sort;
+	view_sort_groups = v->sort_groups;
+	custom_view = 0;
+
+	regex_t *groups = NULL;
+	const int ngroups = compile_groups(&groups);
+
+	int i;
+	for(i = 0; i < nprev; ++i)
+	{
+		(void)trie_set(names, prev[i].name, &prev[i]);
+		slots[i] = -1;
+	}
+
+	/* Entries are changed if they are new or if their sorting keys have
+	 * different values now.  Unchanged entries stay in previous order. */
+	int nrest = 0;
+	for(i = 0; i < nentries; ++i)
+	{
+		const dir_entry_t *const entry = &v->dir_entry[i];
+
+		void *data;
+		if(trie_get(names, entry->name, &data) == 0)
+		{
+			const dir_entry_t *const old = data;
+			const int idx = old - prev;
+			if(slots[idx] < 0 &&
+					compare_by_all_keys(old, entry, groups, ngroups) == 0)
+			{
+				slots[idx] = i;
+				continue;
+			}
+		}
+
+		rest[nrest++] = *entry;
+	}
+	trie_free(names);
+
+	/* Sorting everything is cheaper when too many entries have to be put in
+	 * place. */
+	int success = (nrest <= MAX(64, nentries/8));
+
+	int nkept = 0;
+	for(i = 0; i < nprev && success; ++i)
+	{
+		if(slots[i] < 0)
+		{
+			continue;
+		}
+
+		/* Previous list could have been sorted differently. */
+		const dir_entry_t *const entry = &v->dir_entry[slots[i]];
+		if(nkept != 0 &&
+				compare_by_all_keys(&kept[nkept - 1], entry, groups, ngroups) > 0)
+		{
+			success = 0;
+			break;
+		}
+		kept[nkept++] = *entry;
+	}
+
+	if(success)
+	{
+		assert(nkept + nrest == nentries && "Entries got lost.");
+		sort_sequence(rest, nrest);
+		merge_sorted(kept, nkept, rest, nrest, v->dir_entry, groups, ngroups);
+	}
+
+	free_groups(groups, ngroups);
+	free(slots);
+	free(kept);
+	free(rest);
+	return !success;
+}
+
+/* Merges two sorted lists of entries into the out array, which should be large
+ * enough to hold both of them.  Entries of the first list go first among equal
+ * ones. */
+static void
+merge_sorted(const dir_entry_t a[], int na, const dir_entry_t b[], int nb,
+		dir_entry_t out[], regex_t groups[], int ngroups)
+{
+	int i = 0, j = 0, k = 0;
+	while(i < na || j < nb)
+	{
+		if(j == nb ||
+				(i < na && compare_by_all_keys(&a[i], &b[j], groups, ngroups) <= 0))
+		{
+			out[k++] = a[i++];
+		}
+		else
+		{
+			out[k++] = b[j++];
+		}
+	}
+}
+
+/* Compiles all sorting groups of the view being sorted if they are used.
+ * Returns number of elements in *groups. */
+static int
+compile_groups(regex_t **groups)
+{
+	if(!ui_view_sort_list_contains(view_sort, SK_BY_GROUPS))
+	{
+		return 0;
+	}
+
+	int ngroups = 0;
+	char *const copy = strdup(view_sort_groups);
+	char *group = copy, *state = NULL;
+	while((group = split_and_get(group, ',', &state)) != NULL)
+	{
+		regex_t *const extended = reallocarray(*groups, ngroups + 1,
+				sizeof(**groups));
+		if(extended == NULL)
+		{
+			break;
+		}
+		*groups = extended;
+
+		(void)regexp_compile(&extended[ngroups++], group,
+				REG_EXTENDED | REG_ICASE);
+	}
+	free(copy);
+
+	return ngroups;
+}
+
+/* Frees groups compiled by compile_groups(). */
+static void
+free_groups(regex_t groups[], int ngroups)
+{
+	int i;
+	for(i = 0; i < ngroups; ++i)
+	{
+		regfree(&groups[i]);
+	}
+	free(groups);
+}
+
+/* Compares two entries by all sorting keys of the view being sorted in the
+ * order of their significance.  Returns standard -1, 0, 1 for comparisons. */
+static int
+compare_by_all_keys(const dir_entry_t *a, const dir_entry_t *b,
+		regex_t groups[], int ngroups)
+{
+	int result;
+
+	if(!ui_view_sort_list_contains(view_sort, SK_BY_DIR))
+	{
+		result = compare_by_key(a, b, SK_BY_DIR, NULL);
+		if(result != 0)
+		{
+			return result;
+		}
+	}
+
+	int i;
+	for(i = 0; i < SK_COUNT; ++i)
+	{
+		const signed char sorting_key = view_sort[i];
+		const int sorting_type = abs(sorting_key);
+
+		if(sorting_type > SK_LAST)
+		{
+			continue;
+		}
+
+		if(sorting_type == SK_BY_GROUPS)
+		{
+			/* First group is the most significant one. */
+			int j;
+			for(j = 0; j < ngroups; ++j)
+			{
+				result = compare_by_key(a, b, sorting_key, &groups[j]);
+				if(result != 0)
+				{
+					return result;
+				}
+			}
+			continue;
+		}
+
+		result = compare_by_key(a, b, sorting_key, NULL);
+		if(result != 0)
+		{
+			return result;
+		}
+	}
+
+	return 0;
+}
+
+/* Compares two entries by a single sorting key.  Returns standard -1, 0, 1 for
+ * comparisons. */
+static int
+compare_by_key(const dir_entry_t *a, const dir_entry_t *b, signed char key,
+		void *data)
+{
+	sort_descending = (key < 0);
+	sort_type = (SortingKey)abs(key);
+	sort_data = data;
+
+	/* Equal tags make ties be reported as such. */
+	dir_entry_t first = *a, second = *b;
+	first.tag = 0;
+	second.tag = 0;
+
+	const int result = sort_dir_list(&first, &second);
+	return (result > 0) - (result < 0);
+}
+
 /* Sorts one level of a tree per invocation, recurring to sort all nested
  * trees. */
 static void
@@ -307,7 +670,324 @@ sort_by_key(dir_entry_t *entries, size_t nentries, signed char key, void *data)
 		entries[i].tag = i;
 	}
 
-	safe_qsort(entries, nentries, sizeof(*entries), &sort_dir_list);
+	if(nentries < 2U || radix_sort(entries, nentries) == 0)
+	{
+		return;
+	}
+
+	str_pool_t *const pool = prepare_keys(entries, nentries);
+	if(indexed_sort(entries, nentries) != 0)
+	{
+		safe_qsort(entries, nentries, sizeof(*entries), &sort_dir_list);
+	}
+
+	free(sort_keys);
+	sort_keys = NULL;
+	str_pool_unref(pool);
+}
+
+/* Sorts entries by a numeric key in a stable way without comparing them.
+ * Returns zero on success and non-zero if the key isn't numeric or on memory
+ * error. */
+static int
+radix_sort(dir_entry_t entries[], size_t nentries)
+{
+	if(!is_numeric_key(sort_type))
+	{
+		return 1;
+	}
+
+	radix_item_t *items = malloc(sizeof(*items)*nentries);
+	radix_item_t *buf = malloc(sizeof(*buf)*nentries);
+	int *order = malloc(sizeof(*order)*nentries);
+	if(items == NULL || buf == NULL || order == NULL)
+	{
+		free(items);
+		free(buf);
+		free(order);
+		return 1;
+	}
+
+	size_t i;
+	for(i = 0U; i < nentries; ++i)
+	{
+		items[i].key = get_numeric_key(&entries[i]);
+		items[i].idx = i;
+		if(sort_descending)
+		{
+			items[i].key = ~items[i].key;
+		}
+	}
+
+	/* Least significant digit first, digits are bytes. */
+	int shift;
+	for(shift = 0; shift < 64; shift += 8)
+	{
+		size_t counts[256] = { 0 };
+		for(i = 0U; i < nentries; ++i)
+		{
+			++counts[(items[i].key >> shift) & 0xff];
+		}
+
+		if(counts[(items[0].key >> shift) & 0xff] == nentries)
+		{
+			/* All keys have the same digit, nothing to reorder. */
+			continue;
+		}
+
+		size_t pos = 0U;
+		int digit;
+		for(digit = 0; digit < 256; ++digit)
+		{
+			const size_t count = counts[digit];
+			counts[digit] = pos;
+			pos += count;
+		}
+
+		for(i = 0U; i < nentries; ++i)
+		{
+			buf[counts[(items[i].key >> shift) & 0xff]++] = items[i];
+		}
+
+		radix_item_t *const tmp = items;
+		items = buf;
+		buf = tmp;
+	}
+
+	/* Parent directory always goes first regardless of the key. */
+	size_t j = 0U;
+	for(i = 0U; i < nentries; ++i)
+	{
+		if(is_parent_entry(&entries[items[i].idx]))
+		{
+			order[j++] = items[i].idx;
+		}
+	}
+	for(i = 0U; i < nentries; ++i)
+	{
+		if(!is_parent_entry(&entries[items[i].idx]))
+		{
+			order[j++] = items[i].idx;
+		}
+	}
+
+	free(items);
+	free(buf);
+
+	const int result = reorder_entries(entries, nentries, order);
+	free(order);
+	return result;
+}
+
+/* Checks whether the key orders entries by an integer.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+is_numeric_key(SortingKey key)
+{
+	switch(key)
+	{
+		case SK_BY_DIR:
+		case SK_BY_SIZE:
+		case SK_BY_NITEMS:
+		case SK_BY_TIME_MODIFIED:
+		case SK_BY_TIME_ACCESSED:
+		case SK_BY_TIME_CHANGED:
+#ifndef _WIN32
+		case SK_BY_MODE:
+		case SK_BY_INODE:
+		case SK_BY_OWNER_NAME:
+		case SK_BY_OWNER_ID:
+		case SK_BY_GROUP_NAME:
+		case SK_BY_GROUP_ID:
+		case SK_BY_NLINKS:
+#endif
+			return 1;
+
+		default:
+			return 0;
+	}
+}
+
+/* Maps value of current sorting key of the entry onto an unsigned integer
+ * preserving order.  Returns the integer. */
+static uint64_t
+get_numeric_key(const dir_entry_t *entry)
+{
+	/* Flipping sign bit turns order of signed values into unsigned one. */
+	const uint64_t sign = (uint64_t)1 << 63;
+
+	switch(sort_type)
+	{
+		case SK_BY_DIR:
+			return !fentry_is_dir(entry);
+		case SK_BY_SIZE:
+			return fentry_get_size(view, entry);
+		case SK_BY_NITEMS:
+			return fentry_is_dir(entry) ? fentry_get_nitems(view, entry) : 0U;
+		case SK_BY_TIME_MODIFIED:
+			return (uint64_t)(int64_t)entry->mtime ^ sign;
+		case SK_BY_TIME_ACCESSED:
+			return (uint64_t)(int64_t)entry->atime ^ sign;
+		case SK_BY_TIME_CHANGED:
+			return (uint64_t)(int64_t)entry->ctime ^ sign;
+#ifndef _WIN32
+		case SK_BY_MODE:
+			return entry->mode;
+		case SK_BY_INODE:
+			return entry->inode;
+		case SK_BY_OWNER_NAME:
+		case SK_BY_OWNER_ID:
+			return entry->uid;
+		case SK_BY_GROUP_NAME:
+		case SK_BY_GROUP_ID:
+			return entry->gid;
+		case SK_BY_NLINKS:
+			return (uint64_t)(int64_t)entry->nlinks ^ sign;
+#endif
+
+		default:
+			assert(0 && "Unhandled numeric sorting key.");
+			return 0U;
+	}
+}
+
+/* Checks whether entry represents parent directory.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+is_parent_entry(const dir_entry_t *entry)
+{
+	return fentry_is_dir(entry) && is_parent_dir(entry->name);
+}
+
+/* Computes data for comparing entries by current sorting key once per entry
+ * and makes sort_keys point to it.  Returns pool that holds strings of the
+ * keys, which is NULL if keys weren't computed. */
+static str_pool_t *
+prepare_keys(const dir_entry_t entries[], size_t nentries)
+{
+	const int by_name = (sort_type == SK_BY_NAME || sort_type == SK_BY_INAME);
+	if(!by_name && sort_type != SK_BY_GROUPS)
+	{
+		return NULL;
+	}
+
+	str_pool_t *const pool = str_pool_new();
+	sort_keys = malloc(sizeof(*sort_keys)*nentries);
+	if(pool == NULL || sort_keys == NULL)
+	{
+		free(sort_keys);
+		sort_keys = NULL;
+		str_pool_unref(pool);
+		return NULL;
+	}
+
+	size_t i;
+	for(i = 0U; i < nentries; ++i)
+	{
+		const dir_entry_t *const entry = &entries[i];
+		sort_key_t *const key = &sort_keys[entry->tag];
+		char buf[PATH_MAX + 1];
+
+		key->name = entry->name;
+		key->folded = NULL;
+
+		if(sort_type == SK_BY_GROUPS)
+		{
+			const regmatch_t match = get_group_match(sort_data, entry->name);
+			copy_str(buf, MIN(NAME_MAX + 1U, (size_t)match.rm_eo - match.rm_so + 1U),
+					entry->name + match.rm_so);
+			key->folded = str_pool_dup(pool, buf);
+		}
+		else
+		{
+			if(custom_view)
+			{
+				get_short_path_of(view, entry, NF_NONE, 0, sizeof(buf), buf);
+				key->name = str_pool_dup(pool, buf);
+			}
+
+			if(sort_type == SK_BY_INAME && key->name != NULL)
+			{
+				/* Ignore too small buffer errors by not caring about part that didn't
+				 * fit like compare_file_names() does. */
+				(void)str_to_lower(key->name, buf, NAME_MAX + 1);
+				key->folded = str_pool_dup(pool, buf);
+				if(key->folded == NULL)
+				{
+					key->name = NULL;
+				}
+			}
+		}
+
+		if(key->name == NULL || (sort_type == SK_BY_GROUPS && key->folded == NULL))
+		{
+			free(sort_keys);
+			sort_keys = NULL;
+			str_pool_unref(pool);
+			return NULL;
+		}
+	}
+
+	return pool;
+}
+
+/* Sorts entries by sorting their indexes and moving each entry only once.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+indexed_sort(dir_entry_t entries[], size_t nentries)
+{
+	int *const order = malloc(sizeof(*order)*nentries);
+	if(order == NULL)
+	{
+		return 1;
+	}
+
+	size_t i;
+	for(i = 0U; i < nentries; ++i)
+	{
+		order[i] = i;
+	}
+
+	sorted_entries = entries;
+	qsort(order, nentries, sizeof(*order), &compare_indexes);
+	sorted_entries = NULL;
+
+	const int result = reorder_entries(entries, nentries, order);
+	free(order);
+	return result;
+}
+
+/* qsort() callback for sorting indexes of entries.  Returns standard -1, 0, 1
+ * for comparisons. */
+static int
+compare_indexes(const void *one, const void *two)
+{
+	const int *const a = one;
+	const int *const b = two;
+	return sort_dir_list(&sorted_entries[*a], &sorted_entries[*b]);
+}
+
+/* Rearranges entries in the specified order.  Returns zero on success,
+ * otherwise non-zero is returned and entries aren't changed. */
+static int
+reorder_entries(dir_entry_t entries[], size_t nentries, const int order[])
+{
+	dir_entry_t *const copy = malloc(sizeof(*copy)*nentries);
+	if(copy == NULL)
+	{
+		return 1;
+	}
+
+	memcpy(copy, entries, sizeof(*copy)*nentries);
+
+	size_t i;
+	for(i = 0U; i < nentries; ++i)
+	{
+		entries[i] = copy[order[i]];
+	}
+
+	free(copy);
+	return 0;
 }
 
 /* Compares file names containing numbers correctly. */
@@ -399,7 +1079,12 @@ sort_dir_list(const void *one, const void *two)
 
 		case SK_BY_NAME:
 		case SK_BY_INAME:
-			if(custom_view)
+			if(sort_keys != NULL)
+			{
+				retval = compare_name_keys(&sort_keys[first->tag],
+						&sort_keys[second->tag]);
+			}
+			else if(custom_view)
 			{
 				retval = compare_entry_names(first, second, sort_type == SK_BY_INAME);
 			}
@@ -464,7 +1149,15 @@ sort_dir_list(const void *one, const void *two)
 			break;
 
 		case SK_BY_GROUPS:
-			retval = compare_group(first->name, second->name, sort_data);
+			if(sort_keys != NULL)
+			{
+				retval = strcmp(sort_keys[first->tag].folded,
+						sort_keys[second->tag].folded);
+			}
+			else
+			{
+				retval = compare_group(first->name, second->name, sort_data);
+			}
 			break;
 
 		case SK_BY_TARGET:
@@ -618,6 +1311,33 @@ compare_entry_names(const dir_entry_t *a, const dir_entry_t *b, int ignore_case)
 	return compare_full_file_names(a_short_path, b_short_path, ignore_case);
 }
 
+/* Compares precomputed keys of two entries in the same way as
+ * compare_full_file_names() compares names.  Returns positive value if a is
+ * greater than b, zero if they are equal, otherwise negative value is
+ * returned. */
+static int
+compare_name_keys(const sort_key_t *a, const sort_key_t *b)
+{
+	if(a->name[0] == '.' && b->name[0] != '.')
+	{
+		return -1;
+	}
+	if(a->name[0] != '.' && b->name[0] == '.')
+	{
+		return 1;
+	}
+
+	const char *const s = (a->folded == NULL ? a->name : a->folded);
+	const char *const t = (b->folded == NULL ? b->name : b->folded);
+	const int result = cfg.sort_numbers ? strnumcmp(s, t) : strcmp(s, t);
+	if(result == 0 && a->folded != NULL)
+	{
+		/* Resolve ties of normalized names by comparing original ones. */
+		return strcmp(a->name, b->name);
+	}
+	return result;
+}
+
 /* Compares two full filenames and assumes that dot character is smaller than
  * any other character.  Returns positive value if s is greater than t, zero if
  * they are equal, otherwise negative value is returned. */
@@ -670,6 +1390,35 @@ compare_file_names(const char s[], const char t[], int ignore_case)
 	return result;
 }
 
+int
+sort_needs_meta(const signed char sort[SK_COUNT])
+{
+	int i;
+	for(i = 0; i < SK_COUNT; ++i)
+	{
+		const int sort_key = abs(sort[i]);
+		if(sort_key > SK_LAST)
+		{
+			break;
+		}
+
+		switch(sort_key)
+		{
+			case SK_BY_NAME:
+			case SK_BY_INAME:
+			case SK_BY_EXTENSION:
+			case SK_BY_FILEEXT:
+			case SK_BY_DIR:
+			case SK_BY_GROUPS:
+				break;
+
+			default:
+				return 1;
+		}
+	}
+	return 0;
+}
+
 SortingKey
 get_secondary_key(SortingKey primary_key)
 {
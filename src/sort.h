@@ -29,9 +29,28 @@ extern const char *sort_enum[SK_TOTAL];
 /* Sorts entries of the view according to its sorting configuration. */
 void sort_view(view_t *view);
 
+/* Sorts children of a node of a tree view at specified position leaving the
+ * rest of the list as is. */
+void sort_subtree(view_t *view, int pos);
+
 /* Sorts specified entries using global settings of the view. */
 void sort_entries(view_t *view, entries_t entries);
 
+/* Merges entries into already sorted list of the view keeping it sorted.  The
+ * entries are moved into the list.  Returns zero on success, otherwise non-zero
+ * is returned and both the list and the entries are left intact. */
+int sort_merge_into_view(view_t *view, dir_entry_t entries[], int nentries);
+
+/* Sorts freshly read list of the view by keeping order of entries from its
+ * previous sorted list whose sorting keys didn't change and merging new or
+ * changed entries in.  Returns zero on success, otherwise non-zero is returned
+ * and the list should be sorted as usual. */
+int sort_view_incrementally(view_t *view, const dir_entry_t prev[], int nprev);
+
+/* Checks whether sorting by specified keys needs more meta-data than names and
+ * types of files.  Returns non-zero if so, otherwise zero is returned. */
+int sort_needs_meta(const signed char sort[SK_COUNT]);
+
 /* Maps primary sort key to second column type.  Returns secondary key that
  * corresponds to the primary one. */
 SortingKey get_secondary_key(SortingKey primary_key);
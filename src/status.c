@@ -24,11 +24,14 @@
 #include <assert.h> /* assert() */
 #include <limits.h> /* INT_MIN */
 #include <stddef.h> /* NULL */
-#include <string.h> /* memcpy() memmove() */
+#include <stdio.h> /* remove() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memcpy() memmove() strlen() strrchr() */
 #include <time.h> /* time_t time() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
+#include "compat/os.h"
 #include "compat/pthread.h"
 #include "compat/reallocarray.h"
 #include "lua/vlua.h"
@@ -42,9 +45,11 @@
 #include "utils/macros.h"
 #include "utils/mem.h"
 #include "utils/path.h"
+#include "utils/path_store.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
+#include "utils/trie.h"
 #include "utils/utils.h"
 #include "cmd_completion.h"
 #include "cmd_core.h"
@@ -70,6 +75,24 @@ typedef struct
 }
 dcache_data_t;
 
+/* List of entries of dcache that are being collected for storing. */
+typedef struct
+{
+	char **paths;           /* Paths of entries. */
+	path_store_rec_t *recs; /* Data of entries. */
+	int count;              /* Number of entries. */
+	int capacity;           /* Number of allocated entries. */
+	trie_t *seen;           /* Set of collected paths. */
+
+	const char *base;       /* Path of parent of root nodes or NULL. */
+
+	/* Stack of paths of parents of currently traversed node. */
+	const void **stack_data; /* Data pointers of nodes on the stack. */
+	char **stack_paths;      /* Paths of nodes on the stack. */
+	int depth;               /* Number of nodes on the stack. */
+}
+dcache_dump_t;
+
 /* Saved view selection. */
 typedef struct
 {
@@ -87,6 +110,17 @@ static void set_last_cmdline_command(const char cmd[]);
 static void dcache_get(const char path[], time_t mtime, uint64_t inode,
 		dcache_result_t *size, dcache_result_t *nitems);
 static void size_updater(void *data, void *arg);
+static int dcache_may_be_stored(const char path[]);
+static int dcache_get_stored(const char path[], const char real_path[],
+		dcache_data_t *data);
+static void dcache_promote_parents(const char real_path[]);
+static int dcache_dump_node(const char name[], int valid,
+		const void *parent_data, void *data, void *arg);
+static int dcache_dump_add(dcache_dump_t *dump, char path[],
+		const path_store_rec_t *rec);
+static void dcache_dump_free(dcache_dump_t *dump);
+static int dcache_set_size(const char path[], uint64_t inode, uint64_t size,
+		time_t ts, int new_gen);
 TSTATIC time_t dcache_get_size_timestamp(const char path[]);
 TSTATIC void dcache_set_size_timestamp(const char path[], time_t ts);
 
@@ -108,6 +142,15 @@ static pthread_mutex_t dcache_nitems_mutex = PTHREAD_MUTEX_INITIALIZER;
 static fsdata_t *dcache_size;
 /* Cache for directory item count. */
 static fsdata_t *dcache_nitems;
+/* Sizes of directories from previous runs or NULL.  Guarded by
+ * dcache_size_mutex. */
+static path_store_t *dcache_stored;
+/* Paths that were looked up in dcache_stored and weren't found there or NULL.
+ * Guarded by dcache_size_mutex. */
+static trie_t *dcache_not_stored;
+/* Incremented on every change of the set of cached sizes.  Guarded by
+ * dcache_size_mutex. */
+static unsigned int dcache_size_gen;
 
 /* Whether UI updates should be "paused" (a counter, not a flag). */
 static int silent_ui;
@@ -273,6 +316,7 @@ reset_dircache(void)
 {
 	fsdata_free(dcache_size);
 	dcache_size = fsdata_create(0, 1);
+	++dcache_size_gen;
 
 	fsdata_free(dcache_nitems);
 	dcache_nitems = fsdata_create(0, 1);
@@ -623,7 +667,25 @@ dcache_get(const char path[], time_t mtime, uint64_t inode,
 
 		pthread_mutex_lock(&dcache_size_mutex);
 		dcache_data_t size_data;
-		if(fsdata_get(dcache_size, path, &size_data, sizeof(size_data)) == 0)
+		int found =
+			(fsdata_get(dcache_size, path, &size_data, sizeof(size_data)) == 0);
+		if(!found && dcache_may_be_stored(path))
+		{
+			/* Resolving a path can take a while, don't block other threads. */
+			pthread_mutex_unlock(&dcache_size_mutex);
+			char real_path[PATH_MAX + 1];
+			const int resolved = (os_realpath(path, real_path) == real_path);
+			pthread_mutex_lock(&dcache_size_mutex);
+
+			/* The size could have been set while the lock was released. */
+			found =
+				(fsdata_get(dcache_size, path, &size_data, sizeof(size_data)) == 0);
+			if(!found && resolved)
+			{
+				found = (dcache_get_stored(path, real_path, &size_data) == 0);
+			}
+		}
+		if(found)
 		{
 			size->value = size_data.value;
 			/* We check strictly for less than to handle scenario when multiple
@@ -657,14 +719,340 @@ dcache_get(const char path[], time_t mtime, uint64_t inode,
 	}
 }
 
+/* Checks whether looking up the path in persistent cache makes sense.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+dcache_may_be_stored(const char path[])
+{
+	void *data;
+	return dcache_stored != NULL
+	    && trie_get(dcache_not_stored, path, &data) != 0;
+}
+
+/* Looks up size of a directory in persistent cache copying found entry into the
+ * in-memory one so that it's updated and stored along with the rest.  The path
+ * is also looked up with symbolic links resolved (real_path), as in-memory
+ * cache resolves them and so do paths that it stores.  Misses are remembered to
+ * not resolve the path again.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+dcache_get_stored(const char path[], const char real_path[],
+		dcache_data_t *data)
+{
+	if(!dcache_may_be_stored(path))
+	{
+		return 1;
+	}
+
+	path_store_rec_t rec;
+	if(path_store_get(dcache_stored, real_path, &rec) != 0)
+	{
+		if(dcache_not_stored != NULL)
+		{
+			(void)trie_put(dcache_not_stored, path);
+		}
+		return 1;
+	}
+
+	data->value = rec.value;
+	data->timestamp = rec.timestamp;
+#ifndef _WIN32
+	data->inode = (ino_t)rec.inode;
+#endif
+	(void)fsdata_set(dcache_size, path, data, sizeof(*data));
+	return 0;
+}
+
 void
 dcache_update_parent_sizes(const char path[], uint64_t by)
 {
+	/* Path itself might not exist anymore, but its parent should. */
+	char parent[PATH_MAX + 1];
+	copy_str(parent, sizeof(parent), path);
+	remove_last_path_component(parent);
+	char real_path[PATH_MAX + 1];
+	const int resolved = (os_realpath(parent, real_path) == real_path);
+
 	pthread_mutex_lock(&dcache_size_mutex);
+	if(resolved)
+	{
+		dcache_promote_parents(real_path);
+	}
 	(void)fsdata_map_parents(dcache_size, path, &size_updater, &by);
 	pthread_mutex_unlock(&dcache_size_mutex);
 }
 
+/* Makes sure that sizes of the directory and its parents that are known only
+ * from persistent cache are in the in-memory cache.  The path must have
+ * symbolic links resolved. */
+static void
+dcache_promote_parents(const char real_path[])
+{
+	char parent[PATH_MAX + 1];
+	copy_str(parent, sizeof(parent), real_path);
+	while(dcache_stored != NULL && parent[0] != '\0')
+	{
+		dcache_data_t data;
+		if(fsdata_get(dcache_size, parent, &data, sizeof(data)) != 0)
+		{
+			(void)dcache_get_stored(parent, parent, &data);
+		}
+
+		if(is_root_dir(parent))
+		{
+			break;
+		}
+		remove_last_path_component(parent);
+	}
+}
+
+int
+dcache_load(const char path[])
+{
+	path_store_t *const stored = path_store_open(path);
+	trie_t *const not_stored = (stored == NULL ? NULL : trie_create(NULL));
+
+	pthread_mutex_lock(&dcache_size_mutex);
+	path_store_close(dcache_stored);
+	dcache_stored = stored;
+	trie_free(dcache_not_stored);
+	dcache_not_stored = not_stored;
+	pthread_mutex_unlock(&dcache_size_mutex);
+
+	return (stored == NULL);
+}
+
+int
+dcache_store(const char path[], int max_entries)
+{
+	if(max_entries <= 0)
+	{
+		return 0;
+	}
+
+	dcache_dump_t dump = { .seen = trie_create(NULL) };
+	if(dump.seen == NULL)
+	{
+		return 1;
+	}
+
+	pthread_mutex_lock(&dcache_size_mutex);
+	int error = fsdata_traverse(dcache_size, &dcache_dump_node, &dump);
+	pthread_mutex_unlock(&dcache_size_mutex);
+
+	/* Merge with the current version of the file to keep what other instances
+	 * might have stored since it was loaded. */
+	path_store_t *const current = path_store_open(path);
+	int i;
+	for(i = 0; i < path_store_count(current) && !error; ++i)
+	{
+		path_store_rec_t rec;
+		const char *const stored_path = path_store_at(current, i, &rec);
+		if(trie_put(dump.seen, stored_path) == 0)
+		{
+			char *const copy = strdup(stored_path);
+			error = (copy == NULL || dcache_dump_add(&dump, copy, &rec) != 0);
+		}
+	}
+	path_store_close(current);
+
+	/* Don't create empty file. */
+	if(!error && dump.count != 0)
+	{
+		error = path_store_write(path, (const char **)dump.paths, dump.recs,
+				dump.count, max_entries);
+	}
+
+	dcache_dump_free(&dump);
+	return error;
+}
+
+void
+dcache_drop(const char path[])
+{
+	pthread_mutex_lock(&dcache_size_mutex);
+	path_store_close(dcache_stored);
+	dcache_stored = NULL;
+	trie_free(dcache_not_stored);
+	dcache_not_stored = NULL;
+	fsdata_free(dcache_size);
+	dcache_size = fsdata_create(0, 1);
+	++dcache_size_gen;
+	pthread_mutex_unlock(&dcache_size_mutex);
+
+	pthread_mutex_lock(&dcache_nitems_mutex);
+	fsdata_free(dcache_nitems);
+	dcache_nitems = fsdata_create(0, 1);
+	pthread_mutex_unlock(&dcache_nitems_mutex);
+
+	(void)remove(path);
+}
+
+char **
+dcache_list_under(const char path[], int *count)
+{
+	/* Paths of nodes are built starting with the parent of the subtree. */
+	char base[PATH_MAX + 1];
+	copy_str(base, sizeof(base), path);
+	char *const slash = strrchr(base, '/');
+	if(slash != NULL)
+	{
+		*slash = '\0';
+	}
+
+	dcache_dump_t dump = {
+		.seen = trie_create(NULL),
+		.base = (slash == NULL ? NULL : base),
+	};
+	if(dump.seen == NULL)
+	{
+		*count = 0;
+		return NULL;
+	}
+
+	pthread_mutex_lock(&dcache_size_mutex);
+	(void)fsdata_traverse_under(dcache_size, path, &dcache_dump_node, &dump);
+	pthread_mutex_unlock(&dcache_size_mutex);
+
+	char **const paths = dump.paths;
+	*count = dump.count;
+
+	dump.paths = NULL;
+	dump.count = 0;
+	dcache_dump_free(&dump);
+
+	return paths;
+}
+
+unsigned int
+dcache_generation(void)
+{
+	pthread_mutex_lock(&dcache_size_mutex);
+	const unsigned int gen = dcache_size_gen;
+	pthread_mutex_unlock(&dcache_size_mutex);
+	return gen;
+}
+
+/* fsdata_traverse() callback that collects valid entries into dcache_dump_t
+ * building their paths along the way.  Returns non-zero on error. */
+static int
+dcache_dump_node(const char name[], int valid, const void *parent_data,
+		void *data, void *arg)
+{
+	dcache_dump_t *const dump = arg;
+
+	/* Traversal is depth-first, so parent of the node is on the stack. */
+	while(dump->depth > 0 &&
+			(parent_data == NULL || dump->stack_data[dump->depth - 1] != parent_data))
+	{
+		free(dump->stack_paths[--dump->depth]);
+	}
+
+	const char *const parent_path = (dump->depth != 0)
+	                              ? dump->stack_paths[dump->depth - 1]
+	                              : (dump->base == NULL ? "" : dump->base);
+#ifndef _WIN32
+	char *const path = format_str("%s/%s", parent_path, name);
+#else
+	char *const path = (dump->depth == 0 && dump->base == NULL)
+	                 ? strdup(name)
+	                 : format_str("%s/%s", parent_path, name);
+#endif
+	if(path == NULL)
+	{
+		return 1;
+	}
+
+	void *ptr = reallocarray(dump->stack_data, dump->depth + 1,
+			sizeof(*dump->stack_data));
+	if(ptr == NULL)
+	{
+		free(path);
+		return 1;
+	}
+	dump->stack_data = ptr;
+	ptr = reallocarray(dump->stack_paths, dump->depth + 1,
+			sizeof(*dump->stack_paths));
+	if(ptr == NULL)
+	{
+		free(path);
+		return 1;
+	}
+	dump->stack_paths = ptr;
+
+	dump->stack_data[dump->depth] = data;
+	dump->stack_paths[dump->depth] = path;
+	++dump->depth;
+
+	if(!valid)
+	{
+		return 0;
+	}
+
+	const dcache_data_t *const dcache_data = data;
+	path_store_rec_t rec = {
+		.value = dcache_data->value,
+		.timestamp = dcache_data->timestamp,
+	};
+#ifndef _WIN32
+	rec.inode = dcache_data->inode;
+#endif
+
+	char *const copy = strdup(path);
+	if(copy == NULL || trie_put(dump->seen, copy) < 0)
+	{
+		free(copy);
+		return 1;
+	}
+	return dcache_dump_add(dump, copy, &rec);
+}
+
+/* Appends an entry to the dump taking ownership of the path.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+dcache_dump_add(dcache_dump_t *dump, char path[], const path_store_rec_t *rec)
+{
+	if(dump->count == dump->capacity)
+	{
+		const int capacity = (dump->capacity == 0 ? 256 : dump->capacity*2);
+		char **const paths = reallocarray(dump->paths, capacity,
+				sizeof(*paths));
+		if(paths == NULL)
+		{
+			free(path);
+			return 1;
+		}
+		dump->paths = paths;
+
+		path_store_rec_t *const recs = reallocarray(dump->recs, capacity,
+				sizeof(*recs));
+		if(recs == NULL)
+		{
+			free(path);
+			return 1;
+		}
+		dump->recs = recs;
+
+		dump->capacity = capacity;
+	}
+
+	dump->paths[dump->count] = path;
+	dump->recs[dump->count] = *rec;
+	++dump->count;
+	return 0;
+}
+
+/* Frees resources of a dump. */
+static void
+dcache_dump_free(dcache_dump_t *dump)
+{
+	free_string_array(dump->paths, dump->count);
+	free(dump->recs);
+	free_string_array(dump->stack_paths, dump->depth);
+	free(dump->stack_data);
+	trie_free(dump->seen);
+}
+
 /* Updates cached value by a fixed amount. */
 static void
 size_updater(void *data, void *arg)
@@ -683,14 +1071,7 @@ dcache_set_at(const char path[], uint64_t inode, uint64_t size, uint64_t nitems)
 
 	if(size != DCACHE_UNKNOWN)
 	{
-		dcache_data_t data = { .value = size, .timestamp = ts };
-#ifndef _WIN32
-		data.inode = (ino_t)inode;
-#endif
-
-		pthread_mutex_lock(&dcache_size_mutex);
-		ret |= fsdata_set(dcache_size, path, &data, sizeof(data));
-		pthread_mutex_unlock(&dcache_size_mutex);
+		ret |= dcache_set_size(path, inode, size, ts, 1);
 	}
 
 	if(nitems != DCACHE_UNKNOWN)
@@ -708,6 +1089,31 @@ dcache_set_at(const char path[], uint64_t inode, uint64_t size, uint64_t nitems)
 	return ret;
 }
 
+int
+dcache_update_at(const char path[], uint64_t inode, uint64_t size)
+{
+	return dcache_set_size(path, inode, size, time(NULL), 0);
+}
+
+/* Stores size of a directory optionally changing generation of the cache.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+dcache_set_size(const char path[], uint64_t inode, uint64_t size, time_t ts,
+		int new_gen)
+{
+	dcache_data_t data = { .value = size, .timestamp = ts };
+#ifndef _WIN32
+	data.inode = (ino_t)inode;
+#endif
+
+	pthread_mutex_lock(&dcache_size_mutex);
+	const int ret = fsdata_set(dcache_size, path, &data, sizeof(data));
+	dcache_size_gen += (new_gen != 0);
+	pthread_mutex_unlock(&dcache_size_mutex);
+
+	return ret;
+}
+
 TSTATIC time_t
 dcache_get_size_timestamp(const char path[])
 {
@@ -350,6 +350,33 @@ void dcache_update_parent_sizes(const char path[], uint64_t by);
 int dcache_set_at(const char path[], uint64_t inode, uint64_t size,
 		uint64_t nitems);
 
+/* Same as dcache_set_at() for size only, but doesn't change generation of the
+ * cache, which is meant for updates made by the one who tracks the generation.
+ * Returns zero on success, otherwise non-zero is returned. */
+int dcache_update_at(const char path[], uint64_t inode, uint64_t size);
+
+/* Replaces persistent part of the cache with contents of the file.  Returns
+ * zero on success, otherwise non-zero is returned. */
+int dcache_load(const char path[]);
+
+/* Stores known sizes of directories into the file merging them with its current
+ * contents and dropping the oldest entries above the limit.  Zero limit
+ * disables storing.  Returns zero on success, otherwise non-zero is
+ * returned. */
+int dcache_store(const char path[], int max_entries);
+
+/* Forgets all cached information and removes the file. */
+void dcache_drop(const char path[]);
+
+/* Lists directories of the subtree at the path (including the path itself)
+ * whose sizes are in the in-memory cache.  The path should be resolved.
+ * Returns the list, *count is set to its length. */
+char ** dcache_list_under(const char path[], int *count);
+
+/* Retrieves number that changes whenever set of cached sizes changes.  Returns
+ * the number. */
+unsigned int dcache_generation(void);
+
 /* Selection history. */
 
 /* Adds/updates saved selection of files for a particular directory.  Takes
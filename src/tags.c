@@ -51,6 +51,7 @@ const char *tags[] = {
 	"vifm-'classify'",
 	"vifm-'co'",
 	"vifm-'columns'",
+	"vifm-'comparecache'",
 	"vifm-'confirm'",
 	"vifm-'cpo'",
 	"vifm-'cpoptions'",
@@ -82,6 +83,7 @@ const char *tags[] = {
 	"vifm-'is'",
 	"vifm-'laststatus'",
 	"vifm-'lines'",
+	"vifm-'listcache'",
 	"vifm-'locateprg'",
 	"vifm-'ls'",
 	"vifm-'lsoptions'",
@@ -116,7 +118,9 @@ const char *tags[] = {
 	"vifm-'shm'",
 	"vifm-'shortmess'",
 	"vifm-'showtabline'",
+	"vifm-'sizecache'",
 	"vifm-'sizefmt'",
+	"vifm-'sizewatch'",
 	"vifm-'slowfs'",
 	"vifm-'smartcase'",
 	"vifm-'so'",
@@ -236,6 +240,7 @@ const char *tags[] = {
 	"vifm-:cunabbrev",
 	"vifm-:cunmap",
 	"vifm-:d",
+	"vifm-:dcache",
 	"vifm-:delbmarks",
 	"vifm-:delc",
 	"vifm-:delcommand",
@@ -613,6 +618,7 @@ const char *tags[] = {
 	"vifm-custom-views",
 	"vifm-cw",
 	"vifm-d",
+	"vifm-dcache",
 	"vifm-dd",
 	"vifm-do",
 	"vifm-dp",
@@ -79,7 +79,13 @@ get_type_from_mode(mode_t mode)
 FileType
 type_from_dir_entry(const struct dirent *d, const char path[])
 {
-	switch(get_dirent_type(d, path))
+	return type_from_dtype(get_dirent_type(d, path));
+}
+
+FileType
+type_from_dtype(unsigned char dtype)
+{
+	switch(dtype)
 	{
 		case DT_LNK:  return FT_LINK;
 		case DT_DIR:  return FT_DIR;
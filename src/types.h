@@ -57,6 +57,10 @@ FileType get_type_from_mode(mode_t mode);
  * enumeration.  Returns item of the enumeration. */
 FileType type_from_dir_entry(const struct dirent *d, const char path[]);
 
+/* Converts DT_* value of dirent::d_type field to type from FileType
+ * enumeration.  Returns item of the enumeration. */
+FileType type_from_dtype(unsigned char dtype);
+
 #endif
 
 #endif /* VIFM__TYPES_H__ */
@@ -41,6 +41,7 @@
 #include "../utils/fsddata.h"
 #include "../utils/macros.h"
 #include "../utils/matchers.h"
+#include "../utils/rule_index.h"
 #include "../utils/str.h"
 #include "../utils/string_array.h"
 #include "../utils/utils.h"
@@ -532,6 +533,7 @@ static void restore_primary_cs(const col_scheme_t *cs);
 static void reset_to_default_cs(col_scheme_t *cs);
 static void free_cs_highlights(col_scheme_t *cs);
 static file_hi_t * clone_file_highlights(const col_scheme_t *from);
+static void build_file_hi_index(col_scheme_t *cs);
 static col_attr_t * clone_column_highlights(const col_scheme_t *from);
 static void reset_cs_colors(col_scheme_t *cs);
 static int source_cs(const char name[]);
@@ -938,6 +940,8 @@ cs_assign(col_scheme_t *to, const col_scheme_t *from)
 	*to = *from;
 	to->file_hi = clone_file_highlights(from);
 	to->column_hi = clone_column_highlights(from);
+	to->file_hi_index = NULL;
+	build_file_hi_index(to);
 }
 
 /* Resets color scheme to default builtin values. */
@@ -967,6 +971,9 @@ free_cs_highlights(col_scheme_t *cs)
 	cs->file_hi = NULL;
 	cs->file_hi_count = 0;
 
+	rule_index_free(cs->file_hi_index);
+	cs->file_hi_index = NULL;
+
 	free(cs->column_hi);
 	cs->column_hi = NULL;
 	cs->column_hi_count = 0;
@@ -991,6 +998,25 @@ clone_file_highlights(const col_scheme_t *from)
 	return file_hi;
 }
 
+/* (Re)builds index of filename specific highlights.  The index stays NULL on
+ * failure, which means falling back to checking every highlight. */
+static void
+build_file_hi_index(col_scheme_t *cs)
+{
+	rule_index_free(cs->file_hi_index);
+	cs->file_hi_index = rule_index_alloc();
+
+	int i;
+	for(i = 0; i < cs->file_hi_count && cs->file_hi_index != NULL; ++i)
+	{
+		if(rule_index_add(cs->file_hi_index, cs->file_hi[i].matchers) != 0)
+		{
+			rule_index_free(cs->file_hi_index);
+			cs->file_hi_index = NULL;
+		}
+	}
+}
+
 /* Clones column highlight array of the *from color scheme and returns it. */
 static col_attr_t *
 clone_column_highlights(const col_scheme_t *from)
@@ -1349,6 +1375,12 @@ cs_add_file_hi(struct matchers_t *matchers, const col_attr_t *hi)
 	file_hi->hi = *hi;
 
 	++cs->file_hi_count;
+
+	if(cs->file_hi_index == NULL ||
+			rule_index_add(cs->file_hi_index, matchers) != 0)
+	{
+		build_file_hi_index(cs);
+	}
 }
 
 const col_attr_t *
@@ -1365,6 +1397,15 @@ cs_get_file_hi(const col_scheme_t *cs, const char fname[], int *hi_hint)
 		return &cs->file_hi[*hi_hint].hi;
 	}
 
+	if(cs->file_hi_index != NULL)
+	{
+		int count;
+		const int *const matched = rule_index_find(cs->file_hi_index, fname,
+				&count);
+		*hi_hint = (count == 0 ? INT_MAX : matched[0]);
+		return (count == 0 ? NULL : &cs->file_hi[matched[0]].hi);
+	}
+
 	int i;
 	for(i = 0; i < cs->file_hi_count; ++i)
 	{
@@ -1394,6 +1435,7 @@ cs_del_file_hi(const char matchers_expr[])
 			memmove(&cs->file_hi[i], &cs->file_hi[i + 1],
 					sizeof(*cs->file_hi)*((cs->file_hi_count - 1) - i));
 			--cs->file_hi_count;
+			build_file_hi_index(cs);
 			return 1;
 		}
 	}
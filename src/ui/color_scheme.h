@@ -42,6 +42,7 @@ typedef enum
 ColorSchemeState;
 
 struct matchers_t;
+struct rule_index_t;
 
 /* Single file highlight description. */
 typedef struct
@@ -61,6 +62,8 @@ typedef struct
 
 	file_hi_t *file_hi; /* List of file highlight preferences. */
 	int file_hi_count;  /* Number of file highlight definitions. */
+	/* Index of file_hi for faster lookups, NULL means checking every item. */
+	struct rule_index_t *file_hi_index;
 
 	col_attr_t *column_hi; /* List of column highlight preferences.
 	                          Unused entries are filled with 0xff. */
@@ -1043,6 +1043,9 @@ compute_and_draw_cell(column_data_t *cdt, int cell, size_t col_count,
 {
 	size_t prefix_len = 0U;
 
+	/* Meta-data might not have been loaded if it wasn't needed until now. */
+	fentry_load_meta(cdt->entry);
+
 	const int col = fpos_get_col(cdt->view, cell);
 
 	cdt->current_line = fpos_get_line(cdt->view, cell);
@@ -1877,6 +1880,11 @@ calculate_column_width(view_t *view)
 	{
 		if(view->max_filename_width == 0)
 		{
+			/* Decorations of some of the entries might not be known yet. */
+			if(ui_view_names_need_meta(view))
+			{
+				flist_load_meta(view);
+			}
 			view->max_filename_width = get_max_filename_width(view);
 		}
 
@@ -68,6 +68,7 @@
 #include "../flist_sel.h"
 #include "../macros.h"
 #include "../opt_handlers.h"
+#include "../search.h"
 #include "../sort.h"
 #include "../status.h"
 #include "../vifm.h"
@@ -2072,6 +2073,7 @@ ui_view_reset_selection_and_reload(view_t *view)
 void
 ui_view_reset_search_highlight(view_t *view)
 {
+	search_cancel(view);
 	if(view->matches != 0)
 	{
 		view->matches = 0;
@@ -2713,6 +2715,21 @@ ui_view_displays_columns(const view_t *view)
 	    || is_forced_list_mode(view);
 }
 
+int
+ui_view_names_need_meta(const view_t *view)
+{
+	if(ui_view_displays_columns(view))
+	{
+		return 0;
+	}
+
+	/* Only executable files are told apart from regular ones by their mode. */
+	return strcmp(cfg.type_decs[FT_EXEC][DECORATION_PREFIX],
+	              cfg.type_decs[FT_REG][DECORATION_PREFIX]) != 0
+	    || strcmp(cfg.type_decs[FT_EXEC][DECORATION_SUFFIX],
+	              cfg.type_decs[FT_REG][DECORATION_SUFFIX]) != 0;
+}
+
 int
 ui_view_main_area(const view_t *view)
 {
@@ -35,6 +35,7 @@
 #include "../compat/pthread.h"
 #include "../utils/filter.h"
 #include "../utils/fswatch.h"
+#include "../utils/str_pool.h"
 #include "../utils/test_helpers.h"
 #include "../marks.h"
 #include "../status.h"
@@ -217,6 +218,8 @@ typedef struct dir_entry_t dir_entry_t;
 struct dir_entry_t
 {
 	char *name;       /* File name. */
+	str_pool_t *name_pool; /* Pool that stores the name or NULL if the name is
+	                          allocated on a heap. */
 	char *origin;     /* Location where this file comes from.  Either points to
 	                     view_t::curr_dir for non-cv views or is allocated on
 	                     a heap depending on owns_origin field. */
@@ -263,6 +266,7 @@ struct dir_entry_t
 	unsigned int slow_target : 1;  /* Whether this symlink has a slow target. */
 	unsigned int owns_origin : 1;  /* Whether this entry is custom one. */
 	unsigned int folded : 1;       /* Whether this entry is folded. */
+	unsigned int meta_pending : 1; /* Whether only name and type are known. */
 };
 
 /* List of entries bundled with its size. */
@@ -346,6 +350,20 @@ struct local_filter_t
 	/* Number of entries filtered in other ways. */
 	size_t prefiltered_count;
 
+	/* Whether filtering ran out of its time budget and isn't finished yet. */
+	int pending;
+	/* Position in unfiltered list at which pending filtering continues. */
+	size_t next;
+	/* Whether pending filtering checks only entries that passed previous one. */
+	int narrowing;
+	/* Parent directory entry met by pending filtering or NULL. */
+	dir_entry_t *parent_entry;
+	/* Whether pending filtering has added parent directory entry to the list. */
+	int parent_added;
+	/* Whether tag fields of unfiltered entries mark a superset of entries that
+	 * match current filter, which allows narrowing the result of filtering. */
+	int narrowable;
+
 	/* List of previous cursor positions in the unfiltered array. */
 	int *poshist;
 	/* Number of elements in the poshist field. */
@@ -395,10 +413,18 @@ struct view_t
 	fswatch_t *watch;  /* Monitor that checks for directory changes. */
 	char *watched_dir; /* Path for which the monitor was created. */
 
+	/* Storage for names of entries of the listing that's being loaded or NULL.
+	 * Entries hold references to it, so it outlives the view's reference. */
+	str_pool_t *name_pool;
+
 	char *last_dir; /* Location visited by the view before the current one. */
 
 	/* Number of files that match current search pattern. */
 	int matches;
+	/* State of search matching that didn't fit into its time budget or NULL. */
+	struct search_state_t *search_state;
+	/* Reading of subtree of just unfolded directory in background or NULL. */
+	struct subtree_job_t *subtree_job;
 	/* Last used search pattern, empty if none. */
 	char last_search[NAME_MAX + 1];
 
@@ -751,6 +777,12 @@ int ui_view_is_visible(const view_t *view);
  * zero is returned. */
 int ui_view_displays_columns(const view_t *view);
 
+/* Checks whether laying out names of the view requires meta-data of every
+ * entry, which is the case when width of ls-like columns depends on
+ * decorations of executable files.  Returns non-zero if so, otherwise zero is
+ * returned. */
+int ui_view_names_need_meta(const view_t *view);
+
 /* Gets width of part of the view that is available for the main file list.
  * Returns the width. */
 int ui_view_main_area(const view_t *view);
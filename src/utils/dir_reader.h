@@ -0,0 +1,93 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__DIR_READER_H__
+#define VIFM__UTILS__DIR_READER_H__
+
+#include <sys/stat.h> /* struct stat */
+
+#include "test_helpers.h"
+
+/* Reading of directory contents on a separate thread.  Entries along with
+ * their meta-data are handed out in batches as soon as they become available,
+ * which allows the caller to process beginning of a listing without waiting
+ * for the whole directory to be read.  Only a few batches are queued at a time,
+ * after that reading waits for the caller to retrieve them. */
+
+/* Result of waiting for next batch of entries. */
+typedef enum
+{
+	DRS_BATCH,   /* New batch of entries was retrieved. */
+	DRS_TIMEOUT, /* Nothing new within the timeout. */
+	DRS_DONE,    /* Whole directory was read and all batches were handed out. */
+	DRS_FAILED,  /* Reading has failed or was cancelled. */
+}
+DirReaderState;
+
+/* Single entry of a directory. */
+typedef struct
+{
+	char *name;          /* Name of the entry. */
+	unsigned char dtype; /* Type reported by readdir() (DT_* value). */
+	int stat_skipped;    /* Whether lstat() wasn't performed on request. */
+	int stat_failed;     /* Whether lstat() of the entry has failed. */
+	struct stat stat;    /* Result of lstat() unless stat_* is set. */
+}
+dir_reader_entry_t;
+
+/* Batch of entries. */
+typedef struct
+{
+	dir_reader_entry_t *entries; /* Entries of the batch. */
+	int count;                   /* Number of entries in the batch. */
+}
+dir_reader_batch_t;
+
+/* Opaque type of a reader. */
+typedef struct dir_reader_t dir_reader_t;
+
+/* Starts reading the directory in background.  Non-zero names_only makes
+ * reader skip lstat() for entries whose type is reported by readdir().  Returns
+ * the reader or NULL on error (errno is set in this case). */
+dir_reader_t * dir_reader_start(const char path[], int names_only);
+
+/* Waits at most timeout_ms milliseconds for the next batch of entries.  On
+ * DRS_BATCH the caller becomes an owner of the *batch and must free it with
+ * dir_reader_free_batch().  Returns state of the reading. */
+DirReaderState dir_reader_next(dir_reader_t *reader, int timeout_ms,
+		dir_reader_batch_t *batch);
+
+/* Requests reading to stop as soon as possible.  Subsequent calls to
+ * dir_reader_next() report DRS_FAILED. */
+void dir_reader_cancel(dir_reader_t *reader);
+
+/* Stops reading if it's still in progress and frees all resources.  reader can
+ * be NULL. */
+void dir_reader_free(dir_reader_t *reader);
+
+/* Frees batch of entries. */
+void dir_reader_free_batch(dir_reader_batch_t *batch);
+
+TSTATIC_DEFS(
+	int dir_reader_queued(dir_reader_t *reader);
+)
+
+#endif /* VIFM__UTILS__DIR_READER_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,486 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "dir_reader.h"
+
+#include <sys/stat.h> /* struct stat fstatat() */
+#include <dirent.h> /* DIR closedir() dirfd() opendir() readdir() */
+#include <fcntl.h> /* AT_SYMLINK_NOFOLLOW */
+
+#include <errno.h> /* ETIMEDOUT errno */
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* calloc() free() malloc() */
+#include <string.h> /* strdup() */
+#include <time.h> /* CLOCK_REALTIME clock_gettime() */
+
+#include "../compat/dtype.h"
+#include "../compat/os.h"
+#include "../compat/pthread.h"
+#include "path.h"
+#include "test_helpers.h"
+#include "thread_pool.h"
+
+/* Size of the first batch, which is kept small to make beginning of the list
+ * available as soon as possible. */
+#define FIRST_BATCH_SIZE 64
+
+/* Upper limit on size of a batch. */
+#define MAX_BATCH_SIZE 4096
+
+/* Maximal number of batches waiting to be retrieved.  Reader stops until
+ * consumer catches up, which bounds memory taken by a huge directory that is
+ * read faster than its entries are processed. */
+#define MAX_QUEUED_BATCHES 4
+
+/* Number of threads that query meta-data of entries.  Threads mostly wait for
+ * replies to fstatat(), so they are many to keep several requests to a network
+ * file system in flight. */
+#define STAT_WORKERS 8
+
+/* Minimal number of entries in a batch to query their meta-data in parallel. */
+#define MIN_PARALLEL_STATS 32
+
+/* Number of entries processed by a stat worker at a time. */
+#define STAT_CHUNK 16
+
+/* Element of a queue of batches. */
+typedef struct batch_node_t
+{
+	dir_reader_batch_t batch;  /* Batch itself. */
+	struct batch_node_t *next; /* Next element of the queue or NULL. */
+}
+batch_node_t;
+
+/* State of a reader. */
+struct dir_reader_t
+{
+	char *path;           /* Path to the directory being read. */
+	DIR *dir;             /* Directory stream owned by the worker. */
+	int dir_fd;           /* File descriptor of the dir stream. */
+	pthread_t thread;     /* Worker thread. */
+	thread_pool_t *pool;  /* Stat workers, created on first big batch. */
+	int names_only;       /* Whether lstat() is skipped when possible. */
+
+	pthread_mutex_t lock; /* Protects fields below. */
+	pthread_cond_t cond;  /* Signaled on new batch or end of reading. */
+	pthread_cond_t space; /* Signaled on retrieving a batch or cancellation. */
+
+	batch_node_t *head; /* First batch in the queue or NULL. */
+	batch_node_t *tail; /* Last batch in the queue or NULL. */
+	int queued;         /* Number of batches in the queue. */
+	int finished;       /* Whether worker is done. */
+	int failed;         /* Whether reading has failed. */
+	int cancelled;      /* Whether reading should be stopped. */
+};
+
+/* Work item for stat workers. */
+typedef struct
+{
+	dir_reader_t *reader;      /* Reader that owns the batch. */
+	dir_reader_batch_t *batch; /* Batch whose entries are being processed. */
+}
+stat_job_t;
+
+static void * reader_thread(void *arg);
+static int read_entries(dir_reader_t *reader);
+static void stat_batch(dir_reader_t *reader, dir_reader_batch_t *batch);
+static void stat_entries(void *arg, int from, int to);
+static int publish_batch(dir_reader_t *reader, dir_reader_batch_t *batch);
+static int is_cancelled(dir_reader_t *reader);
+static void compute_deadline(struct timespec *ts, int timeout_ms);
+TSTATIC int dir_reader_queued(dir_reader_t *reader);
+
+dir_reader_t *
+dir_reader_start(const char path[], int names_only)
+{
+	dir_reader_t *const reader = calloc(1, sizeof(*reader));
+	if(reader == NULL)
+	{
+		return NULL;
+	}
+
+	reader->names_only = names_only;
+	reader->path = strdup(path);
+	if(reader->path == NULL)
+	{
+		free(reader);
+		return NULL;
+	}
+
+	/* Open directory here to report failure to the caller immediately. */
+	reader->dir = os_opendir(path);
+	if(reader->dir == NULL)
+	{
+		free(reader->path);
+		free(reader);
+		return NULL;
+	}
+
+	/* All meta-data is queried relative to this descriptor, so neither current
+	 * directory of the process nor full paths are used. */
+	reader->dir_fd = dirfd(reader->dir);
+
+	pthread_mutex_init(&reader->lock, NULL);
+	pthread_cond_init(&reader->cond, NULL);
+	pthread_cond_init(&reader->space, NULL);
+
+	if(pthread_create(&reader->thread, NULL, &reader_thread, reader) != 0)
+	{
+		os_closedir(reader->dir);
+		pthread_cond_destroy(&reader->space);
+		pthread_cond_destroy(&reader->cond);
+		pthread_mutex_destroy(&reader->lock);
+		free(reader->path);
+		free(reader);
+		return NULL;
+	}
+
+	return reader;
+}
+
+DirReaderState
+dir_reader_next(dir_reader_t *reader, int timeout_ms, dir_reader_batch_t *batch)
+{
+	DirReaderState state;
+	struct timespec deadline;
+	compute_deadline(&deadline, timeout_ms);
+
+	pthread_mutex_lock(&reader->lock);
+
+	while(reader->head == NULL && !reader->finished && !reader->cancelled)
+	{
+		if(pthread_cond_timedwait(&reader->cond, &reader->lock,
+					&deadline) == ETIMEDOUT)
+		{
+			break;
+		}
+	}
+
+	if(reader->cancelled || reader->failed)
+	{
+		state = DRS_FAILED;
+	}
+	else if(reader->head != NULL)
+	{
+		batch_node_t *const node = reader->head;
+		reader->head = node->next;
+		if(reader->head == NULL)
+		{
+			reader->tail = NULL;
+		}
+
+		*batch = node->batch;
+		free(node);
+		state = DRS_BATCH;
+
+		--reader->queued;
+		pthread_cond_signal(&reader->space);
+	}
+	else
+	{
+		state = reader->finished ? DRS_DONE : DRS_TIMEOUT;
+	}
+
+	pthread_mutex_unlock(&reader->lock);
+
+	return state;
+}
+
+void
+dir_reader_cancel(dir_reader_t *reader)
+{
+	pthread_mutex_lock(&reader->lock);
+	reader->cancelled = 1;
+	pthread_cond_broadcast(&reader->cond);
+	pthread_cond_broadcast(&reader->space);
+	pthread_mutex_unlock(&reader->lock);
+}
+
+void
+dir_reader_free(dir_reader_t *reader)
+{
+	if(reader == NULL)
+	{
+		return;
+	}
+
+	dir_reader_cancel(reader);
+	pthread_join(reader->thread, NULL);
+
+	while(reader->head != NULL)
+	{
+		batch_node_t *const next = reader->head->next;
+		dir_reader_free_batch(&reader->head->batch);
+		free(reader->head);
+		reader->head = next;
+	}
+
+	pthread_cond_destroy(&reader->space);
+	pthread_cond_destroy(&reader->cond);
+	pthread_mutex_destroy(&reader->lock);
+	free(reader->path);
+	free(reader);
+}
+
+void
+dir_reader_free_batch(dir_reader_batch_t *batch)
+{
+	int i;
+	for(i = 0; i < batch->count; ++i)
+	{
+		free(batch->entries[i].name);
+	}
+	free(batch->entries);
+
+	batch->entries = NULL;
+	batch->count = 0;
+}
+
+/* Entry point of the worker thread.  Returns NULL. */
+static void *
+reader_thread(void *arg)
+{
+	dir_reader_t *const reader = arg;
+
+	const int failed = (read_entries(reader) != 0);
+	thread_pool_free(reader->pool);
+	reader->pool = NULL;
+	os_closedir(reader->dir);
+	reader->dir = NULL;
+
+	pthread_mutex_lock(&reader->lock);
+	reader->finished = 1;
+	reader->failed = failed;
+	pthread_cond_broadcast(&reader->cond);
+	pthread_mutex_unlock(&reader->lock);
+
+	return NULL;
+}
+
+/* Reads all entries of the directory publishing them in batches.  Returns zero
+ * on success, otherwise non-zero is returned. */
+static int
+read_entries(dir_reader_t *reader)
+{
+	dir_reader_batch_t batch = { .entries = NULL, .count = 0 };
+	int batch_size = FIRST_BATCH_SIZE;
+	struct dirent *d;
+
+	while((d = os_readdir(reader->dir)) != NULL)
+	{
+		if(is_builtin_dir(d->d_name))
+		{
+			continue;
+		}
+
+		if(is_cancelled(reader))
+		{
+			dir_reader_free_batch(&batch);
+			return 1;
+		}
+
+		if(batch.entries == NULL)
+		{
+			batch.entries = malloc(sizeof(*batch.entries)*batch_size);
+			if(batch.entries == NULL)
+			{
+				return 1;
+			}
+		}
+
+		dir_reader_entry_t *const entry = &batch.entries[batch.count];
+		entry->name = strdup(d->d_name);
+		if(entry->name == NULL)
+		{
+			dir_reader_free_batch(&batch);
+			return 1;
+		}
+		++batch.count;
+
+#if defined(HAVE_STRUCT_DIRENT_D_TYPE) && HAVE_STRUCT_DIRENT_D_TYPE
+		entry->dtype = d->d_type;
+#else
+		entry->dtype = DT_UNKNOWN;
+#endif
+
+		entry->stat_skipped = (reader->names_only && entry->dtype != DT_UNKNOWN);
+		entry->stat_failed = 0;
+
+		if(batch.count == batch_size)
+		{
+			stat_batch(reader, &batch);
+			if(publish_batch(reader, &batch) != 0)
+			{
+				return 1;
+			}
+			if(batch_size < MAX_BATCH_SIZE)
+			{
+				batch_size *= 2;
+			}
+		}
+	}
+
+	if(batch.count != 0)
+	{
+		stat_batch(reader, &batch);
+		if(publish_batch(reader, &batch) != 0)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Queries meta-data of all entries of the batch, possibly in parallel. */
+static void
+stat_batch(dir_reader_t *reader, dir_reader_batch_t *batch)
+{
+	stat_job_t job = { .reader = reader, .batch = batch };
+
+	int nstats = 0;
+	int i;
+	for(i = 0; i < batch->count; ++i)
+	{
+		nstats += !batch->entries[i].stat_skipped;
+	}
+
+	if(nstats >= MIN_PARALLEL_STATS && reader->pool == NULL)
+	{
+		reader->pool = thread_pool_new(STAT_WORKERS);
+	}
+
+	if(nstats < MIN_PARALLEL_STATS || reader->pool == NULL)
+	{
+		stat_entries(&job, 0, batch->count);
+		return;
+	}
+
+	thread_pool_for(reader->pool, batch->count, STAT_CHUNK, &stat_entries, &job);
+}
+
+/* Queries meta-data of entries in the [from; to) range of a batch.  arg points
+ * at stat_job_t. */
+static void
+stat_entries(void *arg, int from, int to)
+{
+	stat_job_t *const job = arg;
+
+	const int dir_fd = job->reader->dir_fd;
+	dir_reader_entry_t *const entries = job->batch->entries;
+
+	int i;
+	for(i = from; i < to; ++i)
+	{
+		if(entries[i].stat_skipped)
+		{
+			continue;
+		}
+
+		entries[i].stat_failed = (fstatat(dir_fd, entries[i].name,
+					&entries[i].stat, AT_SYMLINK_NOFOLLOW) != 0);
+	}
+}
+
+/* Appends the batch to the queue of the reader waiting for a free slot in it
+ * and resets the batch.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+publish_batch(dir_reader_t *reader, dir_reader_batch_t *batch)
+{
+	batch_node_t *const node = malloc(sizeof(*node));
+	if(node == NULL)
+	{
+		dir_reader_free_batch(batch);
+		return 1;
+	}
+
+	node->batch = *batch;
+	node->next = NULL;
+
+	batch->entries = NULL;
+	batch->count = 0;
+
+	pthread_mutex_lock(&reader->lock);
+	while(reader->queued >= MAX_QUEUED_BATCHES && !reader->cancelled)
+	{
+		pthread_cond_wait(&reader->space, &reader->lock);
+	}
+
+	if(reader->cancelled)
+	{
+		pthread_mutex_unlock(&reader->lock);
+		dir_reader_free_batch(&node->batch);
+		free(node);
+		return 1;
+	}
+
+	if(reader->tail == NULL)
+	{
+		reader->head = node;
+	}
+	else
+	{
+		reader->tail->next = node;
+	}
+	reader->tail = node;
+	++reader->queued;
+	pthread_cond_broadcast(&reader->cond);
+	pthread_mutex_unlock(&reader->lock);
+
+	return 0;
+}
+
+/* Checks whether reading was cancelled.  Returns non-zero if so, otherwise zero
+ * is returned. */
+static int
+is_cancelled(dir_reader_t *reader)
+{
+	pthread_mutex_lock(&reader->lock);
+	const int cancelled = reader->cancelled;
+	pthread_mutex_unlock(&reader->lock);
+	return cancelled;
+}
+
+/* Retrieves number of batches waiting to be retrieved.  Returns the number. */
+TSTATIC int
+dir_reader_queued(dir_reader_t *reader)
+{
+	pthread_mutex_lock(&reader->lock);
+	const int queued = reader->queued;
+	pthread_mutex_unlock(&reader->lock);
+	return queued;
+}
+
+/* Computes absolute time which is timeout_ms milliseconds in the future. */
+static void
+compute_deadline(struct timespec *ts, int timeout_ms)
+{
+	clock_gettime(CLOCK_REALTIME, ts);
+
+	ts->tv_sec += timeout_ms/1000;
+	ts->tv_nsec += (long)(timeout_ms%1000)*1000000L;
+	if(ts->tv_nsec >= 1000000000L)
+	{
+		++ts->tv_sec;
+		ts->tv_nsec -= 1000000000L;
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,606 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "dir_size.h"
+
+#include <sys/stat.h> /* S_ISDIR() stat fstatat() */
+#include <dirent.h> /* DIR dirent fdopendir() readdir() closedir() */
+#ifndef _WIN32
+#include <fcntl.h> /* AT_SYMLINK_NOFOLLOW O_* open() */
+#include <unistd.h> /* close() */
+#endif
+
+#include <stddef.h> /* NULL */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* free() malloc() qsort() */
+#include <string.h> /* memcpy() strdup() strlen() */
+
+#include "../compat/os.h"
+#include "../compat/pthread.h"
+#include "../compat/reallocarray.h"
+#include "path.h"
+#include "thread_pool.h"
+
+/* Number of threads that read directories.  Only meta-data is read, which is
+ * cheap for a disk, but slow on network mounts, so there are more threads than
+ * a disk would need. */
+#define SIZE_WORKERS 8
+
+/* File with several hard links. */
+typedef struct
+{
+	uint64_t dev;    /* Device of the file. */
+	uint64_t ino;    /* Inode number of the file. */
+	dir_size_t size; /* Size of the file. */
+}
+link_t;
+
+/* Set of files with several hard links. */
+typedef struct
+{
+	link_t *items; /* Files sorted by their identifiers. */
+	int count;     /* Number of files. */
+	int capacity;  /* Number of allocated items. */
+}
+links_t;
+
+/* Directory of the tree whose size isn't known yet. */
+typedef struct node_t
+{
+	char *path;            /* Path to the directory. */
+	struct node_t *parent; /* Parent directory or NULL for the root. */
+	uint64_t inode;        /* Inode number of the directory. */
+	dir_size_t size;       /* Size accumulated so far. */
+	links_t links;         /* Multiply linked files of the subtree processed so
+	                          far, each of them is counted in size once. */
+	int pending;           /* Number of unfinished subdirectories plus one while
+	                          the directory itself isn't read. */
+	int failed;            /* Whether the directory couldn't be read. */
+}
+node_t;
+
+/* State of a calculation shared by all threads. */
+typedef struct
+{
+	const dir_size_cbs_t *cbs; /* Callbacks. */
+	pthread_t owner;           /* Thread that started the calculation. */
+
+	pthread_mutex_t lock; /* Protects fields below and sizes of nodes. */
+	pthread_cond_t cond;  /* Signaled on new jobs and on the end of work. */
+	node_t **jobs;        /* Stack of directories that need to be read. */
+	int njobs;            /* Number of pending jobs. */
+	int capacity;         /* Number of allocated jobs. */
+	int active;           /* Number of jobs that are being processed. */
+	int stop;             /* Whether the calculation should be abandoned. */
+	int finished;         /* Whether size of the root is known. */
+	dir_size_t result;    /* Size of the root once it's known. */
+}
+calc_t;
+
+static void size_worker(void *arg, int from, int to);
+static int take_job(calc_t *calc, node_t **node);
+static void finish_job(calc_t *calc);
+static void process_node(calc_t *calc, node_t *node);
+static void read_dir(calc_t *calc, node_t *node, dir_size_t *size,
+		links_t *links);
+static void add_entry(calc_t *calc, node_t *node, const char name[],
+		const struct stat *st, dir_size_t *size, links_t *links);
+static void add_link(links_t *links, const struct stat *st,
+		const dir_size_t *size);
+static void complete_node(calc_t *calc, node_t *node, const dir_size_t *size,
+		links_t *links);
+static void merge_links(node_t *node, links_t *links);
+static int link_cmp(const void *a, const void *b);
+static int push_job(calc_t *calc, node_t *node);
+static node_t * make_node(char path[], node_t *parent, uint64_t inode);
+static char * join_path(const char dir[], const char name[]);
+
+int
+dir_size_calc(const char path[], const dir_size_cbs_t *cbs, dir_size_t *size)
+{
+	struct stat st;
+	const uint64_t inode = (os_stat(path, &st) == 0 ? st.st_ino : 0U);
+
+	char *const root_path = strdup(path);
+	node_t *const root = (root_path == NULL)
+	                   ? NULL
+	                   : make_node(root_path, NULL, inode);
+	if(root == NULL)
+	{
+		free(root_path);
+		return 1;
+	}
+
+	calc_t calc = {
+		.cbs = cbs,
+		.owner = pthread_self(),
+	};
+	pthread_mutex_init(&calc.lock, NULL);
+	pthread_cond_init(&calc.cond, NULL);
+
+	if(push_job(&calc, root) != 0)
+	{
+		pthread_cond_destroy(&calc.cond);
+		pthread_mutex_destroy(&calc.lock);
+		free(root->path);
+		free(root);
+		return 1;
+	}
+
+	/* Read the root right away, there is no point in starting threads for a
+	 * directory without uncached subdirectories. */
+	node_t *node;
+	if(take_job(&calc, &node) == 0)
+	{
+		process_node(&calc, node);
+		finish_job(&calc);
+	}
+
+	if(calc.njobs != 0)
+	{
+		thread_pool_t *const pool = thread_pool_new(SIZE_WORKERS);
+		if(pool == NULL)
+		{
+			size_worker(&calc, 0, 1);
+		}
+		else
+		{
+			/* Each item is a worker that keeps taking jobs until there are none. */
+			thread_pool_for(pool, thread_pool_size(pool) + 1, 1, &size_worker,
+					&calc);
+			thread_pool_free(pool);
+		}
+	}
+
+	const int failed = (calc.stop || !calc.finished);
+	if(!failed)
+	{
+		*size = calc.result;
+	}
+
+	free(calc.jobs);
+	pthread_cond_destroy(&calc.cond);
+	pthread_mutex_destroy(&calc.lock);
+	return failed;
+}
+
+/* thread_pool_for() callback that processes jobs until the work is over. */
+static void
+size_worker(void *arg, int from, int to)
+{
+	calc_t *const calc = arg;
+
+	node_t *node;
+	while(take_job(calc, &node) == 0)
+	{
+		process_node(calc, node);
+		finish_job(calc);
+	}
+}
+
+/* Reads directory of the node and accounts for its files. */
+static void
+process_node(calc_t *calc, node_t *node)
+{
+	dir_size_t own_size;
+	links_t own_links = { };
+	read_dir(calc, node, &own_size, &own_links);
+	complete_node(calc, node, &own_size, &own_links);
+}
+
+/* Waits for the next job.  Jobs keep being handed out after cancellation to
+ * let them finish and free their nodes.  Returns zero if *node was filled,
+ * otherwise non-zero is returned meaning that the work is over. */
+static int
+take_job(calc_t *calc, node_t **node)
+{
+	pthread_mutex_lock(&calc->lock);
+	while(calc->njobs == 0 && calc->active != 0)
+	{
+		pthread_cond_wait(&calc->cond, &calc->lock);
+	}
+
+	const int done = (calc->njobs == 0);
+	if(!done)
+	{
+		*node = calc->jobs[--calc->njobs];
+		++calc->active;
+	}
+	pthread_mutex_unlock(&calc->lock);
+
+	return done;
+}
+
+/* Marks a job taken by take_job() as done and checks for cancellation. */
+static void
+finish_job(calc_t *calc)
+{
+	const int cancelled = (calc->cbs->cancelled != NULL &&
+	                       pthread_equal(pthread_self(), calc->owner) &&
+	                       calc->cbs->cancelled(calc->cbs->arg));
+
+	pthread_mutex_lock(&calc->lock);
+	calc->stop |= cancelled;
+	--calc->active;
+	if(calc->active == 0 && calc->njobs == 0)
+	{
+		/* That was the last job, wake up everyone to let them finish. */
+		pthread_cond_broadcast(&calc->cond);
+	}
+	pthread_mutex_unlock(&calc->lock);
+}
+
+/* Lists directory of the node computing size of its files and queuing its
+ * subdirectories.  *size receives size of files of the directory and *links
+ * collects its multiply linked files. */
+static void
+read_dir(calc_t *calc, node_t *node, dir_size_t *size, links_t *links)
+{
+	size->size = 0U;
+	size->allocated = 0U;
+
+	pthread_mutex_lock(&calc->lock);
+	const int stop = calc->stop;
+	pthread_mutex_unlock(&calc->lock);
+
+	if(stop)
+	{
+		return;
+	}
+
+#ifndef _WIN32
+	/* Entries are queried relative to the directory to avoid resolving the
+	 * same path for each of them. */
+	const int fd = open(node->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	DIR *const dir = (fd == -1 ? NULL : fdopendir(fd));
+	if(dir == NULL)
+	{
+		if(fd != -1)
+		{
+			close(fd);
+		}
+		node->failed = 1;
+		return;
+	}
+
+	struct dirent *dentry;
+	while((dentry = readdir(dir)) != NULL)
+	{
+		struct stat st;
+		if(!is_builtin_dir(dentry->d_name) &&
+				fstatat(dirfd(dir), dentry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0)
+		{
+			add_entry(calc, node, dentry->d_name, &st, size, links);
+		}
+	}
+
+	closedir(dir);
+#else
+	DIR *const dir = os_opendir(node->path);
+	if(dir == NULL)
+	{
+		node->failed = 1;
+		return;
+	}
+
+	struct dirent *dentry;
+	while((dentry = os_readdir(dir)) != NULL)
+	{
+		if(is_builtin_dir(dentry->d_name))
+		{
+			continue;
+		}
+
+		char *const full_path = join_path(node->path, dentry->d_name);
+		struct stat st;
+		if(full_path != NULL && os_lstat(full_path, &st) == 0)
+		{
+			add_entry(calc, node, dentry->d_name, &st, size, links);
+		}
+		free(full_path);
+	}
+
+	os_closedir(dir);
+#endif
+}
+
+/* Accounts for an entry of directory of the node by either adding its size to
+ * *size or by queuing it for reading. */
+static void
+add_entry(calc_t *calc, node_t *node, const char name[], const struct stat *st,
+		dir_size_t *size, links_t *links)
+{
+	if(!S_ISDIR(st->st_mode))
+	{
+		dir_size_t file_size = { .size = st->st_size };
+#ifndef _WIN32
+		file_size.allocated = (uint64_t)st->st_blocks*512U;
+		if(st->st_nlink > 1)
+		{
+			add_link(links, st, &file_size);
+		}
+#else
+		file_size.allocated = st->st_size;
+#endif
+		size->size += file_size.size;
+		size->allocated += file_size.allocated;
+		return;
+	}
+
+	char *const path = join_path(node->path, name);
+	if(path == NULL)
+	{
+		return;
+	}
+
+	uint64_t cached_size;
+	if(calc->cbs->cached != NULL &&
+			calc->cbs->cached(path, st->st_mtime, st->st_ino, &cached_size,
+				calc->cbs->arg))
+	{
+		size->size += cached_size;
+		free(path);
+		return;
+	}
+
+	node_t *const child = make_node(path, node, st->st_ino);
+	if(child == NULL)
+	{
+		free(path);
+		return;
+	}
+
+	pthread_mutex_lock(&calc->lock);
+	++node->pending;
+	pthread_mutex_unlock(&calc->lock);
+
+	if(push_job(calc, child) != 0)
+	{
+		/* Not reading the directory is the best we can do. */
+		const dir_size_t nothing = { };
+		links_t no_links = { };
+		child->failed = 1;
+		complete_node(calc, child, &nothing, &no_links);
+	}
+}
+
+/* Remembers multiply linked file, which is already counted in size.  Failing
+ * to remember it leads to counting it several times. */
+static void
+add_link(links_t *links, const struct stat *st, const dir_size_t *size)
+{
+	if(links->count == links->capacity)
+	{
+		const int capacity = (links->capacity == 0 ? 16 : links->capacity*2);
+		link_t *const items = reallocarray(links->items, capacity,
+				sizeof(*items));
+		if(items == NULL)
+		{
+			return;
+		}
+		links->items = items;
+		links->capacity = capacity;
+	}
+
+	link_t *const link = &links->items[links->count++];
+	link->dev = st->st_dev;
+	link->ino = st->st_ino;
+	link->size = *size;
+}
+
+/* Adds size of files of the node to it and finishes the node and its parents
+ * which don't have any unfinished subdirectories left.  Takes ownership of
+ * links. */
+static void
+complete_node(calc_t *calc, node_t *node, const dir_size_t *size,
+		links_t *links)
+{
+	/* The same file can be linked from a directory several times. */
+	if(links->count != 0)
+	{
+		qsort(links->items, links->count, sizeof(*links->items), &link_cmp);
+	}
+
+	pthread_mutex_lock(&calc->lock);
+	node->size.size += size->size;
+	node->size.allocated += size->allocated;
+	merge_links(node, links);
+	int last = (--node->pending == 0);
+	pthread_mutex_unlock(&calc->lock);
+
+	while(last)
+	{
+		node_t *const parent = node->parent;
+
+		pthread_mutex_lock(&calc->lock);
+		const int stop = calc->stop;
+		if(parent != NULL)
+		{
+			parent->size.size += node->size.size;
+			parent->size.allocated += node->size.allocated;
+			merge_links(parent, &node->links);
+			last = (--parent->pending == 0);
+		}
+		else
+		{
+			calc->result = node->size;
+			calc->finished = !node->failed;
+			last = 0;
+		}
+		pthread_mutex_unlock(&calc->lock);
+
+		/* Nothing can change size of the node at this point. */
+		if(!stop && !node->failed && calc->cbs->done != NULL)
+		{
+			calc->cbs->done(node->path, node->inode, &node->size, calc->cbs->arg);
+		}
+
+		free(node->links.items);
+		free(node->path);
+		free(node);
+		node = parent;
+	}
+}
+
+/* Merges sorted set of multiply linked files into the set of the node
+ * subtracting sizes of files that are already counted by the node.  Which
+ * files end up being counted twice doesn't depend on the order of merging, so
+ * sizes are the same for every calculation.  Empties the set. */
+static void
+merge_links(node_t *node, links_t *links)
+{
+	if(links->count == 0)
+	{
+		free(links->items);
+		*links = (links_t){ };
+		return;
+	}
+
+	links_t *const into = &node->links;
+	link_t *const merged = reallocarray(NULL, into->count + links->count,
+			sizeof(*merged));
+	if(merged == NULL)
+	{
+		/* The same files might be counted several times by parent nodes. */
+		free(links->items);
+		*links = (links_t){ };
+		return;
+	}
+
+	int n = 0;
+	int i = 0, j = 0;
+	while(i < into->count || j < links->count)
+	{
+		const link_t *next;
+		if(j == links->count ||
+				(i < into->count && link_cmp(&into->items[i], &links->items[j]) < 0))
+		{
+			next = &into->items[i++];
+		}
+		else
+		{
+			next = &links->items[j++];
+		}
+
+		if(n != 0 && link_cmp(&merged[n - 1], next) == 0)
+		{
+			node->size.size -= next->size.size;
+			node->size.allocated -= next->size.allocated;
+		}
+		else
+		{
+			merged[n++] = *next;
+		}
+	}
+
+	free(links->items);
+	*links = (links_t){ };
+
+	free(into->items);
+	into->items = merged;
+	into->count = n;
+	into->capacity = n;
+}
+
+/* Compares two multiply linked files by their identifiers.  Returns negative
+ * value, zero or positive value as for qsort(). */
+static int
+link_cmp(const void *a, const void *b)
+{
+	const link_t *const x = a;
+	const link_t *const y = b;
+
+	if(x->dev != y->dev)
+	{
+		return (x->dev < y->dev ? -1 : 1);
+	}
+	if(x->ino != y->ino)
+	{
+		return (x->ino < y->ino ? -1 : 1);
+	}
+	return 0;
+}
+
+/* Adds directory to the queue.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+push_job(calc_t *calc, node_t *node)
+{
+	pthread_mutex_lock(&calc->lock);
+
+	if(calc->njobs == calc->capacity)
+	{
+		const int capacity = (calc->capacity == 0 ? 64 : calc->capacity*2);
+		node_t **const jobs = reallocarray(calc->jobs, capacity, sizeof(*jobs));
+		if(jobs == NULL)
+		{
+			pthread_mutex_unlock(&calc->lock);
+			return 1;
+		}
+		calc->jobs = jobs;
+		calc->capacity = capacity;
+	}
+
+	calc->jobs[calc->njobs++] = node;
+
+	pthread_cond_signal(&calc->cond);
+	pthread_mutex_unlock(&calc->lock);
+	return 0;
+}
+
+/* Allocates a node that takes ownership of the path on success.  Returns the
+ * node or NULL on error. */
+static node_t *
+make_node(char path[], node_t *parent, uint64_t inode)
+{
+	node_t *const node = malloc(sizeof(*node));
+	if(node != NULL)
+	{
+		node->path = path;
+		node->parent = parent;
+		node->inode = inode;
+		node->size.size = 0U;
+		node->size.allocated = 0U;
+		node->links = (links_t){ };
+		node->pending = 1;
+		node->failed = 0;
+	}
+	return node;
+}
+
+/* Appends name to dir inserting a slash if needed.  Returns newly allocated
+ * string or NULL on error. */
+static char *
+join_path(const char dir[], const char name[])
+{
+	const size_t dir_len = strlen(dir);
+	const size_t name_len = strlen(name);
+	const int slash = (dir_len == 0 || dir[dir_len - 1] != '/');
+
+	char *const path = malloc(dir_len + slash + name_len + 1);
+	if(path != NULL)
+	{
+		memcpy(path, dir, dir_len);
+		path[dir_len] = '/';
+		memcpy(path + dir_len + slash, name, name_len + 1);
+	}
+	return path;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
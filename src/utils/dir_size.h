@@ -0,0 +1,76 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__DIR_SIZE_H__
+#define VIFM__UTILS__DIR_SIZE_H__
+
+#include <stdint.h> /* uint64_t */
+#include <time.h> /* time_t */
+
+/* Calculation of recursive size of a directory by several threads at once.
+ * Directories to be read are kept in a queue shared by all threads.  Files
+ * with several hard links are counted once in size of every directory whose
+ * subtree contains them.  Sizes of directories of the tree are reported as
+ * soon as their subtrees are processed. */
+
+/* Size of a directory. */
+typedef struct
+{
+	uint64_t size;      /* Sum of sizes of files (apparent size). */
+	uint64_t allocated; /* Sum of space allocated for files in bytes. */
+}
+dir_size_t;
+
+/* Looks up previously calculated apparent size of a subdirectory.  Called from
+ * several threads at once and thus must be thread-safe.  Returns non-zero and
+ * sets *size if the size is known, otherwise zero is returned. */
+typedef int (*dir_size_cached)(const char path[], time_t mtime,
+		uint64_t inode, uint64_t *size, void *arg);
+
+/* Reports size of a directory of the tree (including the root) whose subtree
+ * is fully processed.  Called from several threads at once and thus must be
+ * thread-safe. */
+typedef void (*dir_size_done)(const char path[], uint64_t inode,
+		const dir_size_t *size, void *arg);
+
+/* Checks whether calculation should stop.  Called only from the thread that
+ * started the calculation.  Returns non-zero if so, otherwise zero is
+ * returned. */
+typedef int (*dir_size_cancelled)(void *arg);
+
+/* Callbacks of a calculation, each of which can be NULL. */
+typedef struct
+{
+	dir_size_cached cached;       /* Source of known sizes. */
+	dir_size_done done;           /* Receiver of sizes of subdirectories. */
+	dir_size_cancelled cancelled; /* Whether to stop. */
+	void *arg;                    /* Argument of callbacks. */
+}
+dir_size_cbs_t;
+
+/* Calculates size of the directory at path.  Sizes of subdirectories that are
+ * taken from cache contribute only to apparent size.  Blocks until calculation
+ * is over.  Returns zero on success and non-zero on error or cancellation, in
+ * which case *size isn't changed. */
+int dir_size_calc(const char path[], const dir_size_cbs_t *cbs,
+		dir_size_t *size);
+
+#endif /* VIFM__UTILS__DIR_SIZE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,469 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "dirwatch.h"
+
+#include <stddef.h> /* NULL */
+
+#ifdef HAVE_INOTIFY
+
+#include <sys/inotify.h> /* IN_* inotify_* */
+#include <unistd.h> /* close() read() */
+
+#include <errno.h> /* EAGAIN errno */
+#include <stdint.h> /* uint32_t */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memmove() strdup() */
+
+#include "../compat/fs_limits.h"
+#include "../compat/reallocarray.h"
+#include "macros.h"
+#include "str.h"
+#include "string_array.h"
+#include "utils.h"
+
+/* Watched directory. */
+typedef struct
+{
+	int wd;             /* Watch descriptor. */
+	char *path;         /* Path to the directory. */
+	long long modified; /* Time of the first unreported modification of a file
+	                       in the directory in ms or zero. */
+	int changed;        /* Whether the directory is to be reported by current
+	                       poll. */
+	int kept;           /* Whether the directory was added during update. */
+}
+entry_t;
+
+/* Watcher data. */
+struct dirwatch_t
+{
+	int fd;             /* File descriptor for inotify or -1. */
+	entry_t *entries;   /* Watched directories sorted by watch descriptors. */
+	int count;          /* Number of watched directories. */
+	int capacity;       /* Number of allocated elements of entries. */
+	int nmodified;      /* Number of entries with non-zero modified field. */
+	int modify_delay;   /* Delay of reporting modifications of files in ms. */
+};
+
+static entry_t * find_entry(dirwatch_t *w, int wd);
+static int lower_bound(const dirwatch_t *w, int wd);
+static void add_changed(entry_t *entry, int *wds[], int *nwds);
+static void clear_modified(dirwatch_t *w, entry_t *entry);
+static int report(dirwatch_t *w, entry_t *entry, char ***paths, int count);
+static void drop_watch(dirwatch_t *w, entry_t *entry);
+static int list_all(dirwatch_t *w, char ***paths);
+
+/* Events that signify change of list of entries of a directory. */
+static const uint32_t LIST_EVENTS = IN_CREATE | IN_DELETE | IN_MOVED_FROM
+                                  | IN_MOVED_TO;
+/* Events that are requested for every watched directory. */
+static const uint32_t EVENTS_MASK = IN_MODIFY | IN_CREATE | IN_DELETE
+                                  | IN_MOVED_FROM | IN_MOVED_TO
+                                  | IN_EXCL_UNLINK | IN_ONLYDIR;
+
+dirwatch_t *
+dirwatch_create(int modify_delay)
+{
+	dirwatch_t *const w = malloc(sizeof(*w));
+	if(w == NULL)
+	{
+		return NULL;
+	}
+
+	w->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(w->fd == -1)
+	{
+		free(w);
+		return NULL;
+	}
+
+	w->entries = NULL;
+	w->count = 0;
+	w->capacity = 0;
+	w->nmodified = 0;
+	w->modify_delay = modify_delay;
+	return w;
+}
+
+void
+dirwatch_free(dirwatch_t *w)
+{
+	if(w != NULL)
+	{
+		int i;
+		for(i = 0; i < w->count; ++i)
+		{
+			free(w->entries[i].path);
+		}
+		free(w->entries);
+		close(w->fd);
+		free(w);
+	}
+}
+
+int
+dirwatch_add(dirwatch_t *w, const char path[])
+{
+	const int wd = inotify_add_watch(w->fd, path, EVENTS_MASK);
+	if(wd < 0)
+	{
+		return 1;
+	}
+
+	/* The same directory can be added under different paths, last one wins. */
+	entry_t *entry = find_entry(w, wd);
+	if(entry != NULL)
+	{
+		if(replace_string(&entry->path, path) != 0)
+		{
+			return 1;
+		}
+		entry->kept = 1;
+		return 0;
+	}
+
+	char *const path_copy = strdup(path);
+	if(path_copy == NULL)
+	{
+		(void)inotify_rm_watch(w->fd, wd);
+		return 1;
+	}
+
+	if(w->count == w->capacity)
+	{
+		const int capacity = MAX(w->capacity*2, 16);
+		entry_t *const entries = reallocarray(w->entries, capacity,
+				sizeof(*entries));
+		if(entries == NULL)
+		{
+			free(path_copy);
+			(void)inotify_rm_watch(w->fd, wd);
+			return 1;
+		}
+		w->entries = entries;
+		w->capacity = capacity;
+	}
+
+	/* Watch descriptors mostly grow, so this usually appends. */
+	const int pos = lower_bound(w, wd);
+	memmove(&w->entries[pos + 1], &w->entries[pos],
+			sizeof(*w->entries)*(w->count - pos));
+	++w->count;
+
+	entry = &w->entries[pos];
+	entry->wd = wd;
+	entry->path = path_copy;
+	entry->modified = 0;
+	entry->changed = 0;
+	entry->kept = 1;
+	return 0;
+}
+
+void
+dirwatch_begin_update(dirwatch_t *w)
+{
+	int i;
+	for(i = 0; i < w->count; ++i)
+	{
+		w->entries[i].kept = 0;
+	}
+}
+
+void
+dirwatch_end_update(dirwatch_t *w)
+{
+	int i, j = 0;
+	for(i = 0; i < w->count; ++i)
+	{
+		entry_t *const entry = &w->entries[i];
+		if(!entry->kept)
+		{
+			/* IN_IGNORED event that follows is skipped as the entry is gone. */
+			(void)inotify_rm_watch(w->fd, entry->wd);
+			clear_modified(w, entry);
+			free(entry->path);
+			continue;
+		}
+
+		w->entries[j++] = *entry;
+	}
+	w->count = j;
+}
+
+int
+dirwatch_count(const dirwatch_t *w)
+{
+	return w->count;
+}
+
+int
+dirwatch_poll(dirwatch_t *w, char ***paths)
+{
+	enum { MAX_READS = 100 };
+	enum { BUF_LEN = (10 * (sizeof(struct inotify_event) + NAME_MAX + 1)) };
+
+	*paths = NULL;
+
+	const long long now = time_in_ms();
+	int *changed = NULL;
+	int nchanged = 0;
+	int lost = 0;
+	int nreads = 0;
+
+	char buf[BUF_LEN];
+	int nread;
+	do
+	{
+		nread = read(w->fd, buf, BUF_LEN);
+		if(nread < 0)
+		{
+			lost |= (errno != EAGAIN);
+			break;
+		}
+
+		char *p;
+		struct inotify_event *e;
+		for(p = buf; p < buf + nread; p += sizeof(struct inotify_event) + e->len)
+		{
+			e = (struct inotify_event *)p;
+
+			if(e->mask & IN_Q_OVERFLOW)
+			{
+				lost = 1;
+				continue;
+			}
+
+			entry_t *const entry = find_entry(w, e->wd);
+			if(entry == NULL)
+			{
+				continue;
+			}
+
+			if(e->mask & IN_IGNORED)
+			{
+				/* Directory is gone, its parent will report this. */
+				drop_watch(w, entry);
+				continue;
+			}
+
+			if(lost)
+			{
+				continue;
+			}
+
+			if(e->mask & LIST_EVENTS)
+			{
+				add_changed(entry, &changed, &nchanged);
+			}
+			else if((e->mask & IN_MODIFY) && entry->modified == 0)
+			{
+				/* Files that are being written produce a stream of events, report
+				 * them after a delay to not process the directory on every one. */
+				entry->modified = now;
+				++w->nmodified;
+			}
+		}
+
+		/* Limit maximum number of reads to ensure that we won't spend all our time
+		 * in this loop. */
+		if(++nreads > MAX_READS)
+		{
+			break;
+		}
+	}
+	while(nread != 0);
+
+	if(lost)
+	{
+		free(changed);
+		return list_all(w, paths);
+	}
+
+	int count = 0;
+	int i;
+	for(i = 0; i < nchanged; ++i)
+	{
+		/* Directory could have been dropped after the change. */
+		entry_t *const entry = find_entry(w, changed[i]);
+		if(entry != NULL)
+		{
+			count = report(w, entry, paths, count);
+			entry->changed = 0;
+		}
+	}
+	free(changed);
+
+	for(i = 0; i < w->count && w->nmodified != 0; ++i)
+	{
+		entry_t *const entry = &w->entries[i];
+		if(entry->modified != 0 && now - entry->modified >= w->modify_delay)
+		{
+			count = report(w, entry, paths, count);
+		}
+	}
+
+	return count;
+}
+
+/* Looks up watched directory by its watch descriptor.  Returns the entry or
+ * NULL. */
+static entry_t *
+find_entry(dirwatch_t *w, int wd)
+{
+	const int pos = lower_bound(w, wd);
+	return (pos < w->count && w->entries[pos].wd == wd) ? &w->entries[pos]
+	                                                     : NULL;
+}
+
+/* Finds position of the first entry whose watch descriptor isn't less than the
+ * specified one.  Returns the position, which is count if there is no such
+ * entry. */
+static int
+lower_bound(const dirwatch_t *w, int wd)
+{
+	int l = 0, r = w->count;
+	while(l < r)
+	{
+		const int m = l + (r - l)/2;
+		if(w->entries[m].wd < wd)
+		{
+			l = m + 1;
+		}
+		else
+		{
+			r = m;
+		}
+	}
+	return l;
+}
+
+/* Remembers that a directory is to be reported by current poll. */
+static void
+add_changed(entry_t *entry, int *wds[], int *nwds)
+{
+	if(entry->changed)
+	{
+		return;
+	}
+
+	int *const new_wds = reallocarray(*wds, *nwds + 1, sizeof(**wds));
+	if(new_wds != NULL)
+	{
+		*wds = new_wds;
+		(*wds)[(*nwds)++] = entry->wd;
+		entry->changed = 1;
+	}
+}
+
+/* Resets pending modification of a directory. */
+static void
+clear_modified(dirwatch_t *w, entry_t *entry)
+{
+	if(entry->modified != 0)
+	{
+		entry->modified = 0;
+		--w->nmodified;
+	}
+}
+
+/* Appends path of a directory to the list and resets its pending
+ * modification, which is covered by this report.  Returns new length of the
+ * list. */
+static int
+report(dirwatch_t *w, entry_t *entry, char ***paths, int count)
+{
+	clear_modified(w, entry);
+	return add_to_string_array(paths, count, entry->path);
+}
+
+/* Forgets about a watched directory.  Invalidates pointers to entries. */
+static void
+drop_watch(dirwatch_t *w, entry_t *entry)
+{
+	clear_modified(w, entry);
+	free(entry->path);
+
+	const int pos = entry - w->entries;
+	memmove(entry, entry + 1, sizeof(*entry)*(w->count - 1 - pos));
+	--w->count;
+}
+
+/* Lists all watched paths.  Returns number of elements in *paths. */
+static int
+list_all(dirwatch_t *w, char ***paths)
+{
+	int count = 0;
+	int i;
+
+	*paths = NULL;
+	for(i = 0; i < w->count; ++i)
+	{
+		entry_t *const entry = &w->entries[i];
+		entry->changed = 0;
+		count = report(w, entry, paths, count);
+	}
+	return count;
+}
+
+#else
+
+dirwatch_t *
+dirwatch_create(int modify_delay)
+{
+	return NULL;
+}
+
+void
+dirwatch_free(dirwatch_t *w)
+{
+}
+
+int
+dirwatch_add(dirwatch_t *w, const char path[])
+{
+	return 1;
+}
+
+void
+dirwatch_begin_update(dirwatch_t *w)
+{
+}
+
+void
+dirwatch_end_update(dirwatch_t *w)
+{
+}
+
+int
+dirwatch_count(const dirwatch_t *w)
+{
+	return 0;
+}
+
+int
+dirwatch_poll(dirwatch_t *w, char ***paths)
+{
+	*paths = NULL;
+	return 0;
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,62 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__DIRWATCH_H__
+#define VIFM__UTILS__DIRWATCH_H__
+
+/* Watcher of a set of directories that reports which of them had their
+ * contents changed (entries added, removed, renamed or written to).  Unlike
+ * fswatch, a single watcher handles many directories.  Writes to files are
+ * reported with a delay to coalesce them.  Available only with inotify. */
+
+/* Opaque type of a watcher. */
+typedef struct dirwatch_t dirwatch_t;
+
+/* Creates an empty watcher.  Directory in which a file was written to is
+ * reported modify_delay milliseconds after the first write, changes of list of
+ * entries are reported immediately.  Returns the watcher or NULL if watching
+ * isn't supported or on error. */
+dirwatch_t * dirwatch_create(int modify_delay);
+
+/* Frees a watcher.  w can be NULL. */
+void dirwatch_free(dirwatch_t *w);
+
+/* Starts watching a directory.  Returns zero on success, otherwise non-zero is
+ * returned. */
+int dirwatch_add(dirwatch_t *w, const char path[]);
+
+/* Starts replacing set of watched directories.  Directories that are added
+ * before dirwatch_end_update() keep their watches and pending changes. */
+void dirwatch_begin_update(dirwatch_t *w);
+
+/* Stops watching directories that weren't added since
+ * dirwatch_begin_update(). */
+void dirwatch_end_update(dirwatch_t *w);
+
+/* Retrieves number of watched directories.  Returns the number. */
+int dirwatch_count(const dirwatch_t *w);
+
+/* Lists directories changed since the last call, each one once.  All watched
+ * directories are listed if some events were lost.  *paths should be freed
+ * with free_string_array().  Returns number of elements in *paths. */
+int dirwatch_poll(dirwatch_t *w, char ***paths);
+
+#endif /* VIFM__UTILS__DIRWATCH_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
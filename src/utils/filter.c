@@ -22,21 +22,25 @@
 #include <sys/types.h> /* required for regex.h on FreeBSD 4.2 */
 #endif
 
-#include <regex.h> /* REG_EXTENDED REG_ICASE regex_t regfree() */
+#include <regex.h> /* REG_EXTENDED REG_ICASE */
 
 #include <assert.h> /* assert */
 #include <stddef.h> /* NULL */
 #include <stdlib.h> /* free() malloc() */
-#include <string.h> /* strdup() strlen() */
+#include <string.h> /* strdup() strlen() strpbrk() strstr() */
 
 #include "regexp.h"
 #include "str.h"
 
+/* Characters that have special meaning in regular expressions. */
+static const char *NEED_ESCAPING = "\\[](){}+*^$.?|";
+
 static int append_to_filter(filter_t *filter, const char value[]);
 static void reset_regex(filter_t *filter, const char value[]);
 static void free_regex(filter_t *filter);
 static void compile_regex(filter_t *filter, const char value[]);
 static char * escape_name_for_filter(const char string[]);
+static int is_literal(const char regex[]);
 
 int
 filter_init(filter_t *filter, int case_sensitive)
@@ -191,7 +195,7 @@ free_regex(filter_t *filter)
 {
 	if(filter->is_regex_valid)
 	{
-		regfree(&filter->regex);
+		regexp_dispose(&filter->regex);
 		filter->is_regex_valid = 0;
 	}
 }
@@ -203,8 +207,12 @@ compile_regex(filter_t *filter, const char value[])
 {
 	int comp_error;
 	assert(!filter->is_regex_valid && "Filter should have been freed.");
-	comp_error = regexp_compile(&filter->regex, value, filter->cflags);
+	comp_error = regexp_init(&filter->regex, value, filter->cflags);
 	filter->is_regex_valid = comp_error == 0;
+	if(!filter->is_regex_valid)
+	{
+		regexp_dispose(&filter->regex);
+	}
 }
 
 /* Escapes the string for the purpose of using it in filter.  Returns new
@@ -212,7 +220,6 @@ compile_regex(filter_t *filter, const char value[])
 static char *
 escape_name_for_filter(const char string[])
 {
-	static const char *NEED_ESCAPING = "\\[](){}+*^$.?|";
 	size_t len;
 	char *ret, *dup;
 
@@ -236,12 +243,40 @@ escape_name_for_filter(const char string[])
 	return ret;
 }
 
+int
+filter_narrows(const filter_t *filter, const char prev[],
+		int prev_case_sensitive)
+{
+	if(!filter->is_regex_valid || !is_literal(filter->raw) || !is_literal(prev))
+	{
+		return 0;
+	}
+
+	/* Case-insensitive matching can accept more strings. */
+	if(prev_case_sensitive && (filter->cflags & REG_ICASE))
+	{
+		return 0;
+	}
+
+	/* Matching isn't anchored, so a string containing the new pattern contains
+	 * all of its substrings. */
+	return strstr(filter->raw, prev) != NULL;
+}
+
+/* Checks whether regular expression consists only of literal characters.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_literal(const char regex[])
+{
+	return strpbrk(regex, NEED_ESCAPING) == NULL;
+}
+
 int
 filter_matches(const filter_t *filter, const char pattern[])
 {
 	if(filter->is_regex_valid)
 	{
-		return regexec(&filter->regex, pattern, 0, NULL, 0) == 0;
+		return regexp_exec(&filter->regex, pattern, 0, NULL) == 0;
 	}
 	else
 	{
@@ -21,7 +21,7 @@
 #ifndef VIFM__UTILS__FILTER_H__
 #define VIFM__UTILS__FILTER_H__
 
-#include <regex.h> /* regex_t */
+#include "regexp.h"
 
 /* Wrapper for a regular expression, its state and compiled form. */
 typedef struct
@@ -36,7 +36,7 @@ typedef struct
 	int cflags;
 
 	/* The expression in compiled form when is_regex_valid != 0. */
-	regex_t regex;
+	regexp_t regex;
 }
 filter_t;
 
@@ -72,6 +72,13 @@ int filter_change(filter_t *filter, const char value[], int case_sensitive);
  * returned. */
 int filter_append(filter_t *filter, const char value[]);
 
+/* Checks whether every string matched by the filter is also matched by a filter
+ * that had prev value and specified case sensitivity.  Only extensions of
+ * literal patterns are recognized.  Returns non-zero if so, otherwise zero is
+ * returned. */
+int filter_narrows(const filter_t *filter, const char prev[],
+		int prev_case_sensitive);
+
 /* Checks whether pattern matches the filter.  Returns positive number on match,
  * zero on no match and negative number on empty or invalid regular expression
  * (wrong state of the filter). */
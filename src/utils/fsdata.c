@@ -392,6 +392,29 @@ fsdata_traverse(fsdata_t *fsd, fsdata_traverser_func traverser, void *arg)
 	return 0;
 }
 
+int
+fsdata_traverse_under(fsdata_t *fsd, const char path[],
+		fsdata_traverser_func traverser, void *arg)
+{
+	if(fsd->root == NULL)
+	{
+		return 0;
+	}
+
+	node_t *const node = get_or_create_node(fsd->root, path, NO_CREATE, NULL,
+			NULL);
+	if(node == NULL)
+	{
+		return 0;
+	}
+
+	if(node == fsd->root)
+	{
+		return fsdata_traverse(fsd, traverser, arg);
+	}
+	return traverse_node(node, NULL, traverser, arg);
+}
+
 /* fsdata_traverse() helper which works with node_t type.  Return non-zero if
  * traversing was stopped prematurely, otherwise zero is returned. */
 static int
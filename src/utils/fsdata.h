@@ -63,6 +63,13 @@ int fsdata_map_parents(fsdata_t *fsd, const char path[],
  * prematurely, otherwise zero is returned. */
 int fsdata_traverse(fsdata_t *fsd, fsdata_traverser_func traverser, void *arg);
 
+/* Calls the callback for each node of the subtree at the path, which is
+ * reported as a root node.  The path isn't resolved, so it should be in the
+ * form in which paths are stored.  Return non-zero if traversing was stopped
+ * prematurely, otherwise zero is returned. */
+int fsdata_traverse_under(fsdata_t *fsd, const char path[],
+		fsdata_traverser_func traverser, void *arg);
+
 #endif /* VIFM__UTILS__FSDATA_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
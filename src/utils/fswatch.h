@@ -34,6 +34,14 @@ FSWatchState;
 /* Opaque type of a watcher. */
 typedef struct fswatch_t fswatch_t;
 
+/* Change of a single entry of a watched directory. */
+typedef struct
+{
+	char *name;  /* Name of the entry. */
+	int existed; /* Whether the entry existed before the first change. */
+}
+fswatch_change_t;
+
 /* Creates new watcher for the specified path.  Returns the watcher or NULL on
  * error. */
 fswatch_t * fswatch_create(const char path[]);
@@ -41,10 +49,25 @@ fswatch_t * fswatch_create(const char path[]);
 /* Frees a watcher.  w can be NULL. */
 void fswatch_free(fswatch_t *w);
 
+/* Checks whether watchers notice changes of files inside of a directory and
+ * not only changes of its list of files.  Returns non-zero if so, otherwise
+ * zero is returned. */
+int fswatch_tracks_files(void);
+
 /* Checks whether any changes were made to the entity being watched since last
  * query.  Returns latest state. */
 FSWatchState fswatch_poll(fswatch_t *w);
 
+/* Same as fswatch_poll(), but on FSWS_UPDATED also lists changed entries of
+ * the watched directory (each one once) in *changes.  *nchanges is set to -1 if
+ * set of changes is unknown (e.g., some events were lost or implementation
+ * doesn't provide this information).  Returns latest state. */
+FSWatchState fswatch_poll_changes(fswatch_t *w, fswatch_change_t **changes,
+		int *nchanges);
+
+/* Frees list of changes returned by fswatch_poll_changes(). */
+void fswatch_free_changes(fswatch_change_t changes[], int nchanges);
+
 #endif /* VIFM__UTILS__FSWATCH_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -29,24 +29,25 @@
 #include <errno.h> /* EAGAIN errno */
 #include <stddef.h> /* NULL */
 #include <stdint.h> /* uint32_t */
-#include <stdlib.h> /* free() */
-#include <string.h> /* strdup() */
+#include <stdlib.h> /* calloc() free() malloc() realloc() */
+#include <string.h> /* memcpy() strdup() */
 #include <time.h> /* time_t time() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "string_array.h"
 #include "trie.h"
 
-/* TODO: consider implementation that could reuse already available descriptor
- *       by just removing old watch and then adding a new one. */
+/* All watchers share single inotify instance, because number of instances per
+ * user is quite limited.  Events read from it are distributed among queues of
+ * watchers, which process them on polling. */
 
 /* Watcher data. */
 struct fswatch_t
 {
 	/* Path that's being watched. */
 	char *path;
-	/* File descriptor for inotify. */
-	int fd;
 	/* Watch descriptor. */
 	int wd;
 	/* Trie to keep track of per file frequency of notifications. */
@@ -54,6 +55,23 @@ struct fswatch_t
 	/* To monitor mount events, which aren't reported by inotify. */
 	dev_t dev;
 	ino_t inode;
+
+	/* Events that were read for this watcher, but weren't processed yet. */
+	char *queue;
+	size_t queue_len;
+	size_t queue_cap;
+	/* Whether some events of this watcher were lost. */
+	int overflow;
+
+	/* Names of files whose events were ignored because of a ban.  They are
+	 * reported along with the next change or when the ban is over. */
+	char **suppressed;
+	int nsuppressed;
+	/* Moment when all bans of suppressed files are over. */
+	time_t suppressed_until;
+
+	/* Next watcher in the list of all watchers. */
+	fswatch_t *next;
 };
 
 /* Per file statistics information. */
@@ -62,11 +80,34 @@ typedef struct
 	time_t last_update;  /* Time of the last change to the file. */
 	time_t banned_until; /* Moment until notifications should be ignored. */
 	uint32_t ban_mask;   /* Events right before the ban. */
+	int suppressed;      /* Whether the file is in the list of suppressed ones. */
 	int count;           /* How many times file changed continuously in the last
 	                        several seconds. */
 }
 notif_stat_t;
 
+/* Changes of directory entries collected while polling. */
+typedef struct
+{
+	fswatch_change_t *list; /* List of changed entries. */
+	int count;              /* Number of changes or -1 if they are unknown. */
+	int capacity;           /* Number of allocated elements of the list. */
+	trie_t *names;          /* Names of entries that are already listed. */
+}
+changes_t;
+
+static void release_fd(void);
+static int wd_is_used(int wd, const fswatch_t *except);
+static int read_events(void);
+static void queue_event(const struct inotify_event *e);
+static void enqueue(fswatch_t *w, const struct inotify_event *e);
+static void drop_queue(fswatch_t *w);
+static FSWatchState poll_events(fswatch_t *w, changes_t *changes);
+static void record_change(changes_t *changes, const struct inotify_event *e);
+static void record_name(changes_t *changes, const char name[], int existed);
+static void report_suppressed(fswatch_t *w, changes_t *changes);
+static void suppress(fswatch_t *w, const char name[], notif_stat_t *stats);
+static void forget_changes(changes_t *changes);
 static FSWatchState poll_for_replacement(fswatch_t *w);
 static int update_file_stats(fswatch_t *w, const struct inotify_event *e,
 		time_t now);
@@ -76,6 +117,11 @@ static const uint32_t EVENTS_MASK = IN_ATTRIB | IN_MODIFY | IN_CLOSE_WRITE
                                   | IN_CREATE | IN_DELETE | IN_EXCL_UNLINK
                                   | IN_MOVED_FROM | IN_MOVED_TO;
 
+/* inotify instance shared by all watchers or -1 if there are no watchers. */
+static int inotify_fd = -1;
+/* List of all existing watchers. */
+static fswatch_t *watchers;
+
 fswatch_t *
 fswatch_create(const char path[])
 {
@@ -85,7 +131,7 @@ fswatch_create(const char path[])
 		return NULL;
 	}
 
-	fswatch_t *const w = malloc(sizeof(*w));
+	fswatch_t *const w = calloc(1, sizeof(*w));
 	if(w == NULL)
 	{
 		return NULL;
@@ -103,25 +149,32 @@ fswatch_create(const char path[])
 		return NULL;
 	}
 
-	/* Create inotify instance. */
-	w->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
-	if(w->fd == -1)
+	/* Create inotify instance if there is none. */
+	if(inotify_fd == -1)
 	{
-		trie_free(w->stats);
-		free(w);
-		return NULL;
+		inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(inotify_fd == -1)
+		{
+			trie_free(w->stats);
+			free(w);
+			return NULL;
+		}
 	}
 
-	/* Add directory to watch. */
-	w->wd = inotify_add_watch(w->fd, path, EVENTS_MASK);
+	/* Add directory to watch.  Watching the same directory again yields the same
+	 * descriptor. */
+	w->wd = inotify_add_watch(inotify_fd, path, EVENTS_MASK);
 	if(w->wd == -1)
 	{
-		close(w->fd);
+		release_fd();
 		trie_free(w->stats);
 		free(w);
 		return NULL;
 	}
 
+	w->next = watchers;
+	watchers = w;
+
 	w->path = strdup(path);
 	if(w->path == NULL)
 	{
@@ -135,26 +188,110 @@ fswatch_create(const char path[])
 void
 fswatch_free(fswatch_t *w)
 {
-	if(w != NULL)
+	if(w == NULL)
 	{
-		free(w->path);
-		trie_free(w->stats);
-		close(w->fd);
-		free(w);
+		return;
+	}
+
+	fswatch_t **link = &watchers;
+	while(*link != w)
+	{
+		link = &(*link)->next;
+	}
+	*link = w->next;
+
+	if(!wd_is_used(w->wd, NULL))
+	{
+		(void)inotify_rm_watch(inotify_fd, w->wd);
+	}
+	release_fd();
+
+	free(w->path);
+	trie_free(w->stats);
+	free(w->queue);
+	free_string_array(w->suppressed, w->nsuppressed);
+	free(w);
+}
+
+/* Closes shared inotify instance if it's not used anymore. */
+static void
+release_fd(void)
+{
+	if(watchers == NULL && inotify_fd != -1)
+	{
+		close(inotify_fd);
+		inotify_fd = -1;
 	}
 }
 
+/* Checks whether watch descriptor is used by any watcher other than the
+ * specified one (can be NULL).  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+wd_is_used(int wd, const fswatch_t *except)
+{
+	const fswatch_t *w;
+	for(w = watchers; w != NULL; w = w->next)
+	{
+		if(w != except && w->wd == wd)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int
+fswatch_tracks_files(void)
+{
+	return 1;
+}
+
 FSWatchState
 fswatch_poll(fswatch_t *w)
+{
+	return poll_events(w, NULL);
+}
+
+FSWatchState
+fswatch_poll_changes(fswatch_t *w, fswatch_change_t **changes, int *nchanges)
+{
+	changes_t collected = {
+		.list = NULL,
+		.count = 0,
+		.capacity = 0,
+		.names = trie_create(NULL),
+	};
+	if(collected.names == NULL)
+	{
+		collected.count = -1;
+	}
+
+	const FSWatchState state = poll_events(w, &collected);
+	trie_free(collected.names);
+
+	if(state != FSWS_UPDATED)
+	{
+		forget_changes(&collected);
+		collected.count = 0;
+	}
+
+	*changes = collected.list;
+	*nchanges = collected.count;
+	return state;
+}
+
+/* Reads events from shared inotify instance distributing them among watchers.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+read_events(void)
 {
 	enum { MAX_READS = 100 };
 	enum { BUF_LEN = (10 * (sizeof(struct inotify_event) + NAME_MAX + 1)) };
 
 	char buf[BUF_LEN];
 	int nread;
-	int changed = 0;
 	int nreads = 0;
-	const time_t now = time(NULL);
 
 	do
 	{
@@ -162,29 +299,17 @@ fswatch_poll(fswatch_t *w)
 		struct inotify_event *e;
 
 		/* Receive a package of events. */
-		nread = read(w->fd, buf, BUF_LEN);
+		nread = read(inotify_fd, buf, BUF_LEN);
 		if(nread < 0)
 		{
-			if(errno != EAGAIN)
-			{
-				return FSWS_ERRORED;
-			}
-			break;
+			return (errno != EAGAIN);
 		}
 
-		/* And process each of them separately. */
+		/* And dispatch each of them separately. */
 		for(p = buf; p < buf + nread; p += sizeof(struct inotify_event) + e->len)
 		{
 			e = (struct inotify_event *)p;
-			if((e->mask & IN_IGNORED) != 0 && e->wd == w->wd)
-			{
-				return poll_for_replacement(w);
-			}
-
-			if((e->mask & EVENTS_MASK) != 0 && update_file_stats(w, e, now))
-			{
-				changed = 1;
-			}
+			queue_event(e);
 		}
 
 		/* Limit maximum number of reads to ensure that we won't spend all our time
@@ -196,9 +321,253 @@ fswatch_poll(fswatch_t *w)
 	}
 	while(nread != 0);
 
+	return 0;
+}
+
+/* Puts event into queues of watchers it's addressed to. */
+static void
+queue_event(const struct inotify_event *e)
+{
+	fswatch_t *w;
+	for(w = watchers; w != NULL; w = w->next)
+	{
+		if(e->mask & IN_Q_OVERFLOW)
+		{
+			/* Some events were lost, so we know only that something changed. */
+			drop_queue(w);
+			w->overflow = 1;
+		}
+		else if(e->wd == w->wd && !w->overflow)
+		{
+			enqueue(w, e);
+		}
+	}
+}
+
+/* Appends event to the queue of a watcher. */
+static void
+enqueue(fswatch_t *w, const struct inotify_event *e)
+{
+	/* Queue of a watcher that isn't polled for a long time shouldn't take up too
+	 * much memory.  This is about the size of default queue of the kernel. */
+	enum { MAX_QUEUE_LEN = 512*1024 };
+
+	const size_t size = sizeof(*e) + e->len;
+
+	if(w->queue_len + size > w->queue_cap)
+	{
+		size_t new_cap = (w->queue_cap == 0U) ? 4096U : w->queue_cap*2U;
+		while(new_cap < w->queue_len + size)
+		{
+			new_cap *= 2U;
+		}
+
+		char *const queue = (new_cap > MAX_QUEUE_LEN)
+		                  ? NULL
+		                  : realloc(w->queue, new_cap);
+		if(queue == NULL)
+		{
+			drop_queue(w);
+			w->overflow = 1;
+			return;
+		}
+
+		w->queue = queue;
+		w->queue_cap = new_cap;
+	}
+
+	memcpy(w->queue + w->queue_len, e, size);
+	w->queue_len += size;
+}
+
+/* Empties queue of a watcher freeing its memory. */
+static void
+drop_queue(fswatch_t *w)
+{
+	free(w->queue);
+	w->queue = NULL;
+	w->queue_len = 0U;
+	w->queue_cap = 0U;
+}
+
+/* Checks for changes of the watched directory optionally collecting changed
+ * entries (changes can be NULL).  Returns latest state. */
+static FSWatchState
+poll_events(fswatch_t *w, changes_t *changes)
+{
+	int changed = 0;
+	const time_t now = time(NULL);
+
+	if(read_events() != 0)
+	{
+		return FSWS_ERRORED;
+	}
+
+	if(w->overflow)
+	{
+		changed = 1;
+		forget_changes(changes);
+		w->overflow = 0;
+	}
+
+	const char *p;
+	const struct inotify_event *e;
+	for(p = w->queue; p < w->queue + w->queue_len;
+			p += sizeof(struct inotify_event) + e->len)
+	{
+		e = (const struct inotify_event *)p;
+		if(e->mask & IN_IGNORED)
+		{
+			drop_queue(w);
+			return poll_for_replacement(w);
+		}
+
+		if((e->mask & EVENTS_MASK) != 0 && update_file_stats(w, e, now))
+		{
+			changed = 1;
+			record_change(changes, e);
+		}
+	}
+	w->queue_len = 0U;
+
+	/* Suppressed changes are delayed, not lost, otherwise final state of a file
+	 * that was changing rapidly won't be picked up. */
+	if(w->nsuppressed != 0 && (changed || now >= w->suppressed_until))
+	{
+		changed = 1;
+		report_suppressed(w, changes);
+	}
+
 	return (changed ? FSWS_UPDATED : poll_for_replacement(w));
 }
 
+/* Adds entry an event is about to the list of changes unless it's already
+ * there. */
+static void
+record_change(changes_t *changes, const struct inotify_event *e)
+{
+	/* Don't let the list grow without bounds, rereading is cheaper at some
+	 * point. */
+	enum { MAX_CHANGES = 64*1024 };
+
+	if(changes == NULL || changes->count < 0)
+	{
+		return;
+	}
+
+	/* Change of the directory itself can affect all of its entries. */
+	if(e->len == 0U || changes->count == MAX_CHANGES)
+	{
+		forget_changes(changes);
+		return;
+	}
+
+	record_name(changes, e->name, (e->mask & (IN_CREATE | IN_MOVED_TO)) == 0);
+}
+
+/* Adds entry to the list of changes unless it's already there or the list is
+ * unknown (changes can be NULL). */
+static void
+record_name(changes_t *changes, const char name[], int existed)
+{
+	if(changes == NULL || changes->count < 0)
+	{
+		return;
+	}
+
+	void *data;
+	if(trie_get(changes->names, name, &data) == 0)
+	{
+		return;
+	}
+
+	if(changes->count == changes->capacity)
+	{
+		const int capacity = (changes->capacity == 0) ? 16 : changes->capacity*2;
+		fswatch_change_t *const list = reallocarray(changes->list, capacity,
+				sizeof(*list));
+		if(list == NULL)
+		{
+			forget_changes(changes);
+			return;
+		}
+		changes->list = list;
+		changes->capacity = capacity;
+	}
+
+	fswatch_change_t *const change = &changes->list[changes->count];
+	change->name = strdup(name);
+	change->existed = existed;
+	if(change->name == NULL || trie_put(changes->names, name) < 0)
+	{
+		free(change->name);
+		forget_changes(changes);
+		return;
+	}
+
+	++changes->count;
+}
+
+/* Moves names of suppressed files to the list of changes (can be NULL). */
+static void
+report_suppressed(fswatch_t *w, changes_t *changes)
+{
+	int i;
+	for(i = 0; i < w->nsuppressed; ++i)
+	{
+		void *data;
+		if(trie_get(w->stats, w->suppressed[i], &data) == 0)
+		{
+			notif_stat_t *const stats = data;
+			stats->suppressed = 0;
+		}
+
+		/* Such a file could have been removed after its events were suppressed,
+		 * in which case it's also in the list of changes already. */
+		record_name(changes, w->suppressed[i], /*existed=*/1);
+	}
+
+	free_string_array(w->suppressed, w->nsuppressed);
+	w->suppressed = NULL;
+	w->nsuppressed = 0;
+	w->suppressed_until = 0;
+}
+
+/* Remembers that events of a banned file were ignored. */
+static void
+suppress(fswatch_t *w, const char name[], notif_stat_t *stats)
+{
+	if(stats->banned_until > w->suppressed_until)
+	{
+		w->suppressed_until = stats->banned_until;
+	}
+
+	if(stats->suppressed)
+	{
+		return;
+	}
+
+	/* Failing to remember the name just means that the change is lost. */
+	const int len = add_to_string_array(&w->suppressed, w->nsuppressed, name);
+	if(len != w->nsuppressed)
+	{
+		w->nsuppressed = len;
+		stats->suppressed = 1;
+	}
+}
+
+/* Drops collected changes marking them as unknown. */
+static void
+forget_changes(changes_t *changes)
+{
+	if(changes != NULL && changes->count >= 0)
+	{
+		fswatch_free_changes(changes->list, changes->count);
+		changes->list = NULL;
+		changes->count = -1;
+	}
+}
+
 /* Detects replacement of path's target.  Returns watcher's state. */
 static FSWatchState
 poll_for_replacement(fswatch_t *w)
@@ -217,7 +586,7 @@ poll_for_replacement(fswatch_t *w)
 	w->dev = st.st_dev;
 	w->inode = st.st_ino;
 
-	int wd = inotify_add_watch(w->fd, w->path, EVENTS_MASK);
+	int wd = inotify_add_watch(inotify_fd, w->path, EVENTS_MASK);
 	if(wd == -1)
 	{
 		return FSWS_ERRORED;
@@ -225,8 +594,12 @@ poll_for_replacement(fswatch_t *w)
 
 	/* We ignore error from this call because input should always be correct from
 	 * our side, yet watch descriptor might have been killed by the kernel.  So
-	 * checking for an error causes false positives. */
-	(void)inotify_rm_watch(w->fd, w->wd);
+	 * checking for an error causes false positives.  Old descriptor can still be
+	 * needed by another watcher that didn't notice replacement yet. */
+	if(wd != w->wd && !wd_is_used(w->wd, w))
+	{
+		(void)inotify_rm_watch(inotify_fd, w->wd);
+	}
 
 	w->wd = wd;
 	return FSWS_REPLACED;
@@ -256,6 +629,7 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 		{
 			stats->last_update = now;
 			stats->banned_until = 0U;
+			stats->suppressed = 0;
 			stats->count = 1;
 			if(trie_set(w->stats, fname, stats) != 0)
 			{
@@ -278,6 +652,7 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 	/* Ignore events during banned period, unless it's something new. */
 	if(now < stats->banned_until && !(e->mask & ~stats->ban_mask))
 	{
+		suppress(w, fname, stats);
 		return 0;
 	}
 
@@ -346,6 +721,13 @@ fswatch_free(fswatch_t *w)
 	}
 }
 
+int
+fswatch_tracks_files(void)
+{
+	/* Modification time of a directory changes only with its list of files. */
+	return 0;
+}
+
 FSWatchState
 fswatch_poll(fswatch_t *w)
 {
@@ -362,7 +744,27 @@ fswatch_poll(fswatch_t *w)
 	return (changed ? FSWS_UPDATED : FSWS_UNCHANGED);
 }
 
+FSWatchState
+fswatch_poll_changes(fswatch_t *w, fswatch_change_t **changes, int *nchanges)
+{
+	/* Timestamp doesn't say what has changed. */
+	*changes = NULL;
+	*nchanges = -1;
+	return fswatch_poll(w);
+}
+
 #endif
 
+void
+fswatch_free_changes(fswatch_change_t changes[], int nchanges)
+{
+	int i;
+	for(i = 0; i < nchanges; ++i)
+	{
+		free(changes[i].name);
+	}
+	free(changes);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -86,6 +86,12 @@ fswatch_free(fswatch_t *w)
 	}
 }
 
+int
+fswatch_tracks_files(void)
+{
+	return 1;
+}
+
 FSWatchState
 fswatch_poll(fswatch_t *w)
 {
@@ -107,6 +113,26 @@ fswatch_poll(fswatch_t *w)
 	return (changed ? FSWS_UPDATED : FSWS_UNCHANGED);
 }
 
+FSWatchState
+fswatch_poll_changes(fswatch_t *w, fswatch_change_t **changes, int *nchanges)
+{
+	/* Change notifications don't say what has changed. */
+	*changes = NULL;
+	*nchanges = -1;
+	return fswatch_poll(w);
+}
+
+void
+fswatch_free_changes(fswatch_change_t changes[], int nchanges)
+{
+	int i;
+	for(i = 0; i < nchanges; ++i)
+	{
+		free(changes[i].name);
+	}
+	free(changes);
+}
+
 /* Gets last directory modification time.  Returns non-zero on error, otherwise
  * zero is returned. */
 static int
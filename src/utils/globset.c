@@ -0,0 +1,523 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "globset.h"
+
+#if(defined(BSD) && (BSD>=199103))
+#include <sys/types.h> /* required for regex.h on FreeBSD 4.2 */
+#endif
+
+#include <regex.h> /* REG_EXTENDED REG_ICASE regex_t regfree() regexec() */
+
+#include <ctype.h> /* tolower() */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memmove() strcasecmp() strcspn() strdup() strlen()
+                       strrchr() */
+
+#include "../compat/reallocarray.h"
+#include "globs.h"
+#include "regexp.h"
+#include "str.h"
+#include "string_array.h"
+
+/* Indexes of roots of the tries. */
+enum
+{
+	PREFIX_ROOT, /* Root of trie of literals and prefixes. */
+	SUFFIX_ROOT, /* Root of trie of reversed suffixes. */
+};
+
+/* Flags of trie nodes. */
+enum
+{
+	NODE_EXACT = 1 << 0,  /* A literal glob ends at this node. */
+	NODE_SUFFIX = 1 << 1, /* A "*suffix" glob ends at this node. */
+};
+
+/* Node of a trie. */
+typedef struct
+{
+	int child;           /* Index of the first child or -1. */
+	int sibling;         /* Index of the next sibling or -1. */
+	int tails;           /* Index of the first tail of "prefix*" globs or -1. */
+	unsigned char ch;    /* Lower-cased character that leads to this node. */
+	unsigned char flags; /* Combination of NODE_* flags. */
+}
+node_t;
+
+/* Part of "prefix*suffix" glob after the asterisk. */
+typedef struct
+{
+	char *suffix; /* Lower-cased suffix, can be empty. */
+	size_t len;   /* Length of the suffix. */
+	int next;     /* Index of the next tail of the same node or -1. */
+}
+tail_t;
+
+/* Set of globs. */
+struct globset_t
+{
+	node_t *nodes; /* Nodes of both tries. */
+	int nnodes;    /* Number of nodes. */
+
+	tail_t *tails; /* Tails of "prefix*suffix" globs. */
+	int ntails;    /* Number of tails. */
+
+	int has_regex; /* Whether regex field is initialized. */
+	regex_t regex; /* Combined expression for globs that aren't simple. */
+};
+
+static int add_glob(globset_t *set, const char glob[]);
+static int add_node(globset_t *set);
+static int insert(globset_t *set, int root, const char str[], size_t len,
+		int reversed);
+static int find_child(const globset_t *set, int node, int ch);
+static int append_glob(char **list, size_t *len, const char glob[]);
+static int match_prefixes(const globset_t *set, const char name[],
+		size_t len);
+static int match_suffixes(const globset_t *set, const char name[],
+		size_t len);
+static int add_key(strlist_t *list, const char key[], size_t len);
+
+globset_t *
+globset_compile(const char globs[], char **error)
+{
+	globset_t *const set = malloc(sizeof(*set));
+	if(set == NULL)
+	{
+		replace_string(error, "Failed to allocate memory for globs.");
+		return NULL;
+	}
+
+	set->nodes = NULL;
+	set->nnodes = 0;
+	set->tails = NULL;
+	set->ntails = 0;
+	set->has_regex = 0;
+
+	char *rest = NULL;
+	size_t rest_len = 0U;
+
+	char *globs_copy = strdup(globs);
+	int failed = (globs_copy == NULL || add_node(set) != PREFIX_ROOT ||
+			add_node(set) != SUFFIX_ROOT);
+
+	char *glob = globs_copy, *state = NULL;
+	while(!failed && (glob = split_and_get_dc(glob, &state)) != NULL)
+	{
+		failed = globset_is_simple(glob) ? add_glob(set, glob)
+		                                 : append_glob(&rest, &rest_len, glob);
+	}
+	free(globs_copy);
+
+	if(failed)
+	{
+		free(rest);
+		globset_free(set);
+		replace_string(error, "Failed to compile globs.");
+		return NULL;
+	}
+
+	if(rest != NULL)
+	{
+		char *const re = globs_to_regex(rest);
+		free(rest);
+		if(re == NULL)
+		{
+			globset_free(set);
+			replace_string(error, "Failed to convert globs into regexp.");
+			return NULL;
+		}
+
+		const int err = regexp_compile(&set->regex, re, REG_EXTENDED | REG_ICASE);
+		free(re);
+		if(err != 0)
+		{
+			replace_string(error, get_regexp_error(err, &set->regex));
+			regfree(&set->regex);
+			globset_free(set);
+			return NULL;
+		}
+		set->has_regex = 1;
+	}
+
+	return set;
+}
+
+/* Adds simple glob to tries of the set.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+add_glob(globset_t *set, const char glob[])
+{
+	const size_t len = strlen(glob);
+	const size_t pos = strcspn(glob, "*");
+
+	/* Literal with no special characters. */
+	if(pos == len)
+	{
+		const int node = insert(set, PREFIX_ROOT, glob, len, 0);
+		if(node < 0)
+		{
+			return 1;
+		}
+		set->nodes[node].flags |= NODE_EXACT;
+		return 0;
+	}
+
+	/* `*something` */
+	if(pos == 0)
+	{
+		const int node = insert(set, SUFFIX_ROOT, glob + 1, len - 1, 1);
+		if(node < 0)
+		{
+			return 1;
+		}
+		set->nodes[node].flags |= NODE_SUFFIX;
+		return 0;
+	}
+
+	/* Literal with one escaped asterisk. */
+	if(glob[pos - 1] == '\\')
+	{
+		char *const literal = format_str("%.*s%s", (int)(pos - 1), glob,
+				glob + pos);
+		const int node = (literal == NULL)
+		               ? -1
+		               : insert(set, PREFIX_ROOT, literal, len - 1, 0);
+		free(literal);
+		if(node < 0)
+		{
+			return 1;
+		}
+		set->nodes[node].flags |= NODE_EXACT;
+		return 0;
+	}
+
+	/* Either `something*` or `some*thing`. */
+	const int node = insert(set, PREFIX_ROOT, glob, pos, 0);
+	if(node < 0)
+	{
+		return 1;
+	}
+
+	tail_t *const tails = reallocarray(set->tails, set->ntails + 1,
+			sizeof(*tails));
+	if(tails == NULL)
+	{
+		return 1;
+	}
+	set->tails = tails;
+
+	tail_t *const tail = &tails[set->ntails];
+	tail->suffix = strdup(glob + pos + 1);
+	if(tail->suffix == NULL)
+	{
+		return 1;
+	}
+	tail->len = len - (pos + 1);
+
+	size_t i;
+	for(i = 0U; i < tail->len; ++i)
+	{
+		tail->suffix[i] = tolower((unsigned char)tail->suffix[i]);
+	}
+
+	tail->next = set->nodes[node].tails;
+	set->nodes[node].tails = set->ntails++;
+	return 0;
+}
+
+/* Appends a node to the set.  Returns index of the node or -1 on error. */
+static int
+add_node(globset_t *set)
+{
+	node_t *const nodes = reallocarray(set->nodes, set->nnodes + 1,
+			sizeof(*nodes));
+	if(nodes == NULL)
+	{
+		return -1;
+	}
+	set->nodes = nodes;
+
+	node_t *const node = &nodes[set->nnodes];
+	node->child = -1;
+	node->sibling = -1;
+	node->tails = -1;
+	node->ch = '\0';
+	node->flags = 0;
+	return set->nnodes++;
+}
+
+/* Inserts lower-cased string into a trie creating nodes as needed.  Returns
+ * index of the node at which the string ends or -1 on error. */
+static int
+insert(globset_t *set, int root, const char str[], size_t len, int reversed)
+{
+	int node = root;
+	size_t i;
+	for(i = 0U; i < len; ++i)
+	{
+		const int ch = tolower((unsigned char)str[reversed ? len - 1 - i : i]);
+
+		int child = find_child(set, node, ch);
+		if(child < 0)
+		{
+			child = add_node(set);
+			if(child < 0)
+			{
+				return -1;
+			}
+			set->nodes[child].ch = ch;
+			set->nodes[child].sibling = set->nodes[node].child;
+			set->nodes[node].child = child;
+		}
+		node = child;
+	}
+	return node;
+}
+
+/* Looks up child of a node by lower-cased character.  Returns index of the
+ * child or -1. */
+static int
+find_child(const globset_t *set, int node, int ch)
+{
+	int child;
+	for(child = set->nodes[node].child; child != -1;
+			child = set->nodes[child].sibling)
+	{
+		if(set->nodes[child].ch == ch)
+		{
+			break;
+		}
+	}
+	return child;
+}
+
+/* Appends glob to comma-separated list escaping commas in it.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+append_glob(char **list, size_t *len, const char glob[])
+{
+	if(*list != NULL && strappendch(list, len, ',') != 0)
+	{
+		return 1;
+	}
+
+	for(; *glob != '\0'; ++glob)
+	{
+		if(*glob == ',' && strappendch(list, len, ',') != 0)
+		{
+			return 1;
+		}
+		if(strappendch(list, len, *glob) != 0)
+		{
+			return 1;
+		}
+	}
+
+	/* Empty glob still needs to be added. */
+	return (*list == NULL ? strappend(list, len, "") : 0);
+}
+
+void
+globset_free(globset_t *set)
+{
+	if(set == NULL)
+	{
+		return;
+	}
+
+	int i;
+	for(i = 0; i < set->ntails; ++i)
+	{
+		free(set->tails[i].suffix);
+	}
+	free(set->tails);
+	free(set->nodes);
+
+	if(set->has_regex)
+	{
+		regfree(&set->regex);
+	}
+
+	free(set);
+}
+
+int
+globset_matches(const globset_t *set, const char name[])
+{
+	const size_t len = strlen(name);
+
+	if(match_prefixes(set, name, len) || match_suffixes(set, name, len))
+	{
+		return 1;
+	}
+
+	return set->has_regex && regexec(&set->regex, name, 0, NULL, 0) == 0;
+}
+
+/* Walks the trie of literals and prefixes checking for literal and prefix
+ * matches.  Returns non-zero on a match, otherwise zero is returned. */
+static int
+match_prefixes(const globset_t *set, const char name[], size_t len)
+{
+	int node = PREFIX_ROOT;
+	size_t i = 0U;
+	while(1)
+	{
+		int t;
+		for(t = set->nodes[node].tails; t != -1; t = set->tails[t].next)
+		{
+			const tail_t *const tail = &set->tails[t];
+			if(len - i >= tail->len &&
+					strcasecmp(name + (len - tail->len), tail->suffix) == 0)
+			{
+				return 1;
+			}
+		}
+
+		if(i == len)
+		{
+			return (set->nodes[node].flags & NODE_EXACT);
+		}
+
+		node = find_child(set, node, tolower((unsigned char)name[i++]));
+		if(node < 0)
+		{
+			return 0;
+		}
+	}
+}
+
+/* Walks the trie of reversed suffixes from the end of the name.  Leading
+ * asterisk matches at least one character, which isn't a leading dot.  Returns
+ * non-zero on a match, otherwise zero is returned. */
+static int
+match_suffixes(const globset_t *set, const char name[], size_t len)
+{
+	if(len == 0U || name[0] == '.')
+	{
+		return 0;
+	}
+
+	int node = SUFFIX_ROOT;
+	size_t i = len;
+	while(1)
+	{
+		if(set->nodes[node].flags & NODE_SUFFIX)
+		{
+			return 1;
+		}
+
+		if(i <= 1U)
+		{
+			return 0;
+		}
+
+		node = find_child(set, node, tolower((unsigned char)name[--i]));
+		if(node < 0)
+		{
+			return 0;
+		}
+	}
+}
+
+int
+globset_is_simple(const char glob[])
+{
+	const size_t pos = strcspn(glob, "[?*");
+	if(glob[pos] == '\0')
+	{
+		return 1;
+	}
+	return glob[pos] == '*'
+	    && glob[pos + 1 + strcspn(glob + pos + 1, "[?*")] == '\0';
+}
+
+int
+globset_get_keys(const char globs[], strlist_t *names, strlist_t *exts)
+{
+	char *const globs_copy = strdup(globs);
+	int failed = (globs_copy == NULL);
+
+	char *glob = globs_copy, *state = NULL;
+	while(!failed && (glob = split_and_get_dc(glob, &state)) != NULL)
+	{
+		if(!globset_is_simple(glob))
+		{
+			failed = 1;
+			break;
+		}
+
+		const size_t len = strlen(glob);
+		const size_t pos = strcspn(glob, "*");
+
+		/* Literal with no special characters. */
+		if(pos == len)
+		{
+			failed = add_key(names, glob, len);
+			continue;
+		}
+
+		/* Literal with one escaped asterisk. */
+		if(pos != 0U && glob[pos - 1] == '\\')
+		{
+			memmove(glob + pos - 1, glob + pos, len - pos + 1);
+			failed = add_key(names, glob, len - 1);
+			continue;
+		}
+
+		/* Names end with the suffix and its last dot is the last dot of a name. */
+		const char *const dot = strrchr(glob + pos + 1, '.');
+		failed = (dot == NULL) || add_key(exts, dot + 1, strlen(dot + 1));
+	}
+	free(globs_copy);
+
+	return failed;
+}
+
+/* Adds lower-cased copy of the key to the list.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+add_key(strlist_t *list, const char key[], size_t len)
+{
+	char *const lower = format_str("%.*s", (int)len, key);
+	if(lower == NULL)
+	{
+		return 1;
+	}
+
+	size_t i;
+	for(i = 0U; i < len; ++i)
+	{
+		lower[i] = tolower((unsigned char)lower[i]);
+	}
+
+	const int n = put_into_string_array(&list->items, list->nitems, lower);
+	if(n == list->nitems)
+	{
+		free(lower);
+		return 1;
+	}
+	list->nitems = n;
+	return 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
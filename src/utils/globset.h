@@ -0,0 +1,58 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__GLOBSET_H__
+#define VIFM__UTILS__GLOBSET_H__
+
+/* Compiled form of comma-separated list of globs that checks a name against all
+ * of them at once.  Literal globs, "*suffix", "prefix*" and "prefix*suffix"
+ * ones are looked up in a pair of tries (forward and reversed) and the rest are
+ * combined into a single regular expression.  Matching is case insensitive and
+ * semantics are those of globs.h. */
+
+struct strlist_t;
+
+/* Opaque type of a set of globs. */
+typedef struct globset_t globset_t;
+
+/* Compiles comma-separated list of globs (commas are escaped by doubling).
+ * Returns the set or NULL on error with *error describing it. */
+globset_t * globset_compile(const char globs[], char **error);
+
+/* Frees the set.  NULL argument is fine. */
+void globset_free(globset_t *set);
+
+/* Checks whether name is matched by at least one glob of the set.  Returns
+ * non-zero if so, otherwise zero is returned. */
+int globset_matches(const globset_t *set, const char name[]);
+
+/* Checks whether glob is handled by set without resorting to a regular
+ * expression.  Returns non-zero if so, otherwise zero is returned. */
+int globset_is_simple(const char glob[]);
+
+/* Collects lower-cased names and extensions (parts after the last dot) which
+ * names matched by comma-separated list of globs must have.  Returns zero on
+ * success, otherwise (when a glob doesn't restrict names this way or on error)
+ * non-zero is returned and the lists might contain some entries. */
+int globset_get_keys(const char globs[], struct strlist_t *names,
+		struct strlist_t *exts);
+
+#endif /* VIFM__UTILS__GLOBSET_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
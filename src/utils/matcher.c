@@ -18,14 +18,15 @@
 
 #include "matcher.h"
 
-#include <regex.h> /* regex_t regexec() regfree() */
+#include <regex.h> /* REG_EXTENDED REG_ICASE */
 
 #include <stddef.h> /* NULL */
 #include <stdlib.h> /* free() malloc() */
-#include <string.h> /* strcspn() strdup() strlen() strrchr() */
+#include <string.h> /* strdup() strlen() strrchr() */
 
 #include "../int/file_magic.h"
 #include "globs.h"
+#include "globset.h"
 #include "path.h"
 #include "regexp.h"
 #include "str.h"
@@ -52,7 +53,8 @@ struct matcher_t
 	unsigned int negated : 1;   /* Whether match is inverted. */
 	unsigned int fglobs : 1;    /* Whether this matcher is a special case of
 	                               globs ("faster" globs) that is optimized. */
-	regex_t regex; /* The expression in compiled form, unless matcher is empty. */
+	regexp_t regex;   /* Compiled expression of non-empty MT_REGEX matcher. */
+	globset_t *globs; /* Compiled globs of non-empty MT_GLOBS/MT_MIME matcher. */
 };
 
 static int is_full_path(const char expr[], int re, int glob, int *strip);
@@ -65,7 +67,6 @@ static int is_fglobs(char expr[]);
 static int parse_re(matcher_t *m, int strip, int cs_by_def,
 		const char on_empty_re[], char **error);
 static void free_matcher_items(matcher_t *matcher);
-static int fglobs_matches(const matcher_t *matcher, const char path[]);
 static int fglobs_includes(const matcher_t *matcher, const matcher_t *like);
 static int is_negated(const char **expr);
 static int is_re_expr(const char expr[], int allow_empty);
@@ -174,9 +175,9 @@ determine_type(const char expr[], int re, int glob, int glob_by_def, int *strip)
 	return glob_by_def ? MT_GLOBS : MT_REGEX;
 }
 
-/* Compiles m->raw into regular expression.  Also replaces global with
- * equivalent regexp.  Returns zero on success or non-zero on error with *error
- * containing description of it. */
+/* Compiles m->raw into regular expression or globs into a set of globs.  Also
+ * replaces globs with equivalent regexp.  Returns zero on success or non-zero
+ * on error with *error containing description of it. */
 static int
 compile_expr(matcher_t *m, int strip, int cs_by_def, const char on_empty_re[],
 		char **error)
@@ -200,17 +201,23 @@ compile_expr(matcher_t *m, int strip, int cs_by_def, const char on_empty_re[],
 			break;
 	}
 
-	if(m->fglobs || m->raw[0] == '\0')
+	if(m->raw[0] == '\0')
 	{
-		/* This is a faster glob or an empty matcher and we don't compile "". */
+		/* This is an empty matcher and we don't compile "". */
 		return 0;
 	}
 
-	err = regexp_compile(&m->regex, m->raw, m->cflags);
+	if(m->type != MT_REGEX)
+	{
+		m->globs = globset_compile(m->undec, error);
+		return (m->globs == NULL);
+	}
+
+	err = regexp_init(&m->regex, m->raw, m->cflags);
 	if(err != 0)
 	{
-		replace_string(error, get_regexp_error(err, &m->regex));
-		regfree(&m->regex);
+		replace_string(error, get_regexp_error(err, &m->regex.re));
+		regexp_dispose(&m->regex);
 		return 1;
 	}
 
@@ -271,17 +278,10 @@ is_fglobs(char expr[])
 	char *glob = expr, *state = NULL;
 	while((glob = split_and_get_dc(glob, &state)) != NULL)
 	{
-		const size_t pos = strcspn(glob, "[?*");
-		if(glob[pos] == '\0')
+		if(!globset_is_simple(glob))
 		{
-			continue;
-		}
-		if(glob[pos] == '*' &&
-				glob[pos + 1 + strcspn(glob + pos + 1, "[?*")] == '\0')
-		{
-			continue;
+			break;
 		}
-		break;
 	}
 
 	free(expr);
@@ -339,6 +339,7 @@ matcher_clone(const matcher_t *matcher)
 	}
 
 	*clone = *matcher;
+	clone->globs = NULL;
 	clone->expr = strdup(matcher->expr);
 	clone->raw = strdup(matcher->raw);
 	clone->undec = strdup(matcher->undec);
@@ -349,15 +350,28 @@ matcher_clone(const matcher_t *matcher)
 		return NULL;
 	}
 
-	/* Don't compile regex for faster globs or empty matcher. */
-	if(!clone->fglobs && clone->raw[0] != '\0')
+	/* Don't compile empty matcher. */
+	if(clone->raw[0] == '\0')
 	{
-		if(regexp_compile(&clone->regex, matcher->raw, matcher->cflags) != 0)
+		return clone;
+	}
+
+	if(clone->type != MT_REGEX)
+	{
+		char *error = NULL;
+		clone->globs = globset_compile(clone->undec, &error);
+		free(error);
+		if(clone->globs == NULL)
 		{
 			matcher_free(clone);
 			return NULL;
 		}
 	}
+	else if(regexp_init(&clone->regex, matcher->raw, matcher->cflags) != 0)
+	{
+		matcher_free(clone);
+		return NULL;
+	}
 
 	return clone;
 }
@@ -377,11 +391,13 @@ matcher_free(matcher_t *matcher)
 static void
 free_matcher_items(matcher_t *matcher)
 {
-	if(!matcher->fglobs && matcher->raw != NULL && !matcher_is_empty(matcher))
+	if(matcher->type == MT_REGEX && matcher->raw != NULL &&
+			!matcher_is_empty(matcher))
 	{
-		/* Regex is compiled only for non-empty matchers of unoptimized patterns. */
-		regfree(&matcher->regex);
+		/* Regex is compiled only for non-empty regular expression matchers. */
+		regexp_dispose(&matcher->regex);
 	}
+	globset_free(matcher->globs);
 	free(matcher->expr);
 	free(matcher->raw);
 	free(matcher->undec);
@@ -409,69 +425,12 @@ matcher_matches(const matcher_t *matcher, const char path[])
 		path = get_last_path_component(path);
 	}
 
-	if(matcher->fglobs)
+	if(matcher->type != MT_REGEX)
 	{
-		return fglobs_matches(matcher, path);
+		return globset_matches(matcher->globs, path)^matcher->negated;
 	}
 
-	return (regexec(&matcher->regex, path, 0, NULL, 0) == 0)^matcher->negated;
-}
-
-/* Checks whether given path/name is matched by a fglobs matcher.  Returns
- * non-zero if so, otherwise zero is returned. */
-static int
-fglobs_matches(const matcher_t *matcher, const char path[])
-{
-	char *globs = strdup(matcher->raw);
-	char *glob = globs, *state = NULL;
-	while((glob = split_and_get_dc(glob, &state)) != NULL)
-	{
-		const char *asterisk = until_first(glob, '*');
-
-		/* Literal with no special characters. */
-		if(*asterisk == '\0')
-		{
-			if(strcasecmp(path, glob) == 0)
-			{
-				break;
-			}
-			continue;
-		}
-
-		size_t pos = asterisk - glob;
-		/* `*something` */
-		if(pos == 0)
-		{
-			if(path[0] != '.' && ends_with_case(path + 1, glob + 1))
-			{
-				break;
-			}
-			continue;
-		}
-
-		/* Literal with one escaped asterisk. */
-		if(asterisk[-1] == '\\')
-		{
-			/* Compare parts around '\\' to ignore it. */
-			--pos;
-			if(strncasecmp(path, glob, pos) == 0 &&
-					strcasecmp(path + pos, glob + pos + 1) == 0)
-			{
-				break;
-			}
-			continue;
-		}
-
-		/* Either `something*` or `some*thing`.  First case work here by matching
-		 * its empty suffix. */
-		if(strncasecmp(path, glob, pos) == 0 &&
-				ends_with_case(path + pos, glob + pos + 1))
-		{
-			break;
-		}
-	}
-	free(globs);
-	return (glob != NULL)^matcher->negated;
+	return (regexp_exec(&matcher->regex, path, 0, NULL) == 0)^matcher->negated;
 }
 
 int
@@ -593,6 +552,24 @@ matcher_is_full_path(const matcher_t *matcher)
 	return matcher->full_path;
 }
 
+int
+matcher_is_mime(const matcher_t *matcher)
+{
+	return matcher->type == MT_MIME;
+}
+
+int
+matcher_get_keys(const matcher_t *matcher, struct strlist_t *names,
+		struct strlist_t *exts)
+{
+	if(matcher->type != MT_GLOBS || matcher->negated || matcher->full_path ||
+			!matcher->fglobs)
+	{
+		return 1;
+	}
+	return globset_get_keys(matcher->undec, names, exts);
+}
+
 TSTATIC int
 matcher_is_fast(const matcher_t *matcher)
 {
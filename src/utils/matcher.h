@@ -24,6 +24,8 @@
 
 #include "test_helpers.h"
 
+struct strlist_t;
+
 /* File path/name matcher (glob/regexp/mime-type). */
 
 /* Opaque matcher type. */
@@ -66,6 +68,17 @@ int matcher_includes(const matcher_t *matcher, const matcher_t *like);
  * otherwise zero is returned. */
 int matcher_is_full_path(const matcher_t *matcher);
 
+/* Checks whether given matcher matches mime types of files.  Returns non-zero
+ * if so, otherwise zero is returned. */
+int matcher_is_mime(const matcher_t *matcher);
+
+/* Collects lower-cased names and extensions (see globset_get_keys()) one of
+ * which a file name must have to be matched.  Returns zero on success and
+ * non-zero if matcher isn't a plain list of globs for file names or on
+ * error. */
+int matcher_get_keys(const matcher_t *matcher, struct strlist_t *names,
+		struct strlist_t *exts);
+
 TSTATIC_DEFS(
 	int matcher_is_fast(const matcher_t *matcher);
 )
@@ -232,6 +232,40 @@ matchers_includes(const matchers_t *matchers, const matchers_t *like)
 	return 1;
 }
 
+int
+matchers_get_keys(const matchers_t *matchers, strlist_t *names,
+		strlist_t *exts)
+{
+	int i;
+	for(i = 0; i < matchers->count; ++i)
+	{
+		strlist_t n = {}, e = {};
+		if(matcher_get_keys(matchers->list[i], &n, &e) == 0)
+		{
+			*names = n;
+			*exts = e;
+			return 0;
+		}
+		free_string_array(n.items, n.nitems);
+		free_string_array(e.items, e.nitems);
+	}
+	return 1;
+}
+
+int
+matchers_examine_contents(const matchers_t *matchers)
+{
+	int i;
+	for(i = 0; i < matchers->count; ++i)
+	{
+		if(matcher_is_mime(matchers->list[i]))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
 int
 matchers_is_expr(const char str[])
 {
@@ -21,6 +21,8 @@
 
 #include "test_helpers.h"
 
+struct strlist_t;
+
 /* Opaque matchers type. */
 typedef struct matchers_t matchers_t;
 
@@ -50,6 +52,15 @@ const char * matchers_get_expr(const matchers_t *matchers);
  * Returns non-zero if so, otherwise zero is returned. */
 int matchers_includes(const matchers_t *matchers, const matchers_t *like);
 
+/* Collects keys of one of the matchers as described by matcher_get_keys().
+ * Returns zero on success and non-zero if none of matchers provides keys. */
+int matchers_get_keys(const matchers_t *matchers, struct strlist_t *names,
+		struct strlist_t *exts);
+
+/* Checks whether any of the matchers examines contents of files instead of
+ * their paths.  Returns non-zero if so, otherwise zero is returned. */
+int matchers_examine_contents(const matchers_t *matchers);
+
 /* Checks whether given string is a list of match expressions.  Returns non-zero
  * if so, otherwise zero is returned. */
 int matchers_is_expr(const char str[]);
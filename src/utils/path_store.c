@@ -0,0 +1,417 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "path_store.h"
+
+#ifndef _WIN32
+#include <sys/mman.h> /* MAP_* PROT_* mmap() munmap() */
+#endif
+#include <sys/stat.h> /* fstat() stat */
+#include <fcntl.h> /* O_RDONLY open() */
+#include <unistd.h> /* close() read() */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint32_t uint64_t */
+#include <stdio.h> /* FILE fclose() fwrite() */
+#include <stdlib.h> /* free() malloc() qsort() */
+#include <string.h> /* memcmp() memcpy() memset() strlen() */
+
+#include "../compat/fs_limits.h"
+#include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "fs.h"
+#include "str.h"
+
+/* Identifies format of the file, the last byte is its version. */
+static const char MAGIC[8] = { 'V', 'I', 'F', 'M', 'P', 'S', 0, 1 };
+
+/* Value of empty hash table bucket. */
+#define NO_RECORD UINT32_MAX
+
+/* Beginning of the file. */
+typedef struct
+{
+	char magic[8];         /* Copy of MAGIC. */
+	uint32_t count;        /* Number of records. */
+	uint32_t nbuckets;     /* Size of hash table (a power of two). */
+	uint64_t strings_size; /* Size of area with paths in bytes. */
+}
+header_t;
+
+/* Record as it's stored in the file. */
+typedef struct
+{
+	uint64_t value;     /* Stored value. */
+	uint64_t inode;     /* Inode number. */
+	int64_t timestamp;  /* When the value was set. */
+	uint32_t path_off;  /* Offset of the path in the area of paths. */
+	uint32_t path_len;  /* Length of the path without trailing '\0'. */
+}
+file_rec_t;
+
+/* The file is a header followed by records, hash table of record indexes and
+ * null-terminated paths. */
+struct path_store_t
+{
+	const char *data;          /* Contents of the file. */
+	size_t size;               /* Size of the contents. */
+	int mapped;                /* Whether data is mapped rather than read. */
+	const header_t *header;    /* Header of the file. */
+	const file_rec_t *recs;    /* Array of records. */
+	const uint32_t *buckets;   /* Hash table. */
+	const char *strings;       /* Area of paths. */
+};
+
+/* Record to be written along with its path. */
+typedef struct
+{
+	const char *path;           /* Path of the record. */
+	const path_store_rec_t *rec; /* The record. */
+}
+entry_t;
+
+static int is_valid(const path_store_t *store);
+static const char * get_path(const path_store_t *store, const file_rec_t *rec);
+static uint64_t hash_path(const char path[], size_t len);
+static int newer_first(const void *a, const void *b);
+
+path_store_t *
+path_store_open(const char path[])
+{
+	const int fd = open(path, O_RDONLY);
+	if(fd == -1)
+	{
+		return NULL;
+	}
+
+	struct stat st;
+	path_store_t *store = malloc(sizeof(*store));
+	if(store == NULL || fstat(fd, &st) != 0 ||
+			(size_t)st.st_size < sizeof(header_t))
+	{
+		free(store);
+		close(fd);
+		return NULL;
+	}
+
+	store->size = st.st_size;
+	store->mapped = 0;
+	store->data = NULL;
+
+#ifndef _WIN32
+	void *const data = mmap(NULL, store->size, PROT_READ, MAP_SHARED, fd, 0);
+	if(data != MAP_FAILED)
+	{
+		store->data = data;
+		store->mapped = 1;
+	}
+#endif
+
+	if(store->data == NULL)
+	{
+		char *const data = malloc(store->size);
+		if(data != NULL && read(fd, data, store->size) == (ssize_t)store->size)
+		{
+			store->data = data;
+		}
+		else
+		{
+			free(data);
+		}
+	}
+
+	close(fd);
+
+	if(store->data == NULL)
+	{
+		free(store);
+		return NULL;
+	}
+
+	store->header = (const header_t *)store->data;
+	if(!is_valid(store))
+	{
+		path_store_close(store);
+		return NULL;
+	}
+
+	return store;
+}
+
+/* Checks that contents of the store are consistent and sets pointers to its
+ * parts.  Returns non-zero if so, otherwise zero is returned. */
+static int
+is_valid(const path_store_t *store)
+{
+	const header_t *const header = store->header;
+	if(memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0)
+	{
+		return 0;
+	}
+
+	if(header->nbuckets == 0U ||
+			(header->nbuckets & (header->nbuckets - 1U)) != 0U ||
+			header->count >= header->nbuckets)
+	{
+		return 0;
+	}
+
+	const uint64_t expected = sizeof(header_t)
+	                        + (uint64_t)header->count*sizeof(file_rec_t)
+	                        + (uint64_t)header->nbuckets*sizeof(uint32_t)
+	                        + header->strings_size;
+	if(expected != store->size)
+	{
+		return 0;
+	}
+
+	path_store_t *const s = (path_store_t *)store;
+	s->recs = (const file_rec_t *)(store->data + sizeof(header_t));
+	s->buckets = (const uint32_t *)(s->recs + header->count);
+	s->strings = (const char *)(s->buckets + header->nbuckets);
+	return 1;
+}
+
+void
+path_store_close(path_store_t *store)
+{
+	if(store == NULL)
+	{
+		return;
+	}
+
+#ifndef _WIN32
+	if(store->mapped)
+	{
+		munmap((void *)store->data, store->size);
+	}
+	else
+#endif
+	{
+		free((void *)store->data);
+	}
+	free(store);
+}
+
+int
+path_store_get(const path_store_t *store, const char path[],
+		path_store_rec_t *rec)
+{
+	if(store == NULL)
+	{
+		return 1;
+	}
+
+	const size_t len = strlen(path);
+	const uint32_t mask = store->header->nbuckets - 1U;
+	uint32_t i = hash_path(path, len) & mask;
+	uint32_t probes;
+	for(probes = 0U; probes <= mask; ++probes, i = (i + 1U) & mask)
+	{
+		const uint32_t idx = store->buckets[i];
+		if(idx == NO_RECORD || idx >= store->header->count)
+		{
+			break;
+		}
+
+		const file_rec_t *const frec = &store->recs[idx];
+		const char *const frec_path = get_path(store, frec);
+		if(frec->path_len == len && frec_path != NULL &&
+				memcmp(frec_path, path, len) == 0)
+		{
+			rec->value = frec->value;
+			rec->inode = frec->inode;
+			rec->timestamp = frec->timestamp;
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+int
+path_store_count(const path_store_t *store)
+{
+	return (store == NULL ? 0 : (int)store->header->count);
+}
+
+const char *
+path_store_at(const path_store_t *store, int idx, path_store_rec_t *rec)
+{
+	const file_rec_t *const frec = &store->recs[idx];
+	rec->value = frec->value;
+	rec->inode = frec->inode;
+	rec->timestamp = frec->timestamp;
+
+	const char *const path = get_path(store, frec);
+	return (path == NULL ? "" : path);
+}
+
+/* Retrieves path of a record checking that it's within the file.  Returns the
+ * path or NULL if record is broken. */
+static const char *
+get_path(const path_store_t *store, const file_rec_t *rec)
+{
+	const uint64_t end = (uint64_t)rec->path_off + rec->path_len;
+	if(end >= store->header->strings_size || store->strings[end] != '\0')
+	{
+		return NULL;
+	}
+	return &store->strings[rec->path_off];
+}
+
+int
+path_store_write(const char path[], const char *paths[],
+		const path_store_rec_t recs[], int count, int max_count)
+{
+	entry_t *const entries = reallocarray(NULL, count, sizeof(*entries));
+	if(entries == NULL && count != 0)
+	{
+		return 1;
+	}
+
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		entries[i].path = paths[i];
+		entries[i].rec = &recs[i];
+	}
+
+	if(count > max_count)
+	{
+		qsort(entries, count, sizeof(*entries), &newer_first);
+		count = MAX(max_count, 0);
+	}
+
+	uint32_t nbuckets = 16U;
+	while(nbuckets < (uint32_t)count*2U)
+	{
+		nbuckets *= 2U;
+	}
+
+	uint64_t strings_size = 0U;
+	for(i = 0; i < count; ++i)
+	{
+		strings_size += strlen(entries[i].path) + 1U;
+	}
+
+	file_rec_t *const frecs = reallocarray(NULL, count, sizeof(*frecs));
+	uint32_t *const buckets = reallocarray(NULL, nbuckets, sizeof(*buckets));
+	if((frecs == NULL && count != 0) || buckets == NULL ||
+			strings_size > UINT32_MAX)
+	{
+		free(frecs);
+		free(buckets);
+		free(entries);
+		return 1;
+	}
+
+	memset(buckets, 0xff, nbuckets*sizeof(*buckets));
+
+	uint32_t offset = 0U;
+	for(i = 0; i < count; ++i)
+	{
+		const size_t len = strlen(entries[i].path);
+
+		file_rec_t *const frec = &frecs[i];
+		memset(frec, 0, sizeof(*frec));
+		frec->value = entries[i].rec->value;
+		frec->inode = entries[i].rec->inode;
+		frec->timestamp = entries[i].rec->timestamp;
+		frec->path_off = offset;
+		frec->path_len = len;
+		offset += len + 1U;
+
+		uint32_t b = hash_path(entries[i].path, len) & (nbuckets - 1U);
+		while(buckets[b] != NO_RECORD)
+		{
+			b = (b + 1U) & (nbuckets - 1U);
+		}
+		buckets[b] = i;
+	}
+
+	header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.count = count;
+	header.nbuckets = nbuckets;
+	header.strings_size = strings_size;
+
+	char tmp_path[PATH_MAX + 16];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", path);
+	FILE *const fp = make_tmp_file(tmp_path, 0600, /*auto_delete=*/0);
+
+	int error = (fp == NULL);
+	if(!error)
+	{
+		error |= (fwrite(&header, sizeof(header), 1U, fp) != 1U);
+		error |= (count != 0 &&
+				fwrite(frecs, sizeof(*frecs), count, fp) != (size_t)count);
+		error |= (fwrite(buckets, sizeof(*buckets), nbuckets, fp) != nbuckets);
+		for(i = 0; i < count && !error; ++i)
+		{
+			const char *const p = entries[i].path;
+			error |= (fwrite(p, strlen(p) + 1U, 1U, fp) != 1U);
+		}
+		error |= (fclose(fp) != 0);
+
+		/* Replacing the file doesn't affect its copies mapped by other
+		 * instances. */
+		if(error || rename_file(tmp_path, path) != 0)
+		{
+			(void)remove(tmp_path);
+			error = 1;
+		}
+	}
+
+	free(frecs);
+	free(buckets);
+	free(entries);
+	return error;
+}
+
+/* Computes hash of the path (FNV-1a).  Returns the hash. */
+static uint64_t
+hash_path(const char path[], size_t len)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	size_t i;
+	for(i = 0U; i < len; ++i)
+	{
+		hash ^= (unsigned char)path[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+/* qsort() comparer that puts entries with newer timestamps first.  Returns
+ * standard -1, 0, 1 for comparisons. */
+static int
+newer_first(const void *a, const void *b)
+{
+	const entry_t *const x = a;
+	const entry_t *const y = b;
+	if(x->rec->timestamp == y->rec->timestamp)
+	{
+		return 0;
+	}
+	return (x->rec->timestamp > y->rec->timestamp ? -1 : 1);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
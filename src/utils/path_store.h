@@ -0,0 +1,73 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__PATH_STORE_H__
+#define VIFM__UTILS__PATH_STORE_H__
+
+#include <stdint.h> /* int64_t uint64_t */
+
+/* Read-only file that maps paths to fixed-size records.  The file is mapped
+ * into memory and contains a hash table, so opening it doesn't read it and
+ * lookups touch only a couple of pages.  The file is replaced as a whole on
+ * writing. */
+
+/* Record associated with a path. */
+typedef struct
+{
+	uint64_t value;    /* Stored value. */
+	uint64_t inode;    /* Inode number of the path. */
+	int64_t timestamp; /* When the value was set. */
+}
+path_store_rec_t;
+
+/* Opaque type of an opened file. */
+typedef struct path_store_t path_store_t;
+
+/* Opens file at the path.  Returns the store or NULL if file is missing or
+ * isn't a valid store. */
+path_store_t * path_store_open(const char path[]);
+
+/* Closes the store.  store can be NULL. */
+void path_store_close(path_store_t *store);
+
+/* Looks up record of the path.  store can be NULL, which is treated as an
+ * empty store.  Returns zero and fills *rec when found, otherwise non-zero is
+ * returned. */
+int path_store_get(const path_store_t *store, const char path[],
+		path_store_rec_t *rec);
+
+/* Retrieves number of records in the store.  store can be NULL.  Returns the
+ * number. */
+int path_store_count(const path_store_t *store);
+
+/* Retrieves path and record by their index, which must be in the range of
+ * [0; path_store_count()).  Returns the path, which is valid until the store
+ * is closed. */
+const char * path_store_at(const path_store_t *store, int idx,
+		path_store_rec_t *rec);
+
+/* Writes count records to a file at the path replacing it.  If count exceeds
+ * max_count, records with the oldest timestamps are dropped.  Returns zero on
+ * success, otherwise non-zero is returned. */
+int path_store_write(const char path[], const char *paths[],
+		const path_store_rec_t recs[], int count, int max_count);
+
+#endif /* VIFM__UTILS__PATH_STORE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
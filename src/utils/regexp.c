@@ -20,13 +20,25 @@
 
 #include <regex.h> /* regex_t regmatch_t regcomp() regerror() regexec() */
 
-#include <ctype.h> /* isdigit() */
+#include <ctype.h> /* isalnum() isdigit() */
 #include <stdlib.h> /* free() malloc() */
-#include <string.h> /* strlen() */
+#include <string.h> /* memcpy() memset() strchr() strlen() strncmp() strpbrk()
+                       strstr() */
 
 #include "../cfg/config.h"
 #include "str.h"
 
+static char * strip_case_flags(const char pattern[], int *cflags);
+static void extract_literal(regexp_t *re, const char pattern[], int cflags);
+static const char * skip_group(const char p[]);
+static const char * skip_bracket(const char p[]);
+static const char * skip_interval(const char p[]);
+static int is_quantifier(char c);
+static const char * find_literal(const regexp_t *re, const char str[]);
+static int literal_equals(const regexp_t *re, const char str[]);
+static int has_non_ascii(const char str[]);
+static int ascii_lower(int c);
+
 int
 get_regexp_cflags(const char pattern[])
 {
@@ -77,12 +89,29 @@ regexp_should_ignore_case(const char pattern[])
 int
 regexp_compile(regex_t *re, const char pattern[], int cflags)
 {
-	char *mod_pattern = malloc(strlen(pattern) + 1);
+	char *const mod_pattern = strip_case_flags(pattern, &cflags);
 	if(mod_pattern == NULL)
 	{
 		return REG_ESPACE;
 	}
 
+	int result = regcomp(re, mod_pattern, cflags);
+	free(mod_pattern);
+
+	return result;
+}
+
+/* Removes \c and \C sequences from the pattern updating *cflags accordingly.
+ * Returns newly allocated string or NULL on error. */
+static char *
+strip_case_flags(const char pattern[], int *cflags)
+{
+	char *mod_pattern = malloc(strlen(pattern) + 1);
+	if(mod_pattern == NULL)
+	{
+		return NULL;
+	}
+
 	char *p = mod_pattern;
 	const char *s = pattern;
 	while(s[0] != '\0')
@@ -91,13 +120,13 @@ regexp_compile(regex_t *re, const char pattern[], int cflags)
 		{
 			if(s[1] == 'c')
 			{
-				cflags |= REG_ICASE;
+				*cflags |= REG_ICASE;
 				s += 2;
 				continue;
 			}
 			else if(s[1] == 'C')
 			{
-				cflags &= ~REG_ICASE;
+				*cflags &= ~REG_ICASE;
 				s += 2;
 				continue;
 			}
@@ -109,12 +138,447 @@ regexp_compile(regex_t *re, const char pattern[], int cflags)
 	}
 	*p = '\0';
 
-	int result = regcomp(re, mod_pattern, cflags);
+	return mod_pattern;
+}
+
+int
+regexp_init(regexp_t *re, const char pattern[], int cflags)
+{
+	/* regfree() is fine with zeroed structure. */
+	memset(&re->re, 0, sizeof(re->re));
+	re->literal = NULL;
+	re->len = 0U;
+	re->icase = 0;
+	re->kind = RL_REQUIRED;
+
+	char *const mod_pattern = strip_case_flags(pattern, &cflags);
+	if(mod_pattern == NULL)
+	{
+		return REG_ESPACE;
+	}
+
+	const int result = regcomp(&re->re, mod_pattern, cflags);
+	if(result == 0)
+	{
+		extract_literal(re, mod_pattern, cflags);
+	}
 	free(mod_pattern);
 
 	return result;
 }
 
+/* Finds the longest sequence of literal characters that's a part of every
+ * match of extended regular expression and checks whether the expression
+ * consists only of it.  Expressions with alternatives at the top level aren't
+ * analyzed. */
+static void
+extract_literal(regexp_t *re, const char pattern[], int cflags)
+{
+	if(!(cflags & REG_EXTENDED))
+	{
+		return;
+	}
+
+	const int icase = ((cflags & REG_ICASE) != 0);
+	const size_t max_len = strlen(pattern);
+	char *const best = malloc(max_len + 1U);
+	char *const run = malloc(max_len + 1U);
+	if(best == NULL || run == NULL)
+	{
+		free(best);
+		free(run);
+		return;
+	}
+
+	size_t best_len = 0U, run_len = 0U;
+	int exact = 1, at_start = 0, at_end = 0;
+
+	const char *p = pattern;
+	if(*p == '^')
+	{
+		at_start = 1;
+		++p;
+	}
+
+	while(*p != '\0')
+	{
+		const char *atom = NULL;
+		size_t atom_len = 0U;
+
+		switch(*p)
+		{
+			case '|':
+			case ')':
+			case '*':
+			case '+':
+			case '?':
+			case '{':
+				/* Alternative or quantifier without an atom. */
+				goto give_up;
+
+			case '(':
+				p = skip_group(p);
+				break;
+			case '[':
+				p = skip_bracket(p);
+				break;
+
+			case '$':
+				if(p[1] == '\0')
+				{
+					at_end = 1;
+					++p;
+					continue;
+				}
+				++p;
+				break;
+			case '^':
+			case '.':
+				++p;
+				break;
+
+			case '\\':
+				if(p[1] == '\0' || (unsigned char)p[1] >= 0x80)
+				{
+					goto give_up;
+				}
+				/* Back-references and GNU extensions like \w or \<. */
+				if(!isalnum((unsigned char)p[1]) && strchr("<>`'", p[1]) == NULL)
+				{
+					atom = p + 1;
+					atom_len = 1U;
+				}
+				p += 2;
+				break;
+
+			default:
+				/* Multibyte character is a single atom. */
+				atom_len = 1U;
+				while(((unsigned char)p[atom_len] & 0xc0) == 0x80)
+				{
+					++atom_len;
+				}
+				/* Case folding of non-ASCII characters isn't done here. */
+				if(!icase || (unsigned char)*p < 0x80)
+				{
+					atom = p;
+				}
+				p += atom_len;
+				break;
+		}
+
+		if(p == NULL)
+		{
+			goto give_up;
+		}
+
+		/* Optional or repeated atom isn't a required part of a match. */
+		int quantified = 0;
+		while(is_quantifier(*p))
+		{
+			quantified = 1;
+			p = (*p == '{') ? skip_interval(p) : p + 1;
+			if(p == NULL)
+			{
+				goto give_up;
+			}
+		}
+
+		if(atom != NULL && !quantified)
+		{
+			memcpy(run + run_len, atom, atom_len);
+			run_len += atom_len;
+			continue;
+		}
+
+		exact = 0;
+		if(run_len > best_len)
+		{
+			memcpy(best, run, run_len);
+			best_len = run_len;
+		}
+		run_len = 0U;
+	}
+
+	if(run_len > best_len)
+	{
+		memcpy(best, run, run_len);
+		best_len = run_len;
+	}
+	free(run);
+
+	/* Empty literal that's not the whole expression is of no use. */
+	if(best_len == 0U && !exact)
+	{
+		free(best);
+		return;
+	}
+
+	best[best_len] = '\0';
+	re->literal = best;
+	re->len = best_len;
+	re->icase = icase;
+	if(!exact)
+	{
+		re->kind = RL_REQUIRED;
+	}
+	else if(at_start)
+	{
+		re->kind = (at_end ? RL_WHOLE : RL_PREFIX);
+	}
+	else
+	{
+		re->kind = (at_end ? RL_SUFFIX : RL_ANYWHERE);
+	}
+	return;
+
+give_up:
+	free(best);
+	free(run);
+}
+
+/* Skips parenthesized group including nested ones.  Returns pointer past the
+ * group or NULL if it's not terminated. */
+static const char *
+skip_group(const char p[])
+{
+	int depth = 0;
+	do
+	{
+		switch(*p)
+		{
+			case '\0':
+				return NULL;
+			case '\\':
+				if(*++p == '\0')
+				{
+					return NULL;
+				}
+				++p;
+				continue;
+			case '[':
+				p = skip_bracket(p);
+				if(p == NULL)
+				{
+					return NULL;
+				}
+				continue;
+			case '(':
+				++depth;
+				break;
+			case ')':
+				--depth;
+				break;
+		}
+		++p;
+	}
+	while(depth != 0);
+	return p;
+}
+
+/* Skips bracket expression.  Returns pointer past the expression or NULL if
+ * it's not terminated. */
+static const char *
+skip_bracket(const char p[])
+{
+	++p;
+	if(*p == '^')
+	{
+		++p;
+	}
+	/* Closing bracket is literal at the first position. */
+	if(*p == ']')
+	{
+		++p;
+	}
+
+	while(*p != ']')
+	{
+		if(*p == '\0')
+		{
+			return NULL;
+		}
+
+		/* Character classes, equivalence classes and collating symbols. */
+		if(p[0] == '[' && p[1] != '\0' && strchr(":=.", p[1]) != NULL)
+		{
+			const char end[] = { p[1], ']', '\0' };
+			const char *const close = strstr(p + 2, end);
+			if(close == NULL)
+			{
+				return NULL;
+			}
+			p = close + 2;
+			continue;
+		}
+
+		++p;
+	}
+	return p + 1;
+}
+
+/* Skips "{n}", "{n,}" and "{n,m}" intervals.  Returns pointer past the
+ * interval or NULL if it's malformed. */
+static const char *
+skip_interval(const char p[])
+{
+	++p;
+	while(isdigit((unsigned char)*p) || *p == ',')
+	{
+		++p;
+	}
+	return (*p == '}' ? p + 1 : NULL);
+}
+
+/* Checks whether character starts a quantifier of extended regular expression.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_quantifier(char c)
+{
+	return c == '*' || c == '+' || c == '?' || c == '{';
+}
+
+void
+regexp_dispose(regexp_t *re)
+{
+	regfree(&re->re);
+	free(re->literal);
+	re->literal = NULL;
+}
+
+int
+regexp_exec(const regexp_t *re, const char str[], size_t nmatch,
+		regmatch_t matches[])
+{
+	/* Non-ASCII characters can be equal to ASCII ones when case is ignored. */
+	if(re->literal == NULL || (re->icase && has_non_ascii(str)))
+	{
+		return regexec(&re->re, str, nmatch, matches, 0);
+	}
+
+	const size_t len = strlen(str);
+	size_t start;
+	switch(re->kind)
+	{
+		case RL_PREFIX:
+			if(len < re->len || !literal_equals(re, str))
+			{
+				return REG_NOMATCH;
+			}
+			start = 0U;
+			break;
+		case RL_SUFFIX:
+			if(len < re->len || !literal_equals(re, str + (len - re->len)))
+			{
+				return REG_NOMATCH;
+			}
+			start = len - re->len;
+			break;
+		case RL_WHOLE:
+			if(len != re->len || !literal_equals(re, str))
+			{
+				return REG_NOMATCH;
+			}
+			start = 0U;
+			break;
+
+		default:
+			{
+				const char *const found = find_literal(re, str);
+				if(found == NULL)
+				{
+					return REG_NOMATCH;
+				}
+				if(re->kind == RL_REQUIRED)
+				{
+					return regexec(&re->re, str, nmatch, matches, 0);
+				}
+				start = found - str;
+			}
+			break;
+	}
+
+	size_t i;
+	for(i = 0U; i < nmatch; ++i)
+	{
+		/* Literal expression has no subexpressions. */
+		matches[i].rm_so = (i == 0U ? (regoff_t)start : -1);
+		matches[i].rm_eo = (i == 0U ? (regoff_t)(start + re->len) : -1);
+	}
+	return 0;
+}
+
+/* Looks up the first occurrence of the literal in the string.  Returns pointer
+ * to it or NULL. */
+static const char *
+find_literal(const regexp_t *re, const char str[])
+{
+	if(!re->icase || re->len == 0U)
+	{
+		return strstr(str, re->literal);
+	}
+
+	/* Candidates are found by first character in either case. */
+	const char lower = ascii_lower(re->literal[0]);
+	const char upper = (lower >= 'a' && lower <= 'z') ? lower - 'a' + 'A' : lower;
+	const char first[] = { lower, upper, '\0' };
+
+	const char *p = str;
+	while((p = strpbrk(p, first)) != NULL)
+	{
+		if(literal_equals(re, p))
+		{
+			return p;
+		}
+		++p;
+	}
+	return NULL;
+}
+
+/* Checks whether the string starts with the literal.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+literal_equals(const regexp_t *re, const char str[])
+{
+	if(!re->icase)
+	{
+		return strncmp(str, re->literal, re->len) == 0;
+	}
+
+	size_t i;
+	for(i = 0U; i < re->len; ++i)
+	{
+		if(ascii_lower(str[i]) != ascii_lower(re->literal[i]))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Checks whether string contains any non-ASCII character.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+has_non_ascii(const char str[])
+{
+	for(; *str != '\0'; ++str)
+	{
+		if((unsigned char)*str >= 0x80)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Converts ASCII letter to lower case leaving other characters intact.
+ * Returns the result. */
+static int
+ascii_lower(int c)
+{
+	return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
 const char *
 get_regexp_error(int err, const regex_t *re)
 {
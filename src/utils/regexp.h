@@ -23,6 +23,32 @@
 
 #include <regex.h> /* regex_t regmatch_t */
 
+#include <stddef.h> /* size_t */
+
+/* Kinds of literals extracted from regular expressions. */
+typedef enum
+{
+	RL_REQUIRED, /* Literal is a part of every match. */
+	RL_ANYWHERE, /* Expression is the literal. */
+	RL_PREFIX,   /* Expression is the literal preceded by "^". */
+	RL_SUFFIX,   /* Expression is the literal followed by "$". */
+	RL_WHOLE,    /* Expression is the literal surrounded by "^" and "$". */
+}
+RegexpLiteral;
+
+/* Compiled regular expression along with a literal that every match must
+ * contain.  The literal rejects most strings without running the expression
+ * and expressions that are just literals aren't run at all. */
+typedef struct
+{
+	regex_t re;         /* Compiled expression. */
+	char *literal;      /* Literal of the expression or NULL. */
+	size_t len;         /* Length of the literal. */
+	int icase;          /* Whether literal is compared ignoring case. */
+	RegexpLiteral kind; /* How the literal relates to the expression. */
+}
+regexp_t;
+
 /* Gets flags for compiling a regular expression specified by the pattern taking
  * 'ignorecase' and 'smartcase' options into account.  Returns regex flags. */
 int get_regexp_cflags(const char pattern[]);
@@ -35,6 +61,19 @@ int regexp_should_ignore_case(const char pattern[]);
 /* Wrapper around regcomp() that handles \c and \C sequences. */
 int regexp_compile(regex_t *re, const char pattern[], int cflags);
 
+/* Same as regexp_compile(), but also extracts literal of the expression.  The
+ * structure should be disposed of even on error.  Returns zero on success,
+ * otherwise non-zero error code is returned. */
+int regexp_init(regexp_t *re, const char pattern[], int cflags);
+
+/* Frees resources of the expression initialized by regexp_init(). */
+void regexp_dispose(regexp_t *re);
+
+/* Equivalent of regexec() without flags for regexp_t.  Returns zero on match,
+ * otherwise REG_NOMATCH is returned. */
+int regexp_exec(const regexp_t *re, const char str[], size_t nmatch,
+		regmatch_t matches[]);
+
 /* Turns error code into error message.  Returns pointer to a statically
  * allocated buffer. */
 const char * get_regexp_error(int err, const regex_t *re);
@@ -0,0 +1,417 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "rule_index.h"
+
+#include <ctype.h> /* tolower() */
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* calloc() free() realloc() */
+#include <string.h> /* strrchr() */
+
+#include "../compat/reallocarray.h"
+#include "matchers.h"
+#include "path.h"
+#include "str.h"
+#include "string_array.h"
+#include "trie.h"
+
+/* Maximum number of paths whose results are remembered at the same time. */
+#define MEMO_LIMIT 8192
+
+/* List of rule numbers in increasing order. */
+typedef struct
+{
+	int *rules; /* Numbers of rules. */
+	int count;  /* Number of elements in the list. */
+}
+bucket_t;
+
+/* Index of rules. */
+struct rule_index_t
+{
+	const struct matchers_t **rules; /* Rules in their order. */
+	char *examine_contents;          /* Whether a rule looks at file contents. */
+	int count;                       /* Number of rules. */
+	int broken;                      /* Every rule is a candidate after OOM. */
+
+	trie_t *keys;    /* Maps "/name" and ".ext" keys onto buckets of rules. */
+	bucket_t others; /* Rules that aren't bound to any key. */
+
+	trie_t *memo;  /* Maps paths onto buckets of rules that match them. */
+	int memo_size; /* Number of entries in the memo. */
+
+	bucket_t found; /* Result of the last lookup. */
+};
+
+static int index_rule(rule_index_t *index, const struct matchers_t *matchers,
+		int rule);
+static int add_key(rule_index_t *index, char kind, const char key[], int rule);
+static void check_rule(rule_index_t *index, int rule, const char path[],
+		int *examine_contents);
+static int next_candidate(bucket_t *candidates[], int pos[], int count);
+static void remember(rule_index_t *index, const char path[]);
+static void forget(rule_index_t *index);
+static int bucket_add(bucket_t *bucket, int rule);
+static void free_bucket(void *ptr);
+
+rule_index_t *
+rule_index_alloc(void)
+{
+	rule_index_t *const index = calloc(1U, sizeof(*index));
+	if(index == NULL)
+	{
+		return NULL;
+	}
+
+	index->keys = trie_create(&free_bucket);
+	if(index->keys == NULL)
+	{
+		free(index);
+		return NULL;
+	}
+
+	return index;
+}
+
+void
+rule_index_free(rule_index_t *index)
+{
+	if(index == NULL)
+	{
+		return;
+	}
+
+	rule_index_reset(index);
+	trie_free(index->keys);
+	free(index->found.rules);
+	free(index);
+}
+
+void
+rule_index_reset(rule_index_t *index)
+{
+	forget(index);
+
+	free(index->rules);
+	index->rules = NULL;
+	free(index->examine_contents);
+	index->examine_contents = NULL;
+	index->count = 0;
+
+	trie_free(index->keys);
+	index->keys = trie_create(&free_bucket);
+	index->broken = (index->keys == NULL);
+
+	free(index->others.rules);
+	index->others.rules = NULL;
+	index->others.count = 0;
+}
+
+int
+rule_index_add(rule_index_t *index, const struct matchers_t *matchers)
+{
+	const struct matchers_t **const rules = reallocarray(index->rules,
+			index->count + 1, sizeof(*rules));
+	if(rules == NULL)
+	{
+		return 1;
+	}
+	index->rules = rules;
+
+	char *const examine_contents = realloc(index->examine_contents,
+			index->count + 1);
+	if(examine_contents == NULL)
+	{
+		return 1;
+	}
+	index->examine_contents = examine_contents;
+
+	const int rule = index->count++;
+	rules[rule] = matchers;
+	examine_contents[rule] = matchers_examine_contents(matchers);
+
+	if(!index->broken && index_rule(index, matchers, rule) != 0 &&
+			bucket_add(&index->others, rule) != 0)
+	{
+		index->broken = 1;
+	}
+
+	forget(index);
+	return 0;
+}
+
+/* Binds the rule to keys of its matchers.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+index_rule(rule_index_t *index, const struct matchers_t *matchers, int rule)
+{
+	strlist_t names = {}, exts = {};
+	int failed = matchers_get_keys(matchers, &names, &exts);
+
+	int i;
+	for(i = 0; i < names.nitems && !failed; ++i)
+	{
+		failed = add_key(index, '/', names.items[i], rule);
+	}
+	for(i = 0; i < exts.nitems && !failed; ++i)
+	{
+		failed = add_key(index, '.', exts.items[i], rule);
+	}
+
+	free_string_array(names.items, names.nitems);
+	free_string_array(exts.items, exts.nitems);
+	return failed;
+}
+
+/* Adds the rule to the bucket of the key creating the bucket if necessary.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+add_key(rule_index_t *index, char kind, const char key[], int rule)
+{
+	char *const full_key = format_str("%c%s", kind, key);
+	if(full_key == NULL)
+	{
+		return 1;
+	}
+
+	void *data;
+	bucket_t *bucket;
+	if(trie_get(index->keys, full_key, &data) == 0)
+	{
+		bucket = data;
+	}
+	else
+	{
+		bucket = calloc(1U, sizeof(*bucket));
+		if(bucket == NULL || trie_set(index->keys, full_key, bucket) < 0)
+		{
+			free(bucket);
+			free(full_key);
+			return 1;
+		}
+	}
+
+	free(full_key);
+	return bucket_add(bucket, rule);
+}
+
+const int *
+rule_index_find(rule_index_t *index, const char path[], int *count)
+{
+	void *data;
+	if(trie_get(index->memo, path, &data) == 0)
+	{
+		const bucket_t *const memo = data;
+		*count = memo->count;
+		return memo->rules;
+	}
+
+	index->found.count = 0;
+	int examine_contents = 0;
+
+	if(index->broken)
+	{
+		int rule;
+		for(rule = 0; rule < index->count; ++rule)
+		{
+			check_rule(index, rule, path, &examine_contents);
+		}
+	}
+	else
+	{
+		bucket_t *candidates[3] = { &index->others };
+		int pos[3] = { 0, 0, 0 };
+		int ncandidates = 1;
+
+		/* Keys are built in place: "/name" and ".ext" that's its tail. */
+		char *const key = format_str("/%s", get_last_path_component(path));
+		if(key != NULL)
+		{
+			char *p;
+			for(p = key + 1; *p != '\0'; ++p)
+			{
+				*p = tolower((unsigned char)*p);
+			}
+
+			if(trie_get(index->keys, key, &data) == 0)
+			{
+				candidates[ncandidates++] = data;
+			}
+
+			const char *const ext = strrchr(key + 1, '.');
+			if(ext != NULL && trie_get(index->keys, ext, &data) == 0)
+			{
+				candidates[ncandidates++] = data;
+			}
+			free(key);
+		}
+
+		int last = -1;
+		int rule;
+		while((rule = next_candidate(candidates, pos, ncandidates)) != -1)
+		{
+			/* A rule can be bound to both name and extension of the file. */
+			if(rule != last)
+			{
+				check_rule(index, rule, path, &examine_contents);
+				last = rule;
+			}
+		}
+	}
+
+	if(!examine_contents)
+	{
+		remember(index, path);
+	}
+
+	*count = index->found.count;
+	return index->found.rules;
+}
+
+/* Checks a single rule against the path and adds it to the result on
+ * a match. */
+static void
+check_rule(rule_index_t *index, int rule, const char path[],
+		int *examine_contents)
+{
+	if(index->examine_contents[rule])
+	{
+		*examine_contents = 1;
+	}
+
+	if(matchers_match(index->rules[rule], path) &&
+			bucket_add(&index->found, rule) != 0)
+	{
+		/* Incomplete result mustn't be remembered. */
+		*examine_contents = 1;
+	}
+}
+
+/* Merges buckets of candidates by picking the smallest of their next
+ * elements.  Returns number of a rule or -1 when all buckets are exhausted. */
+static int
+next_candidate(bucket_t *candidates[], int pos[], int count)
+{
+	int min = -1;
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		if(pos[i] < candidates[i]->count &&
+				(min == -1 || candidates[i]->rules[pos[i]] <
+				              candidates[min]->rules[pos[min]]))
+		{
+			min = i;
+		}
+	}
+
+	return (min == -1 ? -1 : candidates[min]->rules[pos[min]++]);
+}
+
+/* Stores copy of the last result of a lookup in the memo. */
+static void
+remember(rule_index_t *index, const char path[])
+{
+	if(path[0] == '\0')
+	{
+		return;
+	}
+
+	if(index->memo_size >= MEMO_LIMIT)
+	{
+		forget(index);
+	}
+
+	if(index->memo == NULL)
+	{
+		index->memo = trie_create(&free_bucket);
+		if(index->memo == NULL)
+		{
+			return;
+		}
+	}
+
+	bucket_t *const memo = calloc(1U, sizeof(*memo));
+	if(memo == NULL)
+	{
+		return;
+	}
+
+	int i;
+	for(i = 0; i < index->found.count; ++i)
+	{
+		if(bucket_add(memo, index->found.rules[i]) != 0)
+		{
+			free_bucket(memo);
+			return;
+		}
+	}
+
+	if(trie_set(index->memo, path, memo) < 0)
+	{
+		free_bucket(memo);
+		return;
+	}
+
+	++index->memo_size;
+}
+
+/* Drops all remembered results. */
+static void
+forget(rule_index_t *index)
+{
+	trie_free(index->memo);
+	index->memo = NULL;
+	index->memo_size = 0;
+}
+
+/* Appends rule to the bucket unless it's already the last one.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+bucket_add(bucket_t *bucket, int rule)
+{
+	if(bucket->count != 0 && bucket->rules[bucket->count - 1] == rule)
+	{
+		return 0;
+	}
+
+	int *const rules = reallocarray(bucket->rules, bucket->count + 1,
+			sizeof(*rules));
+	if(rules == NULL)
+	{
+		return 1;
+	}
+
+	bucket->rules = rules;
+	bucket->rules[bucket->count++] = rule;
+	return 0;
+}
+
+/* Frees a bucket.  NULL argument is fine. */
+static void
+free_bucket(void *ptr)
+{
+	bucket_t *const bucket = ptr;
+	if(bucket != NULL)
+	{
+		free(bucket->rules);
+		free(bucket);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,56 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__RULE_INDEX_H__
+#define VIFM__UTILS__RULE_INDEX_H__
+
+/* Index of an ordered list of rules (matchers) for looking up rules that match
+ * a file.  Rules which require a file to have a particular name or extension
+ * are checked only for such files, other rules are checked for every file.
+ * Results for paths whose rules don't examine contents of files are remembered
+ * until the list of rules changes. */
+
+struct matchers_t;
+
+/* Opaque type of the index. */
+typedef struct rule_index_t rule_index_t;
+
+/* Allocates an empty index.  Returns the index or NULL on error. */
+rule_index_t * rule_index_alloc(void);
+
+/* Frees the index.  NULL argument is fine. */
+void rule_index_free(rule_index_t *index);
+
+/* Removes all rules from the index. */
+void rule_index_reset(rule_index_t *index);
+
+/* Appends a rule to the index, its number is the number of rules added before
+ * it.  The matchers must live at least until the next reset of the index.
+ * Returns zero on success, otherwise non-zero is returned. */
+int rule_index_add(rule_index_t *index, const struct matchers_t *matchers);
+
+/* Looks up all rules that match the path.  Returns numbers of the rules in
+ * increasing order and sets *count to their number.  The array is valid until
+ * the next call of any function on this index. */
+const int * rule_index_find(rule_index_t *index, const char path[],
+		int *count);
+
+#endif /* VIFM__UTILS__RULE_INDEX_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
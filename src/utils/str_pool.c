@@ -0,0 +1,178 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "str_pool.h"
+
+#include <assert.h> /* assert() */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memcpy() strlen() */
+
+#include "macros.h"
+
+/* Size of storage of the first chunk.  Chunks grow from this size to
+ * CHUNK_SIZE to not waste memory on pools with few strings. */
+#define MIN_CHUNK_SIZE 1024U
+
+/* Size of storage of a regular chunk. */
+#define CHUNK_SIZE (64U*1024U)
+
+/* Single piece of storage, chunks form a list. */
+typedef struct chunk_t
+{
+	struct chunk_t *next; /* Previously allocated chunk or NULL. */
+	char data[];          /* Storage for the strings. */
+}
+chunk_t;
+
+/* Pool of strings. */
+struct str_pool_t
+{
+	chunk_t *chunks; /* List of chunks starting with the current one. */
+	size_t used;     /* Number of used bytes of the current chunk. */
+	size_t capacity; /* Size of storage of the current chunk. */
+	size_t size;     /* Number of bytes allocated for the pool. */
+	int refs;        /* Number of references to the pool. */
+};
+
+static chunk_t * add_chunk(str_pool_t *pool, size_t len);
+
+str_pool_t *
+str_pool_new(void)
+{
+	str_pool_t *const pool = malloc(sizeof(*pool));
+	if(pool == NULL)
+	{
+		return NULL;
+	}
+
+	pool->chunks = NULL;
+	pool->used = 0U;
+	pool->capacity = 0U;
+	pool->size = sizeof(*pool);
+	pool->refs = 1;
+	return pool;
+}
+
+void
+str_pool_ref(str_pool_t *pool)
+{
+	++pool->refs;
+}
+
+void
+str_pool_unref(str_pool_t *pool)
+{
+	if(pool == NULL)
+	{
+		return;
+	}
+
+	assert(pool->refs > 0 && "Too many references dropped.");
+	if(--pool->refs != 0)
+	{
+		return;
+	}
+
+	while(pool->chunks != NULL)
+	{
+		chunk_t *const next = pool->chunks->next;
+		free(pool->chunks);
+		pool->chunks = next;
+	}
+	free(pool);
+}
+
+char *
+str_pool_dup(str_pool_t *pool, const char str[])
+{
+	const size_t len = strlen(str) + 1U;
+
+	char *copy;
+	if(len > CHUNK_SIZE/4)
+	{
+		/* Big strings get chunks of their own to not waste space of the current
+		 * one. */
+		chunk_t *const chunk = malloc(sizeof(*chunk) + len);
+		if(chunk == NULL)
+		{
+			return NULL;
+		}
+		pool->size += sizeof(*chunk) + len;
+
+		if(pool->chunks == NULL)
+		{
+			chunk->next = NULL;
+			pool->chunks = chunk;
+		}
+		else
+		{
+			chunk->next = pool->chunks->next;
+			pool->chunks->next = chunk;
+		}
+		copy = chunk->data;
+	}
+	else
+	{
+		if(pool->used + len > pool->capacity && add_chunk(pool, len) == NULL)
+		{
+			return NULL;
+		}
+
+		copy = pool->chunks->data + pool->used;
+		pool->used += len;
+	}
+
+	memcpy(copy, str, len);
+	return copy;
+}
+
+size_t
+str_pool_size(const str_pool_t *pool)
+{
+	return pool->size;
+}
+
+/* Makes new chunk that can hold at least len bytes the current one.  Returns
+ * the chunk or NULL on error. */
+static chunk_t *
+add_chunk(str_pool_t *pool, size_t len)
+{
+	size_t capacity = MAX(pool->capacity*2U, MIN_CHUNK_SIZE);
+	while(capacity < len)
+	{
+		capacity *= 2U;
+	}
+	capacity = MIN(capacity, CHUNK_SIZE);
+
+	chunk_t *const chunk = malloc(sizeof(*chunk) + capacity);
+	if(chunk == NULL)
+	{
+		return NULL;
+	}
+
+	chunk->next = pool->chunks;
+	pool->chunks = chunk;
+	pool->used = 0U;
+	pool->capacity = capacity;
+	pool->size += sizeof(*chunk) + capacity;
+	return chunk;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
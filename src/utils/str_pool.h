@@ -0,0 +1,54 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__STR_POOL_H__
+#define VIFM__UTILS__STR_POOL_H__
+
+#include <stddef.h> /* size_t */
+
+/* Reference counted storage of strings which are allocated in big chunks and
+ * are freed all at once when the last reference to the pool is dropped.  Meant
+ * for large sets of short strings that share lifetime, like names of files of
+ * a single listing.  Not thread-safe. */
+
+/* Opaque type of a string pool. */
+typedef struct str_pool_t str_pool_t;
+
+/* Creates an empty pool with a single reference to it.  Returns the pool or
+ * NULL on error. */
+str_pool_t * str_pool_new(void);
+
+/* Adds one more reference to the pool. */
+void str_pool_ref(str_pool_t *pool);
+
+/* Drops one reference to the pool freeing it along with all of its strings if
+ * that was the last one.  pool can be NULL. */
+void str_pool_unref(str_pool_t *pool);
+
+/* Copies the string into the pool.  Returns pointer to the copy, which is
+ * valid until the pool is freed, or NULL on error. */
+char * str_pool_dup(str_pool_t *pool, const char str[]);
+
+/* Retrieves amount of memory taken up by the pool.  Returns the size in
+ * bytes. */
+size_t str_pool_size(const str_pool_t *pool);
+
+#endif /* VIFM__UTILS__STR_POOL_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
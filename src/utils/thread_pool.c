@@ -0,0 +1,261 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "thread_pool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h> /* _SC_NPROCESSORS_ONLN sysconf() */
+#endif
+
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* calloc() free() */
+
+#include "../compat/pthread.h"
+
+/* State of a thread pool. */
+struct thread_pool_t
+{
+	pthread_t *workers; /* Worker threads. */
+	int nworkers;       /* Number of worker threads. */
+
+	pthread_mutex_t run_lock; /* Serializes thread_pool_for() calls. */
+
+	pthread_mutex_t lock;   /* Protects fields below. */
+	pthread_cond_t work_cv; /* Signaled on new work and on shutdown. */
+	pthread_cond_t done_cv; /* Signaled when last chunk is processed. */
+
+	thread_pool_func func; /* Callback of current job. */
+	void *arg;             /* Argument of the callback. */
+	int count;             /* Number of items in current job. */
+	int chunk;             /* Maximum number of items in a chunk. */
+	int next;              /* First item that's not taken yet. */
+	int busy;              /* Number of chunks being processed right now. */
+	unsigned int job;      /* Sequential number of current job. */
+	int stop;              /* Whether workers should exit. */
+};
+
+static void * worker_main(void *arg);
+static int take_chunk(thread_pool_t *pool, int *from, int *to);
+static void finish_chunk(thread_pool_t *pool);
+
+thread_pool_t *
+thread_pool_new(int nworkers)
+{
+	thread_pool_t *const pool = calloc(1, sizeof(*pool));
+	if(pool == NULL)
+	{
+		return NULL;
+	}
+
+	if(nworkers <= 0)
+	{
+		nworkers = thread_pool_ncpus();
+	}
+
+	pool->workers = calloc(nworkers, sizeof(*pool->workers));
+	if(pool->workers == NULL)
+	{
+		free(pool);
+		return NULL;
+	}
+
+	pthread_mutex_init(&pool->run_lock, NULL);
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->work_cv, NULL);
+	pthread_cond_init(&pool->done_cv, NULL);
+
+	for(pool->nworkers = 0; pool->nworkers < nworkers; ++pool->nworkers)
+	{
+		if(pthread_create(&pool->workers[pool->nworkers], NULL, &worker_main,
+					pool) != 0)
+		{
+			break;
+		}
+	}
+
+	if(pool->nworkers == 0)
+	{
+		thread_pool_free(pool);
+		return NULL;
+	}
+
+	return pool;
+}
+
+void
+thread_pool_free(thread_pool_t *pool)
+{
+	if(pool == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->work_cv);
+	pthread_mutex_unlock(&pool->lock);
+
+	int i;
+	for(i = 0; i < pool->nworkers; ++i)
+	{
+		pthread_join(pool->workers[i], NULL);
+	}
+
+	pthread_cond_destroy(&pool->done_cv);
+	pthread_cond_destroy(&pool->work_cv);
+	pthread_mutex_destroy(&pool->lock);
+	pthread_mutex_destroy(&pool->run_lock);
+	free(pool->workers);
+	free(pool);
+}
+
+int
+thread_pool_size(const thread_pool_t *pool)
+{
+	return pool->nworkers;
+}
+
+void
+thread_pool_for(thread_pool_t *pool, int count, int chunk,
+		thread_pool_func func, void *arg)
+{
+	if(count <= 0)
+	{
+		return;
+	}
+	if(chunk <= 0)
+	{
+		chunk = 1;
+	}
+
+	pthread_mutex_lock(&pool->run_lock);
+
+	pthread_mutex_lock(&pool->lock);
+	pool->func = func;
+	pool->arg = arg;
+	pool->count = count;
+	pool->chunk = chunk;
+	pool->next = 0;
+	++pool->job;
+	pthread_cond_broadcast(&pool->work_cv);
+	pthread_mutex_unlock(&pool->lock);
+
+	/* Calling thread helps instead of just waiting. */
+	int from, to;
+	while(take_chunk(pool, &from, &to))
+	{
+		func(arg, from, to);
+		finish_chunk(pool);
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	while(pool->busy != 0)
+	{
+		pthread_cond_wait(&pool->done_cv, &pool->lock);
+	}
+	pool->func = NULL;
+	pool->arg = NULL;
+	pthread_mutex_unlock(&pool->lock);
+
+	pthread_mutex_unlock(&pool->run_lock);
+}
+
+int
+thread_pool_ncpus(void)
+{
+#ifndef _WIN32
+	const long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n > 0 ? (int)n : 1);
+#else
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1);
+#endif
+}
+
+/* Entry point of worker threads.  Returns NULL. */
+static void *
+worker_main(void *arg)
+{
+	thread_pool_t *const pool = arg;
+	unsigned int seen_job = 0U;
+
+	while(1)
+	{
+		pthread_mutex_lock(&pool->lock);
+		while(!pool->stop && pool->job == seen_job)
+		{
+			pthread_cond_wait(&pool->work_cv, &pool->lock);
+		}
+		if(pool->stop)
+		{
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		seen_job = pool->job;
+		pthread_mutex_unlock(&pool->lock);
+
+		int from, to;
+		while(take_chunk(pool, &from, &to))
+		{
+			pool->func(pool->arg, from, to);
+			finish_chunk(pool);
+		}
+	}
+
+	return NULL;
+}
+
+/* Reserves next chunk of current job.  Returns non-zero if *from and *to were
+ * set, otherwise zero is returned. */
+static int
+take_chunk(thread_pool_t *pool, int *from, int *to)
+{
+	int taken = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	if(pool->func != NULL && pool->next < pool->count)
+	{
+		*from = pool->next;
+		*to = (pool->count - *from > pool->chunk) ? *from + pool->chunk
+		                                          : pool->count;
+		pool->next = *to;
+		++pool->busy;
+		taken = 1;
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return taken;
+}
+
+/* Marks previously taken chunk as processed. */
+static void
+finish_chunk(thread_pool_t *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	if(--pool->busy == 0 && pool->next >= pool->count)
+	{
+		pthread_cond_broadcast(&pool->done_cv);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
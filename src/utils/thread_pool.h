@@ -0,0 +1,57 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__THREAD_POOL_H__
+#define VIFM__UTILS__THREAD_POOL_H__
+
+/* Fixed set of worker threads for processing arrays of independent items in
+ * parallel.  The thread that submits work participates in processing it and
+ * gets control back only after all items are processed. */
+
+/* Callback that processes items in the [from; to) range.  arg is the value
+ * passed to thread_pool_for(). */
+typedef void (*thread_pool_func)(void *arg, int from, int to);
+
+/* Opaque type of a thread pool. */
+typedef struct thread_pool_t thread_pool_t;
+
+/* Creates a pool with specified number of workers (non-positive value means
+ * number of online processors).  Returns the pool or NULL on error. */
+thread_pool_t * thread_pool_new(int nworkers);
+
+/* Stops workers and frees all resources.  pool can be NULL. */
+void thread_pool_free(thread_pool_t *pool);
+
+/* Retrieves number of workers of the pool.  Returns the number. */
+int thread_pool_size(const thread_pool_t *pool);
+
+/* Processes count items by calling func on ranges of at most chunk items from
+ * workers of the pool and the calling thread.  Blocks until all items are
+ * processed.  Calls from different threads are serialized, calling this from
+ * inside of func for the same pool results in a deadlock. */
+void thread_pool_for(thread_pool_t *pool, int count, int chunk,
+		thread_pool_func func, void *arg);
+
+/* Retrieves number of online processors.  Returns the number, which is at
+ * least one. */
+int thread_pool_ncpus(void);
+
+#endif /* VIFM__UTILS__THREAD_POOL_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,330 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "tree_walker.h"
+
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* strdup() */
+
+#include "../compat/pthread.h"
+#include "../compat/reallocarray.h"
+#include "fs.h"
+#include "str.h"
+#include "string_array.h"
+#include "thread_pool.h"
+#include "trie.h"
+
+/* Number of threads that read directories of a tree.  Trees are usually wide
+ * enough to give each of them a directory to read. */
+#define WALK_WORKERS 8
+
+/* Directory that's waiting to be read. */
+typedef struct
+{
+	char *path; /* Path to the directory. */
+	int depth;  /* Remaining depth. */
+}
+job_t;
+
+/* Results of a walk. */
+struct tree_walker_t
+{
+	trie_t *dirs; /* Maps paths to tree_walker_dir_t. */
+};
+
+/* State of a walk shared by all threads. */
+typedef struct
+{
+	tree_walker_t *walker;        /* Results. */
+	const tree_walker_cbs_t *cbs; /* Callbacks. */
+	pthread_t owner;              /* Thread that started the walk. */
+
+	pthread_mutex_t lock; /* Protects fields below and walker->dirs. */
+	pthread_cond_t cond;  /* Signaled on new jobs and on the end of the walk. */
+	job_t *jobs;          /* Stack of pending jobs. */
+	int njobs;            /* Number of pending jobs. */
+	int capacity;         /* Number of allocated jobs. */
+	int active;           /* Number of jobs that are being processed. */
+	int stop;             /* Whether the walk should be finished early. */
+}
+walk_t;
+
+static void walk_worker(void *arg, int from, int to);
+static int take_job(walk_t *walk, job_t *job);
+static void process_job(walk_t *walk, const job_t *job);
+static tree_walker_dir_t * read_dir(walk_t *walk, const job_t *job);
+static int push_job(walk_t *walk, char *path, int depth);
+static void free_dir(void *ptr);
+
+tree_walker_t *
+tree_walker_walk(const char root[], int depth, const tree_walker_cbs_t *cbs)
+{
+	tree_walker_t *walker = malloc(sizeof(*walker));
+	if(walker == NULL)
+	{
+		return NULL;
+	}
+
+	walker->dirs = trie_create(&free_dir);
+	if(walker->dirs == NULL)
+	{
+		free(walker);
+		return NULL;
+	}
+
+	thread_pool_t *const pool = thread_pool_new(WALK_WORKERS);
+
+	walk_t walk = {
+		.walker = walker,
+		.cbs = cbs,
+		.owner = pthread_self(),
+	};
+	pthread_mutex_init(&walk.lock, NULL);
+	pthread_cond_init(&walk.cond, NULL);
+
+	char *const path = strdup(root);
+	if(pool == NULL || path == NULL || push_job(&walk, path, depth) != 0)
+	{
+		free(path);
+		tree_walker_free(walker);
+		walker = NULL;
+	}
+	else
+	{
+		/* Each item is a worker that keeps taking jobs until there are none. */
+		thread_pool_for(pool, thread_pool_size(pool) + 1, 1, &walk_worker, &walk);
+	}
+
+	int i;
+	for(i = 0; i < walk.njobs; ++i)
+	{
+		free(walk.jobs[i].path);
+	}
+	free(walk.jobs);
+
+	pthread_cond_destroy(&walk.cond);
+	pthread_mutex_destroy(&walk.lock);
+	thread_pool_free(pool);
+	return walker;
+}
+
+const tree_walker_dir_t *
+tree_walker_get(const tree_walker_t *walker, const char path[])
+{
+	void *data;
+	if(walker == NULL || trie_get(walker->dirs, path, &data) != 0)
+	{
+		return NULL;
+	}
+	return data;
+}
+
+void
+tree_walker_free(tree_walker_t *walker)
+{
+	if(walker != NULL)
+	{
+		trie_free(walker->dirs);
+		free(walker);
+	}
+}
+
+/* thread_pool_for() callback that processes jobs until the walk is over. */
+static void
+walk_worker(void *arg, int from, int to)
+{
+	walk_t *const walk = arg;
+
+	job_t job;
+	while(take_job(walk, &job) == 0)
+	{
+		process_job(walk, &job);
+		free(job.path);
+
+		pthread_mutex_lock(&walk->lock);
+		--walk->active;
+		if(walk->active == 0 && walk->njobs == 0)
+		{
+			/* That was the last job, wake up everyone to let them finish. */
+			pthread_cond_broadcast(&walk->cond);
+		}
+		pthread_mutex_unlock(&walk->lock);
+
+		if(walk->cbs->progress != NULL &&
+				pthread_equal(pthread_self(), walk->owner))
+		{
+			walk->cbs->progress(walk->cbs->arg);
+		}
+	}
+}
+
+/* Waits for the next job.  Returns zero if *job was filled, otherwise non-zero
+ * is returned meaning that the walk is over. */
+static int
+take_job(walk_t *walk, job_t *job)
+{
+	pthread_mutex_lock(&walk->lock);
+	while(walk->njobs == 0 && walk->active != 0 && !walk->stop)
+	{
+		pthread_cond_wait(&walk->cond, &walk->lock);
+	}
+
+	const int done = (walk->njobs == 0 || walk->stop);
+	if(!done)
+	{
+		*job = walk->jobs[--walk->njobs];
+		++walk->active;
+	}
+	pthread_mutex_unlock(&walk->lock);
+
+	return done;
+}
+
+/* Reads directory of the job and schedules reading of its subdirectories. */
+static void
+process_job(walk_t *walk, const job_t *job)
+{
+	if(walk->cbs->cancelled(walk->cbs->arg))
+	{
+		pthread_mutex_lock(&walk->lock);
+		walk->stop = 1;
+		pthread_cond_broadcast(&walk->cond);
+		pthread_mutex_unlock(&walk->lock);
+		return;
+	}
+
+	tree_walker_dir_t *const dir = read_dir(walk, job);
+	if(dir == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&walk->lock);
+	const int failed = (trie_set(walk->walker->dirs, job->path, dir) < 0);
+	pthread_mutex_unlock(&walk->lock);
+
+	if(failed)
+	{
+		free_dir(dir);
+	}
+}
+
+/* Lists contents of a directory and queues its subdirectories that pass the
+ * filter.  Returns the contents or NULL on error. */
+static tree_walker_dir_t *
+read_dir(walk_t *walk, const job_t *job)
+{
+	int len;
+	char **names = list_all_files(job->path, &len);
+	if(len < 0)
+	{
+		return NULL;
+	}
+
+	tree_walker_dir_t *const dir = malloc(sizeof(*dir));
+	tree_walker_entry_t *const entries = reallocarray(NULL, len,
+			sizeof(*entries));
+	if(dir == NULL || (entries == NULL && len != 0))
+	{
+		free(dir);
+		free(entries);
+		free_string_array(names, len);
+		return NULL;
+	}
+
+	int i;
+	for(i = 0; i < len; ++i)
+	{
+		tree_walker_entry_t *const entry = &entries[i];
+		char *const full_path = format_str("%s/%s", job->path, names[i]);
+
+		entry->name = names[i];
+		entry->is_dir = (full_path != NULL && is_dir(full_path));
+		entry->real_dir = (entry->is_dir && !is_symlink(full_path));
+
+		if(entry->real_dir && job->depth != 0 &&
+				walk->cbs->filter(job->path, names[i], job->depth, walk->cbs->arg))
+		{
+			if(push_job(walk, full_path, job->depth - 1) == 0)
+			{
+				continue;
+			}
+		}
+		free(full_path);
+	}
+
+	/* Names are owned by entries now. */
+	free(names);
+
+	dir->entries = entries;
+	dir->count = len;
+	return dir;
+}
+
+/* Adds directory to the queue taking ownership of the path.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+push_job(walk_t *walk, char *path, int depth)
+{
+	pthread_mutex_lock(&walk->lock);
+
+	if(walk->njobs == walk->capacity)
+	{
+		const int capacity = (walk->capacity == 0 ? 64 : walk->capacity*2);
+		job_t *const jobs = reallocarray(walk->jobs, capacity, sizeof(*jobs));
+		if(jobs == NULL)
+		{
+			pthread_mutex_unlock(&walk->lock);
+			return 1;
+		}
+		walk->jobs = jobs;
+		walk->capacity = capacity;
+	}
+
+	walk->jobs[walk->njobs].path = path;
+	walk->jobs[walk->njobs].depth = depth;
+	++walk->njobs;
+
+	pthread_cond_signal(&walk->cond);
+	pthread_mutex_unlock(&walk->lock);
+	return 0;
+}
+
+/* Frees contents of a directory, which is passed in as void pointer and can be
+ * NULL. */
+static void
+free_dir(void *ptr)
+{
+	tree_walker_dir_t *const dir = ptr;
+	if(dir == NULL)
+	{
+		return;
+	}
+
+	int i;
+	for(i = 0; i < dir->count; ++i)
+	{
+		free(dir->entries[i].name);
+	}
+	free(dir->entries);
+	free(dir);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,90 @@
+/* vifm
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__TREE_WALKER_H__
+#define VIFM__UTILS__TREE_WALKER_H__
+
+/* Reading of a directory tree by several threads at once.  Directories to be
+ * read are kept in a queue shared by all threads, every thread takes the next
+ * directory as soon as it's done with the previous one and puts subdirectories
+ * that should be read into the queue.  Results are looked up by paths of
+ * directories after the walk is over. */
+
+/* Decides whether subdirectory of dir should be read.  depth is the one passed
+ * to tree_walker_walk() minus nesting level of dir.  Called from several
+ * threads at once and thus must be thread-safe.  Returns non-zero if so,
+ * otherwise zero is returned. */
+typedef int (*tree_walker_filter)(const char dir[], const char name[],
+		int depth, void *arg);
+
+/* Checks whether the walk should stop.  Must be thread-safe.  Returns non-zero
+ * if so, otherwise zero is returned. */
+typedef int (*tree_walker_cancelled)(void *arg);
+
+/* Reports that one more directory was read, called only from the thread that
+ * started the walk. */
+typedef void (*tree_walker_progress)(void *arg);
+
+/* Single entry of a directory. */
+typedef struct
+{
+	char *name;   /* Name of the entry. */
+	int is_dir;   /* Whether it's a directory or a symbolic link to one. */
+	int real_dir; /* Whether it's a directory and not a symbolic link. */
+}
+tree_walker_entry_t;
+
+/* Contents of a directory. */
+typedef struct
+{
+	tree_walker_entry_t *entries; /* Entries in the order of readdir(). */
+	int count;                    /* Number of entries. */
+}
+tree_walker_dir_t;
+
+/* Callbacks of a walk. */
+typedef struct
+{
+	tree_walker_filter filter;       /* Whether to descend into a directory. */
+	tree_walker_cancelled cancelled; /* Whether to stop walking. */
+	tree_walker_progress progress;   /* Progress reporting or NULL. */
+	void *arg;                       /* Argument of callbacks. */
+}
+tree_walker_cbs_t;
+
+/* Opaque type of results of a walk. */
+typedef struct tree_walker_t tree_walker_t;
+
+/* Reads root directory and all directories below it which pass the filter.
+ * Non-zero depth limits nesting of directories, negative value means no limit.
+ * Blocks until the walk is over.  Returns results or NULL on error. */
+tree_walker_t * tree_walker_walk(const char root[], int depth,
+		const tree_walker_cbs_t *cbs);
+
+/* Looks up contents of a directory.  walker can be NULL.  Returns the contents
+ * or NULL if the directory wasn't read. */
+const tree_walker_dir_t * tree_walker_get(const tree_walker_t *walker,
+		const char path[]);
+
+/* Frees results of a walk.  walker can be NULL. */
+void tree_walker_free(tree_walker_t *walker);
+
+#endif /* VIFM__UTILS__TREE_WALKER_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
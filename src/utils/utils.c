@@ -40,7 +40,8 @@
 #include <stdlib.h> /* RAND_MAX free() malloc() qsort() rand() random() srand()
                        srandom() */
 #include <string.h> /* memcpy() strdup() strchr() strlen() strpbrk() strtol() */
-#include <time.h> /* tm localtime() strftime() */
+#include <time.h> /* CLOCK_MONOTONIC clock_gettime() localtime() strftime()
+                     tm */
 #include <wchar.h> /* wcwidth() */
 
 #include "../cfg/config.h"
@@ -995,6 +996,18 @@ format_iso_time(time_t t, char buf[], size_t buf_size)
 	strftime(buf, buf_size, "%a, %d %b %Y %H:%M:%S", tm);
 }
 
+long long
+time_in_ms(void)
+{
+	struct timespec current_time;
+	if(clock_gettime(CLOCK_MONOTONIC, &current_time) != 0)
+	{
+		return 0;
+	}
+
+	return current_time.tv_sec*1000LL + current_time.tv_nsec/1000000;
+}
+
 int
 unichar_bisearch(wchar_t ucs, const interval_t table[], int max)
 {
@@ -240,6 +240,10 @@ void write_marked_paths(FILE *file, struct view_t *view, int null_sep);
  * error. */
 void format_iso_time(time_t t, char buf[], size_t buf_size);
 
+/* Retrieves monotonic time in milliseconds.  Returns the time or zero on
+ * error. */
+long long time_in_ms(void);
+
 /* Checks line for path in it.  Ignores empty lines and attempts to parse it as
  * location line (path followed by a colon and optional line and column
  * numbers).  Returns canonicalized path as a newly allocated string or NULL. */
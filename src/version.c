@@ -27,6 +27,7 @@
 #include "ui/color_manager.h"
 #include "utils/str.h"
 #include "utils/utils.h"
+#include "flist_cache.h"
 #include "status.h"
 #include "vcache.h"
 
@@ -36,7 +37,7 @@ extern const char GIT_INFO[];
 int
 fill_version_info(char **list, int include_stats)
 {
-	const int LEN = 23;
+	const int LEN = 24;
 	int x = 0;
 
 	if(list == NULL)
@@ -112,6 +113,12 @@ fill_version_info(char **list, int include_stats)
 		char size[64];
 		(void)friendly_size_notation(vcache_size(), sizeof(size), size);
 
+		flist_cache_stats_t list_stats;
+		flist_cache_get_stats(&list_stats);
+		char list_size[64];
+		(void)friendly_size_notation(list_stats.size, sizeof(list_size),
+				list_size);
+
 		list[x++] = strdup("");
 #ifndef _WIN32
 		list[x++] = format_str("Terminal name: %s", curr_stats.term_name);
@@ -131,6 +138,8 @@ fill_version_info(char **list, int include_stats)
 
 		list[x++] = strdup("");
 		list[x++] = format_str("Preview cache size: %s", size);
+		list[x++] = format_str("Listing cache: %d (%s), hits: %lu, misses: %lu",
+				list_stats.count, list_size, list_stats.hits, list_stats.misses);
 		list[x++] = format_str("Color pairs in use: %d", colmgr_used_pairs());
 	}
 
@@ -315,6 +315,8 @@ vifm_main(int argc, char *argv[])
 	{
 		load_scheme();
 		cfg_load();
+		/* Which caches are persistent is known only after reading vifmrc. */
+		state_load_caches();
 	}
 
 	if(lwin_cv || rwin_cv)
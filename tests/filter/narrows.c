@@ -0,0 +1,62 @@
+#include <stic.h>
+
+#include "../../src/utils/filter.h"
+
+static filter_t filter;
+
+SETUP()
+{
+	assert_int_equal(0, filter_init(&filter, 1));
+}
+
+TEARDOWN()
+{
+	filter_dispose(&filter);
+}
+
+TEST(extension_of_literal_pattern_narrows)
+{
+	assert_int_equal(0, filter_set(&filter, "abc"));
+	assert_true(filter_narrows(&filter, "", 1));
+	assert_true(filter_narrows(&filter, "ab", 1));
+	assert_true(filter_narrows(&filter, "bc", 1));
+	assert_true(filter_narrows(&filter, "abc", 1));
+}
+
+TEST(unrelated_pattern_does_not_narrow)
+{
+	assert_int_equal(0, filter_set(&filter, "abc"));
+	assert_false(filter_narrows(&filter, "ac", 1));
+	assert_false(filter_narrows(&filter, "abcd", 1));
+}
+
+TEST(regular_expressions_do_not_narrow)
+{
+	assert_int_equal(0, filter_set(&filter, "a|b"));
+	assert_false(filter_narrows(&filter, "a", 1));
+
+	assert_int_equal(0, filter_set(&filter, "ab*"));
+	assert_false(filter_narrows(&filter, "ab", 1));
+
+	assert_int_equal(0, filter_set(&filter, "abc"));
+	assert_false(filter_narrows(&filter, "a.", 1));
+}
+
+TEST(case_insensitivity_does_not_narrow_case_sensitive_pattern)
+{
+	assert_int_equal(0, filter_change(&filter, "abc", 0));
+	assert_false(filter_narrows(&filter, "ab", 1));
+	assert_true(filter_narrows(&filter, "ab", 0));
+
+	assert_int_equal(0, filter_change(&filter, "abc", 1));
+	assert_true(filter_narrows(&filter, "ab", 0));
+}
+
+TEST(invalid_filter_does_not_narrow)
+{
+	assert_int_equal(1, filter_set(&filter, "a["));
+	assert_false(filter_narrows(&filter, "a", 1));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -6,21 +6,33 @@
 #endif
 #include <sys/stat.h> /* chmod() stat */
 #include <sys/types.h> /* stat */
-#include <unistd.h> /* _Exit() lstat() */
+#include <unistd.h> /* R_OK _Exit() access() ftruncate() lstat() */
 
 #include <signal.h> /* SIGXFSZ SIG_IGN signal() */
+#include <stdio.h> /* FILE SEEK_SET fclose() fileno() fopen() fputc() fseek()
+                      fwrite() remove() */
 #include <stdlib.h> /* EXIT_FAILURE EXIT_SUCCESS */
 
 #include <test-utils.h>
 
 #include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
+#include "../../src/io/ioeta.h"
 #include "../../src/io/iop.h"
 #include "../../src/utils/fs.h"
 
 #include "utils.h"
 
 static void file_is_copied(const char original[]);
+static int proc_is_available(void);
+#ifndef _WIN32
+static int can_create_sparse_files(void);
+static void make_sparse_file(const char path[], off_t size, off_t data_at);
+#endif
+
+static int always_cancelled(void *arg);
+
+static const io_cancellation_t no_cancellation;
 
 TEST(dir_is_not_copied)
 {
@@ -156,6 +168,71 @@ TEST(double_block_size_plus_one_file_is_copied)
 			"/various-sizes/double-block-size-plus-one-file");
 }
 
+TEST(large_file_is_copied_with_progress)
+{
+	/* Large enough to require several steps of copying. */
+	enum { SIZE = 17*1024*1024 + 1 };
+
+	FILE *const fp = fopen(SANDBOX_PATH "/large", "wb");
+	assert_non_null(fp);
+	int i;
+	for(i = 0; i < SIZE; ++i)
+	{
+		fputc(i*31 % 251, fp);
+	}
+	fclose(fp);
+
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/large",
+		.arg2.dst = SANDBOX_PATH "/large-copy",
+
+		.estim = ioeta_alloc(NULL, no_cancellation),
+
+		.result.errors = IOE_ERRLST_INIT,
+	};
+
+	ioeta_calculate(args.estim, SANDBOX_PATH "/large", 0);
+
+	assert_int_equal(IO_RES_SUCCEEDED, iop_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+
+	assert_int_equal(SIZE, args.estim->current_byte);
+	assert_int_equal(SIZE, args.estim->total_bytes);
+	assert_int_equal(1, args.estim->current_item);
+
+	assert_true(files_are_identical(SANDBOX_PATH "/large",
+				SANDBOX_PATH "/large-copy"));
+
+	ioeta_free(args.estim);
+	delete_test_file(SANDBOX_PATH "/large");
+	delete_test_file(SANDBOX_PATH "/large-copy");
+}
+
+/* Files of procfs report zero size, but aren't empty. */
+TEST(contents_of_pseudo_files_is_copied, IF(proc_is_available))
+{
+	io_args_t args = {
+		.arg1.src = "/proc/version",
+		.arg2.dst = SANDBOX_PATH "/version",
+
+		.result.errors = IOE_ERRLST_INIT,
+	};
+
+	assert_int_equal(IO_RES_SUCCEEDED, iop_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+
+	assert_true(get_file_size(SANDBOX_PATH "/version") > 0);
+	assert_true(files_are_identical("/proc/version", SANDBOX_PATH "/version"));
+
+	delete_test_file(SANDBOX_PATH "/version");
+}
+
+static int
+proc_is_available(void)
+{
+	return (access("/proc/version", R_OK) == 0);
+}
+
 static void
 file_is_copied(const char original[])
 {
@@ -443,6 +520,32 @@ TEST(overwrite_removal_handles_errors, IF(regular_unix_user))
 #ifndef _WIN32
 
 /* No named fifo in file systems on Windows. */
+TEST(partial_copy_is_removed_on_failure_if_requested, IF(not_windows))
+{
+	io_args_t args = {
+		.arg1.src = TEST_DATA_PATH "/read/two-lines",
+		.arg2.dst = SANDBOX_PATH "/two-lines",
+		.cancellation.hook = &always_cancelled,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	assert_int_equal(IO_RES_FAILED, iop_cp(&args));
+	assert_success(access(SANDBOX_PATH "/two-lines", F_OK));
+	delete_test_file(SANDBOX_PATH "/two-lines");
+
+	args.arg4.remove_on_failure = 1;
+	assert_int_equal(IO_RES_FAILED, iop_cp(&args));
+	assert_failure(access(SANDBOX_PATH "/two-lines", F_OK));
+
+	ioe_errlst_free(&args.result.errors);
+}
+
+static int
+always_cancelled(void *arg)
+{
+	return 1;
+}
+
 TEST(fifo_is_copied, IF(not_windows))
 {
 	struct stat st;
@@ -511,6 +614,100 @@ TEST(socket_is_copied, IF(can_create_sockets))
 	assert_int_equal(0, args.result.errors.error_count);
 }
 
+/* Holes might not be supported by file system. */
+TEST(holes_of_sparse_files_are_preserved, IF(can_create_sparse_files))
+{
+	enum { SIZE = 8*1024*1024, DATA_AT = 1024*1024 };
+
+	struct stat st;
+
+	make_sparse_file(SANDBOX_PATH "/sparse", SIZE, DATA_AT);
+
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/sparse",
+		.arg2.dst = SANDBOX_PATH "/sparse-copy",
+		.arg4.sparse_files = 1,
+
+		.estim = ioeta_alloc(NULL, no_cancellation),
+
+		.result.errors = IOE_ERRLST_INIT,
+	};
+
+	ioeta_calculate(args.estim, SANDBOX_PATH "/sparse", 0);
+
+	assert_int_equal(IO_RES_SUCCEEDED, iop_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+
+	/* Progress accounts for holes. */
+	assert_int_equal(SIZE, args.estim->current_byte);
+	assert_int_equal(SIZE, args.estim->total_bytes);
+
+	assert_success(lstat(SANDBOX_PATH "/sparse-copy", &st));
+	assert_int_equal(SIZE, st.st_size);
+	assert_true(st.st_blocks*512 < SIZE);
+	assert_true(files_are_identical(SANDBOX_PATH "/sparse",
+				SANDBOX_PATH "/sparse-copy"));
+
+	ioeta_free(args.estim);
+	delete_test_file(SANDBOX_PATH "/sparse");
+	delete_test_file(SANDBOX_PATH "/sparse-copy");
+}
+
+TEST(fully_sparse_file_is_copied, IF(can_create_sparse_files))
+{
+	enum { SIZE = 1024*1024 };
+
+	struct stat st;
+
+	make_sparse_file(SANDBOX_PATH "/sparse", SIZE, -1);
+
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/sparse",
+		.arg2.dst = SANDBOX_PATH "/sparse-copy",
+		.arg4.sparse_files = 1,
+
+		.result.errors = IOE_ERRLST_INIT,
+	};
+
+	assert_int_equal(IO_RES_SUCCEEDED, iop_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+
+	assert_success(lstat(SANDBOX_PATH "/sparse-copy", &st));
+	assert_int_equal(SIZE, st.st_size);
+	assert_true(files_are_identical(SANDBOX_PATH "/sparse",
+				SANDBOX_PATH "/sparse-copy"));
+
+	delete_test_file(SANDBOX_PATH "/sparse");
+	delete_test_file(SANDBOX_PATH "/sparse-copy");
+}
+
+static int
+can_create_sparse_files(void)
+{
+	struct stat st;
+	make_sparse_file(SANDBOX_PATH "/sparse", 1024*1024, -1);
+	const int sparse = (lstat(SANDBOX_PATH "/sparse", &st) == 0)
+	                && (st.st_blocks*512 < st.st_size);
+	remove(SANDBOX_PATH "/sparse");
+	return sparse;
+}
+
+/* Creates file of specified size, which consists of holes except for a short
+ * piece of data at the specified offset (negative means no data). */
+static void
+make_sparse_file(const char path[], off_t size, off_t data_at)
+{
+	FILE *const fp = fopen(path, "wb");
+	assert_non_null(fp);
+	if(data_at >= 0)
+	{
+		assert_success(fseek(fp, data_at, SEEK_SET));
+		assert_int_equal(5, fwrite("data\n", 1, 5, fp));
+	}
+	assert_success(ftruncate(fileno(fp), size));
+	fclose(fp);
+}
+
 TEST(append_truncates_destination_files_on_error, IF(not_windows))
 {
 	int status;
@@ -4,9 +4,13 @@
 #include <sys/types.h> /* stat */
 #include <unistd.h> /* F_OK access() */
 
+#include <stdio.h> /* snprintf() */
+
 #include <test-utils.h>
 
+#include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
+#include "../../src/io/ioeta.h"
 #include "../../src/io/iop.h"
 #include "../../src/io/ior.h"
 #include "../../src/utils/fs.h"
@@ -16,6 +20,10 @@
 static int confirm_overwrite(io_args_t *args, const char src[],
 		const char dst[]);
 
+static void make_tree(const char root[], int ndirs, int nfiles);
+static void check_tree(const char root[], int ndirs, int nfiles);
+
+static const io_cancellation_t no_cancellation;
 static int confirm_called;
 
 TEST(file_is_copied)
@@ -652,6 +660,151 @@ TEST(symlink_to_dir_is_symlink_after_copy, IF(not_windows))
 	}
 }
 
+TEST(many_files_are_copied_with_progress)
+{
+	enum { NDIRS = 3, NFILES = 100 };
+
+	make_tree(SANDBOX_PATH "/src", NDIRS, NFILES);
+
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/src",
+		.arg2.dst = SANDBOX_PATH "/dst",
+
+		.estim = ioeta_alloc(NULL, no_cancellation),
+
+		.result.errors = IOE_ERRLST_INIT,
+	};
+
+	ioeta_calculate(args.estim, SANDBOX_PATH "/src", 0);
+	const uint64_t total_bytes = args.estim->total_bytes;
+
+	assert_int_equal(IO_RES_SUCCEEDED, ior_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+
+	assert_ulong_equal(total_bytes, args.estim->current_byte);
+	assert_ulong_equal(args.estim->total_items, args.estim->current_item);
+	assert_int_equal(0, args.estim->parallel_items);
+
+	check_tree(SANDBOX_PATH "/dst", NDIRS, NFILES);
+
+	ioeta_free(args.estim);
+	delete_tree(SANDBOX_PATH "/src");
+	delete_tree(SANDBOX_PATH "/dst");
+}
+
+TEST(dir_attributes_are_set_after_all_files_are_copied)
+{
+	enum { NDIRS = 2, NFILES = 50 };
+
+	struct stat src, dst;
+
+	make_tree(SANDBOX_PATH "/src", NDIRS, NFILES);
+	reset_timestamp(SANDBOX_PATH "/src/0");
+	reset_timestamp(SANDBOX_PATH "/src/1");
+	reset_timestamp(SANDBOX_PATH "/src");
+
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/src",
+		.arg2.dst = SANDBOX_PATH "/dst",
+
+		.result.errors = IOE_ERRLST_INIT,
+	};
+
+	assert_int_equal(IO_RES_SUCCEEDED, ior_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+
+	/* Modification time would be updated if a file was created after setting
+	 * attributes of its directory. */
+	assert_success(os_stat(SANDBOX_PATH "/src/1", &src));
+	assert_success(os_stat(SANDBOX_PATH "/dst/1", &dst));
+	assert_true(src.st_mtime == dst.st_mtime);
+	assert_success(os_stat(SANDBOX_PATH "/src", &src));
+	assert_success(os_stat(SANDBOX_PATH "/dst", &dst));
+	assert_true(src.st_mtime == dst.st_mtime);
+
+	check_tree(SANDBOX_PATH "/dst", NDIRS, NFILES);
+
+	delete_tree(SANDBOX_PATH "/src");
+	delete_tree(SANDBOX_PATH "/dst");
+}
+
+TEST(merging_with_parallel_copying_asks_for_conflicts_only)
+{
+	enum { NDIRS = 2, NFILES = 20 };
+
+	make_tree(SANDBOX_PATH "/src", NDIRS, NFILES);
+	create_empty_dir(SANDBOX_PATH "/dst");
+	create_empty_dir(SANDBOX_PATH "/dst/1");
+	create_empty_file(SANDBOX_PATH "/dst/1/5");
+	create_empty_file(SANDBOX_PATH "/dst/1/15");
+
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/src",
+		.arg2.dst = SANDBOX_PATH "/dst",
+		.arg3.crs = IO_CRS_REPLACE_FILES,
+
+		.confirm = &confirm_overwrite,
+
+		.result.errors = IOE_ERRLST_INIT,
+	};
+
+	confirm_called = 0;
+	assert_int_equal(IO_RES_SUCCEEDED, ior_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+	assert_int_equal(2, confirm_called);
+
+	check_tree(SANDBOX_PATH "/dst", NDIRS, NFILES);
+
+	delete_tree(SANDBOX_PATH "/src");
+	delete_tree(SANDBOX_PATH "/dst");
+}
+
+/* Creates directory with ndirs subdirectories each of which contains nfiles
+ * files that contain their name. */
+static void
+make_tree(const char root[], int ndirs, int nfiles)
+{
+	char path[PATH_MAX + 1];
+
+	create_empty_dir(root);
+
+	int i, j;
+	for(i = 0; i < ndirs; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/%d", root, i);
+		create_empty_dir(path);
+
+		for(j = 0; j < nfiles; ++j)
+		{
+			char contents[32];
+			snprintf(path, sizeof(path), "%s/%d/%d", root, i, j);
+			snprintf(contents, sizeof(contents), "%d/%d", i, j);
+			make_file(path, contents);
+		}
+	}
+}
+
+/* Checks that directory was created by make_tree(). */
+static void
+check_tree(const char root[], int ndirs, int nfiles)
+{
+	char path[PATH_MAX + 1];
+
+	int i, j;
+	for(i = 0; i < ndirs; ++i)
+	{
+		for(j = 0; j < nfiles; ++j)
+		{
+			char contents[32];
+			snprintf(path, sizeof(path), "%s/%d/%d", root, i, j);
+			snprintf(contents, sizeof(contents), "%d/%d", i, j);
+
+			const char *lines[] = { contents };
+			file_is(path, lines, 1);
+		}
+	}
+}
+
 static int
 confirm_overwrite(io_args_t *args, const char src[], const char dst[])
 {
@@ -1,7 +1,7 @@
 #include <stic.h>
 
 #include <sys/stat.h> /* chmod() */
-#include <unistd.h> /* rmdir() */
+#include <unistd.h> /* F_OK access() rmdir() */
 
 #include <string.h> /* strstr() */
 
@@ -73,6 +73,42 @@ TEST(path_in_errors_has_no_double_slashes, IF(regular_unix_user))
 	delete_dir(SANDBOX_PATH "/dir2");
 }
 
+TEST(error_of_parallel_copy_is_reported_once, IF(regular_unix_user))
+{
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/dir",
+		.arg2.dst = SANDBOX_PATH "/dir2",
+
+		.result.errors_cb = &handle_errors,
+		.result.errors = IOE_ERRLST_INIT,
+	};
+
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+	create_empty_file(SANDBOX_PATH "/dir/afile");
+	create_empty_file(SANDBOX_PATH "/dir/file");
+	create_empty_file(SANDBOX_PATH "/dir/zfile");
+	assert_success(chmod(SANDBOX_PATH "/dir/file", 0000));
+
+	ignore_count = 1;
+	assert_int_equal(IO_RES_SUCCEEDED, ior_cp(&args));
+	assert_int_equal(0, ignore_count);
+	/* Failed copy from a worker thread is redone and its error isn't kept. */
+	assert_int_equal(1, args.result.errors.error_count);
+	ioe_errlst_free(&args.result.errors);
+
+	assert_success(access(SANDBOX_PATH "/dir2/afile", F_OK));
+	assert_failure(access(SANDBOX_PATH "/dir2/file", F_OK));
+	assert_success(access(SANDBOX_PATH "/dir2/zfile", F_OK));
+
+	delete_file(SANDBOX_PATH "/dir/afile");
+	delete_file(SANDBOX_PATH "/dir/file");
+	delete_file(SANDBOX_PATH "/dir/zfile");
+	delete_dir(SANDBOX_PATH "/dir");
+	delete_file(SANDBOX_PATH "/dir2/afile");
+	delete_file(SANDBOX_PATH "/dir2/zfile");
+	delete_dir(SANDBOX_PATH "/dir2");
+}
+
 static IoErrCbResult
 handle_errors(struct io_args_t *args, const ioe_err_t *err)
 {
@@ -1,19 +1,32 @@
 #include <stic.h>
 
+#ifndef _WIN32
+#include <sys/resource.h> /* RLIMIT_NOFILE getrlimit() rlim_t rlimit setrlimit() */
+#endif
 #include <sys/stat.h> /* chmod() */
 #include <unistd.h> /* rmdir() */
 
-#include <stdio.h> /* FILE fopen() fwrite() fclose() remove() */
-#include <string.h> /* strcpy() */
+#include <stdio.h> /* FILE fopen() fwrite() fclose() remove() snprintf() */
+#include <stdlib.h> /* atoi() */
+#include <string.h> /* memset() strcat() strcpy() */
 
 #include <test-utils.h>
 
+#include "../../src/compat/fs_limits.h"
 #include "../../src/ui/ui.h"
 #include "../../src/compare.h"
+#include "../../src/filelist.h"
 
 /* These tests are about comparison strategies and not about handling of unusual
  * situations or results of operations in compare views. */
 
+static void make_files_with_tails(int n, int (*tail)(int i));
+static int tail_by_three(int i);
+static int mostly_same_tail(int i);
+static void check_classes(int n, int (*tail)(int i));
+static void remove_files(int n);
+static void describe_diff(char buf[], size_t buf_len);
+
 SETUP()
 {
 	curr_view = &lwin;
@@ -30,6 +43,9 @@ SETUP()
 
 TEARDOWN()
 {
+	compare_stop();
+	progressive_batch = 4096;
+
 	columns_teardown();
 
 	view_teardown(&lwin);
@@ -449,5 +465,293 @@ TEST(content_difference_is_detected)
 	remove_dir(SANDBOX_PATH "/b");
 }
 
+/* Tests fingerprinting of many files of the same size in nested directories. */
+TEST(files_of_the_same_size_are_grouped_by_contents)
+{
+	char path[PATH_MAX + 1];
+	int i;
+
+	create_dir(SANDBOX_PATH "/a");
+	create_dir(SANDBOX_PATH "/a/sub");
+	create_dir(SANDBOX_PATH "/b");
+	create_dir(SANDBOX_PATH "/b/sub");
+
+	for(i = 0; i < 8; ++i)
+	{
+		char data[] = { 'a' + i%4, '\n' };
+
+		snprintf(path, sizeof(path), SANDBOX_PATH "/a/sub/%d", i);
+		FILE *fp = fopen(path, "wb");
+		assert_int_equal(sizeof(data), fwrite(data, 1, sizeof(data), fp));
+		fclose(fp);
+
+		data[0] = 'c' + i%4;
+		snprintf(path, sizeof(path), SANDBOX_PATH "/b/sub/%d", i);
+		fp = fopen(path, "wb");
+		assert_int_equal(sizeof(data), fwrite(data, 1, sizeof(data), fp));
+		fclose(fp);
+	}
+
+	curr_view = &lwin;
+	other_view = &rwin;
+	strcpy(lwin.curr_dir, SANDBOX_PATH "/a");
+	strcpy(rwin.curr_dir, SANDBOX_PATH "/b");
+	compare_two_panes(CT_CONTENTS, LT_DUPS, CF_SHOW);
+
+	/* "c" and "d" are on both sides, each twice. */
+	assert_int_equal(4, lwin.list_rows);
+	assert_int_equal(4, rwin.list_rows);
+	for(i = 0; i < 4; ++i)
+	{
+		assert_int_equal(lwin.dir_entry[i].id, rwin.dir_entry[i].id);
+		assert_int_equal(i < 2 ? 1 : 2, lwin.dir_entry[i].id);
+	}
+	assert_string_equal("2", lwin.dir_entry[0].name);
+	assert_string_equal("6", lwin.dir_entry[1].name);
+	assert_string_equal("0", rwin.dir_entry[0].name);
+	assert_string_equal("4", rwin.dir_entry[1].name);
+
+	for(i = 0; i < 8; ++i)
+	{
+		snprintf(path, sizeof(path), SANDBOX_PATH "/a/sub/%d", i);
+		remove_file(path);
+		snprintf(path, sizeof(path), SANDBOX_PATH "/b/sub/%d", i);
+		remove_file(path);
+	}
+	remove_dir(SANDBOX_PATH "/a/sub");
+	remove_dir(SANDBOX_PATH "/a");
+	remove_dir(SANDBOX_PATH "/b/sub");
+	remove_dir(SANDBOX_PATH "/b");
+}
+
+TEST(files_with_the_same_head_are_told_apart)
+{
+	int flags[] = { CF_NONE, CF_PARANOID };
+	int i;
+
+	for(i = 0; i < (int)(sizeof(flags)/sizeof(flags[0])); ++i)
+	{
+		make_files_with_tails(9, &tail_by_three);
+		strcpy(lwin.curr_dir, SANDBOX_PATH);
+		compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, flags[i]);
+		check_classes(9, &tail_by_three);
+		remove_files(9);
+	}
+}
+
+TEST(paranoid_mode_handles_large_groups)
+{
+	int (*tails[])(int i) = { &tail_by_three, &mostly_same_tail };
+	int i;
+
+	for(i = 0; i < (int)(sizeof(tails)/sizeof(tails[0])); ++i)
+	{
+		make_files_with_tails(100, tails[i]);
+		strcpy(lwin.curr_dir, SANDBOX_PATH);
+		compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, CF_PARANOID);
+		check_classes(100, tails[i]);
+		remove_files(100);
+	}
+}
+
+#ifndef _WIN32
+
+TEST(paranoid_mode_fits_into_limit_on_open_files)
+{
+	struct rlimit rl;
+	assert_success(getrlimit(RLIMIT_NOFILE, &rl));
+	const rlim_t soft = rl.rlim_cur;
+
+	/* Lets each worker keep only a few files open. */
+	rl.rlim_cur = 64;
+	assert_success(setrlimit(RLIMIT_NOFILE, &rl));
+
+	make_files_with_tails(100, &mostly_same_tail);
+	strcpy(lwin.curr_dir, SANDBOX_PATH);
+	compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, CF_PARANOID);
+
+	rl.rlim_cur = soft;
+	assert_success(setrlimit(RLIMIT_NOFILE, &rl));
+
+	check_classes(100, &mostly_same_tail);
+	remove_files(100);
+}
+
+#endif
+
+TEST(progressive_mode_produces_the_same_results)
+{
+	const ListType lts[] = { LT_ALL, LT_DUPS, LT_UNIQUE };
+	const int groupings[] = { CF_GROUP_PATHS, CF_NONE };
+	int i, j;
+
+	/* Process files of each size separately. */
+	progressive_batch = 1;
+
+	for(i = 0; i < (int)(sizeof(lts)/sizeof(lts[0])); ++i)
+	{
+		for(j = 0; j < (int)(sizeof(groupings)/sizeof(groupings[0])); ++j)
+		{
+			char expected[1024], actual[1024];
+
+			strcpy(lwin.curr_dir, TEST_DATA_PATH "/compare/a");
+			strcpy(rwin.curr_dir, TEST_DATA_PATH "/compare/b");
+			compare_two_panes(CT_CONTENTS, lts[i], groupings[j] | CF_SHOW);
+			describe_diff(expected, sizeof(expected));
+			const compare_stats_t stats = lwin.custom.diff_stats;
+
+			strcpy(lwin.curr_dir, TEST_DATA_PATH "/compare/a");
+			strcpy(rwin.curr_dir, TEST_DATA_PATH "/compare/b");
+			compare_two_panes(CT_CONTENTS, lts[i],
+					groupings[j] | CF_SHOW | CF_PROGRESSIVE);
+			while(compare_continue())
+			{
+				/* Process all batches. */
+			}
+			describe_diff(actual, sizeof(actual));
+
+			assert_string_equal(expected, actual);
+			assert_int_equal(stats.identical, lwin.custom.diff_stats.identical);
+			assert_int_equal(stats.different, lwin.custom.diff_stats.different);
+			assert_int_equal(stats.unique_left, lwin.custom.diff_stats.unique_left);
+			assert_int_equal(stats.unique_right,
+					rwin.custom.diff_stats.unique_right);
+		}
+	}
+}
+
+TEST(progressive_comparison_is_continued_keeping_cursor_position)
+{
+	progressive_batch = 1;
+
+	strcpy(lwin.curr_dir, TEST_DATA_PATH "/compare/a");
+	strcpy(rwin.curr_dir, TEST_DATA_PATH "/compare/b");
+	assert_success(compare_two_panes(CT_CONTENTS, LT_ALL,
+				CF_GROUP_PATHS | CF_SHOW | CF_PROGRESSIVE));
+
+	/* Only empty file is compared. */
+	assert_int_equal(CV_DIFF, lwin.custom.type);
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("same-name-different-content", lwin.dir_entry[0].name);
+	assert_int_equal(0, lwin.list_pos);
+
+	assert_true(compare_continue());
+	assert_true(compare_continue());
+	assert_true(compare_continue());
+	assert_false(compare_continue());
+
+	assert_int_equal(4, lwin.list_rows);
+	assert_string_equal("same-name-different-content",
+			lwin.dir_entry[lwin.list_pos].name);
+	assert_int_equal(lwin.list_pos, rwin.list_pos);
+}
+
+TEST(changing_views_stops_progressive_comparison)
+{
+	progressive_batch = 1;
+
+	strcpy(lwin.curr_dir, TEST_DATA_PATH "/compare/a");
+	strcpy(rwin.curr_dir, TEST_DATA_PATH "/compare/b");
+	assert_success(compare_two_panes(CT_CONTENTS, LT_ALL,
+				CF_GROUP_PATHS | CF_SHOW | CF_PROGRESSIVE));
+	assert_int_equal(1, lwin.list_rows);
+
+	/* Excluding the only file leaves the diff. */
+	flist_custom_exclude(&lwin, /*selection_only=*/0);
+	assert_false(flist_custom_active(&lwin));
+
+	assert_true(compare_continue());
+	assert_false(compare_continue());
+	assert_false(flist_custom_active(&lwin));
+	assert_int_equal(3, lwin.list_rows);
+}
+
+/* Creates n files of the same size which differ only past the first 4 KiB. */
+static void
+make_files_with_tails(int n, int (*tail)(int i))
+{
+	char data[8*1024];
+	int i;
+
+	for(i = 0; i < n; ++i)
+	{
+		memset(data, 'x', sizeof(data)/2);
+		memset(data + sizeof(data)/2, tail(i), sizeof(data)/2);
+
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), SANDBOX_PATH "/%d", i);
+		FILE *fp = fopen(path, "wb");
+		assert_int_equal(sizeof(data), fwrite(data, 1, sizeof(data), fp));
+		fclose(fp);
+	}
+}
+
+/* Splits files into three classes. */
+static int
+tail_by_three(int i)
+{
+	return 'a' + i%3;
+}
+
+/* Makes a class which is too big to be compared at once. */
+static int
+mostly_same_tail(int i)
+{
+	return (i < 80 ? 'a' : 'b' + i%2);
+}
+
+/* Checks that files in the left view have the same id only if their tails are
+ * the same. */
+static void
+check_classes(int n, int (*tail)(int i))
+{
+	int i, j;
+
+	assert_int_equal(n, lwin.list_rows);
+	for(i = 0; i < n; ++i)
+	{
+		for(j = 0; j < n; ++j)
+		{
+			const int same_tail = (tail(atoi(lwin.dir_entry[i].name)) ==
+			                       tail(atoi(lwin.dir_entry[j].name)));
+			const int same_id = (lwin.dir_entry[i].id == lwin.dir_entry[j].id);
+			assert_int_equal(same_tail, same_id);
+		}
+	}
+}
+
+/* Removes files created by make_files_with_tails(). */
+static void
+remove_files(int n)
+{
+	int i;
+	for(i = 0; i < n; ++i)
+	{
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), SANDBOX_PATH "/%d", i);
+		remove_file(path);
+	}
+}
+
+/* Describes contents of both views as a string. */
+static void
+describe_diff(char buf[], size_t buf_len)
+{
+	int i;
+
+	buf[0] = '\0';
+	for(i = 0; i < lwin.list_rows + rwin.list_rows; ++i)
+	{
+		const dir_entry_t *const entry = (i < lwin.list_rows)
+		                               ? &lwin.dir_entry[i]
+		                               : &rwin.dir_entry[i - lwin.list_rows];
+
+		char line[256];
+		snprintf(line, sizeof(line), "%s:%d;", entry->name, entry->id);
+		assert_true(strlen(buf) + strlen(line) < buf_len);
+		strcat(buf, line);
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 : */
@@ -1,9 +1,15 @@
 #include <stic.h>
 
+#include <sys/stat.h> /* stat */
+#include <utime.h> /* utimbuf utime() */
+
+#include <stdint.h> /* int64_t */
+#include <stdio.h> /* snprintf() */
 #include <string.h> /* strcpy() */
 
 #include <test-utils.h>
 
+#include "../../src/cfg/config.h"
 #include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
 #include "../../src/engine/mode.h"
@@ -12,6 +18,7 @@
 #include "../../src/ui/ui.h"
 #include "../../src/utils/filter.h"
 #include "../../src/utils/fs.h"
+#include "../../src/utils/path_store.h"
 #include "../../src/cmd_core.h"
 #include "../../src/compare.h"
 #include "../../src/filelist.h"
@@ -22,6 +29,9 @@
 /* These tests are about about handling of unusual situations on comparing files
  * and results of operations in compare views. */
 
+static void make_fpcache_key(const char path[], int limit, char key[],
+		size_t key_len);
+
 static char *saved_cwd;
 
 SETUP()
@@ -623,5 +633,98 @@ TEST(two_panes_unique_is_symmetric)
 	remove_dir(SANDBOX_PATH "/b");
 }
 
+TEST(fingerprints_are_taken_from_the_cache, IF(not_windows))
+{
+	char a[PATH_MAX + 1], b[PATH_MAX + 1];
+	create_dir(SANDBOX_PATH "/dir");
+	copy_file(TEST_DATA_PATH "/read/two-lines", SANDBOX_PATH "/dir/a");
+	copy_file(TEST_DATA_PATH "/read/two-lines", SANDBOX_PATH "/dir/b");
+	assert_non_null(os_realpath(SANDBOX_PATH "/dir/a", a));
+	assert_non_null(os_realpath(SANDBOX_PATH "/dir/b", b));
+
+	/* Put fake fingerprints into the cache. */
+	char key_a[256], key_b[256];
+	make_fpcache_key(a, 4096, key_a, sizeof(key_a));
+	make_fpcache_key(b, 4096, key_b, sizeof(key_b));
+	const char *keys[] = { key_a, key_b };
+	const path_store_rec_t recs[] = { { .value = 1 }, { .value = 2 } };
+	assert_success(path_store_write(SANDBOX_PATH "/fpcache", keys, recs, 2, 10));
+	assert_success(compare_cache_load(SANDBOX_PATH "/fpcache"));
+
+	/* Files with different heads aren't read further. */
+	cfg.compare_cache = 1;
+	strcpy(lwin.curr_dir, SANDBOX_PATH "/dir");
+	compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, CF_NONE);
+	assert_int_equal(2, lwin.list_rows);
+	assert_int_equal(1, lwin.dir_entry[0].id);
+	assert_int_equal(2, lwin.dir_entry[1].id);
+
+	/* Changed files are read again. */
+	struct utimbuf times = { .actime = 1, .modtime = 1 };
+	assert_success(utime(a, &times));
+	assert_success(utime(b, &times));
+	char new_key_a[256], new_key_b[256];
+	make_fpcache_key(a, 4096, new_key_a, sizeof(new_key_a));
+	make_fpcache_key(b, 4096, new_key_b, sizeof(new_key_b));
+	char full_key_a[256], full_key_b[256];
+	make_fpcache_key(a, 0, full_key_a, sizeof(full_key_a));
+	make_fpcache_key(b, 0, full_key_b, sizeof(full_key_b));
+	compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, CF_NONE);
+	assert_int_equal(2, lwin.list_rows);
+	assert_int_equal(1, lwin.dir_entry[0].id);
+	assert_int_equal(1, lwin.dir_entry[1].id);
+
+	/* Used and new fingerprints of heads and whole files are stored. */
+	assert_success(compare_cache_store(SANDBOX_PATH "/fpcache"));
+	path_store_t *const store = path_store_open(SANDBOX_PATH "/fpcache");
+	assert_int_equal(6, path_store_count(store));
+
+	path_store_rec_t rec_a, rec_b;
+	assert_success(path_store_get(store, key_a, &rec_a));
+	assert_success(path_store_get(store, key_b, &rec_b));
+	assert_ulong_equal(1, rec_a.value);
+	assert_ulong_equal(2, rec_b.value);
+	assert_success(path_store_get(store, new_key_a, &rec_a));
+	assert_success(path_store_get(store, new_key_b, &rec_b));
+	assert_true(rec_a.value != 1);
+	assert_ulong_equal(rec_a.value, rec_b.value);
+	assert_success(path_store_get(store, full_key_a, &rec_a));
+	assert_success(path_store_get(store, full_key_b, &rec_b));
+	assert_ulong_equal(rec_a.value, rec_b.value);
+	path_store_close(store);
+
+	/* Nothing is stored without the option. */
+	cfg.compare_cache = 0;
+	assert_failure(compare_cache_load(SANDBOX_PATH "/nope"));
+	compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, CF_NONE);
+	assert_success(compare_cache_store(SANDBOX_PATH "/nope"));
+	assert_false(path_exists(SANDBOX_PATH "/nope", NODEREF));
+
+	remove_file(SANDBOX_PATH "/fpcache");
+	remove_file(SANDBOX_PATH "/dir/a");
+	remove_file(SANDBOX_PATH "/dir/b");
+	remove_dir(SANDBOX_PATH "/dir");
+}
+
+/* Formats key under which fingerprint of the file is cached. */
+static void
+make_fpcache_key(const char path[], int limit, char key[], size_t key_len)
+{
+	struct stat st;
+	assert_success(os_stat(path, &st));
+
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+	const int64_t mtime = st.st_mtim.tv_sec*1000000000LL + st.st_mtim.tv_nsec;
+	const int64_t ctime = st.st_ctim.tv_sec*1000000000LL + st.st_ctim.tv_nsec;
+#else
+	const int64_t mtime = st.st_mtime*1000000000LL;
+	const int64_t ctime = st.st_ctime*1000000000LL;
+#endif
+
+	snprintf(key, key_len, "%d:%llu:%llu:%llu:%lld:%lld", limit,
+			(unsigned long long)st.st_dev, (unsigned long long)st.st_ino,
+			(unsigned long long)st.st_size, (long long)mtime, (long long)ctime);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 : */
@@ -1,15 +1,19 @@
 #include <stic.h>
 
 #include <stddef.h> /* NULL */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* snprintf() */
 #include <string.h> /* memset() strcpy() */
 #include <time.h> /* time() */
 
 #include <test-utils.h>
 
 #include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
 #include "../../src/ui/ui.h"
 #include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
 #include "../../src/status.h"
 
 SETUP()
@@ -114,6 +118,187 @@ TEST(symlink_inode_resolution, IF(not_windows))
 	remove_dir(SANDBOX_PATH "/dir");
 }
 
+TEST(updating_size_does_not_change_generation)
+{
+	const unsigned int gen = dcache_generation();
+
+	uint64_t size;
+	assert_success(dcache_update_at(TEST_DATA_PATH, 0, 10));
+	dcache_get_at(TEST_DATA_PATH, time(NULL) - 10, 0, &size, NULL);
+	assert_ulong_equal(10, size);
+	assert_true(dcache_generation() == gen);
+
+	assert_success(dcache_set_at(TEST_DATA_PATH, 0, 11, DCACHE_UNKNOWN));
+	assert_false(dcache_generation() == gen);
+}
+
+TEST(sizes_are_stored_and_loaded)
+{
+	char dir[PATH_MAX + 1];
+	create_dir(SANDBOX_PATH "/dir");
+	assert_non_null(os_realpath(SANDBOX_PATH "/dir", dir));
+
+	dcache_set_at(dir, 0, 10, 11);
+	assert_success(dcache_store(SANDBOX_PATH "/dcache", 10));
+
+	assert_success(stats_init(&cfg));
+	assert_success(dcache_load(SANDBOX_PATH "/dcache"));
+
+	uint64_t size, nitems;
+	dcache_get_at(dir, time(NULL) - 10, 0, &size, &nitems);
+	assert_ulong_equal(10, size);
+	/* Number of items isn't stored. */
+	assert_ulong_equal(DCACHE_UNKNOWN, nitems);
+
+	/* Validation works as usual. */
+	dcache_get_at(dir, time(NULL) + 1, 0, &size, NULL);
+	assert_ulong_equal(DCACHE_UNKNOWN, size);
+
+	/* Parents that are known only from the file are updated. */
+	char child[PATH_MAX + 16];
+	snprintf(child, sizeof(child), "%s/sub", dir);
+	create_dir(child);
+	assert_success(stats_init(&cfg));
+	dcache_set_at(child, 0, 5, DCACHE_UNKNOWN);
+	dcache_update_parent_sizes(child, 5);
+	dcache_get_at(dir, time(NULL) - 10, 0, &size, NULL);
+	assert_ulong_equal(15, size);
+
+	dcache_drop(SANDBOX_PATH "/dcache");
+	dcache_get_at(dir, time(NULL) - 10, 0, &size, NULL);
+	assert_ulong_equal(DCACHE_UNKNOWN, size);
+	assert_failure(dcache_load(SANDBOX_PATH "/dcache"));
+
+	remove_dir(child);
+	remove_dir(SANDBOX_PATH "/dir");
+}
+
+TEST(storing_merges_with_file)
+{
+	char dir[PATH_MAX + 1];
+	create_dir(SANDBOX_PATH "/dir");
+	assert_non_null(os_realpath(SANDBOX_PATH "/dir", dir));
+
+	char other[PATH_MAX + 1];
+	assert_non_null(os_realpath(SANDBOX_PATH, other));
+
+	dcache_set_at(dir, 0, 10, DCACHE_UNKNOWN);
+	assert_success(dcache_store(SANDBOX_PATH "/dcache", 10));
+
+	/* Another instance which doesn't know about dir stores its data. */
+	assert_success(stats_init(&cfg));
+	assert_failure(dcache_load(SANDBOX_PATH "/nope"));
+	dcache_set_at(other, 0, 20, DCACHE_UNKNOWN);
+	assert_success(dcache_store(SANDBOX_PATH "/dcache", 10));
+
+	assert_success(stats_init(&cfg));
+	assert_success(dcache_load(SANDBOX_PATH "/dcache"));
+
+	uint64_t size;
+	dcache_get_at(dir, time(NULL) - 10, 0, &size, NULL);
+	assert_ulong_equal(10, size);
+	dcache_get_at(other, time(NULL) - 10, 0, &size, NULL);
+	assert_ulong_equal(20, size);
+
+	dcache_drop(SANDBOX_PATH "/dcache");
+	remove_dir(SANDBOX_PATH "/dir");
+}
+
+TEST(stored_sizes_are_found_via_symlinks, IF(not_windows))
+{
+	char dir[PATH_MAX + 1];
+	create_dir(SANDBOX_PATH "/dir");
+	assert_non_null(os_realpath(SANDBOX_PATH "/dir", dir));
+	assert_success(make_symlink("dir", SANDBOX_PATH "/link"));
+
+	dcache_set_at(dir, 0, 10, DCACHE_UNKNOWN);
+	assert_success(dcache_store(SANDBOX_PATH "/dcache", 10));
+
+	assert_success(stats_init(&cfg));
+	assert_success(dcache_load(SANDBOX_PATH "/dcache"));
+
+	uint64_t size;
+	dcache_get_at(SANDBOX_PATH "/link", time(NULL) - 10, 0, &size, NULL);
+	assert_ulong_equal(10, size);
+
+	dcache_drop(SANDBOX_PATH "/dcache");
+	remove_file(SANDBOX_PATH "/link");
+	remove_dir(SANDBOX_PATH "/dir");
+}
+
+TEST(misses_are_forgotten_on_loading_sizes)
+{
+	char dir1[PATH_MAX + 1], dir2[PATH_MAX + 1];
+	create_dir(SANDBOX_PATH "/dir1");
+	create_dir(SANDBOX_PATH "/dir2");
+	assert_non_null(os_realpath(SANDBOX_PATH "/dir1", dir1));
+	assert_non_null(os_realpath(SANDBOX_PATH "/dir2", dir2));
+
+	dcache_set_at(dir1, 0, 10, DCACHE_UNKNOWN);
+	assert_success(dcache_store(SANDBOX_PATH "/dcache", 10));
+	assert_success(stats_init(&cfg));
+	assert_success(dcache_load(SANDBOX_PATH "/dcache"));
+
+	uint64_t size;
+	dcache_get_at(dir2, time(NULL) - 10, 0, &size, NULL);
+	assert_ulong_equal(DCACHE_UNKNOWN, size);
+	dcache_get_at(dir2, time(NULL) - 10, 0, &size, NULL);
+	assert_ulong_equal(DCACHE_UNKNOWN, size);
+
+	dcache_set_at(dir2, 0, 20, DCACHE_UNKNOWN);
+	assert_success(dcache_store(SANDBOX_PATH "/dcache", 10));
+	assert_success(stats_init(&cfg));
+	assert_success(dcache_load(SANDBOX_PATH "/dcache"));
+
+	dcache_get_at(dir2, time(NULL) - 10, 0, &size, NULL);
+	assert_ulong_equal(20, size);
+
+	dcache_drop(SANDBOX_PATH "/dcache");
+	remove_dir(SANDBOX_PATH "/dir1");
+	remove_dir(SANDBOX_PATH "/dir2");
+}
+
+TEST(zero_limit_disables_storing)
+{
+	dcache_set_at(SANDBOX_PATH, 0, 10, DCACHE_UNKNOWN);
+	assert_success(dcache_store(SANDBOX_PATH "/dcache", 0));
+	assert_failure(dcache_load(SANDBOX_PATH "/dcache"));
+}
+
+TEST(only_subtree_is_listed)
+{
+	create_dir(SANDBOX_PATH "/a");
+	create_dir(SANDBOX_PATH "/a/b");
+	create_dir(SANDBOX_PATH "/ab");
+
+	char root[PATH_MAX + 1];
+	assert_non_null(os_realpath(SANDBOX_PATH "/a", root));
+
+	assert_success(dcache_set_at(SANDBOX_PATH "/a", 0, 1, 1));
+	assert_success(dcache_set_at(SANDBOX_PATH "/a/b", 0, 1, 1));
+	assert_success(dcache_set_at(SANDBOX_PATH "/ab", 0, 1, 1));
+
+	int count;
+	char **paths = dcache_list_under(root, &count);
+	assert_int_equal(2, count);
+	assert_string_equal(root, paths[0]);
+	assert_string_ends_with("/a/b", paths[1]);
+	assert_string_starts_with(root, paths[1]);
+	free_string_array(paths, count);
+
+	char missing[PATH_MAX + 1];
+	snprintf(missing, sizeof(missing), "%s/b/c", root);
+	paths = dcache_list_under(missing, &count);
+	assert_int_equal(0, count);
+	free_string_array(paths, count);
+
+	dcache_drop(SANDBOX_PATH "/dcache");
+
+	remove_dir(SANDBOX_PATH "/ab");
+	remove_dir(SANDBOX_PATH "/a/b");
+	remove_dir(SANDBOX_PATH "/a");
+}
+
 /* dir_entry_t::inode doesn't exist on Windows. */
 #ifndef _WIN32
 
@@ -329,6 +329,52 @@ TEST(cursor_is_moved_to_nearest_neighbour)
 	local_filter_cancel(&lwin);
 }
 
+TEST(narrowing_and_widening_local_filter_gives_correct_results)
+{
+	char path[PATH_MAX + 1];
+
+	flist_custom_start(&lwin, "test");
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/binary-data", cwd);
+	flist_custom_add(&lwin, path);
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/dos-eof", cwd);
+	flist_custom_add(&lwin, path);
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/two-lines", cwd);
+	flist_custom_add(&lwin, path);
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/very-long-line", cwd);
+	flist_custom_add(&lwin, path);
+	assert_true(flist_custom_finish(&lwin, CV_REGULAR, 0) == 0);
+
+	assert_int_equal(0, local_filter_set(&lwin, "e"));
+	assert_int_equal(3, lwin.list_rows);
+	assert_int_equal(1, lwin.filtered);
+
+	assert_int_equal(0, local_filter_set(&lwin, "ne"));
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("two-lines", lwin.dir_entry[0].name);
+	assert_string_equal("very-long-line", lwin.dir_entry[1].name);
+
+	assert_int_equal(0, local_filter_set(&lwin, "ines"));
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("two-lines", lwin.dir_entry[0].name);
+	assert_int_equal(3, lwin.filtered);
+
+	assert_int_equal(0, local_filter_set(&lwin, "ne"));
+	assert_int_equal(2, lwin.list_rows);
+
+	assert_int_equal(0, local_filter_set(&lwin, "[dt]"));
+	assert_int_equal(3, lwin.list_rows);
+	assert_string_equal("binary-data", lwin.dir_entry[0].name);
+	assert_string_equal("dos-eof", lwin.dir_entry[1].name);
+	assert_string_equal("two-lines", lwin.dir_entry[2].name);
+
+	assert_int_equal(1, local_filter_set(&lwin, "[dt]x"));
+
+	assert_false(local_filter_continue(&lwin));
+
+	local_filter_accept(&lwin, /*update_history=*/0);
+	assert_false(local_filter_continue(&lwin));
+}
+
 TEST(removed_filename_filter_is_stored)
 {
 	assert_success(filter_set(&lwin.auto_filter, "a"));
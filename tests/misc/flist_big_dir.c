@@ -0,0 +1,249 @@
+#include <stic.h>
+
+#include <sys/stat.h> /* S_ISREG() chmod() */
+
+#include <stdio.h> /* remove() snprintf() */
+#include <string.h> /* strcmp() strcpy() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/utils/fs.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+#include "../../src/sort.h"
+
+/* Number of files to create to make a directory "big". */
+#define NFILES 512
+
+static void create_files(void);
+static void remove_files(void);
+
+static view_t *const view = &lwin;
+
+SETUP()
+{
+	update_string(&cfg.slow_fs_list, "");
+
+	view_setup(view);
+	make_abs_path(view->curr_dir, sizeof(view->curr_dir), SANDBOX_PATH, "", NULL);
+
+	create_files();
+}
+
+TEARDOWN()
+{
+	view_teardown(view);
+	remove_files();
+
+	update_string(&cfg.slow_fs_list, NULL);
+}
+
+TEST(big_directory_is_read_completely_and_sorted)
+{
+	populate_dir_list(view, 0);
+
+	assert_int_equal(NFILES, view->list_rows);
+	assert_string_equal(".hidden-000", view->dir_entry[0].name);
+	assert_string_equal("file-000", view->dir_entry[NFILES/2].name);
+
+	int i;
+	for(i = 1; i < view->list_rows; ++i)
+	{
+		assert_true(strcmp(view->dir_entry[i - 1].name,
+					view->dir_entry[i].name) < 0);
+		assert_int_equal(FT_REG, view->dir_entry[i].type);
+	}
+}
+
+TEST(filters_are_applied_to_big_directory)
+{
+	view->hide_dot = 1;
+	populate_dir_list(view, 0);
+
+	assert_int_equal(NFILES/2, view->list_rows);
+	assert_int_equal(NFILES/2, view->filtered);
+	assert_string_equal("file-000", view->dir_entry[0].name);
+}
+
+TEST(reload_of_big_directory_preserves_selection)
+{
+	populate_dir_list(view, 0);
+	view->dir_entry[10].selected = 1;
+	view->selected_files = 1;
+
+	populate_dir_list(view, 1);
+
+	assert_int_equal(NFILES, view->list_rows);
+	assert_true(view->dir_entry[10].selected);
+	assert_int_equal(1, view->selected_files);
+}
+
+TEST(loading_does_not_change_current_directory)
+{
+	char cwd_before[PATH_MAX + 1], cwd_after[PATH_MAX + 1];
+	assert_non_null(get_cwd(cwd_before, sizeof(cwd_before)));
+
+	populate_dir_list(view, 0);
+	assert_int_equal(NFILES, view->list_rows);
+
+	assert_non_null(get_cwd(cwd_after, sizeof(cwd_after)));
+	assert_string_equal(cwd_before, cwd_after);
+}
+
+TEST(symlinks_are_resolved_without_changing_directory, IF(not_windows))
+{
+	char path[PATH_MAX + 1];
+	snprintf(path, sizeof(path), "%s/link", SANDBOX_PATH);
+	assert_success(make_symlink("file-000", path));
+
+	populate_dir_list(view, 0);
+	assert_int_equal(NFILES + 1, view->list_rows);
+
+	int pos = -1;
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		if(strcmp(view->dir_entry[i].name, "link") == 0)
+		{
+			pos = i;
+		}
+	}
+
+	assert_true(pos >= 0);
+	assert_int_equal(FT_LINK, view->dir_entry[pos].type);
+	fentry_load_meta(&view->dir_entry[pos]);
+	assert_true(S_ISREG(view->dir_entry[pos].mode));
+
+	assert_success(remove(path));
+}
+
+TEST(meta_data_is_loaded_on_demand, IF(not_windows))
+{
+	char path[PATH_MAX + 1];
+	snprintf(path, sizeof(path), "%s/file-000", SANDBOX_PATH);
+	assert_success(chmod(path, 0755));
+
+	populate_dir_list(view, 0);
+
+	dir_entry_t *const entry = &view->dir_entry[NFILES/2];
+	assert_string_equal("file-000", entry->name);
+	assert_true(entry->meta_pending);
+	assert_int_equal(FT_REG, entry->type);
+
+	fentry_load_meta(entry);
+	assert_false(entry->meta_pending);
+	assert_int_equal(FT_EXEC, entry->type);
+	assert_int_equal(0755, entry->mode & 0777);
+}
+
+TEST(current_entry_has_meta_data)
+{
+	populate_dir_list(view, 0);
+
+	view->list_pos = 3;
+	assert_false(get_current_entry(view)->meta_pending);
+}
+
+TEST(sorting_that_needs_meta_data_loads_it_for_all_entries)
+{
+	view_set_sort(view->sort, SK_BY_SIZE, SK_NONE);
+	populate_dir_list(view, 0);
+
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		assert_false(view->dir_entry[i].meta_pending);
+	}
+}
+
+TEST(decorated_ls_view_loads_meta_data_for_all_entries)
+{
+	strcpy(cfg.type_decs[FT_EXEC][DECORATION_SUFFIX], "*");
+	view->ls_view = 1;
+
+	populate_dir_list(view, 0);
+
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		assert_false(view->dir_entry[i].meta_pending);
+	}
+
+	view->ls_view = 0;
+	cfg.type_decs[FT_EXEC][DECORATION_SUFFIX][0] = '\0';
+}
+
+TEST(meta_data_of_whole_list_can_be_loaded)
+{
+	populate_dir_list(view, 0);
+	flist_load_meta(view);
+
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		assert_false(view->dir_entry[i].meta_pending);
+		assert_int_equal(FT_REG, view->dir_entry[i].type);
+		assert_true(view->dir_entry[i].mtime != 0);
+	}
+}
+
+TEST(names_of_listing_are_stored_in_a_pool)
+{
+	populate_dir_list(view, 0);
+
+	str_pool_t *const pool = view->dir_entry[0].name_pool;
+	assert_non_null(pool);
+
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		assert_true(view->dir_entry[i].name_pool == pool);
+	}
+
+	fentry_rename(view, &view->dir_entry[0], "renamed");
+	assert_null(view->dir_entry[0].name_pool);
+	assert_string_equal("renamed", view->dir_entry[0].name);
+
+	/* Names of the previous listing remain valid while it's being replaced. */
+	populate_dir_list(view, 1);
+	assert_int_equal(NFILES, view->list_rows);
+	assert_true(view->dir_entry[1].name_pool != NULL);
+}
+
+static void
+create_files(void)
+{
+	int i;
+	for(i = 0; i < NFILES/2; ++i)
+	{
+		char path[PATH_MAX + 1];
+
+		snprintf(path, sizeof(path), "%s/file-%03d", SANDBOX_PATH, i);
+		create_file(path);
+
+		snprintf(path, sizeof(path), "%s/.hidden-%03d", SANDBOX_PATH, i);
+		create_file(path);
+	}
+}
+
+static void
+remove_files(void)
+{
+	int i;
+	for(i = 0; i < NFILES/2; ++i)
+	{
+		char path[PATH_MAX + 1];
+
+		snprintf(path, sizeof(path), "%s/file-%03d", SANDBOX_PATH, i);
+		remove_file(path);
+
+		snprintf(path, sizeof(path), "%s/.hidden-%03d", SANDBOX_PATH, i);
+		remove_file(path);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
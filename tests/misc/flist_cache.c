@@ -0,0 +1,182 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fswatch.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+#include "../../src/flist_cache.h"
+
+static void visit(const char name[]);
+
+static view_t *const view = &lwin;
+
+SETUP()
+{
+	cfg.list_cache = 1;
+	flist_cache_clear();
+	view_setup(view);
+
+	create_dir(SANDBOX_PATH "/dir");
+	create_file(SANDBOX_PATH "/dir/a");
+	create_file(SANDBOX_PATH "/dir/.b");
+	create_dir(SANDBOX_PATH "/other");
+}
+
+TEARDOWN()
+{
+	view_teardown(view);
+	flist_cache_clear();
+	cfg.list_cache = 0;
+
+	remove_file(SANDBOX_PATH "/dir/a");
+	remove_file(SANDBOX_PATH "/dir/.b");
+	remove_dir(SANDBOX_PATH "/dir");
+	remove_dir(SANDBOX_PATH "/other");
+}
+
+TEST(listing_is_reused_on_returning_to_directory, IF(fswatch_tracks_files))
+{
+	flist_cache_stats_t stats;
+
+	visit("dir");
+	visit("other");
+	visit("dir");
+
+	flist_cache_get_stats(&stats);
+	assert_int_equal(2, stats.count);
+	assert_int_equal(1, stats.hits);
+	assert_int_equal(2, stats.misses);
+
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal(".b", view->dir_entry[0].name);
+	assert_string_equal("a", view->dir_entry[1].name);
+	assert_true(view->dir_entry[1].origin == view->curr_dir);
+}
+
+TEST(selection_is_not_restored)
+{
+	visit("dir");
+	view->dir_entry[1].selected = 1;
+	view->selected_files = 1;
+	populate_dir_list(view, /*reload=*/1);
+
+	visit("other");
+	visit("dir");
+
+	assert_false(view->dir_entry[1].selected);
+	assert_int_equal(0, view->selected_files);
+}
+
+TEST(changed_directory_is_read_again)
+{
+	flist_cache_stats_t stats;
+
+	visit("dir");
+	create_file(SANDBOX_PATH "/dir/c");
+	visit("other");
+	visit("dir");
+
+	flist_cache_get_stats(&stats);
+	assert_int_equal(0, stats.hits);
+	assert_int_equal(3, view->list_rows);
+	assert_string_equal("c", view->dir_entry[2].name);
+
+	remove_file(SANDBOX_PATH "/dir/c");
+}
+
+TEST(change_of_a_file_invalidates_listing)
+{
+	flist_cache_stats_t stats;
+
+	visit("dir");
+	assert_ulong_equal(0, view->dir_entry[1].size);
+
+	make_file(SANDBOX_PATH "/dir/a", "contents");
+	visit("other");
+	visit("dir");
+
+	flist_cache_get_stats(&stats);
+	assert_int_equal(0, stats.hits);
+	assert_string_equal("a", view->dir_entry[1].name);
+	assert_ulong_equal(8, view->dir_entry[1].size);
+}
+
+TEST(listing_is_not_reused_with_different_parameters)
+{
+	flist_cache_stats_t stats;
+
+	visit("dir");
+	view->hide_dot = 1;
+	visit("dir");
+
+	flist_cache_get_stats(&stats);
+	assert_int_equal(0, stats.hits);
+	assert_int_equal(1, view->list_rows);
+	assert_int_equal(1, view->filtered);
+	assert_string_equal("a", view->dir_entry[0].name);
+}
+
+TEST(zero_limit_disables_the_cache)
+{
+	flist_cache_stats_t stats;
+
+	cfg.list_cache = 0;
+	visit("dir");
+	visit("dir");
+
+	flist_cache_get_stats(&stats);
+	assert_int_equal(0, stats.count);
+	assert_int_equal(0, stats.hits);
+}
+
+TEST(least_recently_used_listings_are_dropped, IF(fswatch_tracks_files))
+{
+	flist_cache_stats_t stats;
+
+	visit("dir");
+
+	int i;
+	for(i = 0; i < 16; ++i)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "other/%02d", i);
+
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), "%s/%s", SANDBOX_PATH, name);
+		create_dir(path);
+
+		visit(name);
+	}
+
+	flist_cache_get_stats(&stats);
+	assert_int_equal(16, stats.count);
+
+	visit("dir");
+	flist_cache_get_stats(&stats);
+	assert_int_equal(0, stats.hits);
+
+	for(i = 0; i < 16; ++i)
+	{
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), "%s/other/%02d", SANDBOX_PATH, i);
+		remove_dir(path);
+	}
+}
+
+/* Loads listing of a directory in sandbox. */
+static void
+visit(const char name[])
+{
+	make_abs_path(view->curr_dir, sizeof(view->curr_dir), SANDBOX_PATH, name,
+			NULL);
+	populate_dir_list(view, /*reload=*/0);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,175 @@
+#include <stic.h>
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/filelist.h"
+#include "../../src/sort.h"
+#include "../../src/status.h"
+
+static int using_inotify(void);
+
+static view_t *const view = &lwin;
+
+SETUP()
+{
+	view_setup(view);
+	make_abs_path(view->curr_dir, sizeof(view->curr_dir), SANDBOX_PATH, "", NULL);
+	curr_stats.load_stage = 2;
+
+	create_file(SANDBOX_PATH "/b");
+	create_file(SANDBOX_PATH "/d");
+
+	populate_dir_list(view, /*reload=*/0);
+	assert_int_equal(2, view->list_rows);
+	(void)ui_view_query_scheduled_event(view);
+}
+
+TEARDOWN()
+{
+	curr_stats.load_stage = 0;
+	view_teardown(view);
+
+	remove_file(SANDBOX_PATH "/b");
+	remove_file(SANDBOX_PATH "/d");
+}
+
+TEST(new_files_are_inserted_in_sorted_order, IF(using_inotify))
+{
+	create_file(SANDBOX_PATH "/a");
+	create_file(SANDBOX_PATH "/c");
+	check_if_filelist_has_changed(view);
+
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+	assert_int_equal(4, view->list_rows);
+	assert_string_equal("a", view->dir_entry[0].name);
+	assert_string_equal("b", view->dir_entry[1].name);
+	assert_string_equal("c", view->dir_entry[2].name);
+	assert_string_equal("d", view->dir_entry[3].name);
+
+	remove_file(SANDBOX_PATH "/a");
+	remove_file(SANDBOX_PATH "/c");
+}
+
+TEST(removed_files_are_dropped_keeping_selection, IF(using_inotify))
+{
+	view->dir_entry[1].selected = 1;
+	view->selected_files = 1;
+	view->list_pos = 1;
+
+	remove_file(SANDBOX_PATH "/b");
+	check_if_filelist_has_changed(view);
+
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+	assert_int_equal(1, view->list_rows);
+	assert_string_equal("d", view->dir_entry[0].name);
+	assert_true(view->dir_entry[0].selected);
+	assert_int_equal(1, view->selected_files);
+	assert_int_equal(0, view->list_pos);
+
+	create_file(SANDBOX_PATH "/b");
+}
+
+TEST(updated_files_are_moved_if_order_changes, IF(using_inotify))
+{
+	view_set_sort(view->sort, SK_BY_SIZE, SK_NONE);
+	populate_dir_list(view, /*reload=*/1);
+	(void)ui_view_query_scheduled_event(view);
+
+	make_file(SANDBOX_PATH "/b", "some content");
+	check_if_filelist_has_changed(view);
+
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("d", view->dir_entry[0].name);
+	assert_string_equal("b", view->dir_entry[1].name);
+	assert_int_equal(12, view->dir_entry[1].size);
+}
+
+TEST(filtered_files_are_counted, IF(using_inotify))
+{
+	view->hide_dot = 1;
+
+	create_file(SANDBOX_PATH "/.hidden");
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+	assert_int_equal(2, view->list_rows);
+	assert_int_equal(1, view->filtered);
+
+	remove_file(SANDBOX_PATH "/.hidden");
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+	assert_int_equal(2, view->list_rows);
+	assert_int_equal(0, view->filtered);
+}
+
+TEST(massive_changes_cause_reload, IF(using_inotify))
+{
+	create_file(SANDBOX_PATH "/a");
+	create_file(SANDBOX_PATH "/c");
+	create_file(SANDBOX_PATH "/e");
+	check_if_filelist_has_changed(view);
+
+	assert_int_equal(UUE_RELOAD, ui_view_query_scheduled_event(view));
+	assert_int_equal(2, view->list_rows);
+
+	remove_file(SANDBOX_PATH "/a");
+	remove_file(SANDBOX_PATH "/c");
+	remove_file(SANDBOX_PATH "/e");
+}
+
+TEST(reload_puts_new_files_in_order)
+{
+	create_file(SANDBOX_PATH "/a");
+	create_file(SANDBOX_PATH "/c");
+	populate_dir_list(view, /*reload=*/1);
+
+	assert_int_equal(4, view->list_rows);
+	assert_string_equal("a", view->dir_entry[0].name);
+	assert_string_equal("b", view->dir_entry[1].name);
+	assert_string_equal("c", view->dir_entry[2].name);
+	assert_string_equal("d", view->dir_entry[3].name);
+
+	remove_file(SANDBOX_PATH "/a");
+	remove_file(SANDBOX_PATH "/c");
+}
+
+TEST(reload_moves_entries_that_got_out_of_order)
+{
+	view_set_sort(view->sort, SK_BY_SIZE, SK_NONE);
+	populate_dir_list(view, /*reload=*/1);
+	assert_string_equal("b", view->dir_entry[0].name);
+
+	make_file(SANDBOX_PATH "/b", "some content");
+	populate_dir_list(view, /*reload=*/1);
+
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("d", view->dir_entry[0].name);
+	assert_string_equal("b", view->dir_entry[1].name);
+}
+
+TEST(reload_after_change_of_sorting_sorts_the_list)
+{
+	view_set_sort(view->sort, -SK_BY_NAME, SK_NONE);
+	populate_dir_list(view, /*reload=*/1);
+
+	assert_int_equal(2, view->list_rows);
+	assert_string_equal("d", view->dir_entry[0].name);
+	assert_string_equal("b", view->dir_entry[1].name);
+}
+
+static int
+using_inotify(void)
+{
+#ifdef HAVE_INOTIFY
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
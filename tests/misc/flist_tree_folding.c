@@ -1,6 +1,7 @@
 #include <stic.h>
 
 #include <stdarg.h> /* va_list va_start() va_arg() va_end() */
+#include <unistd.h> /* usleep() */
 
 #include <test-utils.h>
 
@@ -23,6 +24,7 @@ static void column_line_print(const char buf[], int offset, AlignType align,
 		const char full_column[], const format_info_t *info);
 static int build_custom_view(view_t *view, ...);
 static void toggle_fold_and_update(view_t *view);
+static void wait_for_subtree(view_t *view);
 
 static char cwd[PATH_MAX + 1];
 
@@ -415,6 +417,96 @@ TEST(lazy_unfolding)
 	assert_int_equal(7, lwin.list_rows);
 }
 
+TEST(unfolding_reads_only_the_subtree)
+{
+	create_dir(SANDBOX_PATH "/a");
+	create_file(SANDBOX_PATH "/a/z");
+	create_file(SANDBOX_PATH "/a/m");
+	create_dir(SANDBOX_PATH "/b");
+
+	assert_success(load_limited_tree(&lwin, SANDBOX_PATH, cwd, 0));
+	assert_int_equal(2, lwin.list_rows);
+
+	/* Not visible until the whole tree is reloaded. */
+	create_file(SANDBOX_PATH "/c");
+
+	lwin.list_pos = 0;
+	assert_string_equal("a", lwin.dir_entry[lwin.list_pos].name);
+	flist_toggle_fold(&lwin);
+	wait_for_subtree(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	validate_tree(&lwin);
+
+	assert_int_equal(4, lwin.list_rows);
+	assert_string_equal("a", lwin.dir_entry[0].name);
+	assert_false(lwin.dir_entry[0].folded);
+	assert_string_equal("m", lwin.dir_entry[1].name);
+	assert_string_equal("z", lwin.dir_entry[2].name);
+	assert_string_equal("b", lwin.dir_entry[3].name);
+	assert_true(lwin.dir_entry[3].folded);
+
+	remove_file(SANDBOX_PATH "/c");
+	remove_dir(SANDBOX_PATH "/b");
+	remove_file(SANDBOX_PATH "/a/m");
+	remove_file(SANDBOX_PATH "/a/z");
+	remove_dir(SANDBOX_PATH "/a");
+}
+
+TEST(unfolding_keeps_folded_subtrees_folded)
+{
+	create_dir(SANDBOX_PATH "/a");
+	create_dir(SANDBOX_PATH "/a/sub");
+	create_file(SANDBOX_PATH "/a/sub/f");
+
+	assert_success(load_tree(&lwin, SANDBOX_PATH, cwd));
+	assert_int_equal(3, lwin.list_rows);
+
+	lwin.list_pos = 1;
+	assert_string_equal("sub", lwin.dir_entry[lwin.list_pos].name);
+	toggle_fold_and_update(&lwin);
+	assert_int_equal(2, lwin.list_rows);
+
+	lwin.list_pos = 0;
+	assert_string_equal("a", lwin.dir_entry[lwin.list_pos].name);
+	toggle_fold_and_update(&lwin);
+	assert_int_equal(1, lwin.list_rows);
+
+	flist_toggle_fold(&lwin);
+	wait_for_subtree(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	validate_tree(&lwin);
+
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("a", lwin.dir_entry[0].name);
+	assert_false(lwin.dir_entry[0].folded);
+	assert_string_equal("sub", lwin.dir_entry[1].name);
+	assert_true(lwin.dir_entry[1].folded);
+
+	remove_file(SANDBOX_PATH "/a/sub/f");
+	remove_dir(SANDBOX_PATH "/a/sub");
+	remove_dir(SANDBOX_PATH "/a");
+}
+
+TEST(refolding_drops_subtree_that_is_being_read)
+{
+	create_dir(SANDBOX_PATH "/a");
+	create_file(SANDBOX_PATH "/a/f");
+
+	assert_success(load_limited_tree(&lwin, SANDBOX_PATH, cwd, 0));
+	assert_int_equal(1, lwin.list_rows);
+
+	lwin.list_pos = 0;
+	flist_toggle_fold(&lwin);
+	assert_non_null(lwin.subtree_job);
+	flist_toggle_fold(&lwin);
+	assert_null(lwin.subtree_job);
+	assert_true(lwin.dir_entry[0].folded);
+	assert_int_equal(UUE_RELOAD, ui_view_query_scheduled_event(&lwin));
+
+	remove_file(SANDBOX_PATH "/a/f");
+	remove_dir(SANDBOX_PATH "/a");
+}
+
 TEST(lazy_unfolding_and_filtering)
 {
 	(void)filter_set(&lwin.local_filter.filter, "^[^1]+$");
@@ -481,6 +573,10 @@ static void
 toggle_fold_and_update(view_t *view)
 {
 	flist_toggle_fold(view);
+	if(view->subtree_job != NULL)
+	{
+		wait_for_subtree(view);
+	}
 
 	validate_tree(&lwin);
 
@@ -491,5 +587,17 @@ toggle_fold_and_update(view_t *view)
 	validate_tree(&lwin);
 }
 
+/* Waits until subtree of just unfolded directory is inserted into the list. */
+static void
+wait_for_subtree(view_t *view)
+{
+	assert_non_null(view->subtree_job);
+	while(!flist_fold_continue(view))
+	{
+		usleep(1000);
+	}
+	assert_null(view->subtree_job);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 : */
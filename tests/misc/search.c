@@ -2,12 +2,15 @@
 
 #include <unistd.h> /* chdir() */
 
-#include <string.h> /* strcpy() */
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* strcpy() strdup() */
 
 #include <test-utils.h>
 
 #include "../../src/cfg/config.h"
 #include "../../src/modes/normal.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
 #include "../../src/utils/fs.h"
 #include "../../src/filelist.h"
 #include "../../src/search.h"
@@ -93,6 +96,86 @@ TEST(search_finds_matching_files_and_numbers_them)
 	assert_int_equal(2, lwin.dir_entry[2].search_match);
 }
 
+TEST(matches_are_numbered_in_order_when_matching_starts_in_the_middle)
+{
+	lwin.top_line = 2;
+	lwin.window_cells = 1;
+	lwin.list_pos = 2;
+
+	search_pattern(&lwin, "dos", /*stash_selection=*/cfg.hl_search,
+			/*select_matches=*/cfg.hl_search);
+	assert_int_equal(2, lwin.matches);
+	assert_int_equal(1, lwin.dir_entry[1].search_match);
+	assert_int_equal(2, lwin.dir_entry[2].search_match);
+
+	/* Small list is matched at once. */
+	assert_false(search_continue(&lwin));
+
+	lwin.top_line = 0;
+	lwin.window_cells = 0;
+	lwin.list_pos = 0;
+}
+
+TEST(large_list_is_matched_in_several_passes)
+{
+	enum { NENTRIES = 3000 };
+
+	free_dir_entries(&lwin.dir_entry, &lwin.list_rows);
+	lwin.dir_entry = dynarray_cextend(NULL, NENTRIES*sizeof(*lwin.dir_entry));
+	lwin.list_rows = NENTRIES;
+
+	int i;
+	for(i = 0; i < NENTRIES; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "file%04d", i);
+		lwin.dir_entry[i].name = strdup(name);
+		lwin.dir_entry[i].type = FT_REG;
+		lwin.dir_entry[i].origin = lwin.curr_dir;
+	}
+
+	lwin.top_line = 1500;
+	lwin.window_cells = 10;
+	lwin.list_pos = 1500;
+
+	/* Exhausted budget leaves one chunk per pass. */
+	search_budget_ms = 0;
+
+	search_pattern(&lwin, "file", /*stash_selection=*/0, /*select_matches=*/0);
+	assert_non_null(lwin.search_state);
+	assert_int_equal(1024, lwin.matches);
+	assert_true(lwin.dir_entry[1500].search_match != 0);
+	assert_true(lwin.dir_entry[2523].search_match != 0);
+	assert_int_equal(0, lwin.dir_entry[1499].search_match);
+	assert_int_equal(0, lwin.dir_entry[2524].search_match);
+
+	/* Chunk before the cursor goes next. */
+	assert_true(search_continue(&lwin));
+	assert_non_null(lwin.search_state);
+	assert_int_equal(2048, lwin.matches);
+	assert_true(lwin.dir_entry[476].search_match != 0);
+	assert_int_equal(0, lwin.dir_entry[475].search_match);
+
+	int passes = 0;
+	while(search_continue(&lwin))
+	{
+		++passes;
+	}
+	assert_int_equal(2, passes);
+
+	assert_null(lwin.search_state);
+	assert_int_equal(NENTRIES, lwin.matches);
+	for(i = 0; i < NENTRIES; ++i)
+	{
+		assert_int_equal(i + 1, lwin.dir_entry[i].search_match);
+	}
+
+	search_budget_ms = 30;
+	lwin.top_line = 0;
+	lwin.window_cells = 0;
+	lwin.list_pos = 0;
+}
+
 TEST(cursor_can_be_positioned_on_first_match)
 {
 	lwin.list_pos = 0;
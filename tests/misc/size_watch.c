@@ -0,0 +1,229 @@
+#include <stic.h>
+
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fopen() fputs() remove() snprintf() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/cancellation.h"
+#include "../../src/utils/str.h"
+#include "../../src/fops_misc.h"
+#include "../../src/size_watch.h"
+#include "../../src/status.h"
+
+static void check(void);
+static void append(const char path[], const char text[]);
+static uint64_t cached_size(const char path[]);
+static int using_inotify(void);
+
+static char root[PATH_MAX + 1];
+static char dir[PATH_MAX + 16];
+static char sub[PATH_MAX + 16];
+
+SETUP()
+{
+	update_string(&cfg.shell, "");
+	assert_success(stats_init(&cfg));
+
+	view_setup(&lwin);
+	view_setup(&rwin);
+
+	create_dir(SANDBOX_PATH "/dir");
+	create_dir(SANDBOX_PATH "/dir/sub");
+	make_file(SANDBOX_PATH "/dir/sub/file", "12345");
+
+	assert_non_null(os_realpath(SANDBOX_PATH, root));
+	snprintf(dir, sizeof(dir), "%s/dir", root);
+	snprintf(sub, sizeof(sub), "%s/dir/sub", root);
+
+	copy_str(lwin.curr_dir, sizeof(lwin.curr_dir), root);
+	copy_str(rwin.curr_dir, sizeof(rwin.curr_dir), root);
+
+	assert_ulong_equal(5, fops_dir_size(dir, 1, &no_cancellation));
+	cfg.size_watch = 1;
+	size_watch_set_modify_delay(0);
+}
+
+TEARDOWN()
+{
+	cfg.size_watch = 0;
+	size_watch_check();
+	wait_for_bg();
+	size_watch_set_modify_delay(1000);
+
+	remove_file(SANDBOX_PATH "/dir/sub/file");
+	(void)remove(SANDBOX_PATH "/dir/sub/new");
+	remove_dir(SANDBOX_PATH "/dir/sub");
+	remove_dir(SANDBOX_PATH "/dir");
+
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+
+	update_string(&cfg.shell, NULL);
+}
+
+TEST(change_of_file_is_propagated_to_parents, IF(using_inotify))
+{
+	size_watch_check();
+
+	append(SANDBOX_PATH "/dir/sub/file", "678");
+	check();
+
+	assert_ulong_equal(8, cached_size(sub));
+	assert_ulong_equal(8, cached_size(dir));
+}
+
+TEST(new_files_are_accounted_for, IF(using_inotify))
+{
+	size_watch_check();
+
+	make_file(SANDBOX_PATH "/dir/sub/new", "12");
+	check();
+
+	assert_ulong_equal(7, cached_size(sub));
+	assert_ulong_equal(7, cached_size(dir));
+
+	remove_file(SANDBOX_PATH "/dir/sub/new");
+	check();
+
+	assert_ulong_equal(5, cached_size(sub));
+	assert_ulong_equal(5, cached_size(dir));
+}
+
+TEST(views_are_updated_on_changes, IF(using_inotify))
+{
+	size_watch_check();
+	(void)ui_view_query_scheduled_event(&lwin);
+	(void)ui_view_query_scheduled_event(&rwin);
+
+	append(SANDBOX_PATH "/dir/sub/file", "6");
+	check();
+
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&rwin));
+}
+
+TEST(sizes_are_applied_on_next_check, IF(using_inotify))
+{
+	size_watch_check();
+
+	append(SANDBOX_PATH "/dir/sub/file", "678");
+	size_watch_check();
+	wait_for_bg();
+
+	assert_ulong_equal(5, cached_size(sub));
+	assert_ulong_equal(5, cached_size(dir));
+
+	size_watch_check();
+
+	assert_ulong_equal(8, cached_size(sub));
+	assert_ulong_equal(8, cached_size(dir));
+}
+
+TEST(new_subdirectories_are_calculated, IF(using_inotify))
+{
+	size_watch_check();
+
+	create_dir(SANDBOX_PATH "/dir/sub/new");
+	make_file(SANDBOX_PATH "/dir/sub/new/file", "12");
+	check();
+
+	char new_dir[PATH_MAX + 16];
+	snprintf(new_dir, sizeof(new_dir), "%s/dir/sub/new", root);
+	assert_ulong_equal(2, cached_size(new_dir));
+	assert_ulong_equal(7, cached_size(sub));
+	assert_ulong_equal(7, cached_size(dir));
+
+	remove_file(SANDBOX_PATH "/dir/sub/new/file");
+	remove_dir(SANDBOX_PATH "/dir/sub/new");
+}
+
+TEST(own_updates_do_not_change_generation_of_cache, IF(using_inotify))
+{
+	size_watch_check();
+	const unsigned int gen = dcache_generation();
+
+	append(SANDBOX_PATH "/dir/sub/file", "678");
+	check();
+
+	assert_ulong_equal(8, cached_size(sub));
+	assert_true(dcache_generation() == gen);
+}
+
+TEST(new_subdirectories_are_watched, IF(using_inotify))
+{
+	size_watch_check();
+
+	create_dir(SANDBOX_PATH "/dir/sub/new");
+	check();
+
+	make_file(SANDBOX_PATH "/dir/sub/new/file", "12");
+	check();
+
+	assert_ulong_equal(7, cached_size(sub));
+	assert_ulong_equal(7, cached_size(dir));
+
+	remove_file(SANDBOX_PATH "/dir/sub/new/file");
+	remove_dir(SANDBOX_PATH "/dir/sub/new");
+}
+
+TEST(nothing_is_updated_when_option_is_off)
+{
+	cfg.size_watch = 0;
+	size_watch_check();
+
+	append(SANDBOX_PATH "/dir/sub/file", "678");
+	size_watch_check();
+
+	assert_ulong_equal(5, cached_size(sub));
+	assert_ulong_equal(5, cached_size(dir));
+}
+
+/* Processes changes waiting for their recalculation to finish. */
+static void
+check(void)
+{
+	size_watch_check();
+	wait_for_bg();
+	size_watch_check();
+}
+
+/* Appends text to a file. */
+static void
+append(const char path[], const char text[])
+{
+	FILE *const fp = fopen(path, "a");
+	assert_non_null(fp);
+	fputs(text, fp);
+	fclose(fp);
+}
+
+/* Retrieves cached size of a directory ignoring its modification time.
+ * Returns the size. */
+static uint64_t
+cached_size(const char path[])
+{
+	struct stat st;
+	assert_success(os_stat(path, &st));
+
+	uint64_t size;
+	dcache_get_at(path, 0, st.st_ino, &size, NULL);
+	return size;
+}
+
+static int
+using_inotify(void)
+{
+#ifdef HAVE_INOTIFY
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -497,5 +497,48 @@ TEST(inode_sorting_works)
 
 #endif
 
+TEST(descending_numeric_sort_keeps_parent_dir_first)
+{
+	view_teardown(&lwin);
+	view_setup(&lwin);
+
+	lwin.list_rows = 4;
+	lwin.dir_entry = dynarray_cextend(NULL,
+			lwin.list_rows*sizeof(*lwin.dir_entry));
+	lwin.dir_entry[0].name = strdup("b");
+	lwin.dir_entry[0].type = FT_REG;
+	lwin.dir_entry[0].mtime = 10;
+	lwin.dir_entry[1].name = strdup("a");
+	lwin.dir_entry[1].type = FT_REG;
+	lwin.dir_entry[1].mtime = 10;
+	lwin.dir_entry[2].name = strdup("..");
+	lwin.dir_entry[2].type = FT_DIR;
+	lwin.dir_entry[3].name = strdup("c");
+	lwin.dir_entry[3].type = FT_REG;
+	lwin.dir_entry[3].mtime = 20;
+
+	view_set_sort(lwin.sort, -SK_BY_TIME_MODIFIED, SK_NONE);
+	sort_view(&lwin);
+
+	assert_string_equal("..", lwin.dir_entry[0].name);
+	assert_string_equal("c", lwin.dir_entry[1].name);
+	assert_string_equal("b", lwin.dir_entry[2].name);
+	assert_string_equal("a", lwin.dir_entry[3].name);
+}
+
+TEST(distant_times_are_ordered_correctly)
+{
+	lwin.dir_entry[0].mtime = (time_t)4000000000LL;
+	lwin.dir_entry[1].mtime = 0;
+	lwin.dir_entry[2].mtime = -1;
+
+	view_set_sort(lwin.sort, SK_BY_TIME_MODIFIED, SK_NONE);
+	sort_view(&lwin);
+
+	assert_string_equal("A", lwin.dir_entry[0].name);
+	assert_string_equal("_", lwin.dir_entry[1].name);
+	assert_string_equal("a", lwin.dir_entry[2].name);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -11,6 +11,8 @@
 #include "../../src/cfg/config.h"
 #include "../../src/cfg/info.h"
 #include "../../src/cfg/info_chars.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
 #include "../../src/ui/column_view.h"
 #include "../../src/ui/ui.h"
 #include "../../src/utils/matcher.h"
@@ -533,5 +535,27 @@ TEST(options_round_trip)
 	opt_handlers_teardown();
 }
 
+TEST(caches_are_stored_only_if_vifminfo_includes_them)
+{
+	char dir[PATH_MAX + 1];
+	assert_non_null(os_realpath(SANDBOX_PATH, dir));
+
+	cfg.size_cache = 10;
+	assert_success(stats_reset(&cfg));
+	dcache_set_at(dir, 0, 10, DCACHE_UNKNOWN);
+
+	state_store();
+	no_remove_file(SANDBOX_PATH "/dcache");
+	remove_file(SANDBOX_PATH "/vifminfo.json");
+
+	cfg.vifm_info = VINFO_CACHES;
+	state_store();
+	remove_file(SANDBOX_PATH "/dcache");
+	remove_file(SANDBOX_PATH "/vifminfo.json");
+
+	assert_success(stats_reset(&cfg));
+	cfg.size_cache = 0;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
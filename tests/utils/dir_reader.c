@@ -0,0 +1,100 @@
+#include <stic.h>
+
+#include <unistd.h> /* usleep() */
+
+#include <stdio.h> /* remove() snprintf() */
+
+#include <test-utils.h>
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/utils/dir_reader.h"
+
+/* Number of files, which is enough for more batches than can be queued. */
+#define NFILES 2000
+
+static void create_files(void);
+static void remove_files(void);
+
+SETUP()
+{
+	create_files();
+}
+
+TEARDOWN()
+{
+	remove_files();
+}
+
+TEST(queue_of_batches_is_bounded, IF(not_windows))
+{
+	dir_reader_t *const reader = dir_reader_start(SANDBOX_PATH, 1);
+	assert_non_null(reader);
+
+	int i;
+	for(i = 0; i < 1000 && dir_reader_queued(reader) < 4; ++i)
+	{
+		usleep(1000);
+	}
+	usleep(20000);
+	assert_int_equal(4, dir_reader_queued(reader));
+
+	int count = 0;
+	DirReaderState state;
+	do
+	{
+		dir_reader_batch_t batch;
+		state = dir_reader_next(reader, 100, &batch);
+		if(state == DRS_BATCH)
+		{
+			count += batch.count;
+			dir_reader_free_batch(&batch);
+		}
+	}
+	while(state == DRS_BATCH || state == DRS_TIMEOUT);
+
+	assert_int_equal(DRS_DONE, state);
+	assert_int_equal(NFILES, count);
+
+	dir_reader_free(reader);
+}
+
+TEST(reader_waiting_for_space_can_be_freed, IF(not_windows))
+{
+	dir_reader_t *const reader = dir_reader_start(SANDBOX_PATH, 1);
+	assert_non_null(reader);
+
+	int i;
+	for(i = 0; i < 1000 && dir_reader_queued(reader) < 4; ++i)
+	{
+		usleep(1000);
+	}
+
+	dir_reader_free(reader);
+}
+
+static void
+create_files(void)
+{
+	int i;
+	for(i = 0; i < NFILES; ++i)
+	{
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), "%s/%04d", SANDBOX_PATH, i);
+		create_file(path);
+	}
+}
+
+static void
+remove_files(void)
+{
+	int i;
+	for(i = 0; i < NFILES; ++i)
+	{
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), "%s/%04d", SANDBOX_PATH, i);
+		assert_success(remove(path));
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,165 @@
+#include <stic.h>
+
+#include <unistd.h> /* link() unlink() */
+
+#include <stdint.h> /* uint64_t */
+#include <string.h> /* strcmp() */
+
+#include <test-utils.h>
+
+#include "../../src/compat/pthread.h"
+#include "../../src/utils/dir_size.h"
+
+static int cached_a(const char path[], time_t mtime, uint64_t inode,
+		uint64_t *size, void *arg);
+static void count_done(const char path[], uint64_t inode,
+		const dir_size_t *size, void *arg);
+static int cancelled(void *arg);
+
+static pthread_mutex_t done_lock = PTHREAD_MUTEX_INITIALIZER;
+static int ndone;
+static uint64_t a_size;
+static uint64_t c_size;
+
+SETUP()
+{
+	create_dir(SANDBOX_PATH "/a");
+	create_dir(SANDBOX_PATH "/a/b");
+	make_file(SANDBOX_PATH "/a/b/file", "12345");
+	make_file(SANDBOX_PATH "/a/file", "123");
+	create_dir(SANDBOX_PATH "/c");
+	make_file(SANDBOX_PATH "/file", "1");
+
+	ndone = 0;
+	a_size = (uint64_t)-1;
+	c_size = (uint64_t)-1;
+}
+
+TEARDOWN()
+{
+	remove_file(SANDBOX_PATH "/file");
+	remove_dir(SANDBOX_PATH "/c");
+	remove_file(SANDBOX_PATH "/a/file");
+	remove_file(SANDBOX_PATH "/a/b/file");
+	remove_dir(SANDBOX_PATH "/a/b");
+	remove_dir(SANDBOX_PATH "/a");
+}
+
+TEST(size_of_tree_is_calculated_and_reported_per_directory)
+{
+	const dir_size_cbs_t cbs = { .done = &count_done };
+
+	dir_size_t size;
+	assert_success(dir_size_calc(SANDBOX_PATH, &cbs, &size));
+	assert_ulong_equal(9, size.size);
+
+	assert_int_equal(4, ndone);
+	assert_ulong_equal(8, a_size);
+}
+
+TEST(cached_sizes_are_used)
+{
+	const dir_size_cbs_t cbs = { .cached = &cached_a, .done = &count_done };
+
+	dir_size_t size;
+	assert_success(dir_size_calc(SANDBOX_PATH, &cbs, &size));
+	assert_ulong_equal(101, size.size);
+
+	/* Only root and "c" are read. */
+	assert_int_equal(2, ndone);
+}
+
+TEST(hard_links_are_counted_once, IF(not_windows))
+{
+	assert_success(link(SANDBOX_PATH "/a/b/file", SANDBOX_PATH "/c/link"));
+
+	dir_size_t size;
+	const dir_size_cbs_t cbs = { };
+	assert_success(dir_size_calc(SANDBOX_PATH, &cbs, &size));
+	assert_ulong_equal(9, size.size);
+
+	/* Subtree on its own still counts the file. */
+	assert_success(dir_size_calc(SANDBOX_PATH "/c", &cbs, &size));
+	assert_ulong_equal(5, size.size);
+
+	assert_success(unlink(SANDBOX_PATH "/c/link"));
+}
+
+TEST(every_directory_counts_hard_links_of_its_subtree, IF(not_windows))
+{
+	assert_success(link(SANDBOX_PATH "/a/b/file", SANDBOX_PATH "/c/link"));
+	assert_success(link(SANDBOX_PATH "/a/b/file", SANDBOX_PATH "/c/link2"));
+	assert_success(link(SANDBOX_PATH "/a/b/file", SANDBOX_PATH "/a/link"));
+
+	/* Repeat calculation to make different order of processing likely. */
+	int i;
+	for(i = 0; i < 10; ++i)
+	{
+		const dir_size_cbs_t cbs = { .done = &count_done };
+
+		dir_size_t size;
+		assert_success(dir_size_calc(SANDBOX_PATH, &cbs, &size));
+		assert_ulong_equal(9, size.size);
+		assert_ulong_equal(8, a_size);
+		assert_ulong_equal(5, c_size);
+	}
+
+	assert_success(unlink(SANDBOX_PATH "/a/link"));
+	assert_success(unlink(SANDBOX_PATH "/c/link2"));
+	assert_success(unlink(SANDBOX_PATH "/c/link"));
+}
+
+TEST(calculation_can_be_cancelled)
+{
+	const dir_size_cbs_t cbs = { .done = &count_done, .cancelled = &cancelled };
+
+	dir_size_t size = { .size = 77 };
+	assert_failure(dir_size_calc(SANDBOX_PATH, &cbs, &size));
+	assert_ulong_equal(77, size.size);
+}
+
+TEST(missing_root_is_an_error)
+{
+	const dir_size_cbs_t cbs = { };
+
+	dir_size_t size;
+	assert_failure(dir_size_calc(SANDBOX_PATH "/nope", &cbs, &size));
+}
+
+static int
+cached_a(const char path[], time_t mtime, uint64_t inode, uint64_t *size,
+		void *arg)
+{
+	if(strcmp(path, SANDBOX_PATH "/a") == 0)
+	{
+		*size = 100;
+		return 1;
+	}
+	return 0;
+}
+
+static void
+count_done(const char path[], uint64_t inode, const dir_size_t *size,
+		void *arg)
+{
+	pthread_mutex_lock(&done_lock);
+	++ndone;
+	if(strcmp(path, SANDBOX_PATH "/a") == 0)
+	{
+		a_size = size->size;
+	}
+	else if(strcmp(path, SANDBOX_PATH "/c") == 0)
+	{
+		c_size = size->size;
+	}
+	pthread_mutex_unlock(&done_lock);
+}
+
+static int
+cancelled(void *arg)
+{
+	return 1;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,208 @@
+#include <stic.h>
+
+#include <unistd.h> /* usleep() */
+
+#include <test-utils.h>
+
+#include "../../src/utils/dirwatch.h"
+#include "../../src/utils/string_array.h"
+
+static int using_inotify(void);
+static int not_using_inotify(void);
+
+static dirwatch_t *watch;
+
+SETUP()
+{
+	create_dir(SANDBOX_PATH "/a");
+	create_dir(SANDBOX_PATH "/b");
+
+	watch = dirwatch_create(0);
+}
+
+TEARDOWN()
+{
+	dirwatch_free(watch);
+
+	remove_dir(SANDBOX_PATH "/a");
+	remove_dir(SANDBOX_PATH "/b");
+}
+
+TEST(watcher_is_unavailable_without_inotify, IF(not_using_inotify))
+{
+	assert_null(watch);
+}
+
+TEST(changed_directories_are_reported_once, IF(using_inotify))
+{
+	assert_success(dirwatch_add(watch, SANDBOX_PATH "/a"));
+	assert_success(dirwatch_add(watch, SANDBOX_PATH "/b"));
+	assert_int_equal(2, dirwatch_count(watch));
+
+	char **paths;
+	assert_int_equal(0, dirwatch_poll(watch, &paths));
+
+	create_file(SANDBOX_PATH "/a/file");
+	make_file(SANDBOX_PATH "/a/file", "text");
+
+	assert_int_equal(1, dirwatch_poll(watch, &paths));
+	assert_string_equal(SANDBOX_PATH "/a", paths[0]);
+	free_string_array(paths, 1);
+
+	assert_int_equal(0, dirwatch_poll(watch, &paths));
+
+	remove_file(SANDBOX_PATH "/a/file");
+	assert_int_equal(1, dirwatch_poll(watch, &paths));
+	assert_string_equal(SANDBOX_PATH "/a", paths[0]);
+	free_string_array(paths, 1);
+}
+
+TEST(adding_directory_twice_does_not_duplicate_it, IF(using_inotify))
+{
+	assert_success(dirwatch_add(watch, SANDBOX_PATH "/a"));
+	assert_success(dirwatch_add(watch, SANDBOX_PATH "/a"));
+	assert_int_equal(1, dirwatch_count(watch));
+}
+
+TEST(missing_directory_is_not_added, IF(using_inotify))
+{
+	assert_failure(dirwatch_add(watch, SANDBOX_PATH "/nope"));
+	assert_int_equal(0, dirwatch_count(watch));
+}
+
+TEST(removed_directory_is_forgotten, IF(using_inotify))
+{
+	create_dir(SANDBOX_PATH "/a/sub");
+	assert_success(dirwatch_add(watch, SANDBOX_PATH "/a/sub"));
+	assert_int_equal(1, dirwatch_count(watch));
+
+	remove_dir(SANDBOX_PATH "/a/sub");
+
+	char **paths;
+	int count = dirwatch_poll(watch, &paths);
+	free_string_array(paths, count);
+	assert_int_equal(0, dirwatch_count(watch));
+}
+
+TEST(update_stops_watching_directories_that_were_not_added,
+		IF(using_inotify))
+{
+	assert_success(dirwatch_add(watch, SANDBOX_PATH "/a"));
+	assert_success(dirwatch_add(watch, SANDBOX_PATH "/b"));
+
+	dirwatch_begin_update(watch);
+	assert_success(dirwatch_add(watch, SANDBOX_PATH "/b"));
+	dirwatch_end_update(watch);
+	assert_int_equal(1, dirwatch_count(watch));
+
+	create_file(SANDBOX_PATH "/a/file");
+	create_file(SANDBOX_PATH "/b/file");
+
+	char **paths;
+	assert_int_equal(1, dirwatch_poll(watch, &paths));
+	assert_string_equal(SANDBOX_PATH "/b", paths[0]);
+	free_string_array(paths, 1);
+
+	remove_file(SANDBOX_PATH "/a/file");
+	remove_file(SANDBOX_PATH "/b/file");
+}
+
+TEST(update_keeps_changes_of_kept_directories, IF(using_inotify))
+{
+	assert_success(dirwatch_add(watch, SANDBOX_PATH "/a"));
+	create_file(SANDBOX_PATH "/a/file");
+
+	dirwatch_begin_update(watch);
+	assert_success(dirwatch_add(watch, SANDBOX_PATH "/a"));
+	dirwatch_end_update(watch);
+
+	char **paths;
+	assert_int_equal(1, dirwatch_poll(watch, &paths));
+	assert_string_equal(SANDBOX_PATH "/a", paths[0]);
+	free_string_array(paths, 1);
+
+	remove_file(SANDBOX_PATH "/a/file");
+}
+
+TEST(rewatched_directories_are_tracked, IF(using_inotify))
+{
+	int i;
+	for(i = 0; i < 100; ++i)
+	{
+		dirwatch_begin_update(watch);
+		assert_success(dirwatch_add(watch, SANDBOX_PATH "/b"));
+		if(i%2 == 0)
+		{
+			assert_success(dirwatch_add(watch, SANDBOX_PATH "/a"));
+		}
+		dirwatch_end_update(watch);
+		assert_int_equal(1 + (i%2 == 0), dirwatch_count(watch));
+	}
+
+	create_file(SANDBOX_PATH "/a/file");
+	create_file(SANDBOX_PATH "/b/file");
+
+	char **paths;
+	assert_int_equal(1, dirwatch_poll(watch, &paths));
+	assert_string_equal(SANDBOX_PATH "/b", paths[0]);
+	free_string_array(paths, 1);
+
+	dirwatch_begin_update(watch);
+	assert_success(dirwatch_add(watch, SANDBOX_PATH "/a"));
+	assert_success(dirwatch_add(watch, SANDBOX_PATH "/b"));
+	dirwatch_end_update(watch);
+
+	remove_file(SANDBOX_PATH "/a/file");
+	remove_file(SANDBOX_PATH "/b/file");
+
+	assert_int_equal(2, dirwatch_poll(watch, &paths));
+	free_string_array(paths, 2);
+}
+
+TEST(writes_are_reported_after_delay, IF(using_inotify))
+{
+	create_file(SANDBOX_PATH "/a/file");
+
+	dirwatch_free(watch);
+	watch = dirwatch_create(100);
+	assert_success(dirwatch_add(watch, SANDBOX_PATH "/a"));
+
+	make_file(SANDBOX_PATH "/a/file", "text");
+	make_file(SANDBOX_PATH "/a/file", "more text");
+
+	char **paths;
+	assert_int_equal(0, dirwatch_poll(watch, &paths));
+
+	usleep(150*1000);
+	assert_int_equal(1, dirwatch_poll(watch, &paths));
+	assert_string_equal(SANDBOX_PATH "/a", paths[0]);
+	free_string_array(paths, 1);
+
+	/* All writes are covered by a single report. */
+	usleep(150*1000);
+	assert_int_equal(0, dirwatch_poll(watch, &paths));
+
+	/* Changes of list of files aren't delayed. */
+	remove_file(SANDBOX_PATH "/a/file");
+	assert_int_equal(1, dirwatch_poll(watch, &paths));
+	free_string_array(paths, 1);
+}
+
+static int
+using_inotify(void)
+{
+#ifdef HAVE_INOTIFY
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+static int
+not_using_inotify(void)
+{
+	return !using_inotify();
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
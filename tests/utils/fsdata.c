@@ -256,6 +256,28 @@ TEST(tree_can_be_traversed)
 	fsdata_free(fsd);
 }
 
+TEST(subtree_can_be_traversed)
+{
+	int data = 0;
+	fsdata_t *const fsd = fsdata_create(0, 0);
+	assert_success(fsdata_set(fsd, "/no/such/path", &data, sizeof(data)));
+	assert_success(fsdata_set(fsd, "/other/path", &data, sizeof(data)));
+
+	nnodes = 0;
+	fsdata_traverse_under(fsd, "/no/such", &traverser, NULL);
+	assert_int_equal(2, nnodes);
+
+	nnodes = 0;
+	fsdata_traverse_under(fsd, "/", &traverser, NULL);
+	assert_int_equal(5, nnodes);
+
+	nnodes = 0;
+	fsdata_traverse_under(fsd, "/no/path", &traverser, NULL);
+	assert_int_equal(0, nnodes);
+
+	fsdata_free(fsd);
+}
+
 TEST(cancellation)
 {
 	int data = 0;
@@ -2,6 +2,8 @@
 
 #include <stdio.h> /* remove() snprintf() */
 
+#include <test-utils.h>
+
 #include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
 #include "../../src/utils/fs.h"
@@ -45,6 +47,26 @@ TEST(two_watches_for_the_same_directory)
 	fswatch_free(watch1);
 }
 
+TEST(watches_of_the_same_directory_are_independent, IF(using_inotify))
+{
+	fswatch_t *watch1, *watch2;
+
+	assert_non_null(watch1 = fswatch_create(sandbox));
+	assert_non_null(watch2 = fswatch_create(sandbox));
+
+	os_mkdir(SANDBOX_PATH "/testdir", 0700);
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(watch1));
+	assert_int_equal(FSWS_UNCHANGED, fswatch_poll(watch1));
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(watch2));
+
+	fswatch_free(watch1);
+
+	remove(SANDBOX_PATH "/testdir");
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(watch2));
+
+	fswatch_free(watch2);
+}
+
 TEST(events_are_accumulated, IF(using_inotify))
 {
 	fswatch_t *watch;
@@ -153,6 +175,77 @@ TEST(to_many_events_causes_banning_of_same_events, IF(using_inotify))
 	fswatch_free(watch);
 }
 
+TEST(changes_of_banned_file_are_reported_later, IF(using_inotify))
+{
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create(sandbox));
+
+	os_mkdir(SANDBOX_PATH "/testdir", 0700);
+
+	int i;
+	for(i = 0; i < 100; ++i)
+	{
+		os_chmod(SANDBOX_PATH "/testdir", 0777);
+		os_chmod(SANDBOX_PATH "/testdir", 0000);
+		(void)fswatch_poll(watch);
+	}
+
+	os_chmod(SANDBOX_PATH "/testdir", 0700);
+	assert_int_equal(FSWS_UNCHANGED, fswatch_poll(watch));
+
+	fswatch_change_t *changes;
+	int nchanges;
+
+	create_file(SANDBOX_PATH "/watched-file");
+	assert_int_equal(FSWS_UPDATED,
+			fswatch_poll_changes(watch, &changes, &nchanges));
+	assert_int_equal(2, nchanges);
+	assert_string_equal("watched-file", changes[0].name);
+	assert_string_equal("testdir", changes[1].name);
+	assert_true(changes[1].existed);
+	fswatch_free_changes(changes, nchanges);
+
+	assert_int_equal(FSWS_UNCHANGED, fswatch_poll(watch));
+
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/watched-file"));
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+}
+
+TEST(many_changes_are_listed, IF(using_inotify))
+{
+	enum { N = 300 };
+
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create(sandbox));
+
+	char path[PATH_MAX + 1];
+	int i;
+	for(i = 0; i < N; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/%03d", SANDBOX_PATH, i);
+		create_file(path);
+	}
+
+	fswatch_change_t *changes;
+	int nchanges;
+	assert_int_equal(FSWS_UPDATED,
+			fswatch_poll_changes(watch, &changes, &nchanges));
+	assert_int_equal(N, nchanges);
+	assert_string_equal("000", changes[0].name);
+	assert_string_equal("299", changes[N - 1].name);
+	fswatch_free_changes(changes, nchanges);
+
+	fswatch_free(watch);
+
+	for(i = 0; i < N; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/%03d", SANDBOX_PATH, i);
+		assert_success(remove(path));
+	}
+}
+
 TEST(file_recreation_removes_ban, IF(using_inotify))
 {
 	fswatch_t *watch;
@@ -182,6 +275,65 @@ TEST(file_recreation_removes_ban, IF(using_inotify))
 	assert_success(remove(SANDBOX_PATH "/testdir"));
 }
 
+TEST(changed_entries_are_reported_once, IF(using_inotify))
+{
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create(sandbox));
+
+	fswatch_change_t *changes;
+	int nchanges;
+
+	assert_int_equal(FSWS_UNCHANGED,
+			fswatch_poll_changes(watch, &changes, &nchanges));
+	assert_int_equal(0, nchanges);
+
+	create_file(SANDBOX_PATH "/watched-file");
+	assert_success(os_mkdir(SANDBOX_PATH "/testdir", 0700));
+	assert_success(os_chmod(SANDBOX_PATH "/testdir", 0777));
+
+	assert_int_equal(FSWS_UPDATED,
+			fswatch_poll_changes(watch, &changes, &nchanges));
+	assert_int_equal(2, nchanges);
+	assert_string_equal("watched-file", changes[0].name);
+	assert_false(changes[0].existed);
+	assert_string_equal("testdir", changes[1].name);
+	assert_false(changes[1].existed);
+	fswatch_free_changes(changes, nchanges);
+
+	assert_success(remove(SANDBOX_PATH "/watched-file"));
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+
+	assert_int_equal(FSWS_UPDATED,
+			fswatch_poll_changes(watch, &changes, &nchanges));
+	assert_int_equal(2, nchanges);
+	assert_true(changes[0].existed);
+	assert_true(changes[1].existed);
+	fswatch_free_changes(changes, nchanges);
+
+	fswatch_free(watch);
+}
+
+TEST(change_of_directory_itself_is_not_detailed, IF(using_inotify))
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/testdir", 0700));
+
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create(SANDBOX_PATH "/testdir"));
+
+	fswatch_change_t *changes;
+	int nchanges;
+
+	assert_success(os_chmod(SANDBOX_PATH "/testdir", 0777));
+	assert_int_equal(FSWS_UPDATED,
+			fswatch_poll_changes(watch, &changes, &nchanges));
+	assert_int_equal(-1, nchanges);
+	assert_null(changes);
+
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+}
+
 static int
 using_inotify(void)
 {
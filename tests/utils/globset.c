@@ -0,0 +1,148 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* free() */
+
+#include "../../src/utils/globset.h"
+#include "../../src/utils/macros.h"
+#include "../../src/utils/string_array.h"
+
+static globset_t * compile(const char globs[]);
+
+TEST(literals_are_matched_exactly)
+{
+	globset_t *set = compile("abc,abcd,ABCDEF");
+	assert_true(globset_matches(set, "abc"));
+	assert_true(globset_matches(set, "ABCD"));
+	assert_true(globset_matches(set, "abcdef"));
+	assert_false(globset_matches(set, "ab"));
+	assert_false(globset_matches(set, "abcde"));
+	assert_false(globset_matches(set, "abcdefg"));
+	globset_free(set);
+}
+
+TEST(suffixes_are_matched)
+{
+	globset_t *set = compile("*.jpg,*.JPEG,*");
+	assert_true(globset_matches(set, "a.jpg"));
+	assert_true(globset_matches(set, "a.jpeg"));
+	assert_true(globset_matches(set, "anything"));
+	assert_false(globset_matches(set, ".jpg"));
+	assert_false(globset_matches(set, ".hidden"));
+	globset_free(set);
+
+	set = compile("*.c");
+	assert_true(globset_matches(set, "a.c"));
+	assert_false(globset_matches(set, ".c"));
+	assert_false(globset_matches(set, "c"));
+	assert_false(globset_matches(set, "a.h"));
+	globset_free(set);
+}
+
+TEST(prefixes_and_infixes_are_matched)
+{
+	globset_t *set = compile("read*,Make*.am,a*a");
+	assert_true(globset_matches(set, "read"));
+	assert_true(globset_matches(set, "README"));
+	assert_true(globset_matches(set, "makefile.am"));
+	assert_true(globset_matches(set, "Make.am"));
+	assert_true(globset_matches(set, "aa"));
+	assert_true(globset_matches(set, "aba"));
+	assert_false(globset_matches(set, "a"));
+	assert_false(globset_matches(set, "Makefile.in"));
+	assert_false(globset_matches(set, "rea"));
+	globset_free(set);
+}
+
+TEST(escaped_asterisk_is_literal)
+{
+	globset_t *set = compile("a\\*b");
+	assert_true(globset_matches(set, "a*b"));
+	assert_false(globset_matches(set, "axb"));
+	globset_free(set);
+}
+
+TEST(complex_globs_are_combined_with_simple_ones)
+{
+	globset_t *set = compile("*.[ch],file?,*.txt,doc");
+	assert_true(globset_matches(set, "main.c"));
+	assert_true(globset_matches(set, "main.h"));
+	assert_true(globset_matches(set, "file1"));
+	assert_true(globset_matches(set, "notes.txt"));
+	assert_true(globset_matches(set, "doc"));
+	assert_false(globset_matches(set, "main.o"));
+	assert_false(globset_matches(set, "file12"));
+	globset_free(set);
+}
+
+TEST(commas_are_unescaped)
+{
+	globset_t *set = compile("a,,b,[x,,y]z");
+	assert_true(globset_matches(set, "a,b"));
+	assert_true(globset_matches(set, ",z"));
+	assert_false(globset_matches(set, "a"));
+	globset_free(set);
+}
+
+TEST(globs_are_classified)
+{
+	assert_true(globset_is_simple("abc"));
+	assert_true(globset_is_simple("*abc"));
+	assert_true(globset_is_simple("abc*"));
+	assert_true(globset_is_simple("a*c"));
+	assert_false(globset_is_simple("a*c*"));
+	assert_false(globset_is_simple("a?c"));
+	assert_false(globset_is_simple("[a]"));
+}
+
+TEST(keys_are_names_and_extensions)
+{
+	strlist_t names = {}, exts = {};
+	assert_success(globset_get_keys("Makefile,*.TAR.gz,a\\*b,x*y.c", &names,
+				&exts));
+
+	assert_int_equal(2, names.nitems);
+	assert_string_equal("makefile", names.items[0]);
+	assert_string_equal("a*b", names.items[1]);
+	assert_int_equal(2, exts.nitems);
+	assert_string_equal("gz", exts.items[0]);
+	assert_string_equal("c", exts.items[1]);
+
+	free_string_array(names.items, names.nitems);
+	free_string_array(exts.items, exts.nitems);
+}
+
+TEST(globs_without_keys_are_reported)
+{
+	const char *const globs[] = { "*", "*c", "a.*", "a?c", "[ab].c" };
+
+	size_t i;
+	for(i = 0U; i < ARRAY_LEN(globs); ++i)
+	{
+		strlist_t names = {}, exts = {};
+		assert_failure(globset_get_keys(globs[i], &names, &exts));
+		free_string_array(names.items, names.nitems);
+		free_string_array(exts.items, exts.nitems);
+	}
+}
+
+TEST(wrong_glob_is_an_error)
+{
+	char *error = NULL;
+	assert_null(globset_compile("*.c,[", &error));
+	assert_non_null(error);
+	free(error);
+}
+
+static globset_t *
+compile(const char globs[])
+{
+	char *error = NULL;
+	globset_t *const set = globset_compile(globs, &error);
+	assert_non_null(set);
+	assert_null(error);
+	return set;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
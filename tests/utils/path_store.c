@@ -0,0 +1,97 @@
+#include <stic.h>
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() remove() */
+
+#include "../../src/utils/path_store.h"
+
+TEST(missing_file_is_not_opened)
+{
+	assert_null(path_store_open(SANDBOX_PATH "/nope"));
+	path_store_close(NULL);
+}
+
+TEST(null_store_is_empty)
+{
+	path_store_rec_t rec;
+	assert_failure(path_store_get(NULL, "/a", &rec));
+	assert_int_equal(0, path_store_count(NULL));
+}
+
+TEST(invalid_file_is_not_opened)
+{
+	FILE *fp = fopen(SANDBOX_PATH "/store", "wb");
+	assert_non_null(fp);
+	fputs("this is not a store, but it is long enough", fp);
+	fclose(fp);
+
+	assert_null(path_store_open(SANDBOX_PATH "/store"));
+
+	assert_success(remove(SANDBOX_PATH "/store"));
+}
+
+TEST(records_are_written_and_found)
+{
+	const char *paths[] = { "/a", "/a/b", "/c" };
+	const path_store_rec_t recs[] = {
+		{ .value = 1, .inode = 10, .timestamp = 100 },
+		{ .value = 2, .inode = 20, .timestamp = 200 },
+		{ .value = 3, .inode = 30, .timestamp = 300 },
+	};
+
+	assert_success(path_store_write(SANDBOX_PATH "/store", paths, recs, 3, 10));
+
+	path_store_t *store = path_store_open(SANDBOX_PATH "/store");
+	assert_non_null(store);
+	assert_int_equal(3, path_store_count(store));
+
+	path_store_rec_t rec;
+	assert_success(path_store_get(store, "/a/b", &rec));
+	assert_ulong_equal(2, rec.value);
+	assert_ulong_equal(20, rec.inode);
+	assert_int_equal(200, rec.timestamp);
+
+	assert_success(path_store_get(store, "/c", &rec));
+	assert_ulong_equal(3, rec.value);
+
+	assert_failure(path_store_get(store, "/a/", &rec));
+	assert_failure(path_store_get(store, "/b", &rec));
+
+	int i;
+	int sum = 0;
+	for(i = 0; i < path_store_count(store); ++i)
+	{
+		(void)path_store_at(store, i, &rec);
+		sum += rec.value;
+	}
+	assert_int_equal(6, sum);
+
+	path_store_close(store);
+	assert_success(remove(SANDBOX_PATH "/store"));
+}
+
+TEST(oldest_records_are_evicted)
+{
+	const char *paths[] = { "/old", "/new", "/mid" };
+	const path_store_rec_t recs[] = {
+		{ .value = 1, .timestamp = 100 },
+		{ .value = 2, .timestamp = 300 },
+		{ .value = 3, .timestamp = 200 },
+	};
+
+	assert_success(path_store_write(SANDBOX_PATH "/store", paths, recs, 3, 2));
+
+	path_store_t *store = path_store_open(SANDBOX_PATH "/store");
+	assert_non_null(store);
+	assert_int_equal(2, path_store_count(store));
+
+	path_store_rec_t rec;
+	assert_failure(path_store_get(store, "/old", &rec));
+	assert_success(path_store_get(store, "/new", &rec));
+	assert_success(path_store_get(store, "/mid", &rec));
+
+	path_store_close(store);
+	assert_success(remove(SANDBOX_PATH "/store"));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,113 @@
+#include <stic.h>
+
+#include <regex.h> /* REG_EXTENDED REG_ICASE regmatch_t */
+
+#include "../../src/utils/macros.h"
+#include "../../src/utils/regexp.h"
+
+static void check_literal(const char pattern[], const char literal[],
+		RegexpLiteral kind);
+static void check_same_results(int cflags);
+
+TEST(literals_are_extracted)
+{
+	check_literal("abc", "abc", RL_ANYWHERE);
+	check_literal("^abc", "abc", RL_PREFIX);
+	check_literal("abc$", "abc", RL_SUFFIX);
+	check_literal("^a\\.c$", "a.c", RL_WHOLE);
+	check_literal("", "", RL_ANYWHERE);
+	check_literal("ab*cd", "cd", RL_REQUIRED);
+	check_literal("x(b|c)+def", "def", RL_REQUIRED);
+	check_literal("[]abc]x.y?z", "x", RL_REQUIRED);
+	check_literal("ab\\wc", "ab", RL_REQUIRED);
+	check_literal("abc{2,3}", "ab", RL_REQUIRED);
+}
+
+TEST(no_literal_for_alternatives_or_basic_regexps)
+{
+	check_literal("abc|def", NULL, RL_REQUIRED);
+	check_literal(".(ab)", NULL, RL_REQUIRED);
+	check_literal("[a-z]+", NULL, RL_REQUIRED);
+
+	regexp_t re;
+	assert_success(regexp_init(&re, "abc", 0));
+	assert_null(re.literal);
+	regexp_dispose(&re);
+}
+
+TEST(case_flags_are_taken_into_account)
+{
+	regexp_t re;
+	assert_success(regexp_init(&re, "a\\cBc", REG_EXTENDED));
+	assert_string_equal("aBc", re.literal);
+	assert_true(re.icase);
+	assert_success(regexp_exec(&re, "xABC", 0, NULL));
+	regexp_dispose(&re);
+}
+
+TEST(results_match_those_of_regexec)
+{
+	check_same_results(REG_EXTENDED);
+	check_same_results(REG_EXTENDED | REG_ICASE);
+}
+
+/* Compiles extended regexp and checks extracted literal. */
+static void
+check_literal(const char pattern[], const char literal[], RegexpLiteral kind)
+{
+	regexp_t re;
+	assert_success(regexp_init(&re, pattern, REG_EXTENDED));
+	if(literal == NULL)
+	{
+		assert_null(re.literal);
+	}
+	else
+	{
+		assert_string_equal(literal, re.literal);
+		assert_int_equal(kind, re.kind);
+	}
+	regexp_dispose(&re);
+}
+
+/* Compares results of regexp_exec() and regexec() for a set of patterns and
+ * strings. */
+static void
+check_same_results(int cflags)
+{
+	const char *const patterns[] = {
+		"abc", "^abc", "abc$", "^abc$", "", "^", "$", "^$", "a.c", "b+c", "b*c",
+		"x(b|c)+def", "ABC", "^Ab", "bC$", "a\\.c", "абв", "^абв$", "[0-9]c",
+	};
+	const char *const strings[] = {
+		"", "abc", "xabcx", "ABC", "abcabc", "ab", "bc", "a.c", "aXc", "abbbc",
+		"xbcdef", "xdef", "абв", "xабвx", "АБВ", "Kabc", "1c",
+	};
+
+	size_t i, j;
+	for(i = 0U; i < ARRAY_LEN(patterns); ++i)
+	{
+		regexp_t re;
+		regex_t plain;
+		assert_success(regexp_init(&re, patterns[i], cflags));
+		assert_success(regcomp(&plain, patterns[i], cflags));
+
+		for(j = 0U; j < ARRAY_LEN(strings); ++j)
+		{
+			regmatch_t m1[2], m2[2];
+			const int r1 = regexp_exec(&re, strings[j], ARRAY_LEN(m1), m1);
+			const int r2 = regexec(&plain, strings[j], ARRAY_LEN(m2), m2, 0);
+			assert_int_equal(r2 == 0, r1 == 0);
+			if(r1 == 0 && r2 == 0)
+			{
+				assert_int_equal(m2[0].rm_so, m1[0].rm_so);
+				assert_int_equal(m2[0].rm_eo, m1[0].rm_eo);
+			}
+		}
+
+		regfree(&plain);
+		regexp_dispose(&re);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
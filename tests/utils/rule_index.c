@@ -0,0 +1,122 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* free() */
+
+#include "../../src/utils/macros.h"
+#include "../../src/utils/matchers.h"
+#include "../../src/utils/rule_index.h"
+
+static void add_rules(const char *exprs[], int count);
+static int first_match(const char path[]);
+
+static rule_index_t *index;
+static matchers_t *rules[8];
+static int nrules;
+
+SETUP()
+{
+	index = rule_index_alloc();
+	assert_non_null(index);
+	nrules = 0;
+}
+
+TEARDOWN()
+{
+	rule_index_free(index);
+
+	int i;
+	for(i = 0; i < nrules; ++i)
+	{
+		matchers_free(rules[i]);
+	}
+}
+
+TEST(empty_index_matches_nothing)
+{
+	int count;
+	(void)rule_index_find(index, "file.c", &count);
+	assert_int_equal(0, count);
+}
+
+TEST(order_of_indexed_and_other_rules_is_kept)
+{
+	const char *exprs[] = { "{*.c}", "/^a/", "{Makefile,*.h}", "{*.C,*.cpp}" };
+	add_rules(exprs, ARRAY_LEN(exprs));
+
+	int count;
+	const int *matched = rule_index_find(index, "a.c", &count);
+	assert_int_equal(3, count);
+	assert_int_equal(0, matched[0]);
+	assert_int_equal(1, matched[1]);
+	assert_int_equal(3, matched[2]);
+
+	assert_int_equal(2, first_match("dir/makefile"));
+	assert_int_equal(1, first_match("a.h"));
+	assert_int_equal(2, first_match("b.h"));
+	assert_int_equal(-1, first_match("b.hpp"));
+	assert_int_equal(-1, first_match("c"));
+}
+
+TEST(rule_bound_to_name_and_extension_is_reported_once)
+{
+	const char *exprs[] = { "{a.c,*.c}" };
+	add_rules(exprs, ARRAY_LEN(exprs));
+
+	int count;
+	(void)rule_index_find(index, "a.c", &count);
+	assert_int_equal(1, count);
+}
+
+TEST(all_matchers_of_a_rule_are_checked)
+{
+	const char *exprs[] = { "{*.c}!{x.c}", "{*.c}{x*}" };
+	add_rules(exprs, ARRAY_LEN(exprs));
+
+	assert_int_equal(0, first_match("a.c"));
+	assert_int_equal(1, first_match("x.c"));
+	assert_int_equal(-1, first_match("y.h"));
+}
+
+TEST(remembered_results_are_dropped_on_change)
+{
+	const char *exprs1[] = { "{*.c}" };
+	add_rules(exprs1, ARRAY_LEN(exprs1));
+	assert_int_equal(-1, first_match("a.h"));
+	assert_int_equal(-1, first_match("a.h"));
+
+	const char *exprs2[] = { "{*.h}" };
+	add_rules(exprs2, ARRAY_LEN(exprs2));
+	assert_int_equal(1, first_match("a.h"));
+
+	rule_index_reset(index);
+	assert_int_equal(-1, first_match("a.h"));
+}
+
+/* Allocates matchers and appends them to the index. */
+static void
+add_rules(const char *exprs[], int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		char *error = NULL;
+		rules[nrules] = matchers_alloc(exprs[i], 0, 1, "", &error);
+		assert_non_null(rules[nrules]);
+		assert_null(error);
+		assert_success(rule_index_add(index, rules[nrules]));
+		++nrules;
+	}
+}
+
+/* Looks up the first rule matching the path.  Returns its number or -1. */
+static int
+first_match(const char path[])
+{
+	int count;
+	const int *matched = rule_index_find(index, path, &count);
+	return (count == 0 ? -1 : matched[0]);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,101 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+#include <string.h> /* memset() */
+
+#include "../../src/utils/str_pool.h"
+
+TEST(null_pool_can_be_unreferenced)
+{
+	str_pool_unref(NULL);
+}
+
+TEST(strings_are_copied)
+{
+	str_pool_t *pool = str_pool_new();
+	assert_non_null(pool);
+
+	char str[] = "name";
+	char *copy = str_pool_dup(pool, str);
+	str[0] = 'N';
+	assert_string_equal("name", copy);
+	assert_string_equal("", str_pool_dup(pool, ""));
+
+	str_pool_unref(pool);
+}
+
+TEST(pool_lives_until_last_reference_is_dropped)
+{
+	str_pool_t *pool = str_pool_new();
+	char *copy = str_pool_dup(pool, "name");
+
+	str_pool_ref(pool);
+	str_pool_unref(pool);
+	assert_string_equal("name", copy);
+
+	str_pool_unref(pool);
+}
+
+TEST(many_strings_occupy_multiple_chunks)
+{
+	str_pool_t *pool = str_pool_new();
+
+	char *first = str_pool_dup(pool, "first");
+
+	char name[256];
+	memset(name, 'x', sizeof(name) - 1U);
+	name[sizeof(name) - 1U] = '\0';
+
+	int i;
+	for(i = 0; i < 1000; ++i)
+	{
+		assert_string_equal(name, str_pool_dup(pool, name));
+	}
+
+	assert_string_equal("first", first);
+	str_pool_unref(pool);
+}
+
+TEST(big_strings_are_stored)
+{
+	static char big[100*1024];
+	memset(big, 'b', sizeof(big) - 1U);
+
+	str_pool_t *pool = str_pool_new();
+
+	char *small = str_pool_dup(pool, "small");
+	char *copy = str_pool_dup(pool, big);
+	char *next = str_pool_dup(pool, "next");
+
+	assert_string_equal(big, copy);
+	assert_string_equal("small", small);
+	assert_string_equal("next", next);
+	assert_true(next == small + 6);
+
+	str_pool_unref(pool);
+}
+
+TEST(size_accounts_for_all_chunks)
+{
+	str_pool_t *pool = str_pool_new();
+	const size_t empty_size = str_pool_size(pool);
+
+	(void)str_pool_dup(pool, "name");
+	const size_t one_chunk_size = str_pool_size(pool);
+	assert_true(one_chunk_size > empty_size);
+	assert_true(one_chunk_size < empty_size + 64U*1024U);
+
+	(void)str_pool_dup(pool, "other");
+	assert_int_equal(one_chunk_size, str_pool_size(pool));
+
+	char name[64*1024];
+	memset(name, 'x', sizeof(name) - 1U);
+	name[sizeof(name) - 1U] = '\0';
+	(void)str_pool_dup(pool, name);
+	assert_true(str_pool_size(pool) >= one_chunk_size + sizeof(name));
+
+	str_pool_unref(pool);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
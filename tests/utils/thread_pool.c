@@ -0,0 +1,74 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+
+#include "../../src/utils/thread_pool.h"
+
+static void mark_items(void *arg, int from, int to);
+
+TEST(pool_can_be_created_and_freed)
+{
+	thread_pool_t *pool = thread_pool_new(2);
+	assert_non_null(pool);
+	assert_int_equal(2, thread_pool_size(pool));
+	thread_pool_free(pool);
+
+	thread_pool_free(NULL);
+}
+
+TEST(pool_size_defaults_to_number_of_processors)
+{
+	thread_pool_t *pool = thread_pool_new(0);
+	assert_non_null(pool);
+	assert_int_equal(thread_pool_ncpus(), thread_pool_size(pool));
+	thread_pool_free(pool);
+}
+
+TEST(every_item_is_processed_exactly_once)
+{
+	int items[1000] = { };
+
+	thread_pool_t *pool = thread_pool_new(4);
+	assert_non_null(pool);
+	thread_pool_for(pool, 1000, 7, &mark_items, items);
+	thread_pool_free(pool);
+
+	int i;
+	for(i = 0; i < 1000; ++i)
+	{
+		assert_int_equal(1, items[i]);
+	}
+}
+
+TEST(pool_can_be_reused)
+{
+	int items[100] = { };
+
+	thread_pool_t *pool = thread_pool_new(3);
+	assert_non_null(pool);
+	thread_pool_for(pool, 100, 1, &mark_items, items);
+	thread_pool_for(pool, 0, 1, &mark_items, items);
+	thread_pool_for(pool, 50, 100, &mark_items, items);
+	thread_pool_free(pool);
+
+	int i;
+	for(i = 0; i < 100; ++i)
+	{
+		assert_int_equal(i < 50 ? 2 : 1, items[i]);
+	}
+}
+
+static void
+mark_items(void *arg, int from, int to)
+{
+	int *const items = arg;
+
+	int i;
+	for(i = from; i < to; ++i)
+	{
+		++items[i];
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
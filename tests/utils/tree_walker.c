@@ -0,0 +1,181 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+#include <string.h> /* strcmp() */
+
+#include <test-utils.h>
+
+#include "../../src/utils/tree_walker.h"
+
+static int filter_all(const char dir[], const char name[], int depth,
+		void *arg);
+static int filter_none(const char dir[], const char name[], int depth,
+		void *arg);
+static int not_cancelled(void *arg);
+static int cancelled(void *arg);
+static void count_dirs(void *arg);
+static int has_entry(const tree_walker_dir_t *dir, const char name[],
+		int real_dir);
+
+SETUP()
+{
+	create_dir(SANDBOX_PATH "/a");
+	create_dir(SANDBOX_PATH "/a/b");
+	create_file(SANDBOX_PATH "/a/b/file");
+	create_dir(SANDBOX_PATH "/c");
+}
+
+TEARDOWN()
+{
+	remove_file(SANDBOX_PATH "/a/b/file");
+	remove_dir(SANDBOX_PATH "/a/b");
+	remove_dir(SANDBOX_PATH "/a");
+	remove_dir(SANDBOX_PATH "/c");
+}
+
+TEST(null_walker_is_handled)
+{
+	assert_null(tree_walker_get(NULL, SANDBOX_PATH));
+	tree_walker_free(NULL);
+}
+
+TEST(whole_tree_is_read)
+{
+	int ndirs = 0;
+	const tree_walker_cbs_t cbs = {
+		.filter = &filter_all,
+		.cancelled = &not_cancelled,
+		.progress = &count_dirs,
+		.arg = &ndirs,
+	};
+
+	tree_walker_t *walker = tree_walker_walk(SANDBOX_PATH, -1, &cbs);
+	assert_non_null(walker);
+
+	const tree_walker_dir_t *dir = tree_walker_get(walker, SANDBOX_PATH);
+	assert_non_null(dir);
+	assert_int_equal(2, dir->count);
+	assert_true(has_entry(dir, "a", 1));
+	assert_true(has_entry(dir, "c", 1));
+
+	dir = tree_walker_get(walker, SANDBOX_PATH "/a/b");
+	assert_non_null(dir);
+	assert_int_equal(1, dir->count);
+	assert_true(has_entry(dir, "file", 0));
+
+	assert_non_null(tree_walker_get(walker, SANDBOX_PATH "/c"));
+
+	/* Progress is reported only on the calling thread, so it can miss some or
+	 * even all directories if other workers take them first. */
+	assert_true(ndirs >= 0 && ndirs <= 4);
+
+	tree_walker_free(walker);
+}
+
+TEST(depth_limits_walk)
+{
+	const tree_walker_cbs_t cbs = {
+		.filter = &filter_all,
+		.cancelled = &not_cancelled,
+	};
+
+	tree_walker_t *walker = tree_walker_walk(SANDBOX_PATH, 1, &cbs);
+	assert_non_null(walker);
+
+	assert_non_null(tree_walker_get(walker, SANDBOX_PATH));
+	assert_non_null(tree_walker_get(walker, SANDBOX_PATH "/a"));
+	assert_null(tree_walker_get(walker, SANDBOX_PATH "/a/b"));
+
+	tree_walker_free(walker);
+}
+
+TEST(filter_limits_walk)
+{
+	const tree_walker_cbs_t cbs = {
+		.filter = &filter_none,
+		.cancelled = &not_cancelled,
+	};
+
+	tree_walker_t *walker = tree_walker_walk(SANDBOX_PATH, -1, &cbs);
+	assert_non_null(walker);
+
+	assert_non_null(tree_walker_get(walker, SANDBOX_PATH));
+	assert_null(tree_walker_get(walker, SANDBOX_PATH "/a"));
+	assert_null(tree_walker_get(walker, SANDBOX_PATH "/c"));
+
+	tree_walker_free(walker);
+}
+
+TEST(walk_can_be_cancelled)
+{
+	const tree_walker_cbs_t cbs = {
+		.filter = &filter_all,
+		.cancelled = &cancelled,
+	};
+
+	tree_walker_t *walker = tree_walker_walk(SANDBOX_PATH, -1, &cbs);
+	assert_non_null(walker);
+	assert_null(tree_walker_get(walker, SANDBOX_PATH));
+	tree_walker_free(walker);
+}
+
+TEST(missing_root_produces_no_listing)
+{
+	const tree_walker_cbs_t cbs = {
+		.filter = &filter_all,
+		.cancelled = &not_cancelled,
+	};
+
+	tree_walker_t *walker = tree_walker_walk(SANDBOX_PATH "/nope", -1, &cbs);
+	assert_non_null(walker);
+	assert_null(tree_walker_get(walker, SANDBOX_PATH "/nope"));
+	tree_walker_free(walker);
+}
+
+static int
+filter_all(const char dir[], const char name[], int depth, void *arg)
+{
+	return 1;
+}
+
+static int
+filter_none(const char dir[], const char name[], int depth, void *arg)
+{
+	return 0;
+}
+
+static int
+not_cancelled(void *arg)
+{
+	return 0;
+}
+
+static int
+cancelled(void *arg)
+{
+	return 1;
+}
+
+static void
+count_dirs(void *arg)
+{
+	++*(int *)arg;
+}
+
+static int
+has_entry(const tree_walker_dir_t *dir, const char name[], int real_dir)
+{
+	int i;
+	for(i = 0; i < dir->count; ++i)
+	{
+		if(strcmp(dir->entries[i].name, name) == 0)
+		{
+			return dir->entries[i].is_dir == real_dir
+			    && dir->entries[i].real_dir == real_dir;
+		}
+	}
+	return 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */